@@ -0,0 +1,206 @@
+#include "ahrs.h"
+#include <string.h>
+
+#define DEG_TO_RAD 0.017453293f
+#define RAD_TO_DEG 57.29578f
+
+// ===================================================================
+// Initialization
+// ===================================================================
+
+void ahrs_init(AhrsState& ahrs, AhrsAlgorithm algorithm, float rate_hz) {
+  memset(&ahrs, 0, sizeof(ahrs));
+  ahrs.algorithm = algorithm;
+  ahrs.q0 = 1.0f;
+  ahrs.dt_s = 1.0f / rate_hz;
+  ahrs.cos_flat = cosf(AHRS_FLAT_DEG * DEG_TO_RAD);
+  ahrs.cos_upright = cosf(AHRS_UPRIGHT_DEG * DEG_TO_RAD);
+  ahrs.rapid_sq = (float)AHRS_RAPID_DPS * AHRS_RAPID_DPS;
+  ahrs.still_sq = (float)AHRS_FLAT_MAX_DPS * AHRS_FLAT_MAX_DPS;
+}
+
+// Pitch and roll from gravity, zero yaw: starts the filter converged
+static void align(AhrsState& ahrs, float ax, float ay, float az) {
+  float roll = atan2f(ay, az);
+  float pitch = atan2f(-ax, sqrtf(ay * ay + az * az));
+  float cr = cosf(roll * 0.5f), sr = sinf(roll * 0.5f);
+  float cp = cosf(pitch * 0.5f), sp = sinf(pitch * 0.5f);
+  ahrs.q0 = cr * cp;
+  ahrs.q1 = sr * cp;
+  ahrs.q2 = cr * sp;
+  ahrs.q3 = -sr * sp;
+  ahrs.aligned = true;
+}
+
+// One step moves |q| only slightly off 1, so a Newton step from 1 is
+// enough: error ~(|q|^2 - 1)^2, below 1e-4 even at 1000 deg/s
+static void normalise_q(AhrsState& ahrs) {
+  float n = ahrs.q0 * ahrs.q0 + ahrs.q1 * ahrs.q1 + ahrs.q2 * ahrs.q2 + ahrs.q3 * ahrs.q3;
+#ifdef AHRS_EXACT_INV_SQRT
+  float r = 1.0f / sqrtf(n);
+#else
+  float r = 1.5f - 0.5f * n;
+#endif
+  ahrs.q0 *= r;
+  ahrs.q1 *= r;
+  ahrs.q2 *= r;
+  ahrs.q3 *= r;
+}
+
+// ===================================================================
+// Madgwick
+// ===================================================================
+// Gyro rate minus beta times the normalised gradient of the gravity
+// error (Madgwick 2010, IMU-only form). a is already unit length.
+// ===================================================================
+
+static void madgwick_step(AhrsState& ahrs, float ax, float ay, float az,
+                          float gx, float gy, float gz, bool use_accel) {
+  float q0 = ahrs.q0, q1 = ahrs.q1, q2 = ahrs.q2, q3 = ahrs.q3;
+  
+  float dq0 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+  float dq1 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+  float dq2 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+  float dq3 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+  
+  if (use_accel) {
+    float q0q0 = q0 * q0, q1q1 = q1 * q1, q2q2 = q2 * q2, q3q3 = q3 * q3;
+    float s0 = 4.0f * q0 * q2q2 + 2.0f * q2 * ax + 4.0f * q0 * q1q1 - 2.0f * q1 * ay;
+    float s1 = 4.0f * q1 * q3q3 - 2.0f * q3 * ax + 4.0f * q0q0 * q1 - 2.0f * q0 * ay - 4.0f * q1 +
+               8.0f * q1 * q1q1 + 8.0f * q1 * q2q2 + 4.0f * q1 * az;
+    float s2 = 4.0f * q0q0 * q2 + 2.0f * q0 * ax + 4.0f * q2 * q3q3 - 2.0f * q3 * ay - 4.0f * q2 +
+               8.0f * q2 * q1q1 + 8.0f * q2 * q2q2 + 4.0f * q2 * az;
+    float s3 = 4.0f * q1q1 * q3 - 2.0f * q1 * ax + 4.0f * q2q2 * q3 - 2.0f * q2 * ay;
+    float norm_sq = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+    if (norm_sq > 0) {
+      float r = AHRS_MADGWICK_BETA * ahrs_inv_sqrt(norm_sq);
+      dq0 -= r * s0;
+      dq1 -= r * s1;
+      dq2 -= r * s2;
+      dq3 -= r * s3;
+    }
+  }
+  
+  ahrs.q0 = q0 + dq0 * ahrs.dt_s;
+  ahrs.q1 = q1 + dq1 * ahrs.dt_s;
+  ahrs.q2 = q2 + dq2 * ahrs.dt_s;
+  ahrs.q3 = q3 + dq3 * ahrs.dt_s;
+}
+
+// ===================================================================
+// Mahony
+// ===================================================================
+// Error = measured x estimated gravity direction, fed back into the
+// gyro rate through a PI controller (Mahony 2008). The integral term
+// converges on the gyro bias.
+// ===================================================================
+
+static void mahony_step(AhrsState& ahrs, float ax, float ay, float az,
+                        float gx, float gy, float gz, bool use_accel) {
+  float q0 = ahrs.q0, q1 = ahrs.q1, q2 = ahrs.q2, q3 = ahrs.q3;
+  
+  if (use_accel) {
+    // Half the estimated gravity direction
+    float vx = q1 * q3 - q0 * q2;
+    float vy = q0 * q1 + q2 * q3;
+    float vz = q0 * q0 - 0.5f + q3 * q3;
+    float ex = ay * vz - az * vy;
+    float ey = az * vx - ax * vz;
+    float ez = ax * vy - ay * vx;
+    
+    ahrs.integral[0] += 2.0f * AHRS_MAHONY_KI * ex * ahrs.dt_s;
+    ahrs.integral[1] += 2.0f * AHRS_MAHONY_KI * ey * ahrs.dt_s;
+    ahrs.integral[2] += 2.0f * AHRS_MAHONY_KI * ez * ahrs.dt_s;
+    gx += ahrs.integral[0] + 2.0f * AHRS_MAHONY_KP * ex;
+    gy += ahrs.integral[1] + 2.0f * AHRS_MAHONY_KP * ey;
+    gz += ahrs.integral[2] + 2.0f * AHRS_MAHONY_KP * ez;
+  }
+  
+  float h = 0.5f * ahrs.dt_s;
+  gx *= h;
+  gy *= h;
+  gz *= h;
+  ahrs.q0 = q0 + (-q1 * gx - q2 * gy - q3 * gz);
+  ahrs.q1 = q1 + (q0 * gx + q2 * gz - q3 * gy);
+  ahrs.q2 = q2 + (q0 * gy - q1 * gz + q3 * gx);
+  ahrs.q3 = q3 + (q0 * gz + q1 * gy - q2 * gx);
+}
+
+// ===================================================================
+// Update
+// ===================================================================
+
+static void update_signals(AhrsState& ahrs, float rate_sq, uint32_t t_ms) {
+  if (rate_sq > ahrs.rapid_sq) {
+    ahrs.rapid_until_ms = t_ms + AHRS_RAPID_HOLD_MS;
+    ahrs.rapid_started = true;
+    float dps = sqrtf(rate_sq);
+    if (dps > ahrs.peak_dps) ahrs.peak_dps = dps;
+  }
+  
+  float tilt_cos = ahrs.q0 * ahrs.q0 - ahrs.q1 * ahrs.q1 - ahrs.q2 * ahrs.q2 + ahrs.q3 * ahrs.q3;
+  if (fabsf(tilt_cos) < ahrs.cos_flat && rate_sq < ahrs.still_sq) {
+    if (!ahrs.flat_pending) {
+      ahrs.flat_pending = true;
+      ahrs.flat_since_ms = t_ms;
+    }
+    ahrs.flat = t_ms - ahrs.flat_since_ms >= AHRS_FLAT_HOLD_MS;
+  } else {
+    ahrs.flat_pending = false;
+    ahrs.flat = false;
+  }
+}
+
+void ahrs_update(AhrsState& ahrs, float ax, float ay, float az,
+                 float gx_dps, float gy_dps, float gz_dps, uint32_t t_ms) {
+  float a_sq = ax * ax + ay * ay + az * az;
+  bool use_accel = a_sq > 0;
+  if (use_accel) {
+    float r = ahrs_inv_sqrt(a_sq);
+    ax *= r;
+    ay *= r;
+    az *= r;
+    if (!ahrs.aligned) align(ahrs, ax, ay, az);
+  }
+  
+  float gx = gx_dps * DEG_TO_RAD, gy = gy_dps * DEG_TO_RAD, gz = gz_dps * DEG_TO_RAD;
+  if (ahrs.algorithm == AHRS_MAHONY) {
+    mahony_step(ahrs, ax, ay, az, gx, gy, gz, use_accel);
+  } else {
+    madgwick_step(ahrs, ax, ay, az, gx, gy, gz, use_accel);
+  }
+  normalise_q(ahrs);
+  ahrs.samples++;
+  
+  update_signals(ahrs, gx_dps * gx_dps + gy_dps * gy_dps + gz_dps * gz_dps, t_ms);
+}
+
+// ===================================================================
+// Outputs
+// ===================================================================
+
+AhrsSignals ahrs_signals(const AhrsState& ahrs, uint32_t t_ms) {
+  AhrsSignals s;
+  s.valid = ahrs.samples > 0;
+  s.tilt_cos = ahrs.q0 * ahrs.q0 - ahrs.q1 * ahrs.q1 - ahrs.q2 * ahrs.q2 + ahrs.q3 * ahrs.q3;
+  s.flat = ahrs.flat;
+  s.upright = s.valid && s.tilt_cos > ahrs.cos_upright;
+  s.rapid = ahrs.rapid_started && (int32_t)(ahrs.rapid_until_ms - t_ms) > 0;
+  return s;
+}
+
+void ahrs_pitch_roll(const AhrsState& ahrs, float& pitch_deg, float& roll_deg) {
+  float sin_pitch = 2.0f * (ahrs.q0 * ahrs.q2 - ahrs.q1 * ahrs.q3);
+  if (sin_pitch > 1.0f) sin_pitch = 1.0f;
+  if (sin_pitch < -1.0f) sin_pitch = -1.0f;
+  pitch_deg = asinf(sin_pitch) * RAD_TO_DEG;
+  roll_deg = atan2f(ahrs.q0 * ahrs.q1 + ahrs.q2 * ahrs.q3,
+                    0.5f - ahrs.q1 * ahrs.q1 - ahrs.q2 * ahrs.q2) * RAD_TO_DEG;
+}
+
+float ahrs_tilt_deg(const AhrsState& ahrs) {
+  float c = ahrs.q0 * ahrs.q0 - ahrs.q1 * ahrs.q1 - ahrs.q2 * ahrs.q2 + ahrs.q3 * ahrs.q3;
+  if (c > 1.0f) c = 1.0f;
+  if (c < -1.0f) c = -1.0f;
+  return acosf(c) * RAD_TO_DEG;
+}
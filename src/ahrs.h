@@ -0,0 +1,98 @@
+#ifndef AHRS_H
+#define AHRS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+// ===================================================================
+// Orientation Estimator (AHRS)
+// ===================================================================
+// Fuses gyro and accelerometer into an orientation quaternion, one
+// fixed step of 1/rate per IMU sample (no magnetometer, so yaw drifts;
+// pitch, roll and shaft tilt do not). Two filters, chosen at init:
+//   Madgwick  gradient-descent correction towards gravity, gain beta
+//   Mahony    PI correction on the gravity error, learns gyro bias
+// Both normalise the accelerometer and the Madgwick gradient with
+// ahrs_inv_sqrt(), a bit-trick estimate plus one Newton step (under
+// 0.2% error, no divide or sqrt), and the quaternion with a Newton step
+// from 1. Build with AHRS_EXACT_INV_SQRT to use 1/sqrtf() throughout.
+//
+// Signals for fall detection and obstacle logic, derived from the
+// quaternion and raw rates without trig:
+//   flat     shaft more than AHRS_FLAT_DEG from vertical for
+//            AHRS_FLAT_HOLD_MS while nearly not rotating
+//   upright  shaft within AHRS_UPRIGHT_DEG of vertical
+//   rapid    |gyro| above AHRS_RAPID_DPS, held AHRS_RAPID_HOLD_MS
+// Portable; tools/ahrs_bench.cpp checks accuracy on recorded or
+// synthetic traces with known attitude and times both filters.
+// ===================================================================
+
+#define AHRS_MADGWICK_BETA     0.08f
+#define AHRS_MAHONY_KP         2.0f
+#define AHRS_MAHONY_KI         0.05f
+
+#define AHRS_FLAT_DEG          65      // Shaft angle from vertical
+#define AHRS_FLAT_HOLD_MS      800
+#define AHRS_FLAT_MAX_DPS      30      // Rotating faster than this is not lying
+#define AHRS_UPRIGHT_DEG       30
+#define AHRS_RAPID_DPS         200
+#define AHRS_RAPID_HOLD_MS     500
+
+enum AhrsAlgorithm {
+  AHRS_MADGWICK,
+  AHRS_MAHONY
+};
+
+struct AhrsState {
+  AhrsAlgorithm algorithm;
+  float q0, q1, q2, q3;        // Sensor frame relative to earth
+  float dt_s;                  // Fixed step
+  float integral[3];           // Mahony gyro bias estimate (rad/s)
+  float cos_flat, cos_upright; // Thresholds on the shaft tilt cosine
+  float rapid_sq, still_sq;    // (deg/s)^2
+  uint32_t samples;
+  bool aligned;                // First sample set the attitude
+  bool flat;
+  bool flat_pending;
+  uint32_t flat_since_ms;
+  uint32_t rapid_until_ms;
+  bool rapid_started;
+  float peak_dps;              // Fastest rotation since init
+};
+
+struct AhrsSignals {
+  bool valid;                  // At least one sample fused
+  bool flat;
+  bool upright;
+  bool rapid;
+  float tilt_cos;              // Cosine of the shaft angle from vertical
+};
+
+// ===================================================================
+// AHRS Functions
+// ===================================================================
+
+void ahrs_init(AhrsState& ahrs, AhrsAlgorithm algorithm, float rate_hz);
+
+// Accelerometer in any unit (only its direction is used), gyro in deg/s
+void ahrs_update(AhrsState& ahrs, float ax, float ay, float az,
+                 float gx_dps, float gy_dps, float gz_dps, uint32_t t_ms);
+
+AhrsSignals ahrs_signals(const AhrsState& ahrs, uint32_t t_ms);
+
+// Euler angles in degrees (atan2/asin; not needed for the signals)
+void ahrs_pitch_roll(const AhrsState& ahrs, float& pitch_deg, float& roll_deg);
+float ahrs_tilt_deg(const AhrsState& ahrs);
+
+static inline float ahrs_inv_sqrt(float x) {
+#ifdef AHRS_EXACT_INV_SQRT
+  return 1.0f / sqrtf(x);
+#else
+  union { float f; uint32_t i; } v = {x};
+  v.i = 0x5F375A86 - (v.i >> 1);
+  return v.f * (1.5f - 0.5f * x * v.f * v.f);
+#endif
+}
+
+#endif // AHRS_H
@@ -0,0 +1,265 @@
+#include "alert_queue.h"
+#include <string.h>
+#include <stdio.h>
+
+// ===================================================================
+// Records
+// ===================================================================
+
+#define RECORD_HEAD_BYTES offsetof(AlertRecord, crc)
+
+static uint32_t crc32_update(uint32_t crc, const void* data, size_t len) {
+  const uint8_t* p = (const uint8_t*)data;
+  crc = ~crc;
+  while (len--) {
+    crc ^= *p++;
+    for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+  }
+  return ~crc;
+}
+
+static uint32_t record_crc(const AlertRecord& r) {
+  uint32_t crc = crc32_update(0, &r, RECORD_HEAD_BYTES);
+  return crc32_update(crc, r.json, r.len <= ALERT_JSON_MAX ? r.len : 0);
+}
+
+static uint32_t store_crc(const AlertStore& s) {
+  return crc32_update(0, &s, offsetof(AlertStore, crc));
+}
+
+static void seal(AlertRecord& r) {
+  r.crc = record_crc(r);
+}
+
+static void seal(AlertStore& s) {
+  s.crc = store_crc(s);
+}
+
+static AlertRecord& slot(const AlertQueue& q, uint32_t seq) {
+  return q.store->slots[seq & (ALERT_QUEUE_SIZE - 1)];
+}
+
+// Seq 0 is never issued, so a cleared slot holds nothing
+static bool valid(const AlertRecord& r, uint32_t index) {
+  return r.seq != 0 && (r.seq & (ALERT_QUEUE_SIZE - 1)) == index && r.len <= ALERT_JSON_MAX &&
+         r.crc == record_crc(r);
+}
+
+static bool pending(const AlertQueue& q, uint32_t seq) {
+  const AlertRecord& r = slot(q, seq);
+  return r.seq == seq && !(r.flags & ALERT_FLAG_DELIVERED);
+}
+
+// Past delivered, expired and lost records; at most a ring's worth
+static void advance_head(AlertQueue& q) {
+  while (q.head != q.store->next_seq && !pending(q, q.head)) q.head++;
+}
+
+static bool is_replay(const AlertQueue& q, const AlertRecord& r) {
+  return (r.flags & ALERT_FLAG_RESTORED) || (int32_t)(q.link_ms - r.t_ms) > 0;
+}
+
+// The head leaves the queue: confirmed, acked or expired
+static void retire_head(AlertQueue& q, uint32_t now_ms) {
+  AlertRecord& r = slot(q, q.head);
+  r.flags |= ALERT_FLAG_DELIVERED;
+  seal(r);
+  q.head++;
+  advance_head(q);
+  q.in_flight = false;
+  q.attempts = 0;
+  q.retry_ms = now_ms;
+}
+
+// ===================================================================
+// Open and Push
+// ===================================================================
+
+size_t alert_queue_open(AlertQueue& q, AlertStore* store, AlertSend send, void* ctx, uint32_t now_ms) {
+  q = {};
+  q.store = store;
+  q.send = send;
+  q.ctx = ctx;
+  q.link_ms = now_ms;
+  q.retry_ms = now_ms;
+  
+  bool header_ok = store->magic == ALERT_STORE_MAGIC && store->crc == store_crc(*store);
+  uint32_t next = header_ok ? store->next_seq : 1;
+  uint32_t found = 0;
+  for (uint32_t i = 0; i < ALERT_QUEUE_SIZE; i++) {
+    const AlertRecord& r = store->slots[i];
+    if (!valid(r, i)) continue;
+    found++;
+    if ((int32_t)(r.seq + 1 - next) > 0) next = r.seq + 1;
+  }
+  
+  // Power-on: whatever the memory holds is not ours
+  if (!header_ok && found == 0) {
+    memset(store, 0, sizeof(*store));
+    store->magic = ALERT_STORE_MAGIC;
+    store->next_seq = 1;
+    seal(*store);
+    q.head = 1;
+    return 0;
+  }
+  
+  // Keep what is valid and within a ring of the newest; clear the rest
+  for (uint32_t i = 0; i < ALERT_QUEUE_SIZE; i++) {
+    AlertRecord& r = store->slots[i];
+    if (valid(r, i) && next - r.seq <= ALERT_QUEUE_SIZE) continue;
+    if (header_ok && r.seq != 0) q.stats.corrupt++;
+    memset(&r, 0, sizeof(r));
+  }
+  store->magic = ALERT_STORE_MAGIC;
+  store->next_seq = next;
+  seal(*store);
+  
+  // Safety alerts wait for the next client; transient ones are stale
+  size_t restored = 0;
+  q.head = next;
+  for (uint32_t seq = next - ALERT_QUEUE_SIZE; seq != next; seq++) {
+    if (seq == 0 || !pending(q, seq)) continue;
+    AlertRecord& r = slot(q, seq);
+    if (r.cls == ALERT_TRANSIENT) {
+      r.flags |= ALERT_FLAG_DELIVERED;
+      q.stats.expired++;
+    } else {
+      r.flags |= ALERT_FLAG_RESTORED;
+      if (q.head == next) q.head = seq;
+      restored++;
+    }
+    seal(r);
+  }
+  q.stats.restored = restored;
+  return restored;
+}
+
+uint32_t alert_queue_push(AlertQueue& q, const char* json, AlertClass cls, uint32_t now_ms) {
+  AlertStore& s = *q.store;
+  uint32_t seq = s.next_seq;
+  
+  // A full ring gives up its oldest alert, the head, unless that would
+  // trade a pending safety alert for a transient one
+  bool full = seq - q.head >= ALERT_QUEUE_SIZE;
+  if (full && cls == ALERT_TRANSIENT && slot(q, q.head).cls == ALERT_SAFETY) {
+    q.stats.dropped++;
+    return 0;
+  }
+  if (full) {
+    q.stats.overwritten++;
+    q.in_flight = false;
+    q.attempts = 0;
+  }
+  
+  size_t len = strlen(json);
+  if (len > ALERT_JSON_MAX) {
+    len = ALERT_JSON_MAX - 1;
+    while (len > 1 && json[len] != ',') len--;
+  }
+  
+  AlertRecord& r = slot(q, seq);
+  r.seq = seq;
+  r.t_ms = now_ms;
+  r.cls = (uint8_t)cls;
+  r.flags = 0;
+  r.len = (uint16_t)len;
+  memcpy(r.json, json, len);
+  if (len < strlen(json)) r.json[r.len++] = '}';
+  seal(r);
+  
+  // The record is complete before the sequence moves past it
+  s.next_seq = seq + 1;
+  seal(s);
+  
+  if (full) {
+    q.head = seq - ALERT_QUEUE_SIZE + 1;
+    advance_head(q);
+  }
+  q.stats.pushed++;
+  return seq;
+}
+
+// ===================================================================
+// Delivery
+// ===================================================================
+
+void alert_queue_link(AlertQueue& q, bool up, uint32_t now_ms) {
+  q.link = up;
+  q.link_ms = now_ms;
+  q.in_flight = false;
+  q.attempts = 0;
+  q.retry_ms = now_ms;
+}
+
+void alert_queue_confirm(AlertQueue& q, uint32_t now_ms) {
+  if (!q.in_flight) return;
+  if (is_replay(q, slot(q, q.head))) q.stats.replayed++;
+  q.stats.delivered++;
+  retire_head(q, now_ms);
+}
+
+void alert_queue_failed(AlertQueue& q, uint32_t now_ms) {
+  if (!q.in_flight) return;
+  q.in_flight = false;
+  if (q.attempts >= ALERT_MAX_ATTEMPTS) {
+    q.stats.stalls++;
+  } else {
+    q.retry_ms = now_ms + ((uint32_t)ALERT_RETRY_MS << (q.attempts - 1));
+  }
+}
+
+void alert_queue_ack(AlertQueue& q, uint32_t seq, uint32_t now_ms) {
+  while (q.head != q.store->next_seq && (int32_t)(seq - q.head) >= 0) {
+    if (is_replay(q, slot(q, q.head))) q.stats.replayed++;
+    q.stats.delivered++;
+    retire_head(q, now_ms);
+  }
+}
+
+// {"seq":N,"replay":true,...}: the record with its seq spliced in
+static void send_head(AlertQueue& q, uint32_t now_ms) {
+  const AlertRecord& r = slot(q, q.head);
+  char buf[ALERT_SEND_MAX];
+  int n = snprintf(buf, sizeof(buf), "{\"seq\":%lu,%s%.*s", (unsigned long)r.seq,
+                   is_replay(q, r) ? "\"replay\":true," : "", r.len > 0 ? r.len - 1 : 0, r.json + 1);
+  if (!q.send(buf, (size_t)n, q.ctx)) {
+    q.retry_ms = now_ms + ALERT_RETRY_MS;
+    return;
+  }
+  q.stats.sends++;
+  if (q.attempts) q.stats.retries++;
+  q.attempts++;
+  q.in_flight = true;
+  q.sent_ms = now_ms;
+}
+
+void alert_queue_service(AlertQueue& q, uint32_t now_ms) {
+  // Stale transient alerts go unsent, whether or not anyone listens
+  while (!q.in_flight && q.head != q.store->next_seq) {
+    const AlertRecord& r = slot(q, q.head);
+    if (r.cls != ALERT_TRANSIENT || now_ms - r.t_ms <= ALERT_TRANSIENT_TTL_MS) break;
+    q.stats.expired++;
+    retire_head(q, now_ms);
+  }
+  
+  if (!q.link) return;
+  if (q.in_flight) {
+    if (now_ms - q.sent_ms < ALERT_ACK_TIMEOUT_MS) return;
+    alert_queue_failed(q, now_ms);
+  }
+  if (q.head == q.store->next_seq || q.attempts >= ALERT_MAX_ATTEMPTS) return;
+  if ((int32_t)(now_ms - q.retry_ms) < 0) return;
+  send_head(q, now_ms);
+}
+
+size_t alert_queue_pending(const AlertQueue& q) {
+  size_t n = 0;
+  for (uint32_t seq = q.head; seq != q.store->next_seq; seq++) {
+    if (pending(q, seq)) n++;
+  }
+  return n;
+}
+
+uint32_t alert_queue_next_seq(const AlertQueue& q) {
+  return q.store->next_seq;
+}
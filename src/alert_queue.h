@@ -0,0 +1,135 @@
+#ifndef ALERT_QUEUE_H
+#define ALERT_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================================
+// Reliable Alert Queue
+// ===================================================================
+// Every alert gets the next sequence number and a slot in a fixed ring
+// (slot = seq % ALERT_QUEUE_SIZE), whether or not a client is there to
+// hear it. Delivery is one alert at a time, oldest first: the head is
+// sent, and stays queued until the client confirms it, either by the
+// ATT confirmation of an indication or by an app-level ack
+// ({"ack":seq} on ALERTS, cumulative). Unconfirmed sends are retried
+// with doubling back-off up to ALERT_MAX_ATTEMPTS per connection; then
+// the queue waits for the next connection, which replays everything
+// still pending in order.
+//
+//   SAFETY     fall, SOS: kept until delivered; only a full ring of
+//              newer alerts overwrites one, and never a transient: a
+//              transient pushed when the oldest pending alert is a
+//              safety one and the ring is full is dropped instead
+//   TRANSIENT  obstacle, RFID: stale after ALERT_TRANSIENT_TTL_MS and
+//              dropped unsent, and never replayed after a reset
+//
+// The store is plain memory with no pointers: the firmware keeps it in
+// RTC memory that a reset does not clear. Each record carries its own
+// CRC, so a reset in the middle of a push costs at most that record;
+// alert_queue_open keeps every valid record and continues the sequence
+// from the highest one seen. Push is a fixed-size copy plus one record
+// CRC, O(1), and never waits on the radio.
+//
+// Not thread-safe: one task pushes, services and reports the link and
+// confirmations. Portable; tools/alert_queue_sim.cpp runs it on the
+// host against a lossy mock transport.
+// ===================================================================
+
+#define ALERT_QUEUE_SIZE        16     // Power of two
+#define ALERT_JSON_MAX          128    // Alert JSON as built by main.cpp
+#define ALERT_SEND_MAX          (ALERT_JSON_MAX + 32)   // Plus "seq" and "replay"
+#define ALERT_MAX_ATTEMPTS      5      // Per connection
+#define ALERT_ACK_TIMEOUT_MS    2000   // No confirmation by then: failed
+#define ALERT_RETRY_MS          250    // Back-off after the first failure, doubling
+#define ALERT_TRANSIENT_TTL_MS  3000
+
+#define ALERT_STORE_MAGIC       0x414C5131   // "ALQ1"
+
+enum AlertClass {
+  ALERT_SAFETY,
+  ALERT_TRANSIENT
+};
+
+#define ALERT_FLAG_DELIVERED  0x01   // Kept for its seq until overwritten
+#define ALERT_FLAG_RESTORED   0x02   // Queued before the last reset
+
+struct AlertRecord {
+  uint32_t seq;
+  uint32_t t_ms;
+  uint8_t cls;              // AlertClass
+  uint8_t flags;
+  uint16_t len;
+  uint32_t crc;             // Over the fields above and json[0, len)
+  char json[ALERT_JSON_MAX];
+};
+
+struct AlertStore {
+  uint32_t magic;
+  uint32_t next_seq;        // Also recovered from the records
+  uint32_t crc;             // Of the two fields above
+  AlertRecord slots[ALERT_QUEUE_SIZE];
+};
+
+// Hand one alert to the radio; false when there is no subscribed client
+typedef bool (*AlertSend)(const char* json, size_t len, void* ctx);
+
+struct AlertQueueStats {
+  uint32_t pushed;
+  uint32_t sends;           // Including retries
+  uint32_t retries;
+  uint32_t delivered;
+  uint32_t replayed;        // Delivered after a reconnect or reset
+  uint32_t stalls;          // Out of attempts on a connection
+  uint32_t overwritten;     // Undelivered, pushed out by a full ring
+  uint32_t dropped;         // Transient, refused by a ring full behind a safety alert
+  uint32_t expired;         // Transient, stale before delivery
+  uint32_t restored;        // Pending records that survived a reset
+  uint32_t corrupt;         // Records dropped at open for a bad CRC
+};
+
+struct AlertQueue {
+  AlertStore* store;
+  AlertSend send;
+  void* ctx;
+  uint32_t head;            // Oldest undelivered seq; == next_seq when empty
+  bool link;
+  uint32_t link_ms;
+  bool in_flight;           // The head was sent and is not confirmed
+  uint32_t sent_ms;
+  uint32_t retry_ms;        // Next send not before
+  uint8_t attempts;         // Of the head, this connection
+  AlertQueueStats stats;
+};
+
+// ===================================================================
+// Alert Queue Functions
+// ===================================================================
+
+// Adopt the store if it holds a queue from before a reset, otherwise
+// clear it. Returns the number of pending alerts restored.
+size_t alert_queue_open(AlertQueue& q, AlertStore* store, AlertSend send, void* ctx, uint32_t now_ms);
+
+// Queue one alert (a JSON object); returns its seq, or 0 for a dropped
+// transient. Longer JSON is cut to ALERT_JSON_MAX at the last member
+// that fits.
+uint32_t alert_queue_push(AlertQueue& q, const char* json, AlertClass cls, uint32_t now_ms);
+
+// A client subscribed (true) or went away. A new link restarts the
+// attempts and replays from the oldest pending alert.
+void alert_queue_link(AlertQueue& q, bool up, uint32_t now_ms);
+
+// The in-flight alert was confirmed (indication) or failed to go out
+void alert_queue_confirm(AlertQueue& q, uint32_t now_ms);
+void alert_queue_failed(AlertQueue& q, uint32_t now_ms);
+
+// App-level ack: every alert up to and including seq was received
+void alert_queue_ack(AlertQueue& q, uint32_t seq, uint32_t now_ms);
+
+// Sends, retries and expiry; call every loop pass
+void alert_queue_service(AlertQueue& q, uint32_t now_ms);
+
+size_t alert_queue_pending(const AlertQueue& q);
+uint32_t alert_queue_next_seq(const AlertQueue& q);
+
+#endif // ALERT_QUEUE_H
@@ -0,0 +1,141 @@
+#include "battery_model.h"
+#include <string.h>
+
+// Resting single-cell LiPo voltage (mV) at 0%, 5%, ... 100% charge
+static const uint16_t ocv_curve_mv[] = {
+  3270, 3610, 3690, 3710, 3730, 3750, 3770, 3790, 3800, 3820, 3840,
+  3850, 3870, 3910, 3950, 3980, 4020, 4080, 4110, 4150, 4200
+};
+#define OCV_CURVE_POINTS (sizeof(ocv_curve_mv) / sizeof(ocv_curve_mv[0]))
+#define OCV_CURVE_STEP_PCT 5.0f
+
+// ===================================================================
+// Oversampler
+// ===================================================================
+
+void battery_oversampler_reset(BatteryOversampler& os) {
+  memset(&os, 0, sizeof(os));
+}
+
+bool battery_oversampler_add(BatteryOversampler& os, uint16_t raw, uint16_t load_ma) {
+  if (os.count < BATTERY_OVERSAMPLE) {
+    os.raw_sum += raw;
+    os.load_sum += load_ma;
+    os.count++;
+  }
+  return os.count >= BATTERY_OVERSAMPLE;
+}
+
+uint32_t battery_oversampler_mean_q8(const BatteryOversampler& os) {
+  if (os.count == 0) return 0;
+  return ((os.raw_sum << 8) + os.count / 2) / os.count;
+}
+
+uint16_t battery_oversampler_load_ma(const BatteryOversampler& os) {
+  if (os.count == 0) return 0;
+  return (uint16_t)((os.load_sum + os.count / 2) / os.count);
+}
+
+// ===================================================================
+// Discharge Curve
+// ===================================================================
+
+float battery_soc_from_ocv(float ocv_mv) {
+  if (ocv_mv <= ocv_curve_mv[0]) return 0.0f;
+  if (ocv_mv >= ocv_curve_mv[OCV_CURVE_POINTS - 1]) return 100.0f;
+  
+  size_t i = 1;
+  while (ocv_mv > ocv_curve_mv[i]) i++;
+  
+  float lo = ocv_curve_mv[i - 1];
+  float hi = ocv_curve_mv[i];
+  return ((i - 1) + (ocv_mv - lo) / (hi - lo)) * OCV_CURVE_STEP_PCT;
+}
+
+// ===================================================================
+// Model
+// ===================================================================
+
+void battery_model_init(BatteryModel& model, uint16_t capacity_mah, uint16_t internal_mohm) {
+  memset(&model, 0, sizeof(model));
+  model.capacity_mah = capacity_mah;
+  model.internal_mohm = internal_mohm;
+  model.prev_window_soc_pct = -1;
+}
+
+static void update_drain(BatteryModel& model, uint32_t t_ms) {
+  model.window_soc_sum += model.soc_pct;
+  model.window_count++;
+  
+  uint32_t elapsed = t_ms - model.window_start_ms;
+  if (elapsed < BATTERY_DRAIN_WINDOW_MS) return;
+  
+  float mean_pct = model.window_soc_sum / model.window_count;
+  uint32_t mid_ms = model.window_start_ms + elapsed / 2;
+  
+  if (model.prev_window_soc_pct >= 0) {
+    float used_pct = model.prev_window_soc_pct - mean_pct;
+    float hours = (mid_ms - model.prev_window_mid_ms) / 3600000.0f;
+    if (-used_pct >= BATTERY_CHARGE_RISE_PCT) {
+      model.charging = true;
+      model.drain_pct_h = 0;
+    } else if (used_pct > 0 && hours > 0) {
+      float rate = used_pct / hours;
+      model.drain_pct_h = model.drain_pct_h > 0 ?
+                          BATTERY_DRAIN_ALPHA * rate + (1.0f - BATTERY_DRAIN_ALPHA) * model.drain_pct_h :
+                          rate;
+      model.charging = false;
+    }
+    // A flat pair of windows keeps the previous rate
+  }
+  
+  model.prev_window_soc_pct = mean_pct;
+  model.prev_window_mid_ms = mid_ms;
+  model.window_soc_sum = 0;
+  model.window_count = 0;
+  model.window_start_ms = t_ms;
+}
+
+static uint16_t clamp_runtime(float minutes) {
+  if (minutes < 0) return 0;
+  if (minutes >= BATTERY_RUNTIME_UNKNOWN) return BATTERY_RUNTIME_UNKNOWN - 1;
+  return (uint16_t)(minutes + 0.5f);
+}
+
+BatteryEstimate battery_model_update(BatteryModel& model, uint16_t cell_mv,
+                                     uint16_t load_ma, uint32_t t_ms) {
+  float ocv = cell_mv + (float)load_ma * model.internal_mohm / 1000.0f;
+  model.load_ma = load_ma;
+  
+  if (model.readings == 0) {
+    model.ocv_mv = ocv;
+    model.window_start_ms = t_ms;
+  } else {
+    model.ocv_mv = BATTERY_OCV_ALPHA * ocv + (1.0f - BATTERY_OCV_ALPHA) * model.ocv_mv;
+  }
+  model.soc_pct = battery_soc_from_ocv(model.ocv_mv);
+  update_drain(model, t_ms);
+  model.readings++;
+  
+  BatteryEstimate est;
+  est.cell_mv = cell_mv;
+  est.ocv_mv = (uint16_t)(model.ocv_mv + 0.5f);
+  est.percentage = (uint8_t)(model.soc_pct + 0.5f);
+  est.charging = model.charging;
+  
+  if (model.charging) {
+    est.runtime_min = BATTERY_RUNTIME_UNKNOWN;
+    est.runtime_source = BATTERY_RUNTIME_NONE;
+  } else if (model.drain_pct_h > 0) {
+    est.runtime_min = clamp_runtime(model.soc_pct / model.drain_pct_h * 60.0f);
+    est.runtime_source = BATTERY_RUNTIME_MEASURED;
+  } else if (model.load_ma > 0 && model.capacity_mah > 0) {
+    float remaining_mah = model.capacity_mah * model.soc_pct / 100.0f;
+    est.runtime_min = clamp_runtime(remaining_mah / model.load_ma * 60.0f);
+    est.runtime_source = BATTERY_RUNTIME_NOMINAL;
+  } else {
+    est.runtime_min = BATTERY_RUNTIME_UNKNOWN;
+    est.runtime_source = BATTERY_RUNTIME_NONE;
+  }
+  return est;
+}
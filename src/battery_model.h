@@ -0,0 +1,97 @@
+#ifndef BATTERY_MODEL_H
+#define BATTERY_MODEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================================
+// LiPo Battery Model
+// ===================================================================
+// Turns calibrated cell voltages into state of charge and remaining
+// runtime:
+//   1. Oversampler: one ADC conversion per call, averaged over
+//      BATTERY_OVERSAMPLE calls together with the load estimate at
+//      each conversion. Keeps the fractional LSBs.
+//   2. Load compensation: open-circuit voltage = terminal voltage +
+//      load current x internal resistance.
+//   3. State of charge from a piecewise-linear single-cell LiPo
+//      discharge curve (OCV at rest, 5% steps).
+//   4. Drain rate: change in mean SoC between consecutive
+//      BATTERY_DRAIN_WINDOW_MS windows, smoothed. Averaging a whole
+//      window matters on the flat middle of the curve, where 1% is
+//      only ~4 mV. Runtime = SoC / drain rate. Until two windows have
+//      been measured, runtime comes from capacity / estimated load.
+//
+// A rise of BATTERY_CHARGE_RISE_PCT between windows means the cell is on
+// the charger; runtime is unknown until it discharges again.
+// Portable, no heap.
+// ===================================================================
+
+#define BATTERY_OVERSAMPLE          64       // Conversions per reading
+#define BATTERY_OCV_ALPHA           0.25f    // EWMA on the compensated OCV
+#define BATTERY_DRAIN_WINDOW_MS     300000   // 5 min per drain-rate window
+#define BATTERY_DRAIN_ALPHA         0.3f     // EWMA on per-window rates
+#define BATTERY_CHARGE_RISE_PCT     2.0f
+
+#define BATTERY_RUNTIME_UNKNOWN     0xFFFF
+
+enum BatteryRuntimeSource {
+  BATTERY_RUNTIME_NONE,        // Charging or no reading yet
+  BATTERY_RUNTIME_NOMINAL,     // Capacity / estimated load
+  BATTERY_RUNTIME_MEASURED     // SoC / measured drain rate
+};
+
+struct BatteryOversampler {
+  uint32_t raw_sum;
+  uint32_t load_sum;
+  uint16_t count;
+};
+
+struct BatteryModel {
+  uint16_t capacity_mah;
+  uint16_t internal_mohm;
+  float ocv_mv;                // Filtered, load-compensated
+  float soc_pct;
+  float load_ma;               // Mean estimate over the last reading
+  float drain_pct_h;           // Smoothed; 0 = not measured yet
+  float window_soc_sum;        // Current drain window
+  uint16_t window_count;
+  uint32_t window_start_ms;
+  float prev_window_soc_pct;   // Mean SoC of the last full window; < 0 if none
+  uint32_t prev_window_mid_ms;
+  uint32_t readings;
+  bool charging;
+};
+
+struct BatteryEstimate {
+  uint16_t cell_mv;            // Terminal voltage of the last reading
+  uint16_t ocv_mv;
+  uint8_t percentage;
+  uint16_t runtime_min;        // BATTERY_RUNTIME_UNKNOWN when unknown
+  uint8_t runtime_source;      // BatteryRuntimeSource
+  bool charging;
+};
+
+// ===================================================================
+// Battery Model Functions
+// ===================================================================
+
+void battery_oversampler_reset(BatteryOversampler& os);
+
+// Adds one raw conversion; true once BATTERY_OVERSAMPLE are in
+bool battery_oversampler_add(BatteryOversampler& os, uint16_t raw, uint16_t load_ma);
+
+// Mean raw value in 1/256 LSB, and mean load in mA
+uint32_t battery_oversampler_mean_q8(const BatteryOversampler& os);
+uint16_t battery_oversampler_load_ma(const BatteryOversampler& os);
+
+// State of charge (0-100) of a resting cell at ocv_mv
+float battery_soc_from_ocv(float ocv_mv);
+
+void battery_model_init(BatteryModel& model, uint16_t capacity_mah, uint16_t internal_mohm);
+
+// One averaged reading: terminal voltage and the load it was taken under
+BatteryEstimate battery_model_update(BatteryModel& model, uint16_t cell_mv,
+                                     uint16_t load_ma, uint32_t t_ms);
+
+#endif // BATTERY_MODEL_H
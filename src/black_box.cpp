@@ -0,0 +1,332 @@
+#include "black_box.h"
+#include <string.h>
+
+#define RING_MASK (BLACK_BOX_MAX_CHUNKS - 1)
+
+static_assert((BLACK_BOX_MAX_CHUNKS & RING_MASK) == 0, "BLACK_BOX_MAX_CHUNKS must be a power of two");
+static_assert(sizeof(BlackBoxRecord) == 16, "BlackBoxRecord must stay 16 bytes");
+static_assert(sizeof(BlackBoxChunk) <= 512, "A chunk must fit one ATT read");
+static_assert(BLACK_BOX_EVENT_MAX_CHUNKS <= 255, "Event chunk count is a uint8_t");
+
+// Most of an event goes to the pre window; the rest is kept for post
+#define PRE_MAX_CHUNKS \
+  (BLACK_BOX_EVENT_MAX_CHUNKS - BLACK_BOX_EVENT_MAX_CHUNKS * BLACK_BOX_POST_MS / (BLACK_BOX_PRE_MS + BLACK_BOX_POST_MS))
+
+#define DT_ROLLOVER_MS 30000   // Keep every record's dt_ms inside int16
+
+// ===================================================================
+// Chunk Bookkeeping
+// ===================================================================
+
+static BlackBoxChunk& chunk_at(const BlackBox& box, uint16_t index) {
+  return box.pool[index];
+}
+
+static uint16_t ring_slot(const BlackBox& box, uint16_t n) {
+  return (box.ring_tail + n) & RING_MASK;
+}
+
+static uint16_t ring_newest(const BlackBox& box) {
+  return box.ring[ring_slot(box, box.ring_count - 1)];
+}
+
+static BlackBoxEvent* recording_event(BlackBox& box) {
+  for (int i = 0; i < BLACK_BOX_EVENT_SLOTS; i++) {
+    if (box.events[i].state.load(std::memory_order_relaxed) == BLACK_BOX_EVENT_RECORDING) {
+      return &box.events[i];
+    }
+  }
+  return nullptr;
+}
+
+static void free_event(BlackBox& box, BlackBoxEvent& ev) {
+  // Readers check the state after copying, so drop it before any chunk
+  // can be rewritten
+  ev.state.store(BLACK_BOX_EVENT_FREE, std::memory_order_release);
+  for (uint8_t i = 0; i < ev.count; i++) {
+    box.free_list[box.free_count++] = ev.chunks[i];
+  }
+  ev.count = 0;
+}
+
+// Oldest READY capture, if any
+static BlackBoxEvent* oldest_ready_event(BlackBox& box) {
+  BlackBoxEvent* oldest = nullptr;
+  for (int i = 0; i < BLACK_BOX_EVENT_SLOTS; i++) {
+    BlackBoxEvent& ev = box.events[i];
+    if (ev.state.load(std::memory_order_relaxed) != BLACK_BOX_EVENT_READY) continue;
+    if (!oldest || (int16_t)(ev.id - oldest->id) < 0) oldest = &ev;
+  }
+  return oldest;
+}
+
+// Starts a new chunk at the head of the ring: a free one if there is
+// one, otherwise the ring's oldest. Captures hold the rest of the pool;
+// the oldest is given up rather than stop recording.
+static bool start_chunk(BlackBox& box, uint32_t t_ms) {
+  if (box.free_count == 0 && box.ring_count == 0) {
+    BlackBoxEvent* ev = oldest_ready_event(box);
+    if (!ev) return false;
+    free_event(box, *ev);
+    box.stats.evicted++;
+  }
+  
+  uint16_t index;
+  if (box.free_count > 0) {
+    index = box.free_list[--box.free_count];
+  } else {
+    index = box.ring[box.ring_tail];
+    box.ring_tail = (box.ring_tail + 1) & RING_MASK;
+    box.ring_count--;
+  }
+  
+  BlackBoxChunk& chunk = chunk_at(box, index);
+  chunk.t0_ms = t_ms;
+  chunk.seq = box.next_seq++;
+  chunk.count = 0;
+  box.ring[ring_slot(box, box.ring_count)] = index;
+  box.ring_count++;
+  return true;
+}
+
+// The head chunk is done: it stays in the ring as history, or moves to
+// the capture whose post window is open
+static void finish_chunk(BlackBox& box, uint32_t t_ms) {
+  if (box.ring_count == 0) return;
+  BlackBoxEvent* ev = recording_event(box);
+  if (!ev) return;
+  
+  uint16_t index = ring_newest(box);
+  if (chunk_at(box, index).count > 0) {
+    box.ring_count--;
+    ev->chunks[ev->count++] = index;
+  }
+  if (ev->count >= BLACK_BOX_EVENT_MAX_CHUNKS || (int32_t)(t_ms - ev->end_ms) >= 0) {
+    ev->state.store(BLACK_BOX_EVENT_READY, std::memory_order_release);
+  }
+}
+
+static BlackBoxRecord* append(BlackBox& box, uint8_t type, uint32_t t_ms) {
+  if (box.ring_count > 0) {
+    BlackBoxChunk& head = chunk_at(box, ring_newest(box));
+    if (head.count < BLACK_BOX_CHUNK_RECORDS && (int32_t)(t_ms - head.t0_ms) < DT_ROLLOVER_MS) {
+      BlackBoxRecord& rec = head.records[head.count++];
+      rec.dt_ms = (int16_t)(t_ms - head.t0_ms);
+      rec.type = type;
+      box.stats.records++;
+      return &rec;
+    }
+    finish_chunk(box, t_ms);
+  }
+  
+  if (!box.pool || !start_chunk(box, t_ms)) {
+    box.stats.dropped++;
+    return nullptr;
+  }
+  BlackBoxChunk& head = chunk_at(box, ring_newest(box));
+  BlackBoxRecord& rec = head.records[head.count++];
+  rec.dt_ms = 0;
+  rec.type = type;
+  box.stats.records++;
+  return &rec;
+}
+
+// ===================================================================
+// Black Box Init
+// ===================================================================
+
+bool black_box_init(BlackBox& box, void* mem, size_t bytes) {
+  box.pool = nullptr;
+  box.pool_chunks = 0;
+  box.ring_tail = 0;
+  box.ring_count = 0;
+  box.free_count = 0;
+  box.next_seq = 0;
+  box.next_id = 0;
+  box.pending_trigger.store(BLACK_BOX_TRIGGER_NONE);
+  box.pending_release.store(0);
+  memset(&box.stats, 0, sizeof(box.stats));
+  for (int i = 0; i < BLACK_BOX_EVENT_SLOTS; i++) {
+    box.events[i].state.store(BLACK_BOX_EVENT_FREE);
+    box.events[i].count = 0;
+    box.events[i].id = 0;
+  }
+  
+  size_t chunks = mem ? bytes / sizeof(BlackBoxChunk) : 0;
+  if (chunks > BLACK_BOX_MAX_CHUNKS) chunks = BLACK_BOX_MAX_CHUNKS;
+  if (chunks < BLACK_BOX_EVENT_MAX_CHUNKS + 2) return false;
+  
+  box.pool = (BlackBoxChunk*)mem;
+  box.pool_chunks = chunks;
+  // Lowest index comes off the free list first
+  for (size_t i = 0; i < chunks; i++) {
+    box.free_list[i] = chunks - 1 - i;
+  }
+  box.free_count = chunks;
+  return true;
+}
+
+bool black_box_is_active(const BlackBox& box) {
+  return box.pool != nullptr;
+}
+
+// ===================================================================
+// Writer Side
+// ===================================================================
+
+void black_box_push_imu(BlackBox& box, const int16_t* raw6, uint32_t t_ms) {
+  BlackBoxRecord* rec = append(box, BLACK_BOX_RECORD_IMU, t_ms);
+  if (!rec) return;
+  rec->flags = 0;
+  memcpy(rec->v, raw6, sizeof(rec->v));
+}
+
+void black_box_push_tof(BlackBox& box, int16_t distance_mm, uint8_t zone, uint32_t t_ms) {
+  BlackBoxRecord* rec = append(box, BLACK_BOX_RECORD_TOF, t_ms);
+  if (!rec) return;
+  rec->flags = zone;
+  rec->v[0] = distance_mm;
+}
+
+void black_box_push_button(BlackBox& box, bool pressed, uint32_t t_ms) {
+  BlackBoxRecord* rec = append(box, BLACK_BOX_RECORD_BUTTON, t_ms);
+  if (!rec) return;
+  rec->flags = pressed ? 1 : 0;
+}
+
+// Freezes the newest chunks covering BLACK_BOX_PRE_MS into a capture.
+// A trigger while a capture's post window is still open extends that
+// capture instead. With every slot taken, the oldest capture goes.
+void black_box_trigger(BlackBox& box, BlackBoxTrigger trigger, uint32_t t_ms) {
+  if (!box.pool) return;
+  BlackBoxRecord* rec = append(box, BLACK_BOX_RECORD_TRIGGER, t_ms);
+  if (rec) rec->flags = trigger;
+  
+  BlackBoxEvent* ev = recording_event(box);
+  if (ev) {
+    ev->end_ms = t_ms + BLACK_BOX_POST_MS;
+    if (ev->triggers < 255) ev->triggers++;
+    box.stats.merged++;
+    return;
+  }
+  
+  for (int i = 0; i < BLACK_BOX_EVENT_SLOTS && !ev; i++) {
+    if (box.events[i].state.load(std::memory_order_relaxed) == BLACK_BOX_EVENT_FREE) ev = &box.events[i];
+  }
+  if (!ev) {
+    ev = oldest_ready_event(box);
+    free_event(box, *ev);
+    box.stats.evicted++;
+  }
+  
+  // Full chunks behind the head, newest first, until one starts before
+  // the pre window; the head itself joins when it completes
+  uint32_t pre_start = t_ms - BLACK_BOX_PRE_MS;
+  uint16_t taken = 0;
+  while (taken + 1 < box.ring_count && taken < PRE_MAX_CHUNKS) {
+    const BlackBoxChunk& chunk = chunk_at(box, box.ring[ring_slot(box, box.ring_count - 2 - taken)]);
+    taken++;
+    if ((int32_t)(chunk.t0_ms - pre_start) <= 0) break;
+  }
+  
+  uint16_t first = box.ring_count - 1 - taken;
+  for (uint16_t i = 0; i < taken; i++) {
+    ev->chunks[i] = box.ring[ring_slot(box, first + i)];
+  }
+  box.ring[ring_slot(box, first)] = ring_newest(box);
+  box.ring_count -= taken;
+  
+  if (++box.next_id == 0) box.next_id = 1;
+  ev->id = box.next_id;
+  ev->trigger = trigger;
+  ev->triggers = 1;
+  ev->count = taken;
+  ev->trigger_ms = t_ms;
+  ev->end_ms = t_ms + BLACK_BOX_POST_MS;
+  ev->state.store(BLACK_BOX_EVENT_RECORDING, std::memory_order_release);
+  box.stats.captures++;
+}
+
+void black_box_service(BlackBox& box, uint32_t t_ms) {
+  uint8_t trigger = box.pending_trigger.exchange(BLACK_BOX_TRIGGER_NONE);
+  if (trigger != BLACK_BOX_TRIGGER_NONE) black_box_trigger(box, (BlackBoxTrigger)trigger, t_ms);
+  
+  uint16_t release = box.pending_release.exchange(0);
+  if (release != 0) {
+    for (int i = 0; i < BLACK_BOX_EVENT_SLOTS; i++) {
+      BlackBoxEvent& ev = box.events[i];
+      if (ev.id == release && ev.state.load(std::memory_order_relaxed) == BLACK_BOX_EVENT_READY) {
+        free_event(box, ev);
+      }
+    }
+  }
+  
+  // Close the post window on time even if the head is part-filled
+  BlackBoxEvent* ev = recording_event(box);
+  if (ev && (int32_t)(t_ms - ev->end_ms) >= 0) {
+    finish_chunk(box, t_ms);
+    if (ev->state.load(std::memory_order_relaxed) == BLACK_BOX_EVENT_RECORDING) {
+      ev->state.store(BLACK_BOX_EVENT_READY, std::memory_order_release);
+    }
+    // The head went to the capture; the next append starts a new one
+  }
+}
+
+// ===================================================================
+// Any Task
+// ===================================================================
+
+void black_box_post_trigger(BlackBox& box, BlackBoxTrigger trigger) {
+  box.pending_trigger.store(trigger);
+}
+
+void black_box_post_release(BlackBox& box, uint16_t id) {
+  box.pending_release.store(id);
+}
+
+// ===================================================================
+// Reader Side
+// ===================================================================
+
+const BlackBoxEvent* black_box_find_event(const BlackBox& box, uint16_t id) {
+  for (int i = 0; i < BLACK_BOX_EVENT_SLOTS; i++) {
+    const BlackBoxEvent& ev = box.events[i];
+    if (ev.id == id && ev.state.load(std::memory_order_acquire) != BLACK_BOX_EVENT_FREE) return &ev;
+  }
+  return nullptr;
+}
+
+bool black_box_copy_chunk(BlackBox& box, uint16_t id, uint8_t index, BlackBoxChunk& out) {
+  for (int i = 0; i < BLACK_BOX_EVENT_SLOTS; i++) {
+    BlackBoxEvent& ev = box.events[i];
+    if (ev.state.load(std::memory_order_acquire) != BLACK_BOX_EVENT_READY || ev.id != id) continue;
+    if (index >= ev.count) return false;
+    
+    memcpy(&out, &chunk_at(box, ev.chunks[index]), sizeof(out));
+    
+    // Evicted while copying: the chunk may hold newer samples
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (ev.state.load(std::memory_order_relaxed) != BLACK_BOX_EVENT_READY || ev.id != id) {
+      box.stats.torn_reads++;
+      return false;
+    }
+    return true;
+  }
+  return false;
+}
+
+uint32_t black_box_history_ms(const BlackBox& box) {
+  if (box.ring_count == 0) return 0;
+  const BlackBoxChunk& oldest = chunk_at(box, box.ring[box.ring_tail]);
+  const BlackBoxChunk& newest = chunk_at(box, ring_newest(box));
+  int32_t last_dt = newest.count ? newest.records[newest.count - 1].dt_ms : 0;
+  return newest.t0_ms + last_dt - oldest.t0_ms;
+}
+
+const char* black_box_trigger_name(uint8_t trigger) {
+  switch (trigger) {
+    case BLACK_BOX_TRIGGER_FALL: return "fall";
+    case BLACK_BOX_TRIGGER_SOS:  return "sos";
+    default:                     return "none";
+  }
+}
@@ -0,0 +1,140 @@
+#ifndef BLACK_BOX_H
+#define BLACK_BOX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// ===================================================================
+// Black Box (pre/post-event raw sample capture)
+// ===================================================================
+// Every raw IMU sample, ToF range and button edge is appended to a
+// ring of fixed-size chunks in one pool allocated at boot (PSRAM when
+// the board has it). A chunk holds BLACK_BOX_CHUNK_RECORDS records of
+// 16 bytes and is the unit of both capture and download.
+//
+// Chunks are referenced by index, so nothing is ever copied:
+//   live ring   chunk indices oldest..newest; the newest is written
+//   free list   chunks nobody owns
+//   events      chunk indices frozen for one fall/SOS capture
+// A trigger moves the indices of the chunks covering the last
+// BLACK_BOX_PRE_MS out of the ring into a free event slot; the chunks
+// completed over the next BLACK_BOX_POST_MS go straight to the event
+// instead of back to the ring. The writer takes its next chunk from
+// the free list, or recycles the ring's oldest. Each append is one
+// 16-byte store; rollover and trigger are a few index moves.
+//
+// Single writer (the sensing task) does every mutation. Other tasks
+// may only read READY events (black_box_copy_chunk) and post
+// requests (trigger, release) that the writer applies in
+// black_box_service(). Portable; tools/black_box_bench.cpp
+// checks capture windows and times append and freeze.
+// ===================================================================
+
+#define BLACK_BOX_CHUNK_RECORDS     30     // 16 + 30 x 16 = 496 bytes: one ATT read
+#define BLACK_BOX_MAX_CHUNKS        512    // Pool index limit (power of two)
+#define BLACK_BOX_EVENT_SLOTS       4
+#define BLACK_BOX_EVENT_MAX_CHUNKS  80     // ~18 s at 100 Hz IMU + 30 Hz ToF
+#define BLACK_BOX_PRE_MS            10000
+#define BLACK_BOX_POST_MS           5000
+
+enum BlackBoxRecordType {
+  BLACK_BOX_RECORD_IMU,        // v[0..5] = ax ay az gx gy gz raw counts
+  BLACK_BOX_RECORD_TOF,        // v[0] = mm (-1 invalid), flags = zone
+  BLACK_BOX_RECORD_BUTTON,     // flags = 1 pressed, 0 released
+  BLACK_BOX_RECORD_TRIGGER     // flags = BlackBoxTrigger
+};
+
+enum BlackBoxTrigger {
+  BLACK_BOX_TRIGGER_NONE,
+  BLACK_BOX_TRIGGER_FALL,
+  BLACK_BOX_TRIGGER_SOS
+};
+
+enum BlackBoxEventState {
+  BLACK_BOX_EVENT_FREE,
+  BLACK_BOX_EVENT_RECORDING,   // Post window still filling
+  BLACK_BOX_EVENT_READY        // Complete, readable until released
+};
+
+struct BlackBoxRecord {
+  int16_t dt_ms;               // From the chunk's t0_ms (sources interleave)
+  uint8_t type;                // BlackBoxRecordType
+  uint8_t flags;
+  int16_t v[6];
+};
+
+struct BlackBoxChunk {
+  uint32_t t0_ms;
+  uint32_t seq;                // Chunk number since boot
+  uint16_t count;              // Records used
+  uint16_t reserved[3];
+  BlackBoxRecord records[BLACK_BOX_CHUNK_RECORDS];
+};
+
+struct BlackBoxEvent {
+  std::atomic<uint8_t> state;  // BlackBoxEventState
+  uint8_t trigger;             // BlackBoxTrigger
+  uint8_t triggers;            // Triggers folded into this capture
+  uint8_t count;               // Chunks owned
+  uint16_t id;                 // Capture number since boot (1-based)
+  uint32_t trigger_ms;
+  uint32_t end_ms;             // trigger_ms + BLACK_BOX_POST_MS
+  uint16_t chunks[BLACK_BOX_EVENT_MAX_CHUNKS];
+};
+
+struct BlackBoxStats {
+  uint32_t records;
+  uint32_t dropped;            // No chunk to write into
+  uint32_t captures;
+  uint32_t merged;             // Triggers inside an open capture
+  uint32_t evicted;            // Unreleased captures overwritten
+  uint32_t torn_reads;         // Download chunk recycled mid-copy
+};
+
+struct BlackBox {
+  BlackBoxChunk* pool;
+  uint16_t pool_chunks;
+  uint16_t ring[BLACK_BOX_MAX_CHUNKS];   // Circular, oldest at ring_tail
+  uint16_t ring_tail;
+  uint16_t ring_count;                   // Newest = the one being written
+  uint16_t free_list[BLACK_BOX_MAX_CHUNKS];
+  uint16_t free_count;
+  uint32_t next_seq;
+  uint16_t next_id;
+  BlackBoxEvent events[BLACK_BOX_EVENT_SLOTS];
+  std::atomic<uint8_t> pending_trigger;  // Posted by other tasks
+  std::atomic<uint16_t> pending_release; // Event id, 0 = none
+  BlackBoxStats stats;
+};
+
+// ===================================================================
+// Black Box Functions
+// ===================================================================
+
+// mem must stay valid; fails if it holds fewer than
+// BLACK_BOX_EVENT_MAX_CHUNKS + 2 chunks
+bool black_box_init(BlackBox& box, void* mem, size_t bytes);
+bool black_box_is_active(const BlackBox& box);
+
+// Writer side (one task)
+void black_box_push_imu(BlackBox& box, const int16_t* raw6, uint32_t t_ms);
+void black_box_push_tof(BlackBox& box, int16_t distance_mm, uint8_t zone, uint32_t t_ms);
+void black_box_push_button(BlackBox& box, bool pressed, uint32_t t_ms);
+void black_box_trigger(BlackBox& box, BlackBoxTrigger trigger, uint32_t t_ms);
+void black_box_service(BlackBox& box, uint32_t t_ms);   // Posted requests, post-window close
+
+// Any task
+void black_box_post_trigger(BlackBox& box, BlackBoxTrigger trigger);
+void black_box_post_release(BlackBox& box, uint16_t id);
+
+// Reader side: copies chunk `index` of READY event `id`. Returns false
+// if there is no such chunk or the event was evicted during the copy.
+bool black_box_copy_chunk(BlackBox& box, uint16_t id, uint8_t index, BlackBoxChunk& out);
+const BlackBoxEvent* black_box_find_event(const BlackBox& box, uint16_t id);
+
+// Span of the live ring in ms (how much pre-event history exists)
+uint32_t black_box_history_ms(const BlackBox& box);
+const char* black_box_trigger_name(uint8_t trigger);
+
+#endif // BLACK_BOX_H
@@ -1,6 +1,13 @@
 #include "ble.h"
 #include "config.h"
 #include "fall_detection.h"
+#include "sensing_task.h"
+#include "i2c_bus.h"
+#include "boot.h"
+#include "imu_features.h"
+#include "telemetry_batch.h"
+#include "conn_policy.h"
+#include "log.h"
 #include <ArduinoJson.h>
 
 // ===================================================================
@@ -12,23 +19,175 @@ NimBLECharacteristic* pSensorDataChar = nullptr;
 NimBLECharacteristic* pAlertsChar = nullptr;
 NimBLECharacteristic* pConfigChar = nullptr;
 NimBLECharacteristic* pCalibrationChar = nullptr;
+NimBLECharacteristic* pDiagChar = nullptr;
+NimBLECharacteristic* pBlackBoxChar = nullptr;
+NimBLECharacteristic* pJournalChar = nullptr;
 
 static bool deviceConnected = false;
 static bool oldDeviceConnected = false;
+static unsigned long disconnect_time = 0;
+
+// SENSOR_DATA format for this connection; every connection starts on JSON
+static volatile TelemetryEncoding sensor_encoding = TELEMETRY_ENCODING_JSON;
+
+// Binary frames are batched (telemetry_batch.h) and sent from loop();
+// the NimBLE callbacks only leave the new MTU or a reset for it
+static TelemetryBatch sensor_batch;
+static volatile uint16_t pending_mtu = 0;
+static volatile bool batch_reset_pending = false;
+static volatile uint8_t pending_imu_type = 0;   // TelemetryFrameType, 0 none
+
+// Link state of the current connection
+static uint16_t conn_handle = BLE_HS_CONN_HANDLE_NONE;
+static int dle_rc = -1;       // NimBLE return codes of the requests
+static int phy_rc = -1;
+
+// Connection parameters follow what the stick is doing (conn_policy.h);
+// requested and accounted from loop()
+static ConnPolicy conn_policy;
+static int conn_rc = -1;      // Last parameter update request
+
+// Alerts wait in a queue (alert_queue.h) that lives in RTC memory, so
+// a panic or watchdog reset keeps the undelivered ones; the callbacks
+// leave confirmations and acks for loop()
+static RTC_NOINIT_ATTR AlertStore alert_store;
+static AlertQueue alert_queue;
+static volatile uint8_t alert_status = 0;      // ALERT_STATUS_*
+static volatile bool alert_ack_pending = false;
+static volatile uint32_t alert_ack_seq = 0;
+
+#define ALERT_STATUS_CONFIRMED 1
+#define ALERT_STATUS_FAILED    2
+
+// Journal download (journal.h): the callbacks leave the command, loop()
+// reads the journal and sends
+static Journal* sync_journal = nullptr;
+static volatile uint8_t journal_cmd = 0;       // JOURNAL_CMD_*
+static volatile uint32_t journal_cmd_from = 0;
+static bool journal_syncing = false;
+static uint32_t journal_sync_off = 0;
+static uint32_t journal_sync_sent = 0;         // Notifications
+static uint32_t journal_sync_busy = 0;         // Bursts cut short by flow control
+
+#define JOURNAL_CMD_SYNC 1
+#define JOURNAL_CMD_STOP 2
+
+// Batch throughput, updated once a second by ble_update()
+struct LinkRates {
+  uint32_t at_ms;
+  TelemetryBatchStats at;
+  float imu_samples_s;
+  float notifications_s;
+  float bytes_s;
+};
+static LinkRates link_rates = {};
 
 // ===================================================================
 // Server Callbacks
 // ===================================================================
 
 class ServerCallbacks : public NimBLEServerCallbacks {
-  void onConnect(NimBLEServer* pServer) {
+  void onConnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) {
     deviceConnected = true;
-    Serial.println("BLE: Client connected");
+    sensor_encoding = TELEMETRY_ENCODING_JSON;
+    batch_reset_pending = true;
+    pending_imu_type = 0;
+    pending_mtu = TELEMETRY_BATCH_DEFAULT_MTU;
+    conn_handle = desc->conn_handle;
+    
+    // Longer link-layer PDUs and the 2M PHY carry a full batch in one
+    // short packet; both are requests the central may refuse
+    dle_rc = ble_gap_set_data_len(conn_handle, BLE_DLE_TX_OCTETS, BLE_DLE_TX_TIME_US);
+    phy_rc = ble_gap_set_prefered_le_phy(conn_handle, BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_2M_MASK,
+                                         BLE_GAP_LE_PHY_CODED_ANY);
+    LOG_INFO("BLE: Client connected (DLE rc=%d, 2M PHY rc=%d)", dle_rc, phy_rc);
   }
   
   void onDisconnect(NimBLEServer* pServer) {
     deviceConnected = false;
-    Serial.println("BLE: Client disconnected");
+    sensor_encoding = TELEMETRY_ENCODING_JSON;
+    sensing_set_imu_stream(false);
+    batch_reset_pending = true;
+    conn_handle = BLE_HS_CONN_HANDLE_NONE;
+    journal_cmd = JOURNAL_CMD_STOP;
+    LOG_INFO("BLE: Client disconnected");
+  }
+  
+  void onMTUChange(uint16_t MTU, ble_gap_conn_desc* desc) {
+    pending_mtu = MTU;
+    LOG_INFO("BLE: MTU %u", MTU);
+  }
+};
+
+// ===================================================================
+// Sensor Data Characteristic Callbacks
+// ===================================================================
+// {"format":"binary","version":N} switches this connection to binary
+// frames (telemetry_frame.h) of the newest version <= N;
+// {"format":"json"} switches back. The reply is notified on the same
+// characteristic before any frame in the new format. In binary,
+// "imu_stream":true also streams every raw IMU sample in IMU frames;
+// the reply says whether it started (it needs the 100 Hz FIFO).
+// "imu_codec":"delta" sends them as delta frames instead (keyframe +
+// varint deltas, about half the bytes); "raw" is the default.
+// ===================================================================
+
+class SensorDataCharCallbacks : public NimBLECharacteristicCallbacks {
+  void onWrite(NimBLECharacteristic* pCharacteristic) {
+    std::string value = pCharacteristic->getValue();
+    
+    StaticJsonDocument<64> doc;
+    if (deserializeJson(doc, value.c_str())) return;
+    
+    const char* format = doc["format"] | "json";
+    uint8_t version = doc["version"] | 0;
+    bool binary = strcmp(format, "binary") == 0 && version >= TELEMETRY_FRAME_VERSION;
+    bool stream = sensing_set_imu_stream(binary && (doc["imu_stream"] | false));
+    bool delta = strcmp(doc["imu_codec"] | "raw", "delta") == 0;
+    pending_imu_type = delta ? TELEMETRY_FRAME_IMU_DELTA : TELEMETRY_FRAME_IMU;
+    sensor_encoding = binary ? TELEMETRY_ENCODING_BINARY : TELEMETRY_ENCODING_JSON;
+    
+    // Straight out, ahead of anything still batched in the old format
+    char response[96];
+    size_t len = binary ?
+      snprintf(response, sizeof(response),
+               "{\"format\":\"binary\",\"version\":%d,\"imu_stream\":%s,\"imu_codec\":\"%s\"}",
+               TELEMETRY_FRAME_VERSION, stream ? "true" : "false", delta ? "delta" : "raw") :
+      snprintf(response, sizeof(response), "{\"format\":\"json\"}");
+    pCharacteristic->setValue((uint8_t*)response, len);
+    pCharacteristic->notify();
+    LOG_INFO("BLE: Sensor data format %s%s", binary ? "binary" : "json", stream ? " + IMU stream" : "");
+  }
+};
+
+// ===================================================================
+// Alerts Characteristic Callbacks
+// ===================================================================
+// Alerts go out as indications: a client subscribed to indications
+// confirms each one in the ATT layer. A client on notifications acks
+// by writing {"ack":seq}, which covers every alert up to seq. Either
+// way an unconfirmed alert is resent, so clients drop seqs they have
+// seen; gaps are transient alerts that went stale unsent.
+// ===================================================================
+
+class AlertsCharCallbacks : public NimBLECharacteristicCallbacks {
+  void onWrite(NimBLECharacteristic* pCharacteristic) {
+    std::string value = pCharacteristic->getValue();
+    
+    StaticJsonDocument<32> doc;
+    if (deserializeJson(doc, value.c_str()) || !doc["ack"].is<uint32_t>()) return;
+    uint32_t seq = doc["ack"];
+    if (!alert_ack_pending || (int32_t)(seq - alert_ack_seq) > 0) alert_ack_seq = seq;
+    alert_ack_pending = true;
+  }
+  
+  void onStatus(NimBLECharacteristic* pCharacteristic, Status s, int code) {
+    if (s == Status::SUCCESS_INDICATE) {
+      alert_status = ALERT_STATUS_CONFIRMED;
+    } else if (s == Status::ERROR_INDICATE_TIMEOUT || s == Status::ERROR_INDICATE_FAILURE ||
+               s == Status::ERROR_GATT) {
+      alert_status = ALERT_STATUS_FAILED;
+    }
   }
 };
 
@@ -41,14 +200,13 @@ class ConfigCharCallbacks : public NimBLECharacteristicCallbacks {
     std::string value = pCharacteristic->getValue();
     
     if (value.length() > 0) {
-      Serial.println("BLE: Received config write");
+      LOG_INFO("BLE: Received config write");
       
       StaticJsonDocument<256> doc;
       DeserializationError error = deserializeJson(doc, value.c_str());
       
       if (error) {
-        Serial.print("BLE: JSON parse error: ");
-        Serial.println(error.c_str());
+        LOG_WARN("BLE: JSON parse error: %s", error.c_str());
         
         const char* response = "{\"ok\":false,\"err\":\"Invalid JSON\"}";
         size_t len = strlen(response);
@@ -80,12 +238,13 @@ class ConfigCharCallbacks : public NimBLECharacteristicCallbacks {
       
       if (new_config.validate()) {
         g_config = new_config;
+        fall_detection_set_params(fall_params_from_config());
         
         if (doc.containsKey("ble_tx_power")) {
           ble_set_tx_power(g_config.ble_tx_power);
         }
         
-        Serial.println("BLE: Config updated successfully");
+        LOG_INFO("BLE: Config updated successfully");
         
         // Send success response with updated config
         StaticJsonDocument<256> responseDoc;
@@ -102,7 +261,7 @@ class ConfigCharCallbacks : public NimBLECharacteristicCallbacks {
         pCharacteristic->setValue((uint8_t*)response, len);
         pCharacteristic->notify();
       } else {
-        Serial.println("BLE: Config validation failed");
+        LOG_WARN("BLE: Config validation failed");
         const char* response = "{\"ok\":false,\"err\":\"Validation failed\"}";
         size_t len = strlen(response);
         pCharacteristic->setValue((uint8_t*)response, len);
@@ -115,20 +274,43 @@ class ConfigCharCallbacks : public NimBLECharacteristicCallbacks {
 // ===================================================================
 // Calibration Characteristic Callbacks
 // ===================================================================
+// "start"/"stop"/"status" run the single-shot calibration. Sessions:
+// "session" clears one, "trial" records a labelled trial ("fall" or
+// "adl"), "fit" sweeps the thresholds over all trials (in a background
+// task; ble_update() notifies the result) and "dump" prints the trace
+// as CSV on Serial.
+// ===================================================================
+
+static volatile bool calib_fit_pending = false;
+static bool calib_fit_running = false;
+
+static void calib_reply(NimBLECharacteristic* pCharacteristic, const char* status, bool ok) {
+  StaticJsonDocument<128> doc;
+  const CalibSession& session = fall_session_get();
+  doc["status"] = status;
+  doc["ok"] = ok;
+  doc["trials"] = session.trial_count;
+  doc["samples"] = session.used;
+  doc["capacity"] = session.capacity;
+  
+  char response[128];
+  size_t len = serializeJson(doc, response, sizeof(response));
+  pCharacteristic->setValue((uint8_t*)response, len);
+  pCharacteristic->notify();
+}
 
 class CalibrationCharCallbacks : public NimBLECharacteristicCallbacks {
   void onWrite(NimBLECharacteristic* pCharacteristic) {
     std::string value = pCharacteristic->getValue();
     
     if (value.length() > 0) {
-      Serial.println("BLE: Received calibration command");
+      LOG_INFO("BLE: Received calibration command");
       
       StaticJsonDocument<128> doc;
       DeserializationError error = deserializeJson(doc, value.c_str());
       
       if (error) {
-        Serial.print("BLE: Calibration JSON parse error: ");
-        Serial.println(error.c_str());
+        LOG_WARN("BLE: Calibration JSON parse error: %s", error.c_str());
         return;
       }
       
@@ -155,8 +337,519 @@ class CalibrationCharCallbacks : public NimBLECharacteristicCallbacks {
         else if (strcmp(cmd, "status") == 0) {
           ble_send_calibration_result();
         }
+        else if (strcmp(cmd, "session") == 0) {
+          calib_reply(pCharacteristic, "session", fall_session_begin());
+        }
+        else if (strcmp(cmd, "trial") == 0) {
+          const char* label = doc["label"] | "adl";
+          unsigned long duration = doc["duration_ms"] | 8000;
+          CalibLabel l = strcmp(label, "fall") == 0 ? CALIB_LABEL_FALL : CALIB_LABEL_ADL;
+          calib_reply(pCharacteristic, "recording", fall_session_trial_start(l, duration));
+        }
+        else if (strcmp(cmd, "fit") == 0) {
+          calib_fit_pending = true;
+        }
+        else if (strcmp(cmd, "dump") == 0) {
+          calib_reply(pCharacteristic, "dump", fall_session_dump_start());
+        }
+      }
+    }
+  }
+};
+
+// ===================================================================
+// Diagnostics Characteristic Callbacks
+// ===================================================================
+// JSON snapshot of scheduling and acquisition counters, one page at a
+// time.
+// ===================================================================
+
+static void add_i2c_queue(JsonObject obj, const I2CBusStats& stats, I2CPriority p) {
+  uint32_t started = stats.completed[p] + stats.failed[p] + stats.timeouts[p];
+  obj["n"] = stats.completed[p];
+  obj["fail"] = stats.failed[p];
+  obj["timeout"] = stats.timeouts[p];
+  obj["rejected"] = stats.rejected[p];
+  obj["wait_max_us"] = stats.max_wait_us[p];
+  obj["wait_mean_us"] = started ? (uint32_t)(stats.total_wait_us[p] / started) : 0;
+}
+
+static void add_jitter(JsonObject obj, const JitterStats& stats) {
+  obj["cycles"] = stats.cycles;
+  obj["late"] = stats.late_cycles;
+  obj["overruns"] = stats.overruns;
+  obj["max_late_us"] = stats.max_late_us;
+  obj["mean_late_us"] = stats.cycles ? (uint32_t)(stats.total_late_us / stats.cycles) : 0;
+}
+
+static void diag_page_sched(JsonObject doc) {
+  add_jitter(doc.createNestedObject("sensing"), sensing_task_get_jitter());
+  add_jitter(doc.createNestedObject("telemetry"), telemetry_task_get_jitter());
+  
+  SensingQueueStats queues = sensing_get_queue_stats();
+  JsonObject drop = doc.createNestedObject("dropped");
+  drop["samples"] = queues.dropped_samples;
+  drop["events"] = queues.dropped_events;
+}
+
+static void diag_page_acq(JsonObject doc) {
+  ImuFifoStats fifo = imu_fifo_get_stats();
+  JsonObject fifo_obj = doc.createNestedObject("imu_fifo");
+  fifo_obj["samples"] = fifo.samples;
+  fifo_obj["bursts"] = fifo.bursts;
+  fifo_obj["overflows"] = fifo.overflows;
+  fifo_obj["dropped"] = fifo.dropped;
+  
+  I2CBusStats bus = i2c_bus_get_stats();
+  JsonObject i2c_obj = doc.createNestedObject("i2c");
+  i2c_obj["util_pct"] = i2c_bus_utilization_pct();
+  add_i2c_queue(i2c_obj.createNestedObject("imu"), bus, I2C_PRIORITY_HIGH);
+  add_i2c_queue(i2c_obj.createNestedObject("tof"), bus, I2C_PRIORITY_NORMAL);
+}
+
+static void diag_page_tof(JsonObject doc) {
+  TofZoneScheduler zones = tof_zone_get_schedule();
+  JsonObject zone_obj = doc.createNestedObject("tof_zones");
+  zone_obj["active"] = tof_zone_scan_is_active();
+  zone_obj["sweeps"] = zones.stats.sweeps;
+  zone_obj["sweep_ms"] = zones.stats.last_sweep_ms;
+  zone_obj["max_sweep_ms"] = zones.stats.max_sweep_ms;
+  zone_obj["slow"] = zones.stats.slow_sweeps;
+  zone_obj["overhead_ms"] = zones.overhead_ms;
+  zone_obj["restart_ms"] = zones.restart_ms;
+  JsonArray budgets = zone_obj.createNestedArray("budget_ms");
+  for (int z = 0; z < TOF_ZONE_COUNT; z++) {
+    budgets.add(zones.budget_ms[z]);
+  }
+  
+  TofTrackStats track = sensing_get_tof_stats();
+  JsonObject track_obj = doc.createNestedObject("tof_track");
+  track_obj["alerts"] = track.alerts;
+  track_obj["outliers"] = track.outliers;
+  track_obj["suppressed"] = track.suppressed;
+}
+
+static void diag_page_rfid(JsonObject doc) {
+  RfidDetectStats rfid = rfid_get_detect_stats();
+  JsonObject rfid_obj = doc.createNestedObject("rfid");
+  rfid_obj["irq"] = rfid_irq_is_active();
+  rfid_obj["probes"] = rfid.probes;
+  rfid_obj["cards"] = rfid.cards;
+  rfid_obj["timeouts"] = rfid.timeouts;
+  rfid_obj["spi_rd"] = rfid.spi_reads;
+  rfid_obj["spi_wr"] = rfid.spi_writes;
+  rfid_obj["lat_max_ms"] = rfid.max_latency_ms;
+  rfid_obj["lat_mean_ms"] = rfid.cards ? rfid.total_latency_ms / rfid.cards : 0;
+}
+
+static void diag_page_boot(JsonObject doc) {
+  // Boot timeline in microseconds since app start; null = not reached
+  JsonObject boot_obj = doc.createNestedObject("boot_us");
+  for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+    BootPhase phase = (BootPhase)i;
+    if (boot_phase_reached(phase)) {
+      boot_obj[boot_phase_name(phase)] = boot_phase_us(phase);
+    } else {
+      boot_obj[boot_phase_name(phase)] = nullptr;
+    }
+  }
+}
+
+static void add_features(JsonObject obj, const ImuFeatures& f) {
+  obj["n"] = f.samples;
+  obj["mean"] = round(f.mean_g * 1000) / 1000.0;
+  obj["std"] = round(f.std_g * 1000) / 1000.0;
+  obj["min"] = round(f.min_g * 1000) / 1000.0;
+  obj["max"] = round(f.max_g * 1000) / 1000.0;
+  obj["jerk"] = round(f.jerk_mean_g_s * 10) / 10.0;
+  obj["jerk_max"] = round(f.jerk_max_g_s * 10) / 10.0;
+  obj["sma"] = round(f.sma_g * 1000) / 1000.0;
+  obj["tilt"] = round(f.tilt_deg * 10) / 10.0;
+}
+
+static void diag_page_imu(JsonObject doc) {
+  add_features(doc.createNestedObject("short"), imu_features_get(IMU_FEATURES_SHORT));
+  add_features(doc.createNestedObject("long"), imu_features_get(IMU_FEATURES_LONG));
+}
+
+static void diag_page_fall(JsonObject doc) {
+  FallClassifierStats stats = fall_detection_classifier_stats();
+  doc["classifier"] = stats.name;
+  doc["inferences"] = stats.inferences;
+  doc["alerts"] = stats.alerts;
+  doc["over_budget"] = stats.over_budget;
+  doc["cycles"] = stats.last_cycles;
+  doc["max_cycles"] = stats.max_cycles;
+  doc["score"] = stats.last_score;
+  doc["threshold"] = stats.threshold;
+}
+
+static void diag_page_ahrs(JsonObject doc) {
+  AhrsState ahrs = sensing_get_ahrs();
+  AhrsSignals pose = ahrs_signals(ahrs, millis());
+  float pitch, roll;
+  ahrs_pitch_roll(ahrs, pitch, roll);
+  doc["filter"] = ahrs.algorithm == AHRS_MAHONY ? "mahony" : "madgwick";
+  doc["updates"] = ahrs.samples;
+  JsonArray q = doc.createNestedArray("q");
+  q.add(round(ahrs.q0 * 10000) / 10000.0);
+  q.add(round(ahrs.q1 * 10000) / 10000.0);
+  q.add(round(ahrs.q2 * 10000) / 10000.0);
+  q.add(round(ahrs.q3 * 10000) / 10000.0);
+  doc["pitch"] = round(pitch * 10) / 10.0;
+  doc["roll"] = round(roll * 10) / 10.0;
+  doc["tilt"] = round(ahrs_tilt_deg(ahrs) * 10) / 10.0;
+  doc["flat"] = pose.flat;
+  doc["upright"] = pose.upright;
+  doc["rapid"] = pose.rapid;
+  doc["peak_dps"] = (uint16_t)ahrs.peak_dps;
+}
+
+static void diag_page_gait(JsonObject doc) {
+  GaitState gait = sensing_get_gait();
+  GaitSummary s = gait_summary(gait, millis());
+  doc["steps"] = s.steps;
+  doc["plants"] = s.plants;
+  doc["cad"] = s.cadence_spm;
+  doc["stride_ms"] = s.stride_ms;
+  doc["cv"] = round(s.stride_cv * 1000) / 1000.0;
+  doc["bouts"] = s.bouts;
+  doc["walk_s"] = s.walking_s;
+  doc["walking"] = s.walking;
+  doc["bout_steps"] = s.bout_steps;
+  doc["longest"] = s.longest_bout_steps;
+  doc["thr_mg"] = gait_threshold_mg(gait);
+  doc["rejected"] = gait.rejected;
+}
+
+static void diag_page_bbox(JsonObject doc) {
+  const BlackBox& box = sensing_get_black_box();
+  doc["active"] = black_box_is_active(box);
+  doc["kb"] = (uint32_t)box.pool_chunks * sizeof(BlackBoxChunk) / 1024;
+  doc["history_s"] = round(black_box_history_ms(box) / 100.0) / 10.0;
+  doc["records"] = box.stats.records;
+  doc["dropped"] = box.stats.dropped;
+  doc["captures"] = box.stats.captures;
+  doc["merged"] = box.stats.merged;
+  doc["evicted"] = box.stats.evicted;
+  doc["torn"] = box.stats.torn_reads;
+}
+
+static void diag_page_power(JsonObject doc) {
+  BatteryModel model = battery_get_model();
+  JsonObject bat_obj = doc.createNestedObject("battery");
+  bat_obj["adc_cal"] = battery_adc_cal_source();
+  bat_obj["readings"] = model.readings;
+  bat_obj["ocv_mv"] = (uint16_t)model.ocv_mv;
+  bat_obj["soc_pct"] = round(model.soc_pct * 10) / 10.0;
+  bat_obj["load_ma"] = (uint16_t)model.load_ma;
+  bat_obj["drain_pct_h"] = round(model.drain_pct_h * 100) / 100.0;
+  bat_obj["charging"] = model.charging;
+}
+
+static void diag_page_conn(JsonObject doc) {
+  const ConnPolicy& p = conn_policy;
+  doc["mode"] = conn_mode_name(p.mode);
+  doc["itvl_ms"] = p.itvl * 1.25;
+  doc["latency"] = p.latency;
+  doc["timeout_ms"] = p.timeout * 10;
+  doc["applied"] = p.applied;
+  doc["requests"] = p.requests;
+  doc["retries"] = p.retries;
+  doc["rc"] = conn_rc;
+  for (int m = 0; m < CONN_MODE_COUNT; m++) {
+    const ConnModeStats& s = p.stats[m];
+    JsonObject obj = doc.createNestedObject(conn_mode_name((ConnMode)m));
+    obj["n"] = s.entries;
+    obj["s"] = s.time_ms / 1000;
+    obj["events"] = s.events;
+    obj["notify"] = s.notifications;
+    obj["radio_ms"] = (uint32_t)(s.radio_us / 1000);
+    obj["radio_pct"] = s.time_ms ? round(s.radio_us / (s.time_ms * 10.0) * 100) / 100.0 : 0;
+  }
+}
+
+static void diag_page_link(JsonObject doc) {
+  doc["mtu"] = sensor_batch.payload + 3;
+  uint8_t tx_phy = 0, rx_phy = 0;
+  if (deviceConnected && ble_gap_read_le_phy(conn_handle, &tx_phy, &rx_phy) == 0) {
+    doc["phy_tx"] = tx_phy;
+    doc["phy_rx"] = rx_phy;
+  }
+  doc["dle_rc"] = dle_rc;
+  doc["phy_rc"] = phy_rc;
+  doc["imu_stream"] = sensing_imu_stream_enabled();
+  doc["imu_codec"] = sensor_batch.imu_type == TELEMETRY_FRAME_IMU_DELTA ? "delta" : "raw";
+  doc["imu_per_s"] = round(link_rates.imu_samples_s * 10) / 10.0;
+  doc["notify_per_s"] = round(link_rates.notifications_s * 10) / 10.0;
+  doc["bytes_per_s"] = (uint32_t)link_rates.bytes_s;
+  
+  const TelemetryBatchStats& b = sensor_batch.stats;
+  doc["notifications"] = b.notifications;
+  doc["frames"] = b.frames;
+  doc["full"] = b.full_flushes;
+  doc["deadline"] = b.deadline_flushes;
+  doc["oversize"] = b.oversize;
+  doc["stream_dropped"] = sensing_get_queue_stats().dropped_stream;
+}
+
+static void diag_page_alerts(JsonObject doc) {
+  const AlertQueue& q = alert_queue;
+  doc["next_seq"] = alert_queue_next_seq(q);
+  doc["pending"] = alert_queue_pending(q);
+  doc["link"] = q.link;
+  doc["in_flight"] = q.in_flight;
+  doc["attempts"] = q.attempts;
+  
+  const AlertQueueStats& s = q.stats;
+  doc["pushed"] = s.pushed;
+  doc["sends"] = s.sends;
+  doc["retries"] = s.retries;
+  doc["delivered"] = s.delivered;
+  doc["replayed"] = s.replayed;
+  doc["stalls"] = s.stalls;
+  doc["overwritten"] = s.overwritten;
+  doc["dropped"] = s.dropped;
+  doc["expired"] = s.expired;
+  doc["restored"] = s.restored;
+  doc["corrupt"] = s.corrupt;
+}
+
+static void diag_page_log(JsonObject doc) {
+  LogStats s = log_get_stats();
+  doc["written"] = s.written;
+  doc["drained"] = s.drained;
+  doc["dropped"] = s.dropped;
+  doc["truncated"] = s.truncated;
+  doc["high_water"] = s.high_water;
+  doc["slots"] = LOG_RING_SLOTS;
+  doc["level"] = LOG_LEVEL;
+}
+
+// One page per read keeps each value under the 512-byte ATT limit.
+// Write {"page":"<name>"} to choose the page the next read returns.
+struct DiagPage {
+  const char* name;
+  void (*fill)(JsonObject doc);
+};
+
+static const DiagPage diag_pages[] = {
+  {"sched", diag_page_sched},
+  {"acq",   diag_page_acq},
+  {"tof",   diag_page_tof},
+  {"rfid",  diag_page_rfid},
+  {"boot",  diag_page_boot},
+  {"power", diag_page_power},
+  {"imu",   diag_page_imu},
+  {"fall",  diag_page_fall},
+  {"ahrs",  diag_page_ahrs},
+  {"bbox",  diag_page_bbox},
+  {"gait",  diag_page_gait},
+  {"link",  diag_page_link},
+  {"conn",  diag_page_conn},
+  {"alerts", diag_page_alerts},
+  {"log",   diag_page_log}
+};
+
+#define DIAG_PAGE_COUNT (sizeof(diag_pages) / sizeof(diag_pages[0]))
+
+static volatile uint8_t diag_page = 0;
+
+class DiagCharCallbacks : public NimBLECharacteristicCallbacks {
+  void onWrite(NimBLECharacteristic* pCharacteristic) {
+    std::string value = pCharacteristic->getValue();
+    
+    StaticJsonDocument<64> doc;
+    if (deserializeJson(doc, value.c_str())) return;
+    
+    const char* page = doc["page"];
+    if (!page) return;
+    
+    for (uint8_t i = 0; i < DIAG_PAGE_COUNT; i++) {
+      if (strcmp(page, diag_pages[i].name) == 0) {
+        diag_page = i;
+        return;
+      }
+    }
+  }
+  
+  void onRead(NimBLECharacteristic* pCharacteristic) {
+    // Static: this runs on the NimBLE host task's small stack
+    static StaticJsonDocument<768> doc;
+    doc.clear();
+    
+    const DiagPage& page = diag_pages[diag_page];
+    doc["page"] = page.name;
+    page.fill(doc.as<JsonObject>());
+    
+    static char json[BLE_ATT_ATTR_MAX_LEN];
+    size_t len = serializeJson(doc, json, sizeof(json));
+    pCharacteristic->setValue((uint8_t*)json, len);
+  }
+};
+
+// ===================================================================
+// Black Box Characteristic Callbacks
+// ===================================================================
+// Download of fall/SOS captures (black_box.h). Write a command, then
+// read:
+//   {"cmd":"list"}                    JSON list of captures (default)
+//   {"cmd":"get","id":N,"chunk":K}    each read returns one chunk of
+//                                     capture N, starting at K
+//   {"cmd":"release","id":N}          free capture N once it is saved
+// A chunk read is a 4-byte header (id u16, chunk u8, chunk count u8,
+// little-endian) followed by the BlackBoxChunk as stored. After the
+// last chunk the header comes alone with chunk == count; count 0
+// means the capture is gone. Re-send "get" to retry a chunk.
+// ===================================================================
+
+#define BLACK_BOX_FRAME_HEADER 4
+
+static volatile bool bbox_listing = true;
+static volatile uint16_t bbox_id = 0;
+static volatile uint8_t bbox_chunk = 0;
+
+static void bbox_fill_list(JsonObject doc) {
+  const BlackBox& box = sensing_get_black_box();
+  doc["history_s"] = round(black_box_history_ms(box) / 100.0) / 10.0;
+  doc["pre_ms"] = BLACK_BOX_PRE_MS;
+  doc["post_ms"] = BLACK_BOX_POST_MS;
+  JsonArray list = doc.createNestedArray("captures");
+  for (int i = 0; i < BLACK_BOX_EVENT_SLOTS; i++) {
+    const BlackBoxEvent& ev = box.events[i];
+    uint8_t state = ev.state.load();
+    if (state == BLACK_BOX_EVENT_FREE) continue;
+    JsonObject obj = list.createNestedObject();
+    obj["id"] = ev.id;
+    obj["trigger"] = black_box_trigger_name(ev.trigger);
+    obj["t_ms"] = ev.trigger_ms;
+    obj["chunks"] = ev.count;
+    obj["ready"] = state == BLACK_BOX_EVENT_READY;
+  }
+}
+
+class BlackBoxCharCallbacks : public NimBLECharacteristicCallbacks {
+  void onWrite(NimBLECharacteristic* pCharacteristic) {
+    std::string value = pCharacteristic->getValue();
+    
+    StaticJsonDocument<96> doc;
+    if (deserializeJson(doc, value.c_str())) return;
+    
+    const char* cmd = doc["cmd"] | "list";
+    uint16_t id = doc["id"] | 0;
+    if (strcmp(cmd, "get") == 0) {
+      bbox_id = id;
+      bbox_chunk = doc["chunk"] | 0;
+      bbox_listing = false;
+    } else if (strcmp(cmd, "release") == 0) {
+      black_box_post_release(sensing_get_black_box(), id);
+      bbox_listing = true;
+    } else {
+      bbox_listing = true;
+    }
+  }
+  
+  void onRead(NimBLECharacteristic* pCharacteristic) {
+    // Static: this runs on the NimBLE host task's small stack
+    alignas(4) static uint8_t frame[BLACK_BOX_FRAME_HEADER + sizeof(BlackBoxChunk)];
+    
+    if (bbox_listing) {
+      static StaticJsonDocument<512> doc;
+      doc.clear();
+      bbox_fill_list(doc.to<JsonObject>());
+      size_t len = serializeJson(doc, (char*)frame, sizeof(frame));
+      pCharacteristic->setValue(frame, len);
+      return;
+    }
+    
+    BlackBox& box = sensing_get_black_box();
+    const BlackBoxEvent* ev = black_box_find_event(box, bbox_id);
+    uint8_t count = (ev && ev->state.load() == BLACK_BOX_EVENT_READY) ? ev->count : 0;
+    uint8_t index = bbox_chunk;
+    frame[0] = bbox_id & 0xFF;
+    frame[1] = bbox_id >> 8;
+    frame[2] = index;
+    frame[3] = count;
+    
+    size_t len = BLACK_BOX_FRAME_HEADER;
+    if (index < count) {
+      if (black_box_copy_chunk(box, bbox_id, index, *(BlackBoxChunk*)(frame + BLACK_BOX_FRAME_HEADER))) {
+        len += sizeof(BlackBoxChunk);
+        bbox_chunk = index + 1;
+      } else {
+        frame[3] = 0;
       }
     }
+    pCharacteristic->setValue(frame, len);
+  }
+};
+
+// ===================================================================
+// Journal Characteristic Callbacks
+// ===================================================================
+// Download of the telemetry journal (journal.h) by log offset. Read
+// for its extent and counters as JSON; write a command:
+//   {"cmd":"sync","from":N}   notify the log from offset N to the head
+//   {"cmd":"stop"}
+// Each notification is the u32 log offset of its first byte
+// (little-endian) and up to MTU - 7 log bytes; records run on across
+// notifications. The offset jumps forward when the ring has overwritten
+// what was asked for. A notification with the offset alone is the head
+// and ends the sync. After a disconnect, sync from the end of the
+// bytes received without a gap.
+// ===================================================================
+
+#define JOURNAL_SYNC_HEADER 4
+#define JOURNAL_SYNC_BURST  8   // Notifications per ble_update() at most
+
+class JournalCharCallbacks : public NimBLECharacteristicCallbacks {
+  void onWrite(NimBLECharacteristic* pCharacteristic) {
+    std::string value = pCharacteristic->getValue();
+    
+    StaticJsonDocument<64> doc;
+    if (deserializeJson(doc, value.c_str())) return;
+    
+    const char* cmd = doc["cmd"] | "";
+    if (strcmp(cmd, "sync") == 0) {
+      journal_cmd_from = doc["from"].as<uint32_t>();
+      journal_cmd = JOURNAL_CMD_SYNC;
+    } else if (strcmp(cmd, "stop") == 0) {
+      journal_cmd = JOURNAL_CMD_STOP;
+    }
+  }
+  
+  void onRead(NimBLECharacteristic* pCharacteristic) {
+    // Static: this runs on the NimBLE host task's small stack
+    static StaticJsonDocument<512> doc;
+    doc.clear();
+    
+    const Journal* j = sync_journal;
+    doc["mounted"] = j && j->mounted;
+    if (j && j->mounted) {
+      doc["tail"] = journal_tail(*j);
+      doc["head"] = journal_head(*j);
+      doc["segments"] = j->segments;
+      doc["buffered"] = j->buf_len;
+      
+      const JournalStats& s = j->stats;
+      doc["records"] = s.records;
+      doc["payload_bytes"] = s.payload_bytes;
+      doc["flash_bytes"] = s.flash_bytes;
+      doc["flushes"] = s.flushes;
+      doc["erases"] = s.erases;
+      doc["overwritten"] = s.overwritten;
+      doc["torn"] = s.torn;
+      doc["errors"] = s.errors;
+      doc["rejected"] = s.rejected;
+    }
+    doc["syncing"] = journal_syncing;
+    doc["sync_off"] = journal_sync_off;
+    doc["sent"] = journal_sync_sent;
+    doc["busy"] = journal_sync_busy;
+    
+    static char json[BLE_ATT_ATTR_MAX_LEN];
+    size_t len = serializeJson(doc, json, sizeof(json));
+    pCharacteristic->setValue((uint8_t*)json, len);
   }
 };
 
@@ -191,8 +884,45 @@ void ble_send_calibration_result() {
   pCalibrationChar->setValue((uint8_t*)json, len);
   pCalibrationChar->notify();
   
-  Serial.print("BLE Calibration: ");
-  Serial.println(json);
+  LOG_DEBUG("BLE Calibration: %s", json);
+}
+
+// Session fit: thresholds to apply through the config characteristic,
+// with how well they separated the trials
+static void ble_send_calibration_fit(const CalibFit& fit, bool ok) {
+  if (!pCalibrationChar) return;
+  
+  StaticJsonDocument<512> doc;
+  doc["status"] = "fit";
+  doc["ok"] = ok;
+  if (!ok) {
+    doc["err"] = fit.error;
+  } else {
+    doc["fall_ax_threshold"] = fit.fall_ax_threshold;
+    doc["fall_motion_threshold"] = fit.fall_motion_threshold;
+    doc["fall_stillness_ms"] = fit.fall_stillness_ms;
+    doc["falls"] = fit.falls;
+    doc["adls"] = fit.adls;
+    doc["tpr"] = fit.tpr;
+    doc["fpr"] = fit.fpr;
+    doc["youden"] = fit.youden;
+    doc["auc"] = fit.auc;
+    doc["robustness"] = fit.robustness;
+    doc["clearance"] = fit.clearance;
+    doc["confidence"] = calib_confidence_name(fit.confidence);
+    JsonObject margins = doc.createNestedObject("margins");
+    margins["fall_peak_min_g"] = fit.fall_peak_min_g;
+    margins["adl_peak_max_g"] = fit.adl_peak_max_g;
+    margins["fall_run_min_ms"] = fit.fall_run_min_ms;
+    margins["adl_run_max_ms"] = fit.adl_run_max_ms;
+  }
+  
+  char json[512];
+  size_t len = serializeJson(doc, json, sizeof(json));
+  pCalibrationChar->setValue((uint8_t*)json, len);
+  pCalibrationChar->notify();
+  
+  LOG_DEBUG("BLE Calibration: %s", json);
 }
 
 // ===================================================================
@@ -215,15 +945,163 @@ static void ble_sync_config() {
   pConfigChar->setValue((uint8_t*)json, len);
 }
 
+// ===================================================================
+// Sensor Data Batch
+// ===================================================================
+
+static void notify_batch(const uint8_t* data, size_t len, void* ctx) {
+  if (deviceConnected && pSensorDataChar->getSubscribedCount() > 0) {
+    pSensorDataChar->setValue(data, len);
+    pSensorDataChar->notify();
+  }
+}
+
+// ===================================================================
+// Alert Transport
+// ===================================================================
+
+static bool indicate_alert(const char* json, size_t len, void* ctx) {
+  if (!deviceConnected || pAlertsChar->getSubscribedCount() == 0) return false;
+  pAlertsChar->setValue((uint8_t*)json, len);
+  pAlertsChar->indicate();
+  LOG_INFO("BLE Alert: %s", json);
+  return true;
+}
+
+// Confirmations and acks from the callbacks, then sends and retries.
+// The queue's link is a subscribed client, not just a connection.
+static void service_alerts(unsigned long now) {
+  bool link = deviceConnected && pAlertsChar->getSubscribedCount() > 0;
+  if (link != alert_queue.link) {
+    alert_status = 0;
+    alert_queue_link(alert_queue, link, now);
+  }
+  
+  uint8_t status = alert_status;
+  alert_status = 0;
+  if (status == ALERT_STATUS_CONFIRMED) alert_queue_confirm(alert_queue, now);
+  if (status == ALERT_STATUS_FAILED) alert_queue_failed(alert_queue, now);
+  if (alert_ack_pending) {
+    alert_ack_pending = false;
+    alert_queue_ack(alert_queue, alert_ack_seq, now);
+  }
+  alert_queue_service(alert_queue, now);
+}
+
+// ===================================================================
+// Journal Sync
+// ===================================================================
+
+// A burst of journal notifications from the sync offset. They go
+// through the NimBLE host directly: when its buffers are full the
+// burst stops and the same offset goes on the next call.
+static void service_journal_sync() {
+  uint8_t cmd = journal_cmd;
+  journal_cmd = 0;
+  if (cmd == JOURNAL_CMD_STOP) journal_syncing = false;
+  if (cmd == JOURNAL_CMD_SYNC && sync_journal) {
+    journal_sync_off = journal_cmd_from;
+    journal_syncing = true;
+  }
+  if (!journal_syncing) return;
+  if (!deviceConnected || pJournalChar->getSubscribedCount() == 0) {
+    journal_syncing = false;
+    return;
+  }
+  
+  static uint8_t frame[BLE_PREFERRED_MTU - 3];
+  uint16_t mtu = ble_att_mtu(conn_handle);
+  if (mtu < BLE_ATT_MTU_DFLT) mtu = BLE_ATT_MTU_DFLT;
+  size_t room = mtu - 3;
+  if (room > sizeof(frame)) room = sizeof(frame);
+  room -= JOURNAL_SYNC_HEADER;
+  
+  for (int i = 0; i < JOURNAL_SYNC_BURST; i++) {
+    uint32_t off = journal_sync_off;
+    size_t n = journal_read(*sync_journal, off, frame + JOURNAL_SYNC_HEADER, room);
+    frame[0] = off & 0xFF;
+    frame[1] = (off >> 8) & 0xFF;
+    frame[2] = (off >> 16) & 0xFF;
+    frame[3] = off >> 24;
+    
+    // The host consumes the mbuf whether or not the notify is queued
+    os_mbuf* om = ble_hs_mbuf_from_flat(frame, JOURNAL_SYNC_HEADER + n);
+    if (!om || ble_gatts_notify_custom(conn_handle, pJournalChar->getHandle(), om) != 0) {
+      journal_sync_busy++;
+      return;
+    }
+    journal_sync_sent++;
+    journal_sync_off = off + n;
+    if (n == 0) {
+      journal_syncing = false;
+      return;
+    }
+  }
+}
+
+// Once a second: batch rates, and the live link and its traffic for
+// the connection policy's accounting
+static void update_link_rates(unsigned long now) {
+  uint32_t elapsed = now - link_rates.at_ms;
+  if (elapsed < 1000) return;
+  
+  const TelemetryBatchStats& s = sensor_batch.stats;
+  uint32_t notifications = s.notifications - link_rates.at.notifications;
+  uint32_t bytes = s.bytes - link_rates.at.bytes;
+  float scale = 1000.0f / elapsed;
+  link_rates.imu_samples_s = (s.imu_samples - link_rates.at.imu_samples) * scale;
+  link_rates.notifications_s = notifications * scale;
+  link_rates.bytes_s = bytes * scale;
+  link_rates.at = s;
+  link_rates.at_ms = now;
+  
+  ble_gap_conn_desc desc;
+  if (!deviceConnected || ble_gap_conn_find(conn_handle, &desc) != 0) return;
+  conn_policy_link(conn_policy, now, desc.conn_itvl, desc.conn_latency, desc.supervision_timeout);
+  
+  // ATT, L2CAP and link-layer overhead per notification; 8 us a byte
+  // at 1M PHY, 4 at 2M
+  uint8_t tx_phy = 1, rx_phy = 1;
+  ble_gap_read_le_phy(conn_handle, &tx_phy, &rx_phy);
+  uint32_t us_per_byte = tx_phy == BLE_GAP_LE_PHY_2M ? 4 : 8;
+  conn_policy_traffic(conn_policy, notifications, (bytes + notifications * 17) * us_per_byte);
+}
+
+static void request_conn_params(unsigned long now) {
+  const ConnParams& c = conn_policy_params(conn_policy);
+  ble_gap_upd_params params = {};
+  params.itvl_min = c.itvl_min;
+  params.itvl_max = c.itvl_max;
+  params.latency = c.latency;
+  params.supervision_timeout = c.timeout;
+  conn_rc = ble_gap_update_params(conn_handle, &params);
+  conn_policy_requested(conn_policy, now);
+  LOG_INFO("BLE: %s link requested (%u-%u x1.25 ms, latency %u) rc=%d",
+           conn_mode_name(conn_policy.mode), c.itvl_min, c.itvl_max, c.latency, conn_rc);
+}
+
 // ===================================================================
 // BLE Initialization
 // ===================================================================
 
 void ble_init() {
-  Serial.println("BLE: Initializing...");
+  LOG_INFO("BLE: Initializing...");
   
   NimBLEDevice::init(BLE_DEVICE_NAME);
   NimBLEDevice::setPower(ESP_PWR_LVL_P9);
+  NimBLEDevice::setMTU(BLE_PREFERRED_MTU);
+  telemetry_batch_init(sensor_batch, notify_batch, nullptr);
+  
+  static const ConnParams conn_modes[CONN_MODE_COUNT] = {
+    {BLE_CONN_INTERVAL_MIN, BLE_CONN_INTERVAL_MAX, 0, 0},
+    {BLE_STREAM_INTERVAL_MIN, BLE_STREAM_INTERVAL_MAX, 0, 0},
+    {BLE_IDLE_INTERVAL_MIN, BLE_IDLE_INTERVAL_MAX, BLE_IDLE_LATENCY, 0}
+  };
+  conn_policy_init(conn_policy, conn_modes);
+  
+  size_t restored = alert_queue_open(alert_queue, &alert_store, indicate_alert, nullptr, millis());
+  LOG_INFO("BLE: Alert queue at seq %lu, %u undelivered kept over reset",
+           (unsigned long)alert_queue_next_seq(alert_queue), (unsigned)restored);
   
   pServer = NimBLEDevice::createServer();
   pServer->setCallbacks(new ServerCallbacks());
@@ -232,13 +1110,15 @@ void ble_init() {
   
   pSensorDataChar = pService->createCharacteristic(
     SENSOR_DATA_CHAR_UUID,
-    NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY
+    NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::NOTIFY
   );
+  pSensorDataChar->setCallbacks(new SensorDataCharCallbacks());
   
   pAlertsChar = pService->createCharacteristic(
     ALERTS_CHAR_UUID,
-    NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY
+    NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::INDICATE
   );
+  pAlertsChar->setCallbacks(new AlertsCharCallbacks());
   
   pConfigChar = pService->createCharacteristic(
     CONFIG_CHAR_UUID,
@@ -252,6 +1132,24 @@ void ble_init() {
   );
   pCalibrationChar->setCallbacks(new CalibrationCharCallbacks());
   
+  pDiagChar = pService->createCharacteristic(
+    DIAG_CHAR_UUID,
+    NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE
+  );
+  pDiagChar->setCallbacks(new DiagCharCallbacks());
+  
+  pBlackBoxChar = pService->createCharacteristic(
+    BLACK_BOX_CHAR_UUID,
+    NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE
+  );
+  pBlackBoxChar->setCallbacks(new BlackBoxCharCallbacks());
+  
+  pJournalChar = pService->createCharacteristic(
+    JOURNAL_CHAR_UUID,
+    NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::NOTIFY
+  );
+  pJournalChar->setCallbacks(new JournalCharCallbacks());
+  
   pService->start();
   
   // Set initial config from current g_config values
@@ -260,27 +1158,88 @@ void ble_init() {
   NimBLEAdvertising* pAdvertising = NimBLEDevice::getAdvertising();
   pAdvertising->addServiceUUID(SMART_STICK_SVC_UUID);
   pAdvertising->setScanResponse(true);
-  pAdvertising->setMinPreferred(0x06);
-  pAdvertising->setMaxPreferred(0x12);
+  // Connect on the short interval; the policy relaxes it once idle
+  pAdvertising->setMinPreferred(BLE_CONN_INTERVAL_MIN);
+  pAdvertising->setMaxPreferred(BLE_CONN_INTERVAL_MAX);
   
   NimBLEDevice::startAdvertising();
-  Serial.println("BLE: Advertising started");
+  LOG_INFO("BLE: Advertising started");
 }
 
 // ===================================================================
 // BLE Update (handle connection state changes)
 // ===================================================================
+// Never blocks: the re-advertise delay is timed against millis() so the
+// telemetry loop keeps draining the sensing queues meanwhile, and a
+// session fit runs in its own task and is notified when it finishes.
+// Also sends due batches, queued alerts and the journal download, and
+// asks for the connection parameters the policy wants (conn_policy.h).
+// ===================================================================
+
+static void service_calibration_fit() {
+  CalibFit fit;
+  bool ok;
+  
+  if (calib_fit_pending) {
+    calib_fit_pending = false;
+    if (!calib_fit_running && fall_session_fit_start()) {
+      calib_fit_running = true;
+    } else {
+      fit = {};
+      if (calib_fit_running) fit.error = "fit running";
+      else fit.error = fall_session_get().recording ? "trial recording" : "no task";
+      ble_send_calibration_fit(fit, false);
+    }
+  }
+  if (calib_fit_running && fall_session_fit_poll(fit, ok)) {
+    calib_fit_running = false;
+    ble_send_calibration_fit(fit, ok);
+  }
+}
 
 void ble_update() {
+  service_calibration_fit();
+  
+  unsigned long now = millis();
+  if (batch_reset_pending) {
+    batch_reset_pending = false;
+    telemetry_batch_reset(sensor_batch);
+    telemetry_batch_set_imu_type(sensor_batch, TELEMETRY_FRAME_IMU);
+  }
+  if (pending_imu_type) {
+    telemetry_batch_set_imu_type(sensor_batch, (TelemetryFrameType)pending_imu_type);
+    pending_imu_type = 0;
+  }
+  if (pending_mtu) {
+    telemetry_batch_set_mtu(sensor_batch, pending_mtu);
+    pending_mtu = 0;
+  }
+  telemetry_batch_service(sensor_batch, now);
+  update_link_rates(now);
+  service_alerts(now);
+  service_journal_sync();
+  
   if (!deviceConnected && oldDeviceConnected) {
-    delay(500);
-    pServer->startAdvertising();
-    Serial.println("BLE: Restarted advertising");
-    oldDeviceConnected = deviceConnected;
+    if (disconnect_time == 0) {
+      conn_policy_disconnected(conn_policy, now);
+      disconnect_time = millis();
+    } else if (millis() - disconnect_time >= BLE_READVERTISE_DELAY_MS) {
+      pServer->startAdvertising();
+      LOG_INFO("BLE: Restarted advertising");
+      oldDeviceConnected = deviceConnected;
+      disconnect_time = 0;
+    }
   }
   
   if (deviceConnected && !oldDeviceConnected) {
     oldDeviceConnected = deviceConnected;
+    disconnect_time = 0;
+    conn_policy_connected(conn_policy, now);
+  }
+  
+  bool urgent = fall_calibration_is_active() || fall_session_get().recording || journal_syncing;
+  if (conn_policy_update(conn_policy, now, urgent, sensing_imu_stream_enabled())) {
+    request_conn_params(now);
   }
 }
 
@@ -301,23 +1260,48 @@ void ble_send_sensor_data(const char* json) {
     size_t len = strlen(json);
     pSensorDataChar->setValue((uint8_t*)json, len);
     pSensorDataChar->notify();
-    Serial.print("BLE Sensor: ");
-    Serial.println(json);
+    LOG_DEBUG("BLE Sensor: %s", json);
   }
 }
 
+TelemetryEncoding ble_sensor_encoding() {
+  return sensor_encoding;
+}
+
+// Batched frames are not echoed to Serial
+void ble_send_sensor_sample(const TelemetryValues& v, const GaitSummary* gait) {
+  if (!deviceConnected) return;
+  telemetry_batch_add_sample(sensor_batch, v, gait, millis());
+}
+
+void ble_stream_imu(const TelemetryImuSample& s, uint8_t period_ms) {
+  if (!deviceConnected || sensor_encoding != TELEMETRY_ENCODING_BINARY) return;
+  telemetry_batch_add_imu(sensor_batch, s, period_ms, millis());
+}
+
 // ===================================================================
 // Send Alert
 // ===================================================================
 
-void ble_send_alert(const char* json) {
-  if (deviceConnected && pAlertsChar->getSubscribedCount() > 0) {
-    size_t len = strlen(json);
-    pAlertsChar->setValue((uint8_t*)json, len);
-    pAlertsChar->notify();
-    Serial.print("BLE Alert: ");
-    Serial.println(json);
-  }
+// Queued whether or not a client is there, and sent now if one is and
+// nothing older is waiting. Also holds the link on the short interval
+// for the follow-up.
+uint32_t ble_send_alert(const char* json, AlertClass cls) {
+  unsigned long now = millis();
+  conn_policy_kick(conn_policy, now);
+  uint32_t seq = alert_queue_push(alert_queue, json, cls, now);
+  if (!seq) LOG_WARN("BLE: Alert dropped, queue full behind a safety alert");
+  else if (!alert_queue.link) LOG_INFO("BLE: Alert %lu queued, no client", (unsigned long)seq);
+  service_alerts(now);
+  return seq;
+}
+
+// ===================================================================
+// Journal
+// ===================================================================
+
+void ble_attach_journal(Journal* journal) {
+  sync_journal = journal;
 }
 
 // ===================================================================
@@ -337,7 +1321,5 @@ void ble_set_tx_power(int8_t power) {
   else powerLevel = ESP_PWR_LVL_P9;
   
   NimBLEDevice::setPower(powerLevel);
-  Serial.print("BLE: TX power set to ");
-  Serial.print(power);
-  Serial.println(" dBm");
+  LOG_INFO("BLE: TX power set to %d dBm", power);
 }
@@ -3,6 +3,9 @@
 
 #include <Arduino.h>
 #include <NimBLEDevice.h>
+#include "telemetry_frame.h"
+#include "alert_queue.h"
+#include "journal.h"
 
 // ===================================================================
 // BLE GATT Service and Characteristic UUIDs
@@ -13,9 +16,22 @@
 #define ALERTS_CHAR_UUID        "12345678-1234-1234-1234-1234567890ae"
 #define CONFIG_CHAR_UUID        "12345678-1234-1234-1234-1234567890af"
 #define CALIBRATION_CHAR_UUID   "12345678-1234-1234-1234-1234567890b0"
+#define DIAG_CHAR_UUID          "12345678-1234-1234-1234-1234567890b1"
+#define BLACK_BOX_CHAR_UUID     "12345678-1234-1234-1234-1234567890b2"
+#define JOURNAL_CHAR_UUID       "12345678-1234-1234-1234-1234567890b3"
 
 #define BLE_DEVICE_NAME "SmartStick"
 
+// Delay before re-advertising after a disconnect (non-blocking)
+#define BLE_READVERTISE_DELAY_MS 500
+
+// Link requests made on every connection; the central decides. 247 is
+// the largest ATT MTU whose notification (plus the 4-byte L2CAP
+// header) fits one 251-byte Data Length Extension PDU.
+#define BLE_PREFERRED_MTU     247
+#define BLE_DLE_TX_OCTETS     251
+#define BLE_DLE_TX_TIME_US    2120   // 251 octets at 1M PHY
+
 // ===================================================================
 // BLE Function Declarations
 // ===================================================================
@@ -24,7 +40,16 @@ void ble_init();
 void ble_update();
 bool ble_is_connected();
 void ble_send_sensor_data(const char* json);
-void ble_send_alert(const char* json);
+TelemetryEncoding ble_sensor_encoding();   // Negotiated per connection
+// Binary only: queued in the notification batch (telemetry_batch.h)
+void ble_send_sensor_sample(const TelemetryValues& v, const GaitSummary* gait);
+void ble_stream_imu(const TelemetryImuSample& s, uint8_t period_ms);
+// Queued (alert_queue.h) and resent until the client confirms it;
+// kept for the next client when nobody is connected. Returns its seq,
+// or 0 for a transient the full queue refused.
+uint32_t ble_send_alert(const char* json, AlertClass cls = ALERT_SAFETY);
+// The journal the JOURNAL characteristic downloads; appended from loop()
+void ble_attach_journal(Journal* journal);
 void ble_set_tx_power(int8_t power);
 
 // ===================================================================
@@ -35,6 +60,9 @@ extern NimBLECharacteristic* pSensorDataChar;
 extern NimBLECharacteristic* pAlertsChar;
 extern NimBLECharacteristic* pConfigChar;
 extern NimBLECharacteristic* pCalibrationChar;
+extern NimBLECharacteristic* pDiagChar;
+extern NimBLECharacteristic* pBlackBoxChar;
+extern NimBLECharacteristic* pJournalChar;
 extern NimBLEServer* pServer;
 
 void ble_send_calibration_result();
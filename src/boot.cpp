@@ -0,0 +1,103 @@
+#include "boot.h"
+#include "sensors.h"
+#include "fall_detection.h"
+#include "sensing_task.h"
+#include "log.h"
+
+// ===================================================================
+// Boot Timeline
+// ===================================================================
+
+static uint32_t phase_us[BOOT_PHASE_COUNT] = {0};
+static bool phase_reached[BOOT_PHASE_COUNT] = {false};
+
+static const char* const phase_names[BOOT_PHASE_COUNT] = {
+  "serial",
+  "haptics",
+  "advertising",
+  "imu",
+  "tof",
+  "sensing",
+  "first_sample",
+  "rfid"
+};
+
+void boot_mark(BootPhase phase) {
+  if (phase_reached[phase]) return;
+  phase_us[phase] = (uint32_t)esp_timer_get_time();
+  phase_reached[phase] = true;
+}
+
+bool boot_phase_reached(BootPhase phase) {
+  return phase_reached[phase];
+}
+
+uint32_t boot_phase_us(BootPhase phase) {
+  return phase_us[phase];
+}
+
+const char* boot_phase_name(BootPhase phase) {
+  return phase_names[phase];
+}
+
+// ===================================================================
+// Sensor Bring-up Task
+// ===================================================================
+// Runs on core 0 alongside setup()'s BLE init on core 1. The I2C
+// sensors come first so sampling starts as early as possible; RFID
+// (which needs a ~50 ms reset) is brought up after the sensing task.
+// ===================================================================
+
+static void boot_sensor_task(void* param) {
+  if (!sensors_init()) {
+    LOG_WARN("WARNING: Sensor initialization failed!");
+    LOG_WARN("Continuing without sensors (BLE test mode)...");
+  } else {
+    fall_detection_set_params(fall_params_from_config());
+    fall_detection_init();
+  }
+  
+  // Acquisition and detection run from here on in their own task
+  if (sensing_task_start()) {
+    boot_mark(BOOT_PHASE_SENSING);
+  }
+  
+  rfid_init();
+  boot_mark(BOOT_PHASE_RFID);
+  
+  sensors_save_presence();
+  boot_print_timeline();
+  vTaskDelete(nullptr);
+}
+
+bool boot_start_sensors() {
+  BaseType_t ok = xTaskCreatePinnedToCore(
+    boot_sensor_task, "boot_sensors", BOOT_SENSOR_TASK_STACK, nullptr,
+    BOOT_SENSOR_TASK_PRIORITY, nullptr, BOOT_SENSOR_TASK_CORE
+  );
+  return ok == pdPASS;
+}
+
+// ===================================================================
+// Timeline Report
+// ===================================================================
+
+void boot_print_timeline() {
+  LOG_INFO("Boot timeline:");
+  for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+    if (phase_reached[i]) {
+      LOG_INFO("  %-13s %6lu us", phase_names[i], (unsigned long)phase_us[i]);
+    } else {
+      LOG_INFO("  %-13s pending", phase_names[i]);
+    }
+  }
+  
+  if (phase_reached[BOOT_PHASE_ADVERTISING] &&
+      phase_us[BOOT_PHASE_ADVERTISING] > BOOT_ADVERTISING_TARGET_MS * 1000UL) {
+    LOG_WARN("  WARNING: advertising later than target");
+  }
+  if (phase_reached[BOOT_PHASE_FIRST_SAMPLE] &&
+      phase_us[BOOT_PHASE_FIRST_SAMPLE] > BOOT_FIRST_SAMPLE_TARGET_MS * 1000UL) {
+    LOG_WARN("  WARNING: first sample later than target");
+  }
+}
@@ -0,0 +1,51 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <Arduino.h>
+
+// ===================================================================
+// Boot Sequencer
+// ===================================================================
+// setup() brings BLE up while a separate task brings the sensors up,
+// so the stick advertises without waiting for I2C/SPI devices. Every
+// phase is stamped (microseconds since the app started; ROM and
+// second-stage bootloader time are not included) and the timeline is
+// readable over the DIAG characteristic.
+// ===================================================================
+
+#define BOOT_SENSOR_TASK_STACK     4096
+#define BOOT_SENSOR_TASK_PRIORITY  2
+#define BOOT_SENSOR_TASK_CORE      0
+
+// Targets from reset, used only to flag overruns in the timeline
+#define BOOT_ADVERTISING_TARGET_MS  300
+#define BOOT_FIRST_SAMPLE_TARGET_MS 500
+
+enum BootPhase {
+  BOOT_PHASE_SERIAL,          // Serial up, setup() entered
+  BOOT_PHASE_HAPTICS,
+  BOOT_PHASE_ADVERTISING,     // ble_init() returned, advertising
+  BOOT_PHASE_IMU,             // MPU6050 configured (or skipped)
+  BOOT_PHASE_TOF,             // VL53L1X ranging (or skipped)
+  BOOT_PHASE_SENSING,         // Sensing task started
+  BOOT_PHASE_FIRST_SAMPLE,    // First valid IMU sample or ToF range
+  BOOT_PHASE_RFID,            // MFRC522 up (or skipped)
+  BOOT_PHASE_COUNT
+};
+
+// ===================================================================
+// Boot Functions
+// ===================================================================
+
+void boot_mark(BootPhase phase);       // Only the first call per phase counts
+bool boot_phase_reached(BootPhase phase);
+uint32_t boot_phase_us(BootPhase phase);
+const char* boot_phase_name(BootPhase phase);
+
+// Spawns the task that initialises sensors, fall detection and the
+// sensing task, then RFID last.
+bool boot_start_sensors();
+
+void boot_print_timeline();
+
+#endif // BOOT_H
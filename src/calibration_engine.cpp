@@ -0,0 +1,356 @@
+#include "calibration_engine.h"
+#include "fall_kernels.h"
+#include <math.h>
+#include <string.h>
+
+static_assert(CALIB_MAX_TRIALS <= 15, "Grid cells pack two 4-bit trial counts");
+
+// ===================================================================
+// Session Recording
+// ===================================================================
+
+void calib_session_init(CalibSession& session, void* mem, size_t bytes, float lsb_per_g) {
+  session.samples = (CalibSample*)mem;
+  session.capacity = mem ? bytes / sizeof(CalibSample) : 0;
+  session.lsb_per_g = lsb_per_g;
+  calib_session_clear(session);
+}
+
+void calib_session_clear(CalibSession& session) {
+  session.recording = false;
+  session.used = 0;
+  session.trial_count = 0;
+}
+
+bool calib_trial_start(CalibSession& session, CalibLabel label, uint32_t t_ms, uint32_t duration_ms) {
+  if (session.recording || session.trial_count >= CALIB_MAX_TRIALS) return false;
+  if (session.used >= session.capacity) return false;
+  
+  CalibTrial& trial = session.trials[session.trial_count++];
+  trial.first = session.used;
+  trial.count = 0;
+  trial.label = label;
+  trial.truncated = false;
+  session.start_ms = t_ms;
+  session.duration_ms = duration_ms > CALIB_TRIAL_MAX_MS ? CALIB_TRIAL_MAX_MS : duration_ms;
+  session.recording = true;
+  return true;
+}
+
+void calib_trial_stop(CalibSession& session) {
+  session.recording = false;
+}
+
+uint8_t calib_trial_push(CalibSession& session, const int16_t* ax, const int16_t* ay,
+                         const int16_t* az, const uint32_t* t_ms, uint8_t n) {
+  if (!session.recording) return 0;
+  CalibTrial& trial = session.trials[session.trial_count - 1];
+  
+  for (uint8_t i = 0; i < n; i++) {
+    // FIFO samples can predate the start command by a few milliseconds
+    int32_t t = (int32_t)(t_ms[i] - session.start_ms);
+    if (t < 0) continue;
+    if ((uint32_t)t >= session.duration_ms) {
+      session.recording = false;
+      return i;
+    }
+    if (session.used >= session.capacity) {
+      trial.truncated = true;
+      continue;
+    }
+    CalibSample& s = session.samples[session.used++];
+    s.ax = ax[i];
+    s.ay = ay[i];
+    s.az = az[i];
+    s.t_ms = (uint16_t)t;
+    trial.count++;
+  }
+  return n;
+}
+
+// ===================================================================
+// Trial Replay
+// ===================================================================
+// The impact/stillness rule of detection_update() over one trial, run
+// without ever confirming. Returns the longest still run (ms) seen
+// after an impact, -1 if nothing crossed the impact threshold. The
+// real rule would have confirmed for every fall_stillness_ms up to it:
+// its path is the same as this one until the moment it confirms.
+// ===================================================================
+
+static inline uint32_t sample_magsq(const CalibSample& s) {
+  return (uint32_t)((int32_t)s.ax * s.ax) + (uint32_t)((int32_t)s.ay * s.ay) +
+         (uint32_t)((int32_t)s.az * s.az);
+}
+
+static int32_t replay(const CalibSession& session, const CalibTrial& trial,
+                      uint32_t impact_sq, uint32_t still_sq) {
+  const CalibSample* s = session.samples + trial.first;
+  bool potential = false;
+  bool still_run = false;
+  uint32_t potential_ms = 0, still_since = 0;
+  int32_t longest = -1;
+  
+  for (uint16_t i = 0; i < trial.count; i++) {
+    uint32_t m = sample_magsq(s[i]);
+    uint32_t t = s[i].t_ms;
+    if (!potential) {
+      if (m > impact_sq) {
+        potential = true;
+        potential_ms = t;
+        still_run = false;
+        if (longest < 0) longest = 0;
+      }
+    } else if (m < still_sq) {
+      if (!still_run) {
+        still_run = true;
+        still_since = t;
+      }
+      if ((int32_t)(t - still_since) > longest) longest = t - still_since;
+    } else {
+      still_run = false;
+      if (t - potential_ms > CALIB_CONFIRM_WINDOW_MS) potential = false;
+    }
+  }
+  return longest;
+}
+
+static float peak_g(const CalibSession& session, const CalibTrial& trial) {
+  uint32_t peak = 0;
+  for (uint16_t i = 0; i < trial.count; i++) {
+    uint32_t m = sample_magsq(session.samples[trial.first + i]);
+    if (m > peak) peak = m;
+  }
+  return sqrtf((float)peak) / session.lsb_per_g;
+}
+
+// ===================================================================
+// Grid Helpers
+// ===================================================================
+
+static inline float impact_at(int i) { return CALIB_IMPACT_MIN_G + i * CALIB_IMPACT_STEP_G; }
+static inline float motion_at(int m) { return CALIB_MOTION_MIN_G + m * CALIB_MOTION_STEP_G; }
+static inline uint16_t still_at(int s) { return CALIB_STILL_MIN_MS + s * CALIB_STILL_STEP_MS; }
+
+static inline int cell(int i, int m, int s) {
+  return (i * CALIB_MOTION_STEPS + m) * CALIB_STILL_STEPS + s;
+}
+
+// Youden index scaled by falls x ADLs, exact in integers
+static inline int32_t score(uint8_t packed, uint8_t falls, uint8_t adls) {
+  return (int32_t)(packed >> 4) * adls - (int32_t)(packed & 0x0F) * falls;
+}
+
+// Outside the grid counts as worse, so edge points are not favoured
+static float robustness(const uint8_t* grid, int i0, int m0, int s0, int32_t best,
+                        uint8_t falls, uint8_t adls) {
+  const int r = CALIB_ROBUST_RADIUS;
+  int same = 0;
+  for (int i = i0 - r; i <= i0 + r; i++) {
+    if (i < 0 || i >= CALIB_IMPACT_STEPS) continue;
+    for (int m = m0 - r; m <= m0 + r; m++) {
+      if (m < 0 || m >= CALIB_MOTION_STEPS) continue;
+      for (int s = s0 - r; s <= s0 + r; s++) {
+        if (s < 0 || s >= CALIB_STILL_STEPS) continue;
+        if (score(grid[cell(i, m, s)], falls, adls) == best) same++;
+      }
+    }
+  }
+  return (float)same / ((2 * r + 1) * (2 * r + 1) * (2 * r + 1));
+}
+
+// Chessboard distance from every best point to the nearest worse point
+// or the grid edge: two chamfer passes with the 26-neighbour mask,
+// which is exact for this metric
+static uint8_t clearance_at(const uint8_t* dist, int i, int m, int s) {
+  if (i < 0 || i >= CALIB_IMPACT_STEPS || m < 0 || m >= CALIB_MOTION_STEPS ||
+      s < 0 || s >= CALIB_STILL_STEPS) return 0;
+  return dist[cell(i, m, s)];
+}
+
+static void chamfer_pass(uint8_t* dist, int dir) {
+  int i0 = dir > 0 ? 0 : CALIB_IMPACT_STEPS - 1;
+  int m0 = dir > 0 ? 0 : CALIB_MOTION_STEPS - 1;
+  int s0 = dir > 0 ? 0 : CALIB_STILL_STEPS - 1;
+  for (int i = i0; i >= 0 && i < CALIB_IMPACT_STEPS; i += dir) {
+    for (int m = m0; m >= 0 && m < CALIB_MOTION_STEPS; m += dir) {
+      for (int s = s0; s >= 0 && s < CALIB_STILL_STEPS; s += dir) {
+        uint8_t& d = dist[cell(i, m, s)];
+        if (d == 0) continue;
+        // The 13 neighbours already visited in this pass
+        for (int di = -1; di <= 0; di++) {
+          for (int dm = -1; dm <= 1; dm++) {
+            for (int ds = -1; ds <= 1; ds++) {
+              if (di == 0 && (dm > 0 || (dm == 0 && ds >= 0))) continue;
+              uint8_t n = clearance_at(dist, i + di * dir, m + dm * dir, s + ds * dir);
+              if (n + 1 < d) d = n + 1;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+// Area under the ROC traced by the impact threshold, motion and
+// stillness held at the fit
+static float impact_auc(const uint8_t* grid, int m, int s, uint8_t falls, uint8_t adls) {
+  float fpr[CALIB_IMPACT_STEPS + 2], tpr[CALIB_IMPACT_STEPS + 2];
+  int n = 0;
+  fpr[n] = 0.0f; tpr[n++] = 0.0f;
+  fpr[n] = 1.0f; tpr[n++] = 1.0f;
+  for (int i = 0; i < CALIB_IMPACT_STEPS; i++) {
+    uint8_t packed = grid[cell(i, m, s)];
+    fpr[n] = (float)(packed & 0x0F) / adls;
+    tpr[n++] = (float)(packed >> 4) / falls;
+  }
+  
+  // Insertion sort by (fpr, tpr); n is small
+  for (int a = 1; a < n; a++) {
+    float f = fpr[a], t = tpr[a];
+    int b = a - 1;
+    while (b >= 0 && (fpr[b] > f || (fpr[b] == f && tpr[b] > t))) {
+      fpr[b + 1] = fpr[b];
+      tpr[b + 1] = tpr[b];
+      b--;
+    }
+    fpr[b + 1] = f;
+    tpr[b + 1] = t;
+  }
+  
+  float area = 0.0f;
+  for (int a = 1; a < n; a++) {
+    area += (fpr[a] - fpr[a - 1]) * (tpr[a] + tpr[a - 1]) * 0.5f;
+  }
+  return area;
+}
+
+// ===================================================================
+// Fit
+// ===================================================================
+
+bool calib_fit(const CalibSession& session, uint8_t* scratch, CalibFit& out) {
+  uint8_t* grid = scratch;
+  uint8_t* dist = scratch + CALIB_GRID_POINTS;
+  memset(&out, 0, sizeof(out));
+  
+  for (uint8_t k = 0; k < session.trial_count; k++) {
+    if (session.trials[k].label == CALIB_LABEL_FALL) out.falls++;
+    else out.adls++;
+  }
+  if (session.recording) {
+    out.error = "trial in progress";
+    return false;
+  }
+  if (out.falls == 0 || out.adls == 0) {
+    out.error = "need fall and non-fall trials";
+    return false;
+  }
+  
+  // One replay per (impact, motion); every stillness at once
+  for (int i = 0; i < CALIB_IMPACT_STEPS; i++) {
+    uint32_t impact_sq = fall_kernel_above_sq(1.0f + impact_at(i), session.lsb_per_g);
+    for (int m = 0; m < CALIB_MOTION_STEPS; m++) {
+      uint32_t still_sq = fall_kernel_below_sq(motion_at(m), session.lsb_per_g);
+      uint8_t* row = grid + cell(i, m, 0);
+      memset(row, 0, CALIB_STILL_STEPS);
+      
+      for (uint8_t k = 0; k < session.trial_count; k++) {
+        const CalibTrial& trial = session.trials[k];
+        int32_t longest = replay(session, trial, impact_sq, still_sq);
+        uint8_t add = trial.label == CALIB_LABEL_FALL ? 0x10 : 0x01;
+        for (int s = 0; s < CALIB_STILL_STEPS && longest >= still_at(s); s++) {
+          row[s] += add;
+        }
+      }
+    }
+  }
+  
+  int32_t best = INT32_MIN;
+  for (int c = 0; c < CALIB_GRID_POINTS; c++) {
+    int32_t v = score(grid[c], out.falls, out.adls);
+    if (v > best) best = v;
+  }
+  
+  for (int c = 0; c < CALIB_GRID_POINTS; c++) {
+    dist[c] = score(grid[c], out.falls, out.adls) == best ? UINT8_MAX : 0;
+  }
+  chamfer_pass(dist, 1);
+  chamfer_pass(dist, -1);
+  
+  // Deepest inside the plateau; the fuller neighbourhood breaks ties
+  int bi = 0, bm = 0, bs = 0;
+  uint8_t best_clear = 0;
+  float best_robust = -1.0f;
+  for (int i = 0; i < CALIB_IMPACT_STEPS; i++) {
+    for (int m = 0; m < CALIB_MOTION_STEPS; m++) {
+      for (int s = 0; s < CALIB_STILL_STEPS; s++) {
+        uint8_t clear = dist[cell(i, m, s)];
+        if (clear == 0 || clear < best_clear) continue;
+        float r = robustness(grid, i, m, s, best, out.falls, out.adls);
+        if (clear > best_clear || r > best_robust) {
+          best_clear = clear;
+          best_robust = r;
+          bi = i;
+          bm = m;
+          bs = s;
+        }
+      }
+    }
+  }
+  
+  uint8_t packed = grid[cell(bi, bm, bs)];
+  out.ok = true;
+  out.fall_ax_threshold = roundf(impact_at(bi) * 100.0f) / 100.0f;
+  out.fall_motion_threshold = roundf(motion_at(bm) * 100.0f) / 100.0f;
+  out.fall_stillness_ms = still_at(bs);
+  out.tp = packed >> 4;
+  out.fp = packed & 0x0F;
+  out.tpr = (float)out.tp / out.falls;
+  out.fpr = (float)out.fp / out.adls;
+  out.youden = out.tpr - out.fpr;
+  out.robustness = best_robust;
+  out.clearance = best_clear;
+  out.auc = impact_auc(grid, bm, bs, out.falls, out.adls);
+  
+  // How close the trials came to the fitted thresholds
+  uint32_t impact_sq = fall_kernel_above_sq(1.0f + out.fall_ax_threshold, session.lsb_per_g);
+  uint32_t still_sq = fall_kernel_below_sq(out.fall_motion_threshold, session.lsb_per_g);
+  out.fall_peak_min_g = 1e9f;
+  out.fall_run_min_ms = UINT16_MAX;
+  for (uint8_t k = 0; k < session.trial_count; k++) {
+    const CalibTrial& trial = session.trials[k];
+    float peak = peak_g(session, trial);
+    int32_t longest = replay(session, trial, impact_sq, still_sq);
+    uint16_t run = longest < 0 ? 0 : (longest > UINT16_MAX ? UINT16_MAX : longest);
+    if (trial.label == CALIB_LABEL_FALL) {
+      if (peak < out.fall_peak_min_g) out.fall_peak_min_g = peak;
+      if (run >= out.fall_stillness_ms && run < out.fall_run_min_ms) out.fall_run_min_ms = run;
+    } else {
+      if (peak > out.adl_peak_max_g) out.adl_peak_max_g = peak;
+      if (run > out.adl_run_max_ms) out.adl_run_max_ms = run;
+    }
+  }
+  if (out.fall_run_min_ms == UINT16_MAX) out.fall_run_min_ms = 0;
+  
+  if (out.youden >= 1.0f && out.clearance > CALIB_ROBUST_RADIUS && out.falls >= 3 && out.adls >= 3) {
+    out.confidence = CALIB_CONFIDENCE_HIGH;
+  } else if (out.youden >= 0.8f && out.falls >= 2 && out.adls >= 2) {
+    out.confidence = CALIB_CONFIDENCE_MEDIUM;
+  } else {
+    out.confidence = CALIB_CONFIDENCE_LOW;
+  }
+  return true;
+}
+
+const char* calib_label_name(uint8_t label) {
+  return label == CALIB_LABEL_FALL ? "fall" : "adl";
+}
+
+const char* calib_confidence_name(uint8_t confidence) {
+  switch (confidence) {
+    case CALIB_CONFIDENCE_HIGH:   return "high";
+    case CALIB_CONFIDENCE_MEDIUM: return "medium";
+    default:                      return "low";
+  }
+}
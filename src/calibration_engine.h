@@ -0,0 +1,130 @@
+#ifndef CALIBRATION_ENGINE_H
+#define CALIBRATION_ENGINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================================
+// Calibration Engine (multi-trial threshold fitting)
+// ===================================================================
+// A session records the complete accelerometer trace of several
+// labelled trials (real or simulated falls, and everyday movements
+// that must not alert) into one buffer: 8 bytes a sample, appended
+// with no logging so it can sit in the sampling path.
+//
+// calib_fit() then replays every trial through the impact/stillness
+// rule of fall_detection.cpp for each point of a grid over
+//   fall_ax_threshold      impact when |a| > 1 + threshold
+//   fall_motion_threshold  still while |a| < threshold
+//   fall_stillness_ms      still this long confirms the fall
+// and keeps the one with the best Youden index (TPR - FPR, the ROC
+// point furthest from chance). Of the points that reach it, the one
+// furthest (in grid steps) from any worse point or the edge of the
+// grid wins: the middle of the plateau, not its edge, so small drift
+// in the user's movements does not flip a decision. Each (impact,
+// motion) pair is replayed once: a trial is detected for every
+// stillness up to the longest still run it produced, so the stillness
+// axis costs nothing extra.
+//
+// Portable; tools/calib_fit.cpp runs the same fit on sessions saved as
+// CSV (the firmware's "dump" command) or on synthetic trials.
+// ===================================================================
+
+#define CALIB_MAX_TRIALS        15
+#define CALIB_TRIAL_MAX_MS      10000
+#define CALIB_CONFIRM_WINDOW_MS 2000   // As FALL_CONFIRM_WINDOW_MS
+
+// Search grid
+#define CALIB_IMPACT_MIN_G      0.5f
+#define CALIB_IMPACT_STEP_G     0.1f
+#define CALIB_IMPACT_STEPS      36     // 0.5 .. 4.0 g
+#define CALIB_MOTION_MIN_G      1.02f
+#define CALIB_MOTION_STEP_G     0.02f
+#define CALIB_MOTION_STEPS      30     // 1.02 .. 1.60 g
+#define CALIB_STILL_MIN_MS      200
+#define CALIB_STILL_STEP_MS     100
+#define CALIB_STILL_STEPS       19     // 200 .. 2000 ms
+#define CALIB_GRID_POINTS       (CALIB_IMPACT_STEPS * CALIB_MOTION_STEPS * CALIB_STILL_STEPS)
+#define CALIB_FIT_SCRATCH       (2 * CALIB_GRID_POINTS)   // Bytes
+#define CALIB_ROBUST_RADIUS     2      // Grid steps each way
+
+enum CalibLabel {
+  CALIB_LABEL_ADL,             // Activity of daily living: must not alert
+  CALIB_LABEL_FALL
+};
+
+struct CalibSample {
+  int16_t ax, ay, az;          // Raw counts
+  uint16_t t_ms;               // Since the trial started
+};
+
+struct CalibTrial {
+  uint32_t first;              // Index of the first sample
+  uint16_t count;
+  uint8_t label;               // CalibLabel
+  bool truncated;              // Buffer filled before the trial ended
+};
+
+struct CalibSession {
+  CalibSample* samples;
+  uint32_t capacity;
+  uint32_t used;
+  float lsb_per_g;
+  CalibTrial trials[CALIB_MAX_TRIALS];
+  uint8_t trial_count;
+  volatile bool recording;     // Trial trials[trial_count - 1] is open
+  uint32_t start_ms;
+  uint32_t duration_ms;
+};
+
+enum CalibConfidence {
+  CALIB_CONFIDENCE_LOW,
+  CALIB_CONFIDENCE_MEDIUM,
+  CALIB_CONFIDENCE_HIGH
+};
+
+struct CalibFit {
+  bool ok;
+  const char* error;           // Why not, when !ok
+  float fall_ax_threshold;
+  float fall_motion_threshold;
+  uint16_t fall_stillness_ms;
+  uint8_t falls, adls;         // Trials of each label
+  uint8_t tp, fp;              // Falls detected, ADLs that would alert
+  float tpr, fpr;
+  float youden;                // tpr - fpr
+  float auc;                   // ROC over the impact threshold at the fit
+  float robustness;            // Share of the CALIB_ROBUST_RADIUS cube that scores the same
+  uint8_t clearance;           // Grid steps to the nearest worse point or grid edge
+  float fall_peak_min_g;       // Weakest fall impact (|a|)
+  float adl_peak_max_g;        // Strongest ADL impact
+  uint16_t fall_run_min_ms;    // Shortest confirming still run among falls
+  uint16_t adl_run_max_ms;     // Longest still run after an ADL impact
+  uint8_t confidence;          // CalibConfidence
+};
+
+// ===================================================================
+// Calibration Engine Functions
+// ===================================================================
+
+void calib_session_init(CalibSession& session, void* mem, size_t bytes, float lsb_per_g);
+void calib_session_clear(CalibSession& session);
+
+// False if the session is full or a trial is already open
+bool calib_trial_start(CalibSession& session, CalibLabel label, uint32_t t_ms, uint32_t duration_ms);
+void calib_trial_stop(CalibSession& session);
+
+// Hot path: appends the samples that fall inside the open trial and
+// closes it once one lands past its end. Returns the index of the
+// first sample after the trial (n while it is still open, 0 when
+// none is).
+uint8_t calib_trial_push(CalibSession& session, const int16_t* ax, const int16_t* ay,
+                         const int16_t* az, const uint32_t* t_ms, uint8_t n);
+
+// scratch holds CALIB_FIT_SCRATCH bytes
+bool calib_fit(const CalibSession& session, uint8_t* scratch, CalibFit& out);
+
+const char* calib_label_name(uint8_t label);
+const char* calib_confidence_name(uint8_t confidence);
+
+#endif // CALIBRATION_ENGINE_H
@@ -49,35 +49,72 @@ extern Config g_config;
 // Uncomment to enable low-power mode (light sleep between cycles)
 // #define LOW_POWER
 
-// Low-power mode parameters
+// Low-power mode parameters. BLE_CONN_INTERVAL_* is requested during
+// alerts and calibration, BLE_STREAM_* while the IMU stream is on and
+// BLE_IDLE_* (with peripheral latency) otherwise (conn_policy.h).
 #ifdef LOW_POWER
   #define LIGHT_SLEEP_ENABLED true
   #define BLE_CONN_INTERVAL_MIN 80   // 100ms (units of 1.25ms)
   #define BLE_CONN_INTERVAL_MAX 160  // 200ms
+  #define BLE_STREAM_INTERVAL_MIN 80 // 100ms
+  #define BLE_STREAM_INTERVAL_MAX 160 // 200ms
+  #define BLE_IDLE_INTERVAL_MIN 400  // 500ms
+  #define BLE_IDLE_INTERVAL_MAX 480  // 600ms
+  #define BLE_IDLE_LATENCY      2    // Events the stick may skip
 #else
   #define LIGHT_SLEEP_ENABLED false
   #define BLE_CONN_INTERVAL_MIN 12   // 15ms
   #define BLE_CONN_INTERVAL_MAX 24   // 30ms
+  #define BLE_STREAM_INTERVAL_MIN 48 // 60ms
+  #define BLE_STREAM_INTERVAL_MAX 80 // 100ms
+  #define BLE_IDLE_INTERVAL_MIN 160  // 200ms
+  #define BLE_IDLE_INTERVAL_MAX 200  // 250ms
+  #define BLE_IDLE_LATENCY      4
 #endif
 
+// IMU acquisition mode: drain the MPU6050 FIFO every loop so fall
+// detection sees every sample at IMU_SAMPLE_RATE_HZ. Comment out to
+// fall back to one getEvent() per sensor tick.
+#define IMU_FIFO_MODE
+
+// Orientation filter fed by every IMU sample (ahrs.h): AHRS_MADGWICK or
+// AHRS_MAHONY
+#define AHRS_ALGORITHM AHRS_MADGWICK
+
+// ToF scanning mode: step the VL53L1X region of interest across left,
+// centre and right zones on successive ranges (see tof_zones.h).
+// Comment out for a single full-width zone at a 50 ms budget.
+#define TOF_ZONE_SCAN
+
 // ===================================================================
 // Timing Constants
 // ===================================================================
 
-#define RFID_POLL_PERIOD_MS 200
+#define RFID_POLL_PERIOD_MS 100     // Interval between REQA probes (reader sleeps between)
 #define RFID_DEDUPLICATE_MS 3000
 #define BATTERY_READ_PERIOD_MS 10000
-#define IMU_SAMPLE_RATE_HZ 100
-#define OBSTACLE_ALERT_COOLDOWN_MS 1000
+#define IMU_SAMPLE_RATE_HZ 100       // MPU6050 output rate in FIFO mode (100-1000)
+#define OBSTACLE_ALERT_COOLDOWN_MS 1000   // Slowest obstacle repeat; faster as TTC drops (tof_tracker.h)
 #define SOS_DEBOUNCE_MS 20
+#define JOURNAL_SAMPLE_PERIOD_MS 1000   // Samples kept in the flash journal (journal.h)
+
+#if IMU_SAMPLE_RATE_HZ < 100 || IMU_SAMPLE_RATE_HZ > 1000
+  #error "IMU_SAMPLE_RATE_HZ must be between 100 and 1000"
+#endif
 
 // ===================================================================
 // Battery Monitoring Constants
 // ===================================================================
 
-#define BATTERY_MIN_VOLTAGE 3.0
-#define BATTERY_MAX_VOLTAGE 4.2
-#define BATTERY_FILTER_ALPHA 0.1  // Low-pass filter coefficient
+// Pack and load figures for the battery model (battery_model.h). The
+// load estimates only feed IR compensation and the runtime estimate
+// before a drain rate has been measured.
+#define BATTERY_DIVIDER_RATIO 2.0f      // Cell voltage / ADC pin voltage
+#define BATTERY_CAPACITY_MAH 2000
+#define BATTERY_INTERNAL_MOHM 150       // Cell + protection + wiring
+#define BATTERY_BASE_LOAD_MA 90         // ESP32-S3, sensors, BLE advertising
+#define BATTERY_BLE_LOAD_MA 15          // Extra while connected
+#define BATTERY_HAPTIC_LOAD_MA 120      // Motor or buzzer running
 
 // ===================================================================
 // Fall Detection Constants
@@ -86,4 +123,39 @@ extern Config g_config;
 // Note: FALL_MOTION_THRESHOLD and FALL_STILLNESS_DURATION_MS are now
 // configurable via g_config.fall_motion_threshold and g_config.fall_stillness_ms
 
+// Fall decision: 1 = int8 tree classifier on the IMU feature windows
+// (fall_classifier.h), 0 = impact/stillness state machine only. The
+// classifier runs only while the long window holds an impact above
+// 1 + fall_ax_threshold g and stands in for the impact check: a fall
+// it scores still needs fall_stillness_ms below fall_motion_threshold
+// and passes the orientation veto before it is confirmed.
+#define FALL_USE_CLASSIFIER 1
+#define FALL_CLASSIFIER_BUDGET_CYCLES 24000   // 100 us at 240 MHz; overruns are counted
+
+// Calibration session trace (calibration_engine.h), 8 bytes a sample:
+// CALIB_MAX_TRIALS trials of CALIB_TRIAL_MAX_MS at 100 Hz in PSRAM,
+// allocated by the first session. Without PSRAM, about 20 s in total.
+#define CALIB_SESSION_SAMPLES 15000
+#define CALIB_INTERNAL_SAMPLES 2000
+
+// ===================================================================
+// Gait Constants
+// ===================================================================
+
+// Steps, cadence, stride variability and walking bouts (gait.h) are
+// computed on the stick from the 100 Hz FIFO stream and sent as a
+// summary in the SENSOR_DATA JSON this often.
+#define GAIT_SUMMARY_PERIOD_MS 10000
+
+// ===================================================================
+// Black Box Constants
+// ===================================================================
+
+// Chunk pool for the pre/post-event capture (black_box.h), 496 bytes a
+// chunk. 448 in PSRAM: about 50 s of live history plus four captures
+// of BLACK_BOX_PRE_MS + BLACK_BOX_POST_MS. Without PSRAM a smaller pool
+// in internal RAM holds one capture at a time.
+#define BLACK_BOX_POOL_CHUNKS 448
+#define BLACK_BOX_INTERNAL_CHUNKS 128
+
 #endif // CONFIG_H
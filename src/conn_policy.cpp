@@ -0,0 +1,125 @@
+#include "conn_policy.h"
+
+// ===================================================================
+// Accounting
+// ===================================================================
+
+// Charge the time since the last call to the current mode
+static void account(ConnPolicy& p, uint32_t now_ms) {
+  uint32_t elapsed = now_ms - p.account_ms;
+  p.account_ms = now_ms;
+  if (!p.connected || p.itvl == 0) return;
+  
+  ConnModeStats& s = p.stats[p.mode];
+  s.time_ms += elapsed;
+  uint32_t period_us = p.itvl * 1250UL * (1 + p.latency);
+  uint64_t us = (uint64_t)elapsed * 1000 + p.event_rem_us;
+  uint32_t events = (uint32_t)(us / period_us);
+  p.event_rem_us = (uint32_t)(us % period_us);
+  s.events += events;
+  s.radio_us += (uint64_t)events * CONN_EVENT_RADIO_US;
+}
+
+static bool within(const ConnPolicy& p, const ConnParams& want) {
+  return p.itvl >= want.itvl_min && p.itvl <= want.itvl_max && p.latency <= want.latency;
+}
+
+// ===================================================================
+// Connection Policy
+// ===================================================================
+
+void conn_policy_init(ConnPolicy& p, const ConnParams modes[CONN_MODE_COUNT]) {
+  p = {};
+  for (int m = 0; m < CONN_MODE_COUNT; m++) {
+    ConnParams& c = p.params[m];
+    c = modes[m];
+    // Two worst-case gaps (1.25 ms x interval x (1 + latency)) plus
+    // margin, in 10 ms units; at least 2 s, at most 6 s (iOS limit)
+    uint32_t gap_ms = c.itvl_max * 5UL * (1 + c.latency) / 4;
+    uint32_t timeout_ms = 2 * gap_ms + 500;
+    if (timeout_ms < 2000) timeout_ms = 2000;
+    if (timeout_ms > 6000) timeout_ms = 6000;
+    c.timeout = timeout_ms / 10;
+  }
+}
+
+void conn_policy_connected(ConnPolicy& p, uint32_t now_ms) {
+  p.connected = true;
+  p.mode = CONN_MODE_FAST;
+  p.stats[p.mode].entries++;
+  p.fast_until_ms = now_ms + CONN_POLICY_CONNECT_FAST_MS;
+  p.applied = false;
+  p.requested_ms = now_ms - CONN_POLICY_RETRY_MS;   // Request on the first update
+  p.itvl = 0;
+  p.latency = 0;
+  p.account_ms = now_ms;
+  p.event_rem_us = 0;
+}
+
+void conn_policy_disconnected(ConnPolicy& p, uint32_t now_ms) {
+  account(p, now_ms);
+  p.connected = false;
+}
+
+void conn_policy_kick(ConnPolicy& p, uint32_t now_ms) {
+  uint32_t until = now_ms + CONN_POLICY_HOLD_MS;
+  if ((int32_t)(until - p.fast_until_ms) > 0) p.fast_until_ms = until;
+}
+
+bool conn_policy_update(ConnPolicy& p, uint32_t now_ms, bool urgent, bool streaming) {
+  if (!p.connected) return false;
+  if (urgent) conn_policy_kick(p, now_ms);
+  
+  ConnMode target = (int32_t)(p.fast_until_ms - now_ms) > 0 ? CONN_MODE_FAST :
+                    streaming ? CONN_MODE_STREAM : CONN_MODE_IDLE;
+  if (target != p.mode) {
+    account(p, now_ms);
+    p.event_rem_us = 0;
+    p.mode = target;
+    p.stats[target].entries++;
+    p.applied = within(p, p.params[target]);
+    return !p.applied;
+  }
+  if (!p.applied && now_ms - p.requested_ms >= CONN_POLICY_RETRY_MS) {
+    if (p.requests) p.retries++;
+    return true;
+  }
+  return false;
+}
+
+const ConnParams& conn_policy_params(const ConnPolicy& p) {
+  return p.params[p.mode];
+}
+
+void conn_policy_requested(ConnPolicy& p, uint32_t now_ms) {
+  p.requests++;
+  p.requested_ms = now_ms;
+}
+
+void conn_policy_link(ConnPolicy& p, uint32_t now_ms, uint16_t itvl, uint16_t latency, uint16_t timeout) {
+  account(p, now_ms);
+  p.itvl = itvl;
+  p.latency = latency;
+  p.timeout = timeout;
+  p.applied = within(p, p.params[p.mode]);
+}
+
+// A notification in an event latency would have skipped wakes the
+// stick; on average latency / (1 + latency) of them do
+void conn_policy_traffic(ConnPolicy& p, uint32_t notifications, uint32_t air_us) {
+  if (!p.connected) return;
+  ConnModeStats& s = p.stats[p.mode];
+  uint32_t extra = notifications * p.latency / (1 + p.latency);
+  s.notifications += notifications;
+  s.events += extra;
+  s.radio_us += (uint64_t)extra * CONN_EVENT_RADIO_US + air_us;
+}
+
+const char* conn_mode_name(ConnMode mode) {
+  switch (mode) {
+    case CONN_MODE_FAST:   return "fast";
+    case CONN_MODE_STREAM: return "stream";
+    case CONN_MODE_IDLE:   return "idle";
+    default:               return "?";
+  }
+}
@@ -0,0 +1,103 @@
+#ifndef CONN_POLICY_H
+#define CONN_POLICY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================================
+// BLE Connection Parameter Policy
+// ===================================================================
+// Picks the connection parameters to request from what the stick is
+// doing:
+//   FAST    an alert in the last CONN_POLICY_HOLD_MS, calibration
+//           running, or the first seconds of a connection (discovery,
+//           MTU and format negotiation): short interval, no latency
+//   STREAM  the raw IMU stream is on: a medium interval with room to
+//           carry the batched notifications
+//   IDLE    anything else: long interval plus peripheral latency, so
+//           the radio skips most connection events
+// Latency only lets the stick skip events it has nothing to send in;
+// an alert still leaves at the next event, at most one idle interval
+// away, and switches the link to FAST for what follows.
+//
+// The central has the last word. The policy re-requests every
+// CONN_POLICY_RETRY_MS while the reported parameters are outside the
+// mode's, and keeps per-mode counters of time, connection events the
+// stick wakes for and radio-on time. The last two are estimates from
+// the live interval, latency and bytes sent. Portable: the caller
+// makes the requests and reports the link.
+// ===================================================================
+
+#define CONN_POLICY_CONNECT_FAST_MS 5000
+#define CONN_POLICY_HOLD_MS         10000
+#define CONN_POLICY_RETRY_MS        5000
+#define CONN_EVENT_RADIO_US         400    // Empty event: ramp-up, RX window, empty PDUs
+
+enum ConnMode {
+  CONN_MODE_FAST,
+  CONN_MODE_STREAM,
+  CONN_MODE_IDLE,
+  CONN_MODE_COUNT
+};
+
+// Units of the BLE spec: intervals in 1.25 ms, timeout in 10 ms
+struct ConnParams {
+  uint16_t itvl_min;
+  uint16_t itvl_max;
+  uint16_t latency;
+  uint16_t timeout;
+};
+
+struct ConnModeStats {
+  uint32_t entries;
+  uint32_t time_ms;
+  uint32_t events;          // Connection events the stick woke for
+  uint32_t notifications;
+  uint64_t radio_us;
+};
+
+struct ConnPolicy {
+  ConnParams params[CONN_MODE_COUNT];
+  bool connected;
+  ConnMode mode;
+  uint32_t fast_until_ms;
+  uint32_t requested_ms;
+  bool applied;             // Link parameters are within the mode's
+  uint16_t itvl;            // Live link, as last reported
+  uint16_t latency;
+  uint16_t timeout;
+  uint32_t account_ms;
+  uint32_t event_rem_us;    // Part of an event period not yet counted
+  uint32_t requests;
+  uint32_t retries;
+  ConnModeStats stats[CONN_MODE_COUNT];
+};
+
+// ===================================================================
+// Connection Policy Functions
+// ===================================================================
+
+// Interval ranges and latency per mode; the supervision timeout is
+// derived so the link survives (1 + latency) missed intervals twice
+void conn_policy_init(ConnPolicy& p, const ConnParams modes[CONN_MODE_COUNT]);
+void conn_policy_connected(ConnPolicy& p, uint32_t now_ms);
+void conn_policy_disconnected(ConnPolicy& p, uint32_t now_ms);
+
+// An alert went out: FAST for the hold time
+void conn_policy_kick(ConnPolicy& p, uint32_t now_ms);
+
+// Once per loop pass. urgent holds FAST (calibration running);
+// streaming selects STREAM over IDLE. True when the caller should
+// request conn_policy_params(p) now.
+bool conn_policy_update(ConnPolicy& p, uint32_t now_ms, bool urgent, bool streaming);
+const ConnParams& conn_policy_params(const ConnPolicy& p);
+void conn_policy_requested(ConnPolicy& p, uint32_t now_ms);
+
+// The live link (interval 1.25 ms units, latency, timeout 10 ms units),
+// and traffic since the last call: notifications and their air time
+void conn_policy_link(ConnPolicy& p, uint32_t now_ms, uint16_t itvl, uint16_t latency, uint16_t timeout);
+void conn_policy_traffic(ConnPolicy& p, uint32_t notifications, uint32_t air_us);
+
+const char* conn_mode_name(ConnMode mode);
+
+#endif // CONN_POLICY_H
@@ -0,0 +1,66 @@
+#include "fall_classifier.h"
+#include "fall_model.h"
+#include <math.h>
+
+#define FALL_MODEL_NODES  ((1 << FALL_MODEL_DEPTH) - 1)
+
+static_assert(FALL_MODEL_FEATURES == FALL_FEATURE_COUNT,
+              "fall_model.h was trained on a different feature set; rerun tools/train_fall_model.py");
+
+// ===================================================================
+// Features
+// ===================================================================
+
+void fall_features_extract(const ImuFeatures& short_window, const ImuFeatures& long_window,
+                           float* features) {
+  features[FALL_FEATURE_LONG_MAX] = long_window.max_g;
+  features[FALL_FEATURE_LONG_MIN] = long_window.min_g;
+  features[FALL_FEATURE_LONG_STD] = long_window.std_g;
+  features[FALL_FEATURE_LONG_JERK_MAX] = long_window.jerk_max_g_s;
+  features[FALL_FEATURE_LONG_JERK_MEAN] = long_window.jerk_mean_g_s;
+  features[FALL_FEATURE_LONG_TILT] = long_window.tilt_deg;
+  features[FALL_FEATURE_SHORT_MEAN] = short_window.mean_g;
+  features[FALL_FEATURE_SHORT_STD] = short_window.std_g;
+  features[FALL_FEATURE_SHORT_JERK_MEAN] = short_window.jerk_mean_g_s;
+  features[FALL_FEATURE_SHORT_MAX] = short_window.max_g;
+}
+
+// ===================================================================
+// Tree Ensemble
+// ===================================================================
+// Trees are complete and stored level by level: node n has children
+// 2n+1 (q <= threshold) and 2n+2 (q > threshold). Unsplit nodes carry
+// threshold 127 so they always go left; the walk never branches on
+// depth and every tree costs FALL_MODEL_DEPTH comparisons.
+// ===================================================================
+
+void fall_model_quantise(const float* features, int8_t* q) {
+  for (uint8_t f = 0; f < FALL_MODEL_FEATURES; f++) {
+    long v = lroundf((features[f] - fall_model_feature_lo[f]) * fall_model_feature_inv_scale[f]) - 128;
+    q[f] = (int8_t)(v < -128 ? -128 : v > 127 ? 127 : v);
+  }
+}
+
+int32_t fall_model_score_q(const int8_t* q) {
+  int32_t score = fall_model_bias;
+  for (uint8_t t = 0; t < FALL_MODEL_TREES; t++) {
+    uint8_t n = 0;
+    for (uint8_t d = 0; d < FALL_MODEL_DEPTH; d++) {
+      n = 2 * n + 1 + (q[fall_model_node_feature[t][n]] > fall_model_node_threshold[t][n]);
+    }
+    score += fall_model_leaf[t][n - FALL_MODEL_NODES];
+  }
+  return score;
+}
+
+static int32_t tree_score(const float* features) {
+  int8_t q[FALL_MODEL_FEATURES];
+  fall_model_quantise(features, q);
+  return fall_model_score_q(q);
+}
+
+const FallClassifier fall_classifier_trees = {
+  "trees-int8",
+  tree_score,
+  fall_model_threshold
+};
@@ -0,0 +1,61 @@
+#ifndef FALL_CLASSIFIER_H
+#define FALL_CLASSIFIER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "imu_features.h"
+
+// ===================================================================
+// Fall Classifier
+// ===================================================================
+// Decides "fall" or "not a fall" from the sliding-window IMU features
+// (imu_features.h) instead of the impact/stillness state machine in
+// fall_detection.cpp, which stays as the fallback.
+//
+// Classifiers are pluggable: a FallClassifier is a name, a score
+// function over the float feature vector and a decision threshold.
+// The built-in one is a gradient-boosted ensemble of fixed-depth
+// decision trees over int8-quantised features. Every inference
+// quantises FALL_FEATURE_COUNT values and walks exactly
+// FALL_MODEL_DEPTH nodes per tree, so its cost is the same for every
+// window. The tables are constexpr in src/fall_model.h, generated by
+// tools/train_fall_model.py; tools/fall_eval.cpp produces the training
+// features and reports precision/recall and cycles per inference on
+// CSV recordings. Portable.
+// ===================================================================
+
+#define FALL_CLASSIFIER_EVERY        25     // Samples between inferences (4 Hz at 100 Hz)
+#define FALL_CLASSIFIER_REFRACTORY_MS 3000  // One alert per impact
+
+enum FallFeatureIndex {
+  FALL_FEATURE_LONG_MAX,         // Largest |a| in the long window (g)
+  FALL_FEATURE_LONG_MIN,         // Smallest |a|: free fall before impact
+  FALL_FEATURE_LONG_STD,
+  FALL_FEATURE_LONG_JERK_MAX,
+  FALL_FEATURE_LONG_JERK_MEAN,
+  FALL_FEATURE_LONG_TILT,        // Orientation change across the window
+  FALL_FEATURE_SHORT_MEAN,       // Newest 0.64 s: what happened after
+  FALL_FEATURE_SHORT_STD,
+  FALL_FEATURE_SHORT_JERK_MEAN,
+  FALL_FEATURE_SHORT_MAX,
+  FALL_FEATURE_COUNT
+};
+
+struct FallClassifier {
+  const char* name;
+  int32_t (*score)(const float* features);   // FALL_FEATURE_COUNT values
+  int32_t threshold;                         // score > threshold is a fall
+};
+
+// Built-in int8 tree ensemble (fall_model.h)
+extern const FallClassifier fall_classifier_trees;
+
+// Feature vector in FallFeatureIndex order
+void fall_features_extract(const ImuFeatures& short_window, const ImuFeatures& long_window,
+                           float* features);
+
+// Tree ensemble pieces, exposed for the host tools
+void fall_model_quantise(const float* features, int8_t* q);
+int32_t fall_model_score_q(const int8_t* q);
+
+#endif // FALL_CLASSIFIER_H
@@ -1,5 +1,13 @@
 #include "fall_detection.h"
 #include "config.h"
+#include "imu_features.h"
+#include "log.h"
+#include <esp_heap_caps.h>
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
 
 // ===================================================================
 // Fall Detection State Variables
@@ -7,8 +15,23 @@
 
 static FallState fall_state = FALL_IDLE;
 static unsigned long potential_fall_time = 0;
+static unsigned long confirm_time = 0;
+static unsigned long still_since = 0;   // Start of the current still run
+static bool still_run = false;
+static bool rotated = false;            // Rapid rotation around the impact
+static AhrsSignals orientation = {};    // As of the current block
+static unsigned long rapid_time = 0;    // Last block with rapid rotation
+static bool rapid_seen = false;
 static float fall_ax = 0, fall_ay = 0, fall_az = 0;
 
+// Config() defaults until fall_detection_set_params(); the squared
+// thresholds are worked out once here rather than per block
+static FallParams params = {0.96f, 1.22f, 300};
+static FallKernelThresholds thresholds = {};
+
+#define FALL_CONFIRM_WINDOW_MS 2000   // Movement after this long is a false alarm
+#define CALIBRATION_SPIKE_G    1.5    // Stillness is tracked after a spike this big
+
 // ===================================================================
 // Calibration State Variables
 // ===================================================================
@@ -25,14 +48,72 @@ static CalibrationData calibration = {
 
 static bool peak_detected = false;  // Track if we've seen the impact spike
 
+static CalibSession session = {};
+static bool dump_active = false;
+static uint8_t dump_trial = 0;
+static uint16_t dump_index = 0;
+static volatile bool fit_running = false;    // Background fit reading the session
+
+#define DUMP_LINE_MAX 48   // Longest CSV line, with headroom
+
+// ===================================================================
+// Classifier State Variables
+// ===================================================================
+
+static const FallClassifier* classifier = nullptr;
+static FallClassifierStats classifier_stats = {};
+static bool classifier_subscribed = false;
+static bool classifier_fall = false;         // Scored a fall; next block confirms
+static unsigned long classifier_fall_time = 0;
+static unsigned long last_alert_time = 0;
+static bool alerted = false;
+
+// Strongest impact in the long window, reported with a classifier fall
+static uint32_t impact_sq = 0;
+static unsigned long impact_time = 0;
+static int16_t impact_ax = 0, impact_ay = 0, impact_az = 0;
+
+#define IMPACT_MEMORY_MS (IMU_FEATURE_LONG_WINDOW * 1000UL / IMU_SAMPLE_RATE_HZ)
+
 // ===================================================================
 // Fall Detection Initialization
 // ===================================================================
 
+static void on_long_window(const ImuFeatures& long_window, void* ctx);
+
+void fall_detection_set_params(const FallParams& p) {
+  params = p;
+  thresholds.impact_sq = fall_kernel_above_sq(1.0f + p.impact_g, MPU6050_ACCEL_LSB_PER_G);
+  thresholds.still_sq = fall_kernel_below_sq(p.still_g, MPU6050_ACCEL_LSB_PER_G);
+}
+
+FallParams fall_detection_get_params() {
+  return params;
+}
+
+FallParams fall_params_from_config() {
+  FallParams p;
+  p.impact_g = g_config.fall_ax_threshold;
+  p.still_g = g_config.fall_motion_threshold;
+  p.stillness_ms = g_config.fall_stillness_ms;
+  return p;
+}
+
 void fall_detection_init() {
+  fall_detection_set_params(params);
   fall_state = FALL_IDLE;
   potential_fall_time = 0;
-  Serial.println("Fall Detection: Initialized");
+  still_run = false;
+  classifier_fall = false;
+  
+  if (!classifier_subscribed) {
+    classifier_subscribed = imu_features_subscribe(IMU_FEATURES_LONG, FALL_CLASSIFIER_EVERY,
+                                                   on_long_window, nullptr);
+  }
+  fall_detection_set_classifier(FALL_USE_CLASSIFIER && classifier_subscribed ?
+                                &fall_classifier_trees : nullptr);
+  LOG_INFO("Fall Detection: Initialized (%s)",
+           classifier ? classifier->name : "state machine");
 }
 
 // ===================================================================
@@ -51,20 +132,20 @@ void fall_calibration_start(unsigned long duration_ms) {
   calibration.peak_az = 0.0;
   peak_detected = false;
   
-  Serial.println("Fall Calibration: STARTED - Perform a fall now!");
-  Serial.printf("Fall Calibration: Recording for %lu ms\n", duration_ms);
+  LOG_INFO("Fall Calibration: STARTED - Perform a fall now!");
+  LOG_INFO("Fall Calibration: Recording for %lu ms", duration_ms);
 }
 
 void fall_calibration_stop() {
   if (calibration.active) {
     calibration.active = false;
     calibration.complete = true;
-    Serial.println("Fall Calibration: STOPPED");
-    Serial.printf("Fall Calibration Results:\n");
-    Serial.printf("  Peak Acceleration: %.3f g\n", calibration.peak_acceleration);
-    Serial.printf("  Min Motion (after peak): %.3f g\n", calibration.min_motion);
-    Serial.printf("  Peak Axis Values: X=%.3f, Y=%.3f, Z=%.3f\n", 
-                  calibration.peak_ax, calibration.peak_ay, calibration.peak_az);
+    LOG_INFO("Fall Calibration: STOPPED");
+    LOG_INFO("Fall Calibration Results:");
+    LOG_INFO("  Peak Acceleration: %.3f g", calibration.peak_acceleration);
+    LOG_INFO("  Min Motion (after peak): %.3f g", calibration.min_motion);
+    LOG_INFO("  Peak Axis Values: X=%.3f, Y=%.3f, Z=%.3f", 
+             calibration.peak_ax, calibration.peak_ay, calibration.peak_az);
   }
 }
 
@@ -81,92 +162,418 @@ CalibrationData fall_calibration_get_results() {
 }
 
 // ===================================================================
-// Calibration Update (called from fall_detection_update)
+// Calibration Session Functions
 // ===================================================================
 
-static void calibration_update(const IMUData& imu) {
-  if (!calibration.active) return;
+bool fall_session_begin() {
+  if (session.recording || fit_running) return false;
+  dump_active = false;
+  if (session.samples) {
+    calib_session_clear(session);
+    return true;
+  }
   
-  unsigned long elapsed = millis() - calibration.start_time;
+  size_t bytes = CALIB_SESSION_SAMPLES * sizeof(CalibSample);
+  void* mem = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!mem) {
+    bytes = CALIB_INTERNAL_SAMPLES * sizeof(CalibSample);
+    mem = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  }
+  if (!mem) {
+    LOG_WARN("Fall Calibration: No memory for a session");
+    return false;
+  }
+  calib_session_init(session, mem, bytes, MPU6050_ACCEL_LSB_PER_G);
+  LOG_INFO("Fall Calibration: Session of %u samples", (unsigned)session.capacity);
+  return true;
+}
+
+bool fall_session_trial_start(CalibLabel label, unsigned long duration_ms) {
+  if (!session.samples || calibration.active || dump_active || fit_running) return false;
+  if (!calib_trial_start(session, label, millis(), duration_ms)) return false;
+  LOG_INFO("Fall Calibration: Trial %u (%s) for %lu ms",
+           session.trial_count, calib_label_name(label), duration_ms);
+  return true;
+}
+
+void fall_session_trial_stop() {
+  calib_trial_stop(session);
+}
+
+const CalibSession& fall_session_get() {
+  return session;
+}
+
+bool fall_session_fit(CalibFit& fit) {
+  if (session.recording) {
+    fit = {};
+    fit.error = "trial recording";
+    return false;
+  }
   
-  // Check if calibration time is up
-  if (elapsed >= calibration.duration_ms) {
-    fall_calibration_stop();
-    return;
+  // The grid only lives for the fit
+  uint8_t* scratch = (uint8_t*)heap_caps_malloc(CALIB_FIT_SCRATCH, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!scratch) scratch = (uint8_t*)heap_caps_malloc(CALIB_FIT_SCRATCH, MALLOC_CAP_8BIT);
+  if (!scratch) {
+    fit = {};
+    fit.error = "no memory";
+    return false;
   }
   
-  float accel_magnitude = sqrt(imu.ax * imu.ax + imu.ay * imu.ay + imu.az * imu.az);
+  unsigned long start = millis();
+  bool ok = calib_fit(session, scratch, fit);
+  free(scratch);
+  LOG_INFO("Fall Calibration: Fit in %lu ms: %s", millis() - start, ok ? "ok" : fit.error);
+  return ok;
+}
+
+#ifdef ESP_PLATFORM
+static CalibFit fit_result;
+static bool fit_ok = false;
+static volatile bool fit_done = false;
+
+static void fit_task(void* param) {
+  (void)param;
+  fit_ok = fall_session_fit(fit_result);
+  fit_done = true;
+  vTaskDelete(nullptr);
+}
+
+bool fall_session_fit_start() {
+  if (fit_running || session.recording) return false;
+  fit_running = true;
+  fit_done = false;
+  BaseType_t ok = xTaskCreatePinnedToCore(
+    fit_task, "calib_fit", CALIB_FIT_TASK_STACK, nullptr,
+    CALIB_FIT_TASK_PRIORITY, nullptr, CALIB_FIT_TASK_CORE
+  );
+  if (ok != pdPASS) fit_running = false;
+  return ok == pdPASS;
+}
+
+bool fall_session_fit_poll(CalibFit& fit, bool& ok) {
+  if (!fit_done) return false;
+  fit = fit_result;
+  ok = fit_ok;
+  fit_done = false;
+  fit_running = false;
+  return true;
+}
+#endif
+
+bool fall_session_dump_start() {
+  if (!session.samples || session.recording) return false;
+  dump_active = true;
+  dump_trial = 0;
+  dump_index = 0;
+  Serial.println("# trial,label,t_ms,ax,ay,az");
+  return true;
+}
+
+void fall_session_dump_service() {
+  if (!dump_active) return;
   
-  // Track peak acceleration (the impact spike)
-  if (accel_magnitude > calibration.peak_acceleration) {
-    calibration.peak_acceleration = accel_magnitude;
-    calibration.peak_ax = imu.ax;
-    calibration.peak_ay = imu.ay;
-    calibration.peak_az = imu.az;
+  while (Serial.availableForWrite() >= DUMP_LINE_MAX) {
+    if (dump_trial >= session.trial_count) {
+      Serial.println("# end");
+      dump_active = false;
+      return;
+    }
+    const CalibTrial& trial = session.trials[dump_trial];
+    if (dump_index >= trial.count) {
+      dump_trial++;
+      dump_index = 0;
+      continue;
+    }
+    const CalibSample& s = session.samples[trial.first + dump_index++];
+    Serial.printf("%u,%s,%u,%.3f,%.3f,%.3f\n", dump_trial, calib_label_name(trial.label), s.t_ms,
+                  s.ax / (float)MPU6050_ACCEL_LSB_PER_G, s.ay / (float)MPU6050_ACCEL_LSB_PER_G,
+                  s.az / (float)MPU6050_ACCEL_LSB_PER_G);
+  }
+}
+
+// ===================================================================
+// Sample Blocks
+// ===================================================================
+
+static int16_t accel_counts(float g) {
+  float counts = g * (float)MPU6050_ACCEL_LSB_PER_G;
+  if (counts > 32767.0f) return 32767;
+  if (counts < -32768.0f) return -32768;
+  return (int16_t)lroundf(counts);
+}
+
+static float accel_g(int32_t counts) {
+  return counts / (float)MPU6050_ACCEL_LSB_PER_G;
+}
+
+static float magnitude_g(uint32_t mag_sq) {
+  return sqrtf((float)mag_sq) / (float)MPU6050_ACCEL_LSB_PER_G;
+}
+
+bool fall_block_push(FallBlock& block, const IMUData& imu) {
+  if (block.count < FALL_BLOCK_MAX) {
+    uint8_t i = block.count++;
+    block.ax[i] = accel_counts(imu.ax);
+    block.ay[i] = accel_counts(imu.ay);
+    block.az[i] = accel_counts(imu.az);
+    block.t_ms[i] = imu.timestamp_ms;
+  }
+  return block.count >= FALL_BLOCK_MAX;
+}
+
+// ===================================================================
+// Calibration Update
+// ===================================================================
+// Records the peak |a| and, once a spike over CALIBRATION_SPIKE_G has
+// been seen, the lowest |a| after it. Returns the index of the first
+// sample after calibration, i.e. where fall detection may resume.
+// ===================================================================
+
+static uint8_t calibration_update(const FallBlock& block, const uint32_t* mag_sq) {
+  if (!calibration.active) return 0;
+  
+  // FIFO samples can predate the start command by a few milliseconds
+  uint8_t from = 0;
+  while (from < block.count && (long)(block.t_ms[from] - calibration.start_time) < 0) from++;
+  
+  uint8_t to = from;
+  while (to < block.count && block.t_ms[to] - calibration.start_time < calibration.duration_ms) to++;
+  
+  if (to > from) {
+    FallKernelThresholds thr;
+    thr.impact_sq = fall_kernel_above_sq(CALIBRATION_SPIKE_G, MPU6050_ACCEL_LSB_PER_G);
+    thr.still_sq = 0;
+    FallBlockScan scan;
+    fall_kernel_scan(mag_sq + from, to - from, thr, scan);
     
-    // Mark that we've seen a significant spike (above 1.5g)
-    if (accel_magnitude > 1.5) {
+    // Track peak acceleration (the impact spike)
+    float peak = magnitude_g(scan.peak_sq);
+    if (peak > calibration.peak_acceleration) {
+      uint8_t i = from + scan.peak_index;
+      calibration.peak_acceleration = peak;
+      calibration.peak_ax = accel_g(block.ax[i]);
+      calibration.peak_ay = accel_g(block.ay[i]);
+      calibration.peak_az = accel_g(block.az[i]);
+    }
+    
+    // Only track minimum motion from the impact spike on
+    // This captures the "stillness" phase after the fall
+    uint8_t still_from = to;
+    if (peak_detected) {
+      still_from = from;
+    } else if (scan.impact_mask) {
       peak_detected = true;
+      still_from = from + __builtin_ctz(scan.impact_mask);
     }
     
-    Serial.printf("Calibration: New peak %.3f g at (%+.2f, %+.2f, %+.2f)\n", 
-                  accel_magnitude, imu.ax, imu.ay, imu.az);
+    uint32_t lowest = fall_kernel_min(mag_sq, still_from, to);
+    if (lowest != UINT32_MAX && magnitude_g(lowest) < calibration.min_motion) {
+      calibration.min_motion = magnitude_g(lowest);
+    }
   }
   
-  // Only track minimum motion AFTER we've detected the impact spike
-  // This captures the "stillness" phase after the fall
-  if (peak_detected && accel_magnitude < calibration.min_motion) {
-    calibration.min_motion = accel_magnitude;
-    Serial.printf("Calibration: New min motion %.3f g\n", accel_magnitude);
+  // Check if calibration time is up
+  if (to < block.count) {
+    fall_calibration_stop();
+    return to;
   }
+  return block.count;
 }
 
 // ===================================================================
-// Fall Detection Update
+// Classifier
+// ===================================================================
+// Scores the long window every FALL_CLASSIFIER_EVERY samples while it
+// holds an impact. Runs inside imu_features_push(), before
+// fall_detection_update_block() sees the same samples, so a fall is
+// only flagged here. The block update then treats it as the impact of
+// the state machine: the fall is confirmed only after
+// fall_stillness_ms below fall_motion_threshold, and dropped by the
+// upright veto or by movement within FALL_CONFIRM_WINDOW_MS.
 // ===================================================================
 
-void fall_detection_update(const IMUData& imu) {
-  if (!imu.valid) return;
+void fall_detection_set_classifier(const FallClassifier* c) {
+  classifier = c;
+  classifier_fall = false;
+  alerted = false;
+  classifier_stats = {};
+  classifier_stats.name = c ? c->name : nullptr;
+  classifier_stats.threshold = c ? c->threshold : 0;
+}
+
+FallClassifierStats fall_detection_classifier_stats() {
+  return classifier_stats;
+}
+
+static void on_long_window(const ImuFeatures& long_window, void* ctx) {
+  (void)ctx;
+  if (!classifier || calibration.active || session.recording || fall_state != FALL_IDLE || classifier_fall) return;
+  if (long_window.samples < IMU_FEATURE_LONG_WINDOW) return;
+  if (long_window.max_g <= 1.0f + params.impact_g) return;
+  if (alerted && long_window.t_ms - last_alert_time < FALL_CLASSIFIER_REFRACTORY_MS) return;
   
-  // Update calibration if active
-  calibration_update(imu);
+  float features[FALL_FEATURE_COUNT];
+  fall_features_extract(imu_features_now(IMU_FEATURES_SHORT), long_window, features);
   
-  // Skip normal fall detection during calibration
-  if (calibration.active) return;
+  uint32_t start = ESP.getCycleCount();
+  int32_t score = classifier->score(features);
+  uint32_t cycles = ESP.getCycleCount() - start;
   
-  float accel_magnitude = sqrt(imu.ax * imu.ax + imu.ay * imu.ay + imu.az * imu.az);
+  classifier_stats.inferences++;
+  classifier_stats.last_cycles = cycles;
+  classifier_stats.last_score = score;
+  if (cycles > classifier_stats.max_cycles) classifier_stats.max_cycles = cycles;
+  if (cycles > FALL_CLASSIFIER_BUDGET_CYCLES) classifier_stats.over_budget++;
   
-  switch (fall_state) {
-    case FALL_IDLE:
-      if (accel_magnitude > (1.0 + g_config.fall_ax_threshold)) {
+  if (score > classifier->threshold) {
+    classifier_fall = true;
+    classifier_fall_time = long_window.t_ms;
+    classifier_stats.alerts++;
+    alerted = true;
+    last_alert_time = long_window.t_ms;
+  }
+}
+
+// Keeps the strongest impact of the last IMPACT_MEMORY_MS for the event
+static void track_impact(const FallBlock& block, const uint32_t* mag_sq, uint8_t from) {
+  FallKernelThresholds thr = {thresholds.impact_sq, 0};
+  FallBlockScan scan;
+  fall_kernel_scan(mag_sq + from, block.count - from, thr, scan);
+  if (!scan.impact_mask) return;
+  
+  uint8_t i = from + scan.peak_index;
+  if (scan.peak_sq > impact_sq || block.t_ms[i] - impact_time > IMPACT_MEMORY_MS) {
+    impact_sq = scan.peak_sq;
+    impact_time = block.t_ms[i];
+    impact_ax = block.ax[i];
+    impact_ay = block.ay[i];
+    impact_az = block.az[i];
+  }
+}
+
+static void detection_update(const FallBlock& block, const uint32_t* mag_sq, uint8_t from);
+
+static void classifier_update(const FallBlock& block, const uint32_t* mag_sq, uint8_t from) {
+  if (from < block.count) track_impact(block, mag_sq, from);
+  
+  if (classifier_fall) {
+    classifier_fall = false;
+    fall_state = FALL_POTENTIAL;
+    potential_fall_time = classifier_fall_time;
+    still_run = false;
+    // The score can come well after the impact, so look back for the swing
+    rotated = orientation.rapid || (rapid_seen && classifier_fall_time - rapid_time <= IMPACT_MEMORY_MS);
+    fall_ax = accel_g(impact_ax);
+    fall_ay = accel_g(impact_ay);
+    fall_az = accel_g(impact_az);
+    impact_sq = 0;
+    LOG_INFO("Fall Detection: Potential fall scored by %s (score %ld)",
+             classifier->name, (long)classifier_stats.last_score);
+    
+    // Samples up to the score were in the window it saw
+    while (from < block.count && (long)(block.t_ms[from] - potential_fall_time) <= 0) from++;
+  }
+  if (fall_state == FALL_POTENTIAL) detection_update(block, mag_sq, from);
+}
+
+// ===================================================================
+// Fall Detection Update
+// ===================================================================
+
+static void detection_update(const FallBlock& block, const uint32_t* mag_sq, uint8_t from) {
+  if (from >= block.count || fall_state == FALL_CONFIRMED) return;
+  
+  uint8_t n = block.count - from;
+  FallBlockScan scan;
+  fall_kernel_scan(mag_sq + from, n, thresholds, scan);
+  
+  // Idle blocks without an impact (nearly all of them) end here;
+  // otherwise skip straight to the first impact
+  uint8_t k = 0;
+  if (fall_state == FALL_IDLE) {
+    if (!scan.impact_mask) return;
+    k = __builtin_ctz(scan.impact_mask);
+  } else if (orientation.rapid) {
+    rotated = true;
+  }
+  
+  for (; k < n; k++) {
+    uint8_t i = from + k;
+    unsigned long t = block.t_ms[i];
+    
+    if (fall_state == FALL_IDLE) {
+      if (scan.impact_mask & (1UL << k)) {
         fall_state = FALL_POTENTIAL;
-        potential_fall_time = millis();
-        fall_ax = imu.ax;
-        fall_ay = imu.ay;
-        fall_az = imu.az;
-        Serial.println("Fall Detection: Potential fall detected (acceleration spike)");
+        potential_fall_time = t;
+        still_run = false;
+        rotated = orientation.rapid;
+        fall_ax = accel_g(block.ax[i]);
+        fall_ay = accel_g(block.ay[i]);
+        fall_az = accel_g(block.az[i]);
+        LOG_INFO("Fall Detection: Potential fall detected (acceleration spike)");
       }
-      break;
-      
-    case FALL_POTENTIAL:
-      if (accel_magnitude < g_config.fall_motion_threshold) {
-        if (millis() - potential_fall_time >= g_config.fall_stillness_ms) {
-          fall_state = FALL_CONFIRMED;
-          Serial.println("Fall Detection: FALL CONFIRMED!");
-        }
-      } else {
-        if (millis() - potential_fall_time > 2000) {
-          Serial.println("Fall Detection: False alarm, resetting");
+    } else if (scan.still_mask & (1UL << k)) {
+      if (!still_run) {
+        still_run = true;
+        still_since = t;
+      }
+      if (t - still_since >= params.stillness_ms) {
+        // A stick still upright that never swung fast was tapped or
+        // knocked, not dropped with its user
+        if (orientation.valid && orientation.upright && !rotated) {
+          LOG_INFO("Fall Detection: Stick upright and steady, resetting");
           fall_state = FALL_IDLE;
+          return;
         }
+        fall_state = FALL_CONFIRMED;
+        confirm_time = t;
+        LOG_INFO("Fall Detection: FALL CONFIRMED!");
+        return;
+      }
+    } else {
+      still_run = false;
+      if (t - potential_fall_time > FALL_CONFIRM_WINDOW_MS) {
+        LOG_INFO("Fall Detection: False alarm, resetting");
+        fall_state = FALL_IDLE;
       }
-      break;
-      
-    case FALL_CONFIRMED:
-      break;
+    }
+  }
+}
+
+void fall_detection_set_orientation(const AhrsSignals& signals) {
+  orientation = signals;
+}
+
+void fall_detection_update_block(const FallBlock& block) {
+  uint32_t mag_sq[FALL_BLOCK_MAX];
+  fall_kernel_magsq(block, mag_sq);
+  
+  // Detection is skipped while calibrating or recording a trial and
+  // resumes with the first sample after it
+  uint8_t from = calibration_update(block, mag_sq);
+  uint8_t after = calib_trial_push(session, block.ax, block.ay, block.az, block.t_ms, block.count);
+  if (after > from) from = after;
+  if (orientation.rapid && block.count) {
+    rapid_seen = true;
+    rapid_time = block.t_ms[block.count - 1];
+  }
+  if (classifier) {
+    classifier_update(block, mag_sq, from);
+  } else {
+    detection_update(block, mag_sq, from);
   }
 }
 
+void fall_detection_update(const IMUData& imu) {
+  if (!imu.valid) return;
+  
+  FallBlock block;
+  block.count = 0;
+  fall_block_push(block, imu);
+  fall_detection_update_block(block);
+}
+
 // ===================================================================
 // Check if Fall Detected
 // ===================================================================
@@ -181,6 +588,10 @@ bool fall_detection_check(float& ax, float& ay, float& az) {
   return false;
 }
 
+unsigned long fall_detection_confirm_ms() {
+  return confirm_time;
+}
+
 // ===================================================================
 // Reset Fall Detection
 // ===================================================================
@@ -188,4 +599,7 @@ bool fall_detection_check(float& ax, float& ay, float& az) {
 void fall_detection_reset() {
   fall_state = FALL_IDLE;
   potential_fall_time = 0;
+  still_run = false;
+  classifier_fall = false;
+  rapid_seen = false;
 }
@@ -3,6 +3,10 @@
 
 #include <Arduino.h>
 #include "sensors.h"
+#include "fall_kernels.h"
+#include "fall_classifier.h"
+#include "ahrs.h"
+#include "calibration_engine.h"
 
 // ===================================================================
 // Fall Detection State
@@ -32,11 +36,62 @@ struct CalibrationData {
 // Fall Detection Functions
 // ===================================================================
 
+// Samples are processed in blocks (fall_kernels.h): |a|^2 is computed
+// once per block and shared by calibration and detection. With the
+// state machine, a fall is confirmed when |a| stays under
+// fall_motion_threshold for fall_stillness_ms after an impact. With a
+// classifier (FALL_USE_CLASSIFIER), the imu_features long window is
+// scored every FALL_CLASSIFIER_EVERY samples after an impact, and a
+// fall it scores takes the place of the impact: the same stillness
+// run confirms it. The samples must already have been pushed to
+// imu_features.
+//
+// With orientation from the AHRS, either decision also drops a
+// confirmation when the stick is still upright and did not rotate
+// quickly around the impact (a tap or knock, not a fall).
 void fall_detection_init();
-void fall_detection_update(const IMUData& imu);
+void fall_detection_update(const IMUData& imu);          // Block of one
+void fall_detection_update_block(const FallBlock& block);
+void fall_detection_set_orientation(const AhrsSignals& signals);   // Before each block
 bool fall_detection_check(float& ax, float& ay, float& az);
+unsigned long fall_detection_confirm_ms();               // Sample that confirmed it
 void fall_detection_reset();
 
+// Appends one sample (g -> raw counts); true when the block is full
+bool fall_block_push(FallBlock& block, const IMUData& imu);
+
+// Thresholds the detector runs on, copied in from g_config at boot and
+// on every config write, so the module never reads g_config itself
+// (tools/fall_replay.cpp runs it natively with its own values)
+struct FallParams {
+  float impact_g;             // fall_ax_threshold: impact above 1 + this
+  float still_g;              // fall_motion_threshold: still below this
+  uint16_t stillness_ms;      // fall_stillness_ms
+};
+
+void fall_detection_set_params(const FallParams& params);
+FallParams fall_detection_get_params();
+FallParams fall_params_from_config();
+
+// ===================================================================
+// Classifier
+// ===================================================================
+
+struct FallClassifierStats {
+  const char* name;           // nullptr: state machine in use
+  uint32_t inferences;
+  uint32_t alerts;
+  uint32_t over_budget;       // Inferences over FALL_CLASSIFIER_BUDGET_CYCLES
+  uint32_t last_cycles;
+  uint32_t max_cycles;
+  int32_t last_score;
+  int32_t threshold;
+};
+
+// nullptr falls back to the impact/stillness state machine
+void fall_detection_set_classifier(const FallClassifier* classifier);
+FallClassifierStats fall_detection_classifier_stats();
+
 // ===================================================================
 // Calibration Functions
 // ===================================================================
@@ -47,4 +102,34 @@ bool fall_calibration_is_active();
 bool fall_calibration_is_complete();
 CalibrationData fall_calibration_get_results();
 
+// ===================================================================
+// Calibration Session Functions
+// ===================================================================
+// Multi-trial sessions (calibration_engine.h): each trial records the
+// full trace of one labelled movement, detection paused as for the
+// single-shot calibration above. The dump runs on the caller's task,
+// never while a trial is recording. The fit sweeps the whole grid (tens
+// of ms or more), so the firmware runs it in a low-priority task; no
+// session or trial can start until its result has been polled.
+
+bool fall_session_begin();                     // Allocates on first use; clears
+bool fall_session_trial_start(CalibLabel label, unsigned long duration_ms);
+void fall_session_trial_stop();
+const CalibSession& fall_session_get();
+bool fall_session_fit(CalibFit& fit);          // On the caller's task
+
+#ifdef ESP_PLATFORM
+#define CALIB_FIT_TASK_PRIORITY  1             // With the log drain, below the loop
+#define CALIB_FIT_TASK_CORE      0             // Away from the sensing task
+#define CALIB_FIT_TASK_STACK     4096
+
+bool fall_session_fit_start();                 // False while one is running
+bool fall_session_fit_poll(CalibFit& fit, bool& ok);   // True once, when it finishes
+#endif
+
+// CSV over Serial for tools/calib_fit.cpp, a few lines per call so the
+// loop never waits on the UART
+bool fall_session_dump_start();
+void fall_session_dump_service();
+
 #endif // FALL_DETECTION_H
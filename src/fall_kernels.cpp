@@ -0,0 +1,128 @@
+#include "fall_kernels.h"
+#include <math.h>
+
+// ===================================================================
+// Thresholds
+// ===================================================================
+
+static double threshold_counts_sq(float g, float lsb_per_g) {
+  double counts = (double)g * lsb_per_g;
+  return counts * counts;
+}
+
+uint32_t fall_kernel_above_sq(float g, float lsb_per_g) {
+  if (g <= 0) return 0;
+  double sq = floor(threshold_counts_sq(g, lsb_per_g));
+  return sq >= UINT32_MAX ? UINT32_MAX : (uint32_t)sq;
+}
+
+uint32_t fall_kernel_below_sq(float g, float lsb_per_g) {
+  if (g <= 0) return 0;
+  double sq = ceil(threshold_counts_sq(g, lsb_per_g));
+  return sq >= UINT32_MAX ? UINT32_MAX : (uint32_t)sq;
+}
+
+// ===================================================================
+// Scalar Kernels
+// ===================================================================
+
+static inline uint32_t magsq(int16_t x, int16_t y, int16_t z) {
+  // Each square fits int32 (max 2^30); the sum needs uint32
+  return (uint32_t)((int32_t)x * x) + (uint32_t)((int32_t)y * y) + (uint32_t)((int32_t)z * z);
+}
+
+void fall_kernel_magsq_scalar(const FallBlock& block, uint32_t* mag_sq) {
+  for (uint8_t i = 0; i < block.count; i++) {
+    mag_sq[i] = magsq(block.ax[i], block.ay[i], block.az[i]);
+  }
+}
+
+void fall_kernel_scan_scalar(const uint32_t* mag_sq, uint8_t n,
+                             const FallKernelThresholds& thr, FallBlockScan& out) {
+  out.impact_mask = 0;
+  out.still_mask = 0;
+  out.peak_sq = 0;
+  out.peak_index = 0;
+  
+  for (uint8_t i = 0; i < n; i++) {
+    uint32_t m = mag_sq[i];
+    if (m > thr.impact_sq) out.impact_mask |= 1UL << i;
+    if (m < thr.still_sq) out.still_mask |= 1UL << i;
+    if (m > out.peak_sq) {
+      out.peak_sq = m;
+      out.peak_index = i;
+    }
+  }
+}
+
+uint32_t fall_kernel_min(const uint32_t* mag_sq, uint8_t from, uint8_t to) {
+  uint32_t lo = UINT32_MAX;
+  for (uint8_t i = from; i < to; i++) {
+    if (mag_sq[i] < lo) lo = mag_sq[i];
+  }
+  return lo;
+}
+
+// ===================================================================
+// Vector Kernels
+// ===================================================================
+// Fixed-width inner loops with no data-dependent branches: the compiler
+// turns them into SIMD where the target has it (SSE/NEON on a host) and
+// into straight-line MUL16/MAX code on the Xtensa cores. The tail that
+// does not fill a lane group goes through the same per-lane code.
+// ===================================================================
+
+void fall_kernel_magsq_vector(const FallBlock& block, uint32_t* mag_sq) {
+  const uint8_t n = block.count;
+  uint8_t i = 0;
+  
+  for (; i + FALL_KERNEL_LANES <= n; i += FALL_KERNEL_LANES) {
+    for (uint8_t l = 0; l < FALL_KERNEL_LANES; l++) {
+      mag_sq[i + l] = magsq(block.ax[i + l], block.ay[i + l], block.az[i + l]);
+    }
+  }
+  for (; i < n; i++) {
+    mag_sq[i] = magsq(block.ax[i], block.ay[i], block.az[i]);
+  }
+}
+
+void fall_kernel_scan_vector(const uint32_t* mag_sq, uint8_t n,
+                             const FallKernelThresholds& thr, FallBlockScan& out) {
+  uint32_t impact = 0, still = 0;
+  uint32_t lane_max[FALL_KERNEL_LANES] = {0};
+  uint8_t i = 0;
+  
+  for (; i + FALL_KERNEL_LANES <= n; i += FALL_KERNEL_LANES) {
+    uint32_t imp_bits = 0, still_bits = 0;
+    for (uint8_t l = 0; l < FALL_KERNEL_LANES; l++) {
+      uint32_t m = mag_sq[i + l];
+      imp_bits |= (uint32_t)(m > thr.impact_sq) << l;
+      still_bits |= (uint32_t)(m < thr.still_sq) << l;
+      lane_max[l] = m > lane_max[l] ? m : lane_max[l];
+    }
+    impact |= imp_bits << i;
+    still |= still_bits << i;
+  }
+  for (uint8_t l = 0; i < n; i++, l++) {
+    uint32_t m = mag_sq[i];
+    impact |= (uint32_t)(m > thr.impact_sq) << i;
+    still |= (uint32_t)(m < thr.still_sq) << i;
+    lane_max[l] = m > lane_max[l] ? m : lane_max[l];
+  }
+  
+  uint32_t peak = 0;
+  for (uint8_t l = 0; l < FALL_KERNEL_LANES; l++) {
+    peak = lane_max[l] > peak ? lane_max[l] : peak;
+  }
+  
+  // First index holding the peak, as the scalar scan reports it
+  uint32_t at_peak = 0;
+  for (uint8_t j = 0; j < n; j++) {
+    at_peak |= (uint32_t)(mag_sq[j] == peak) << j;
+  }
+  
+  out.impact_mask = impact;
+  out.still_mask = still;
+  out.peak_sq = peak;
+  out.peak_index = at_peak ? (uint8_t)__builtin_ctz(at_peak) : 0;
+}
@@ -0,0 +1,91 @@
+#ifndef FALL_KERNELS_H
+#define FALL_KERNELS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================================
+// Fall Detection Kernels
+// ===================================================================
+// Block kernels over raw accelerometer counts. Magnitudes stay squared
+// (|a|^2 in counts^2, exact in uint32 for +/-8 g int16 data), so there
+// is no sqrt and no rounding. Thresholds are squared once per block.
+//
+//   magsq   |a|^2 for every sample in the block
+//   scan    impact and stillness bitmasks plus the first peak, one pass
+//   min     smallest |a|^2 in a range (calibration stillness)
+//
+// Stillness runs are read off still_mask, so run-length tests need no
+// per-sample branching in the kernels.
+//
+// Two implementations with identical results:
+//   _scalar  one sample at a time, branches (reference)
+//   _vector  FALL_KERNEL_LANES samples per step, branch-free, written
+//            so the compiler can vectorise or unroll it
+// fall_kernel_magsq()/fall_kernel_scan() pick _vector unless the build
+// defines FALL_KERNEL_SCALAR. Portable; tools/fall_kernel_bench.cpp
+// checks the two paths agree and times both.
+// ===================================================================
+
+#define FALL_BLOCK_MAX      32      // Bitmasks are uint32_t
+#define FALL_KERNEL_LANES   8
+
+// Struct-of-arrays so each axis is contiguous for the kernels
+struct FallBlock {
+  int16_t ax[FALL_BLOCK_MAX];
+  int16_t ay[FALL_BLOCK_MAX];
+  int16_t az[FALL_BLOCK_MAX];
+  uint32_t t_ms[FALL_BLOCK_MAX];
+  uint8_t count;
+};
+
+struct FallKernelThresholds {
+  uint32_t impact_sq;     // |a|^2 above this is an impact
+  uint32_t still_sq;      // |a|^2 below this is still
+};
+
+struct FallBlockScan {
+  uint32_t impact_mask;   // Bit i: sample i above impact_sq
+  uint32_t still_mask;    // Bit i: sample i below still_sq
+  uint32_t peak_sq;       // Largest |a|^2 (0 for an empty block)
+  uint8_t peak_index;     // First sample holding peak_sq
+};
+
+// ===================================================================
+// Kernel Functions
+// ===================================================================
+
+// Squared thresholds for "|a| > g" (floor) and "|a| < g" (ceil), so the
+// integer tests match the real-valued comparison exactly
+uint32_t fall_kernel_above_sq(float g, float lsb_per_g);
+uint32_t fall_kernel_below_sq(float g, float lsb_per_g);
+
+void fall_kernel_magsq_scalar(const FallBlock& block, uint32_t* mag_sq);
+void fall_kernel_magsq_vector(const FallBlock& block, uint32_t* mag_sq);
+
+void fall_kernel_scan_scalar(const uint32_t* mag_sq, uint8_t n,
+                             const FallKernelThresholds& thr, FallBlockScan& out);
+void fall_kernel_scan_vector(const uint32_t* mag_sq, uint8_t n,
+                             const FallKernelThresholds& thr, FallBlockScan& out);
+
+// Smallest value in mag_sq[from, to); UINT32_MAX if the range is empty
+uint32_t fall_kernel_min(const uint32_t* mag_sq, uint8_t from, uint8_t to);
+
+static inline void fall_kernel_magsq(const FallBlock& block, uint32_t* mag_sq) {
+#ifdef FALL_KERNEL_SCALAR
+  fall_kernel_magsq_scalar(block, mag_sq);
+#else
+  fall_kernel_magsq_vector(block, mag_sq);
+#endif
+}
+
+static inline void fall_kernel_scan(const uint32_t* mag_sq, uint8_t n,
+                                    const FallKernelThresholds& thr, FallBlockScan& out) {
+#ifdef FALL_KERNEL_SCALAR
+  fall_kernel_scan_scalar(mag_sq, n, thr, out);
+#else
+  fall_kernel_scan_vector(mag_sq, n, thr, out);
+#endif
+}
+
+#endif // FALL_KERNELS_H
@@ -0,0 +1,94 @@
+#ifndef FALL_MODEL_H
+#define FALL_MODEL_H
+
+#include <stdint.h>
+
+// ===================================================================
+// Fall Model (generated by tools/train_fall_model.py - do not edit)
+// ===================================================================
+// 16 trees of depth 3 on 10 int8 features, trained on 4007 windows
+// (508 falls). Training windows at the chosen threshold: precision 1.000,
+// recall 1.000. Leaves are logits x 95.81.
+// ===================================================================
+
+#define FALL_MODEL_FEATURES 10
+#define FALL_MODEL_TREES    16
+#define FALL_MODEL_DEPTH    3
+
+// q = clamp(round((x - lo) * inv_scale) - 128, -128, 127)
+static constexpr float fall_model_feature_lo[FALL_MODEL_FEATURES] = {
+  2.1273f,        // long_max_g
+  0.033f,         // long_min_g
+  0.106001f,      // long_std_g
+  136.206f,       // long_jerk_max_g_s
+  4.45684f,       // long_jerk_mean_g_s
+  0.10279f,       // long_tilt_deg
+  0.556847f,      // short_mean_g
+  0.0053506f,     // short_std_g
+  1.26259f,       // short_jerk_mean_g_s
+  1.011f,         // short_max_g
+};
+static constexpr float fall_model_feature_inv_scale[FALL_MODEL_FEATURES] = {
+  44.2041f, 291.136f, 530.705f, 0.393906f, 8.00675f, 3.51678f, 400.759f, 268.038f, 3.17836f, 44.3633f
+};
+
+// Node n: go to 2n+2 if q[feature] > threshold, else 2n+1
+static constexpr uint8_t fall_model_node_feature[FALL_MODEL_TREES][7] = {
+  {7, 7, 5, 0, 1, 7, 4},
+  {7, 7, 5, 0, 1, 7, 4},
+  {7, 7, 5, 0, 1, 7, 4},
+  {7, 7, 5, 0, 1, 0, 4},
+  {7, 7, 5, 0, 1, 0, 4},
+  {5, 7, 7, 9, 0, 0, 7},
+  {4, 1, 7, 1, 0, 1, 0},
+  {5, 7, 7, 4, 0, 0, 7},
+  {7, 7, 5, 0, 1, 0, 0},
+  {5, 7, 7, 2, 0, 0, 7},
+  {4, 0, 7, 0, 0, 2, 5},
+  {5, 7, 7, 0, 0, 0, 9},
+  {1, 1, 0, 0, 9, 0, 0},
+  {5, 7, 7, 0, 0, 0, 7},
+  {1, 1, 0, 0, 5, 0, 0},
+  {7, 7, 5, 0, 5, 0, 0},
+};
+static constexpr int8_t fall_model_node_threshold[FALL_MODEL_TREES][7] = {
+  {-105, -127, -21, 127, 29, -102, -10},
+  {-105, -127, -21, 127, 29, -102, -10},
+  {-105, -127, -21, 127, 29, -102, -10},
+  {-105, -127, -21, 127, 29, 75, -10},
+  {-102, -127, -12, 127, 29, 127, -13},
+  {-101, -112, -127, -128, 127, 127, -97},
+  {-53, 27, -99, -83, 127, -104, 127},
+  {-101, -112, -127, -94, 127, 127, -97},
+  {-102, -127, -12, 127, 29, 127, 127},
+  {-101, -112, -127, -84, 127, 127, -97},
+  {-53, 127, -102, 127, 127, 58, -38},
+  {-101, -112, -127, 127, 127, 127, -113},
+  {10, -100, 127, 127, -117, 127, 127},
+  {-101, -112, -127, 127, 127, 127, -102},
+  {10, -100, 127, 127, -97, 127, 127},
+  {-102, -127, -92, 127, -100, 127, 127},
+};
+static constexpr int8_t fall_model_leaf[FALL_MODEL_TREES][8] = {
+  {-37, 0, 127, -29, -25, -37, -35, 94},
+  {-34, 0, 55, -27, -22, -34, -32, 53},
+  {-32, 0, 43, -24, -19, -33, -30, 40},
+  {-31, 0, 38, -22, -31, -7, -28, 33},
+  {-30, 0, 35, -28, -31, 0, -26, 23},
+  {-27, 6, -30, 0, -29, 0, 33, -28},
+  {-27, 13, -30, 0, -23, 31, -28, 0},
+  {-24, 5, -29, 0, -27, 0, 31, -26},
+  {-27, 0, 30, -21, -29, 0, -8, 0},
+  {-20, -1, -29, 0, -26, 0, 29, -24},
+  {-27, 0, 0, 0, 28, -4, -26, -4},
+  {-10, 0, -28, 0, -24, 0, 27, -20},
+  {-24, 0, 27, -11, -27, 0, 0, 0},
+  {-7, 0, -27, 0, -21, 0, 26, -13},
+  {-21, 0, -7, 26, -26, 0, 0, 0},
+  {-21, 0, 0, 25, -26, 0, -7, 0},
+};
+
+static constexpr int32_t fall_model_bias = -118;
+static constexpr int32_t fall_model_threshold = 37;   // score > threshold: fall
+
+#endif // FALL_MODEL_H
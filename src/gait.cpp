@@ -0,0 +1,200 @@
+#include "gait.h"
+#include <math.h>
+#include <string.h>
+
+static_assert((GAIT_STRIDE_WINDOW & (GAIT_STRIDE_WINDOW - 1)) == 0, "Stride window must be a power of two");
+
+// ===================================================================
+// Initialization
+// ===================================================================
+
+void gait_init(GaitState& gait, float lsb_per_g) {
+  memset(&gait, 0, sizeof(gait));
+  gait.lsb_per_g = lsb_per_g;
+  gait.env_mg = GAIT_ENV_INIT_MG;
+}
+
+int32_t gait_threshold_mg(const GaitState& gait) {
+  int32_t thr = gait.env_mg * GAIT_THRESHOLD_PCT / 100;
+  return thr > GAIT_MIN_PEAK_MG ? thr : GAIT_MIN_PEAK_MG;
+}
+
+// ===================================================================
+// Strides
+// ===================================================================
+
+static void stride_reset(GaitState& gait) {
+  gait.stride_count = 0;
+  gait.stride_head = 0;
+  gait.stride_sum = 0;
+  gait.stride_sum_sq = 0;
+}
+
+static void stride_push(GaitState& gait, uint32_t stride_ms) {
+  uint16_t s = stride_ms > UINT16_MAX ? UINT16_MAX : (uint16_t)stride_ms;
+  if (gait.stride_count == GAIT_STRIDE_WINDOW) {
+    uint16_t old = gait.strides[gait.stride_head];
+    gait.stride_sum -= old;
+    gait.stride_sum_sq -= (uint32_t)old * old;
+  } else {
+    gait.stride_count++;
+  }
+  gait.strides[gait.stride_head] = s;
+  gait.stride_head = (gait.stride_head + 1) & (GAIT_STRIDE_WINDOW - 1);
+  gait.stride_sum += s;
+  gait.stride_sum_sq += (uint32_t)s * s;
+}
+
+// ===================================================================
+// Strikes and Bouts
+// ===================================================================
+
+static void close_bout(GaitState& gait) {
+  gait.walking_ms += gait.last_strike_ms - gait.bout_start_ms;
+  if (gait.bout_steps > gait.longest_bout_steps) gait.longest_bout_steps = gait.bout_steps;
+  gait.in_bout = false;
+}
+
+// No strike for GAIT_BOUT_GAP_MS: the run is over and the threshold
+// drops back for whoever starts walking next
+static void check_idle(GaitState& gait, uint32_t t_ms) {
+  if (gait.run == 0 || t_ms - gait.last_strike_ms <= GAIT_BOUT_GAP_MS) return;
+  if (gait.in_bout) close_bout(gait);
+  gait.run = 0;
+  gait.env_mg = GAIT_ENV_INIT_MG;
+}
+
+static bool strike(GaitState& gait) {
+  uint32_t t = gait.peak_ms;
+  if (gait.peak_mg > GAIT_MAX_PEAK_MG ||
+      (gait.run > 0 && t - gait.last_strike_ms < GAIT_MIN_STEP_MS)) {
+    gait.rejected++;
+    return false;
+  }
+  int32_t delta = gait.peak_mg - gait.env_mg;
+  gait.env_mg += delta >> (delta > 0 ? GAIT_ENV_RISE_SHIFT : GAIT_ENV_FALL_SHIFT);
+  bool plant = gait.cycle_jerk_mg >= GAIT_PLANT_JERK_MG;
+  
+  // Once the rhythm is known, a much longer step is a pause
+  if (gait.in_bout && gait.stride_count >= 2 &&
+      (uint64_t)(t - gait.last_strike_ms) * gait.stride_count * 100 >
+      (uint64_t)gait.stride_sum * GAIT_PAUSE_PCT) {
+    close_bout(gait);
+    gait.run = 0;
+  }
+  
+  if (gait.run == 0) {
+    gait.run_start_ms = t;
+    gait.run_plants = 0;
+  } else if (gait.in_bout && gait.run >= 2) {
+    stride_push(gait, t - gait.prev_strike_ms);
+  }
+  gait.prev_strike_ms = gait.last_strike_ms;
+  gait.last_strike_ms = t;
+  gait.run++;
+  gait.run_plants += plant;
+  
+  if (gait.in_bout) {
+    gait.steps++;
+    gait.plants += plant;
+    gait.bout_steps++;
+  } else if (gait.run >= GAIT_BOUT_MIN_STEPS) {
+    // The strikes that led up to it were steps too
+    gait.in_bout = true;
+    gait.bouts++;
+    gait.bout_start_ms = gait.run_start_ms;
+    gait.bout_steps = gait.run;
+    gait.steps += gait.run;
+    gait.plants += gait.run_plants;
+    stride_reset(gait);
+  }
+  return true;
+}
+
+// ===================================================================
+// Sample Update
+// ===================================================================
+
+bool gait_push(GaitState& gait, int16_t ax, int16_t ay, int16_t az, uint32_t t_ms) {
+  float sq = (float)((int32_t)ax * ax) + (float)((int32_t)ay * ay) + (float)((int32_t)az * az);
+  float mg = sqrtf(sq) * 1000.0f / gait.lsb_per_g;
+  uint16_t mag_mg = mg > 65535.0f ? 65535 : (uint16_t)mg;
+  
+  if (!gait.primed) {
+    gait.lp = gait.base = (int32_t)mag_mg << 8;
+    gait.prev_mag_mg = mag_mg;
+    gait.primed = true;
+    return false;
+  }
+  
+  uint16_t jerk = mag_mg > gait.prev_mag_mg ? mag_mg - gait.prev_mag_mg : gait.prev_mag_mg - mag_mg;
+  gait.prev_mag_mg = mag_mg;
+  if (jerk > gait.cycle_jerk_mg) gait.cycle_jerk_mg = jerk;
+  
+  gait.lp += (((int32_t)mag_mg << 8) - gait.lp) >> GAIT_LP_SHIFT;
+  gait.base += (gait.lp - gait.base) >> GAIT_BASE_SHIFT;
+  int32_t d = (gait.lp - gait.base) >> 8;
+  
+  check_idle(gait, t_ms);
+  
+  bool struck = false;
+  if (gait.in_peak) {
+    if (d > gait.peak_mg) {
+      gait.peak_mg = d;
+      gait.peak_ms = t_ms;
+    }
+    if (d < 0) {
+      gait.in_peak = false;
+      struck = strike(gait);
+    } else if (t_ms - gait.peak_start_ms > GAIT_MAX_PEAK_MS) {
+      // Posture change or a lean, not a step
+      gait.in_peak = false;
+      gait.rejected++;
+    }
+  } else if (gait.armed && d > gait_threshold_mg(gait)) {
+    gait.in_peak = true;
+    gait.armed = false;
+    gait.peak_mg = d;
+    gait.peak_ms = t_ms;
+    gait.peak_start_ms = t_ms;
+  }
+  
+  // Back under the baseline: the next cycle starts
+  if (d < 0 && !gait.in_peak && !gait.armed) {
+    gait.armed = true;
+    gait.cycle_jerk_mg = 0;
+  }
+  return struck;
+}
+
+// ===================================================================
+// Summary
+// ===================================================================
+
+GaitSummary gait_summary(const GaitState& gait, uint32_t now_ms) {
+  GaitSummary s = {};
+  s.t_ms = now_ms;
+  s.steps = gait.steps;
+  s.plants = gait.plants;
+  s.bouts = gait.bouts;
+  s.bout_steps = gait.bout_steps;
+  s.longest_bout_steps = gait.longest_bout_steps;
+  
+  bool walking = gait.in_bout && now_ms - gait.last_strike_ms <= GAIT_BOUT_GAP_MS;
+  s.walking = walking;
+  uint32_t walking_ms = gait.walking_ms;
+  if (gait.in_bout) walking_ms += gait.last_strike_ms - gait.bout_start_ms;
+  s.walking_s = walking_ms / 1000;
+  if (walking && gait.bout_steps > s.longest_bout_steps) s.longest_bout_steps = gait.bout_steps;
+  
+  if (gait.stride_count > 0) {
+    uint32_t n = gait.stride_count;
+    // n * sum(x^2) - sum(x)^2 is exact in 64 bits
+    uint64_t spread = (uint64_t)n * gait.stride_sum_sq - (uint64_t)gait.stride_sum * gait.stride_sum;
+    s.stride_ms = (uint16_t)(gait.stride_sum / n);
+    s.stride_cv = sqrtf((float)spread) / gait.stride_sum;
+    // Two steps a stride
+    if (walking) s.cadence_spm = (uint16_t)(120000UL * n / gait.stride_sum);
+  }
+  return s;
+}
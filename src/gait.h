@@ -0,0 +1,127 @@
+#ifndef GAIT_H
+#define GAIT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================================
+// Gait Analytics
+// ===================================================================
+// Steps, stick plants, cadence, stride-time variability and walking
+// bouts from the accelerometer stream, updated one sample at a time:
+//   1. |a| in mg, low-passed (~4.5 Hz) and with a slow baseline
+//      (~0.25 Hz) removed, leaves the gait oscillation around 0.
+//   2. Adaptive-threshold peak detector: a peak must rise above
+//      GAIT_THRESHOLD_PCT of the running peak envelope (never under
+//      GAIT_MIN_PEAK_MG), and the signal must fall back through the
+//      baseline before the next one. The envelope rises slowly and
+//      falls fast, so with a plant spike on every other step it sits
+//      near the smaller peaks and the steps between plants still
+//      count. Peaks closer than GAIT_MIN_STEP_MS, wider than
+//      GAIT_MAX_PEAK_MS or over GAIT_MAX_PEAK_MG (impacts) are
+//      rejected.
+//   3. Each accepted peak is a strike; one whose raw |a| jumped by
+//      GAIT_PLANT_JERK_MG in a sample was the stick landing (a plant).
+//   4. Strikes only count once GAIT_BOUT_MIN_STEPS of them follow
+//      each other within GAIT_BOUT_GAP_MS (a bout), so isolated taps
+//      and fidgeting are not steps. A longer gap ends the bout, as
+//      does a step longer than GAIT_PAUSE_PCT of the bout's mean stride
+//      (a pause, or a tap after stopping).
+//   5. Stride time (strike to the next-but-one) over the last
+//      GAIT_STRIDE_WINDOW strides in a bout: running sums, exact ints.
+// Fixed-size state, no heap, O(1) per sample. Portable;
+// tools/gait_replay.cpp checks step counts on synthetic or recorded
+// traces and times gait_push().
+// ===================================================================
+
+#define GAIT_LP_SHIFT          2      // Low-pass: 1/4 of the error per sample
+#define GAIT_BASE_SHIFT        6      // Baseline: 1/64 per sample
+#define GAIT_MIN_PEAK_MG       40     // Threshold floor
+#define GAIT_MAX_PEAK_MG       2500   // Above this it was an impact, not a step
+#define GAIT_ENV_INIT_MG       100    // Peak envelope at rest
+#define GAIT_ENV_RISE_SHIFT    3      // Envelope moves 1/8 of the way up to a peak
+#define GAIT_ENV_FALL_SHIFT    1      // and 1/2 of the way down
+#define GAIT_THRESHOLD_PCT     40     // Of the envelope
+#define GAIT_MIN_STEP_MS       250    // 240 steps/min
+#define GAIT_MAX_PEAK_MS       600
+#define GAIT_PLANT_JERK_MG     250    // Per sample (25 g/s at 100 Hz)
+#define GAIT_BOUT_MIN_STEPS    4
+#define GAIT_BOUT_GAP_MS       2000   // Slowest step: 30 steps/min
+#define GAIT_PAUSE_PCT         90     // Of the mean stride, about 1.8 steps
+#define GAIT_STRIDE_WINDOW     16     // Power of two
+
+struct GaitState {
+  float lsb_per_g;
+  
+  // Filter, fixed point (mg << 8)
+  int32_t lp;
+  int32_t base;
+  uint16_t prev_mag_mg;
+  bool primed;
+  
+  // Peak detector
+  bool armed;                 // Signal has been under the baseline
+  bool in_peak;
+  int32_t peak_mg;
+  uint32_t peak_ms;
+  uint32_t peak_start_ms;
+  uint16_t cycle_jerk_mg;     // Largest |a| jump since the last peak
+  int32_t env_mg;             // Running peak height
+  
+  // Strikes and bouts
+  uint32_t last_strike_ms;
+  uint32_t prev_strike_ms;    // The one before
+  uint16_t run;               // Consecutive strikes within GAIT_BOUT_GAP_MS
+  uint16_t run_plants;
+  uint32_t run_start_ms;
+  bool in_bout;
+  uint32_t bout_start_ms;
+  uint16_t bout_steps;
+  
+  // Strides in the current (or last) bout
+  uint16_t strides[GAIT_STRIDE_WINDOW];
+  uint8_t stride_count;
+  uint8_t stride_head;
+  uint32_t stride_sum;
+  uint64_t stride_sum_sq;
+  
+  // Totals
+  uint32_t steps;
+  uint32_t plants;
+  uint16_t bouts;
+  uint32_t walking_ms;        // Closed bouts
+  uint16_t longest_bout_steps;
+  uint32_t rejected;          // Peaks that were not strikes
+};
+
+// Compact periodic report, instead of the raw stream
+struct GaitSummary {
+  uint32_t t_ms;
+  uint32_t steps;
+  uint32_t plants;
+  uint16_t cadence_spm;       // 0 outside a bout
+  uint16_t stride_ms;         // Mean of the recent strides
+  float stride_cv;            // std / mean of the same strides
+  uint16_t bouts;
+  uint32_t walking_s;         // Including the bout in progress
+  bool walking;
+  uint16_t bout_steps;        // Current bout, or the last one
+  uint16_t longest_bout_steps;
+};
+
+// ===================================================================
+// Gait Functions
+// ===================================================================
+
+void gait_init(GaitState& gait, float lsb_per_g);
+
+// One accelerometer sample (raw counts); true when it completed a
+// strike
+bool gait_push(GaitState& gait, int16_t ax, int16_t ay, int16_t az, uint32_t t_ms);
+
+GaitSummary gait_summary(const GaitState& gait, uint32_t now_ms);
+
+// Current detection threshold above the baseline (diagnostics)
+int32_t gait_threshold_mg(const GaitState& gait);
+
+#endif // GAIT_H
@@ -1,5 +1,6 @@
 #include "haptics.h"
 #include "pins.h"
+#include "log.h"
 
 // ===================================================================
 // Haptics State Variables
@@ -42,7 +43,7 @@ void haptics_init() {
   ledcAttachPin(BUZZER, BUZZER_PWM_CHANNEL);
   buzzer_stop();
   
-  Serial.println("Haptics: Initialized (Passive Buzzer with PWM)");
+  LOG_INFO("Haptics: Initialized (Passive Buzzer with PWM)");
 }
 
 // ===================================================================
@@ -87,7 +88,7 @@ void haptics_trigger(HapticEvent event) {
       digitalWrite(VIB_MOTOR, HIGH);
       vib_end = now + 200;
       
-      Serial.println("Haptics: SOS triggered (3000 Hz)");
+      LOG_INFO("Haptics: SOS triggered (3000 Hz)");
       break;
       
     case HAPTIC_FALL:
@@ -101,7 +102,7 @@ void haptics_trigger(HapticEvent event) {
       digitalWrite(VIB_MOTOR, HIGH);
       vib_end = now + 200;
       
-      Serial.println("Haptics: Fall alert triggered (2500 Hz)");
+      LOG_INFO("Haptics: Fall alert triggered (2500 Hz)");
       break;
       
     case HAPTIC_OBSTACLE:
@@ -112,7 +113,7 @@ void haptics_trigger(HapticEvent event) {
       digitalWrite(VIB_MOTOR, HIGH);
       vib_end = now + 100;
       
-      Serial.println("Haptics: Obstacle alert triggered (2000 Hz)");
+      LOG_INFO("Haptics: Obstacle alert triggered (2000 Hz)");
       break;
       
     case HAPTIC_RFID:
@@ -123,7 +124,7 @@ void haptics_trigger(HapticEvent event) {
       buzzer_tone(TONE_RFID);
       buzzer_end = now + 50;
       
-      Serial.println("Haptics: RFID detected (3500 Hz)");
+      LOG_INFO("Haptics: RFID detected (3500 Hz)");
       break;
   }
 }
@@ -141,3 +142,71 @@ void haptics_led_blink(uint16_t duration_ms) {
   digitalWrite(LED, HIGH);
   led_blink_end = millis() + duration_ms;
 }
+
+bool haptics_is_active() {
+  return vib_end > 0 || buzzer_end > 0;
+}
+
+// ===================================================================
+// Directional Obstacle Alert
+// ===================================================================
+// Same pattern as HAPTIC_OBSTACLE with the pitch giving the side. The
+// zone numbering follows TofZone (0 left, 1 centre, 2 right).
+// ===================================================================
+
+void haptics_obstacle(uint8_t zone) {
+  static const uint16_t zone_tones[] = {TONE_OBSTACLE_LEFT, TONE_OBSTACLE, TONE_OBSTACLE_RIGHT};
+  uint16_t tone = zone < sizeof(zone_tones) / sizeof(zone_tones[0]) ? zone_tones[zone] : TONE_OBSTACLE;
+  unsigned long now = millis();
+  
+  buzzer_tone(tone);
+  buzzer_end = now + 100;
+  
+  digitalWrite(VIB_MOTOR, HIGH);
+  vib_end = now + 100;
+  
+  LOG_INFO("Haptics: Obstacle alert zone %u (%u Hz)", zone, tone);
+}
+
+// ===================================================================
+// Landmark Cues
+// ===================================================================
+// Indexed by the cue byte in the landmark table. Distinct pitch and
+// length so common landmarks are recognisable without the phone.
+// ===================================================================
+
+struct HapticCue {
+  uint16_t tone_hz;
+  uint16_t tone_ms;
+  uint16_t vib_ms;
+};
+
+static const HapticCue haptic_cues[HAPTIC_CUE_COUNT] = {
+  {TONE_RFID,  50,   0},   // 0: generic tag
+  {TONE_RFID, 150,   0},   // 1: door
+  {2200,      150, 150},   // 2: crossing
+  {1800,      250, 250},   // 3: stairs
+  {3000,       80,  80},   // 4: elevator
+  {4000,      100,   0},   // 5: restroom
+  {2800,      200, 100}    // 6: exit
+};
+
+void haptics_cue(uint8_t cue) {
+  if (cue >= HAPTIC_CUE_COUNT) cue = 0;
+  
+  unsigned long now = millis();
+  const HapticCue& c = haptic_cues[cue];
+  
+  digitalWrite(LED, HIGH);
+  led_blink_end = now + 200;
+  
+  buzzer_tone(c.tone_hz);
+  buzzer_end = now + c.tone_ms;
+  
+  if (c.vib_ms > 0) {
+    digitalWrite(VIB_MOTOR, HIGH);
+    vib_end = now + c.vib_ms;
+  }
+  
+  LOG_INFO("Haptics: Landmark cue %u (%u Hz)", cue, c.tone_hz);
+}
@@ -19,6 +19,11 @@
 #define TONE_OBSTACLE  2000   // Medium warning tone
 #define TONE_RFID      3500   // High confirmation beep
 
+// Obstacle direction from ToF zone scanning: lower pitch on the left,
+// higher on the right, TONE_OBSTACLE straight ahead
+#define TONE_OBSTACLE_LEFT   1600
+#define TONE_OBSTACLE_RIGHT  2400
+
 // ===================================================================
 // Haptics Event Types
 // ===================================================================
@@ -37,7 +42,14 @@ enum HapticEvent {
 void haptics_init();
 void haptics_update();
 void haptics_trigger(HapticEvent event);
+void haptics_obstacle(uint8_t zone);   // TofZone
+
+// Landmark cue from the RFID landmark index; unknown cues fall back to
+// the plain HAPTIC_RFID beep
+#define HAPTIC_CUE_COUNT 7
+void haptics_cue(uint8_t cue);
 void haptics_led_set(bool state);
+bool haptics_is_active();   // Motor or buzzer running (battery load estimate)
 void haptics_led_blink(uint16_t duration_ms);
 
 #endif // HAPTICS_H
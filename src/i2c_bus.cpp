@@ -0,0 +1,250 @@
+#include "i2c_bus.h"
+#include "ring_buffer.h"
+#include <atomic>
+#include <string.h>
+
+// ===================================================================
+// Scheduler State
+// ===================================================================
+
+static I2CBusBackend bus_backend;
+static RingBuffer<I2CTransaction, I2C_BUS_QUEUE_SIZE> queues[I2C_PRIORITY_COUNT];
+static I2CBusStats stats;
+
+// Deadline of the op being run, for i2c_bus_op_remaining_us()
+static bool op_has_deadline = false;
+static uint32_t op_deadline_us = 0;
+
+enum I2CCallState : uint8_t {
+  CALL_FREE,
+  CALL_QUEUED,
+  CALL_RUNNING,
+  CALL_DONE,             // Waiting for the caller to collect the result
+  CALL_ABANDONED         // Caller timed out; still queued, op never runs
+};
+
+struct I2CCall {
+  I2CResult (*op)(void* arg);
+  void* arg;
+  uint32_t seq;
+  I2CResult result;
+  std::atomic<uint8_t> state;   // I2CCallState
+};
+
+static I2CCall calls[I2C_PRIORITY_COUNT][I2C_CALL_SLOTS];
+static uint32_t call_seq[I2C_PRIORITY_COUNT];
+
+static inline uint32_t bus_now() {
+  return bus_backend.now_us(bus_backend.ctx);
+}
+
+// ===================================================================
+// Initialization
+// ===================================================================
+
+void i2c_bus_init(const I2CBusBackend& backend) {
+  bus_backend = backend;
+  for (int i = 0; i < I2C_PRIORITY_COUNT; i++) {
+    queues[i].clear();
+    for (I2CCall& call : calls[i]) call.state.store(CALL_FREE);
+  }
+  i2c_bus_reset_stats();
+}
+
+void i2c_bus_reset_stats() {
+  memset(&stats, 0, sizeof(stats));
+  stats.since_us = bus_now();
+}
+
+// ===================================================================
+// Submit
+// ===================================================================
+
+bool i2c_bus_submit(const I2CTransaction& txn) {
+  I2CTransaction queued = txn;
+  queued.submit_us = bus_now();
+  
+  if (!queues[txn.priority].push(queued)) {
+    stats.rejected[txn.priority]++;
+    return false;
+  }
+  return true;
+}
+
+// ===================================================================
+// Run One Transaction
+// ===================================================================
+
+static void run_transaction(const I2CTransaction& txn) {
+  int p = txn.priority;
+  uint32_t start = bus_now();
+  uint32_t waited = start - txn.submit_us;
+  
+  stats.total_wait_us[p] += waited;
+  if (waited > stats.max_wait_us[p]) stats.max_wait_us[p] = waited;
+  
+  I2CResult result;
+  if (txn.timeout_us != 0 && waited >= txn.timeout_us) {
+    // Expired in the queue; don't spend bus time on it
+    result = I2C_TIMEOUT;
+  } else {
+    uint32_t remaining = txn.timeout_us ? txn.timeout_us - waited : 0;
+    if (txn.op) {
+      op_has_deadline = txn.timeout_us != 0;
+      op_deadline_us = txn.submit_us + txn.timeout_us;
+      result = txn.op(txn.ctx);
+      op_has_deadline = false;
+      // An op can't be cut short like a transfer, but one that overran
+      // its deadline is reported as late even if it got through
+      if (result == I2C_OK && txn.timeout_us != 0 && bus_now() - txn.submit_us > txn.timeout_us) {
+        result = I2C_TIMEOUT;
+      }
+    } else {
+      result = bus_backend.transfer(bus_backend.ctx, txn.address,
+                                    txn.tx, txn.tx_len, txn.rx, txn.rx_len, remaining);
+    }
+    stats.busy_us += bus_now() - start;
+  }
+  
+  if (result == I2C_OK) {
+    stats.completed[p]++;
+  } else if (result == I2C_TIMEOUT) {
+    stats.timeouts[p]++;
+  } else {
+    stats.failed[p]++;
+  }
+  
+  if (txn.done) {
+    txn.done(txn, result);
+  }
+}
+
+// ===================================================================
+// Worker Loop
+// ===================================================================
+// Priorities are re-checked after every transaction, so anything
+// queued at a higher level while a transfer was running goes next.
+// ===================================================================
+
+size_t i2c_bus_run() {
+  size_t count = 0;
+  
+  for (;;) {
+    I2CTransaction txn;
+    bool found = false;
+    
+    for (int p = 0; p < I2C_PRIORITY_COUNT && !found; p++) {
+      found = queues[p].pop(txn);
+    }
+    if (!found) break;
+    
+    run_transaction(txn);
+    count++;
+  }
+  
+  return count;
+}
+
+bool i2c_bus_pending() {
+  for (int p = 0; p < I2C_PRIORITY_COUNT; p++) {
+    if (!queues[p].empty()) return true;
+  }
+  return false;
+}
+
+uint32_t i2c_bus_op_remaining_us() {
+  if (!op_has_deadline) return 0;
+  int32_t left = (int32_t)(op_deadline_us - bus_now());
+  return left > 0 ? (uint32_t)left : 1;
+}
+
+// ===================================================================
+// Synchronous Calls
+// ===================================================================
+// State changes the caller and the worker can race on (queued to
+// running or abandoned, running to done or abandoned-and-freed) are
+// compare-exchanges, so exactly one side wins each.
+// ===================================================================
+
+static I2CResult call_op(void* ctx) {
+  I2CCall& call = *(I2CCall*)ctx;
+  uint8_t expected = CALL_QUEUED;
+  if (!call.state.compare_exchange_strong(expected, CALL_RUNNING)) {
+    return I2C_TIMEOUT;   // Abandoned: arg may no longer exist
+  }
+  return call.op(call.arg);
+}
+
+static void call_done(const I2CTransaction& txn, I2CResult result) {
+  I2CCall& call = *(I2CCall*)txn.ctx;
+  call.result = result;
+  
+  // QUEUED here means it expired in the queue and call_op never ran
+  uint8_t state = call.state.load();
+  while (state != CALL_ABANDONED) {
+    if (call.state.compare_exchange_weak(state, CALL_DONE)) {
+      if (bus_backend.call_done) bus_backend.call_done(bus_backend.ctx, txn.priority);
+      return;
+    }
+  }
+  call.state.store(CALL_FREE);
+}
+
+uint32_t i2c_call_submit(I2CPriority priority, uint8_t address,
+                         I2CResult (*op)(void* arg), void* arg, uint32_t timeout_us) {
+  uint32_t seq = ++call_seq[priority];
+  if (seq == 0) seq = ++call_seq[priority];
+  I2CCall& call = calls[priority][seq % I2C_CALL_SLOTS];
+  if (call.state.load() != CALL_FREE) {
+    stats.rejected[priority]++;
+    return 0;
+  }
+  
+  call.op = op;
+  call.arg = arg;
+  call.seq = seq;
+  call.state.store(CALL_QUEUED);
+  
+  I2CTransaction txn = {};
+  txn.address = address;
+  txn.priority = priority;
+  txn.op = call_op;
+  txn.ctx = &call;
+  txn.timeout_us = timeout_us;
+  txn.done = call_done;
+  if (!i2c_bus_submit(txn)) {
+    call.state.store(CALL_FREE);
+    return 0;
+  }
+  return seq;
+}
+
+bool i2c_call_finished(I2CPriority priority, uint32_t seq, I2CResult& result) {
+  I2CCall& call = calls[priority][seq % I2C_CALL_SLOTS];
+  if (call.seq != seq || call.state.load() != CALL_DONE) return false;
+  result = call.result;
+  call.state.store(CALL_FREE);
+  return true;
+}
+
+bool i2c_call_abandon(I2CPriority priority, uint32_t seq) {
+  I2CCall& call = calls[priority][seq % I2C_CALL_SLOTS];
+  if (call.seq != seq) return true;
+  uint8_t expected = CALL_QUEUED;
+  return call.state.compare_exchange_strong(expected, CALL_ABANDONED);
+}
+
+// ===================================================================
+// Statistics
+// ===================================================================
+
+I2CBusStats i2c_bus_get_stats() {
+  return stats;
+}
+
+uint8_t i2c_bus_utilization_pct() {
+  uint32_t window = bus_now() - stats.since_us;
+  if (window == 0) return 0;
+  uint64_t pct = stats.busy_us * 100 / window;
+  return pct > 100 ? 100 : (uint8_t)pct;
+}
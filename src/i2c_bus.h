@@ -0,0 +1,128 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================================
+// Shared I2C Bus Scheduler
+// ===================================================================
+// The MPU6050 and VL53L1X share one bus. Drivers queue transactions
+// here instead of touching Wire; a background worker runs them back
+// to back, always taking the highest-priority queue first, so a slow
+// ToF access can delay an IMU drain by at most one transaction.
+//
+// Each priority level has its own lock-free SPSC queue, so exactly one
+// task may submit at each level. The scheduler has no Arduino
+// dependencies; the bus is reached through I2CBusBackend so a mock
+// backend can drive it on a host build.
+// ===================================================================
+
+#define I2C_BUS_QUEUE_SIZE 8
+#define I2C_CALL_SLOTS     (I2C_BUS_QUEUE_SIZE + 1)   // Per priority
+
+enum I2CPriority {
+  I2C_PRIORITY_HIGH,     // MPU6050
+  I2C_PRIORITY_NORMAL,   // VL53L1X
+  I2C_PRIORITY_LOW,      // Housekeeping
+  I2C_PRIORITY_COUNT
+};
+
+enum I2CResult {
+  I2C_OK,
+  I2C_NACK,
+  I2C_TIMEOUT,           // Deadline passed before or during the transfer
+  I2C_BUS_ERROR
+};
+
+struct I2CTransaction;
+typedef void (*I2CCallback)(const I2CTransaction& txn, I2CResult result);
+
+struct I2CTransaction {
+  uint8_t address;
+  I2CPriority priority;
+  
+  // Register-style transfer: write tx, then read rx after a repeated start
+  const uint8_t* tx;
+  size_t tx_len;
+  uint8_t* rx;
+  size_t rx_len;
+  
+  // Driver call: when set, run with exclusive bus access instead of tx/rx
+  I2CResult (*op)(void* ctx);
+  
+  uint32_t timeout_us;   // Measured from submit, ops included; 0 = none
+  I2CCallback done;      // Runs in the worker context, may be null
+  void* ctx;
+  
+  uint32_t submit_us;    // Filled in by i2c_bus_submit()
+};
+
+struct I2CBusBackend {
+  I2CResult (*transfer)(void* ctx, uint8_t address,
+                        const uint8_t* tx, size_t tx_len,
+                        uint8_t* rx, size_t rx_len, uint32_t timeout_us);
+  uint32_t (*now_us)(void* ctx);
+  void* ctx;
+  
+  // Worker side: a synchronous call at this priority finished and its
+  // caller is still waiting; may be null
+  void (*call_done)(void* ctx, I2CPriority priority);
+};
+
+struct I2CBusStats {
+  uint32_t completed[I2C_PRIORITY_COUNT];
+  uint32_t failed[I2C_PRIORITY_COUNT];
+  uint32_t timeouts[I2C_PRIORITY_COUNT];
+  uint32_t rejected[I2C_PRIORITY_COUNT];       // Queue full at submit
+  uint32_t max_wait_us[I2C_PRIORITY_COUNT];    // Submit to start
+  uint64_t total_wait_us[I2C_PRIORITY_COUNT];
+  uint64_t busy_us;                            // Time spent in transfers
+  uint32_t since_us;                           // Start of the stats window
+};
+
+// ===================================================================
+// Bus Functions
+// ===================================================================
+
+void i2c_bus_init(const I2CBusBackend& backend);
+
+// Producer side: non-blocking, false when that priority's queue is full
+bool i2c_bus_submit(const I2CTransaction& txn);
+
+// Worker side: run queued transactions until every queue is empty
+size_t i2c_bus_run();
+bool i2c_bus_pending();
+
+// Inside an op: time left before its deadline, at least 1 once it has
+// passed so transfers fail fast; 0 = no deadline (or not in an op)
+uint32_t i2c_bus_op_remaining_us();
+
+I2CBusStats i2c_bus_get_stats();
+uint8_t i2c_bus_utilization_pct();
+void i2c_bus_reset_stats();
+
+// ===================================================================
+// Synchronous Calls
+// ===================================================================
+// For a task that blocks until its op has run. The queued transaction
+// points at a call record owned by the scheduler, not at the caller's
+// stack, and the sequence number i2c_call_submit() returns is the token
+// that ties a completion to the call waiting for it:
+//   - the caller waits (for call_done, or its own timeout), then asks
+//     i2c_call_finished() with its token; a wake-up for any other call
+//     is stale and is ignored
+//   - on timeout it calls i2c_call_abandon(). If the op has not started
+//     it never will, the call's completion is dropped, and the caller
+//     may return. If the op is already running on arg, the caller has
+//     to keep waiting; the op's deadline bounds how long.
+// Same rule as i2c_bus_submit(): one calling task per priority.
+// ===================================================================
+
+// 0 = rejected: queue full, or the slot is still held by an abandoned call
+uint32_t i2c_call_submit(I2CPriority priority, uint8_t address,
+                         I2CResult (*op)(void* arg), void* arg, uint32_t timeout_us);
+bool i2c_call_finished(I2CPriority priority, uint32_t seq, I2CResult& result);
+bool i2c_call_abandon(I2CPriority priority, uint32_t seq);
+
+#endif // I2C_BUS_H
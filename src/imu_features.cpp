@@ -0,0 +1,111 @@
+#include "imu_features.h"
+#include <stdlib.h>
+
+// ===================================================================
+// Engine State
+// ===================================================================
+
+struct Subscriber {
+  ImuFeatureWindowId window;
+  uint16_t every_n;
+  uint16_t countdown;
+  ImuFeatureHandler handler;
+  void* ctx;
+};
+
+static ImuFeatureWindow<IMU_FEATURE_SHORT_WINDOW> short_window;
+static ImuFeatureWindow<IMU_FEATURE_LONG_WINDOW> long_window;
+static ImuFeatureSample last_sample;
+static bool have_last = false;
+
+static Subscriber subscribers[IMU_FEATURE_MAX_SUBSCRIBERS];
+static uint8_t subscriber_count = 0;
+
+static ImuFeatures snapshots[IMU_FEATURE_WINDOW_COUNT];
+static uint16_t snapshot_countdown = IMU_FEATURE_SNAPSHOT_EVERY;
+
+static float rate_hz = 100.0f;
+static float counts_per_g = 4096.0f;
+
+// ===================================================================
+// Per-Sample Preprocessing
+// ===================================================================
+
+static uint16_t to_mg(float counts, float lsb_per_g) {
+  float mg = counts * 1000.0f / lsb_per_g + 0.5f;
+  return mg >= 65535.0f ? 65535 : (uint16_t)mg;
+}
+
+static float vector_length(int32_t x, int32_t y, int32_t z) {
+  return sqrtf((float)x * x + (float)y * y + (float)z * z);
+}
+
+ImuFeatureSample imu_feature_sample(int16_t ax, int16_t ay, int16_t az,
+                                    const ImuFeatureSample* prev, float lsb_per_g) {
+  ImuFeatureSample s;
+  s.ax = ax;
+  s.ay = ay;
+  s.az = az;
+  s.mag_mg = to_mg(vector_length(ax, ay, az), lsb_per_g);
+  s.sma_mg = to_mg((float)(abs(ax) + abs(ay) + abs(az)), lsb_per_g);
+  s.jerk_mg = prev ? to_mg(vector_length(ax - prev->ax, ay - prev->ay, az - prev->az), lsb_per_g) : 0;
+  return s;
+}
+
+// ===================================================================
+// Engine
+// ===================================================================
+
+void imu_features_init(float sample_rate_hz, float lsb_per_g) {
+  rate_hz = sample_rate_hz;
+  counts_per_g = lsb_per_g;
+  short_window.reset();
+  long_window.reset();
+  have_last = false;
+  snapshot_countdown = IMU_FEATURE_SNAPSHOT_EVERY;
+}
+
+static ImuFeatures window_features(ImuFeatureWindowId window) {
+  return window == IMU_FEATURES_SHORT ? short_window.features(rate_hz) :
+                                        long_window.features(rate_hz);
+}
+
+void imu_features_push(int16_t ax, int16_t ay, int16_t az, uint32_t t_ms) {
+  ImuFeatureSample s = imu_feature_sample(ax, ay, az, have_last ? &last_sample : nullptr,
+                                          counts_per_g);
+  last_sample = s;
+  have_last = true;
+  
+  short_window.push(s, t_ms);
+  long_window.push(s, t_ms);
+  
+  for (uint8_t i = 0; i < subscriber_count; i++) {
+    Subscriber& sub = subscribers[i];
+    if (--sub.countdown == 0) {
+      sub.countdown = sub.every_n;
+      sub.handler(window_features(sub.window), sub.ctx);
+    }
+  }
+  
+  if (--snapshot_countdown == 0) {
+    snapshot_countdown = IMU_FEATURE_SNAPSHOT_EVERY;
+    for (int w = 0; w < IMU_FEATURE_WINDOW_COUNT; w++) {
+      snapshots[w] = window_features((ImuFeatureWindowId)w);
+    }
+  }
+}
+
+bool imu_features_subscribe(ImuFeatureWindowId window, uint16_t every_n,
+                            ImuFeatureHandler handler, void* ctx) {
+  if (subscriber_count >= IMU_FEATURE_MAX_SUBSCRIBERS || !handler || every_n == 0) return false;
+  subscribers[subscriber_count++] = {window, every_n, every_n, handler, ctx};
+  return true;
+}
+
+ImuFeatures imu_features_get(ImuFeatureWindowId window) {
+  return snapshots[window < IMU_FEATURE_WINDOW_COUNT ? window : IMU_FEATURES_SHORT];
+}
+
+ImuFeatures imu_features_now(ImuFeatureWindowId window) {
+  return window_features(window < IMU_FEATURE_WINDOW_COUNT ? window : IMU_FEATURES_SHORT);
+}
@@ -0,0 +1,237 @@
+#ifndef IMU_FEATURES_H
+#define IMU_FEATURES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+// ===================================================================
+// IMU Sliding-Window Features
+// ===================================================================
+// Streaming features over the last N accelerometer samples, O(1) per
+// sample whatever N is:
+//   mean / std of |a|      running sum and sum of squares (exact ints)
+//   min / max of |a|       monotonic deques
+//   jerk                   |a(t) - a(t-1)| x rate: running mean, deque max
+//   SMA                    mean of |ax| + |ay| + |az|
+//   tilt                   angle between the mean acceleration vectors
+//                          of the older and newer half of the window
+// Per-sample values are kept in milli-g so the running sums are exact
+// integers and never drift.
+//
+// ImuFeatureWindow<N> is the building block. The engine below owns one
+// short and one long window (lengths fixed at compile time), and
+// notifies subscribers (fall detection, gait, telemetry) every K
+// samples. Portable; tools/imu_feature_bench.cpp checks it against a
+// brute-force recompute and times it for several window lengths.
+// ===================================================================
+
+#define IMU_FEATURE_SHORT_WINDOW   64     // 0.64 s at 100 Hz: impacts, jerk
+#define IMU_FEATURE_LONG_WINDOW    256    // 2.56 s at 100 Hz: activity, tilt
+#define IMU_FEATURE_MAX_SUBSCRIBERS 4
+#define IMU_FEATURE_SNAPSHOT_EVERY 10     // Samples between get() snapshots
+
+struct ImuFeatures {
+  uint16_t samples;        // In the window (< N while it fills)
+  uint32_t t_ms;           // Newest sample
+  float mean_g;
+  float std_g;
+  float min_g;
+  float max_g;
+  float jerk_mean_g_s;
+  float jerk_max_g_s;
+  float sma_g;             // Signal magnitude area per sample
+  float tilt_deg;          // 0 until the window is full
+};
+
+// One sample as stored in a window
+struct ImuFeatureSample {
+  int16_t ax, ay, az;      // Raw counts (for the tilt sums)
+  uint16_t mag_mg;
+  uint16_t jerk_mg;        // |delta a| since the previous sample
+  uint16_t sma_mg;
+};
+
+// ===================================================================
+// Monotonic Deque
+// ===================================================================
+// Sliding-window max (or min, with KeepMin) of the last N values.
+// Each value enters and leaves once, so push is amortised O(1).
+// ===================================================================
+
+template <uint16_t N, bool KeepMin>
+class ImuMonoDeque {
+public:
+  void reset() { head = 0; count = 0; }
+  
+  void push(uint32_t seq, uint16_t value) {
+    // Expire the front once it falls out of the window; this also keeps
+    // count < N before the new entry goes in
+    while (count > 0 && seq - entries[head].seq >= N) {
+      head = (head + 1) & (N - 1);
+      count--;
+    }
+    // Drop values the new one dominates for as long as it is in window
+    while (count > 0 && dominated(entries[back_index()].value, value)) count--;
+    entries[(head + count) & (N - 1)] = {seq, value};
+    count++;
+  }
+  
+  uint16_t front() const { return count ? entries[head].value : 0; }
+
+private:
+  struct Entry {
+    uint32_t seq;
+    uint16_t value;
+  };
+  
+  static bool dominated(uint16_t old_value, uint16_t value) {
+    return KeepMin ? old_value >= value : old_value <= value;
+  }
+  uint16_t back_index() const { return (head + count - 1) & (N - 1); }
+  
+  Entry entries[N];
+  uint16_t head = 0;
+  uint16_t count = 0;
+};
+
+// ===================================================================
+// Feature Window
+// ===================================================================
+
+template <uint16_t N>
+class ImuFeatureWindow {
+  static_assert(N >= 4 && (N & (N - 1)) == 0, "Feature window must be a power of two");
+
+public:
+  void reset() {
+    seq = 0;
+    filled = 0;
+    sum_mag = sum_jerk = sum_sma = 0;
+    sum_mag_sq = 0;
+    for (int a = 0; a < 3; a++) old_sum[a] = new_sum[a] = 0;
+    min_mag.reset();
+    max_mag.reset();
+    max_jerk.reset();
+    last_t_ms = 0;
+  }
+  
+  void push(const ImuFeatureSample& s, uint32_t t_ms) {
+    uint16_t slot = seq & (N - 1);
+    
+    if (filled == N) {
+      // Evict the oldest sample (it sat in the older half)
+      const ImuFeatureSample& e = ring[slot];
+      sum_mag -= e.mag_mg;
+      sum_mag_sq -= (uint32_t)e.mag_mg * e.mag_mg;
+      sum_jerk -= e.jerk_mg;
+      sum_sma -= e.sma_mg;
+      old_sum[0] -= e.ax;
+      old_sum[1] -= e.ay;
+      old_sum[2] -= e.az;
+    }
+    if (filled >= N / 2) {
+      // The sample N/2 back crosses from the newer to the older half
+      const ImuFeatureSample& m = ring[(seq - N / 2) & (N - 1)];
+      new_sum[0] -= m.ax; old_sum[0] += m.ax;
+      new_sum[1] -= m.ay; old_sum[1] += m.ay;
+      new_sum[2] -= m.az; old_sum[2] += m.az;
+    }
+    
+    ring[slot] = s;
+    sum_mag += s.mag_mg;
+    sum_mag_sq += (uint32_t)s.mag_mg * s.mag_mg;
+    sum_jerk += s.jerk_mg;
+    sum_sma += s.sma_mg;
+    new_sum[0] += s.ax;
+    new_sum[1] += s.ay;
+    new_sum[2] += s.az;
+    min_mag.push(seq, s.mag_mg);
+    max_mag.push(seq, s.mag_mg);
+    max_jerk.push(seq, s.jerk_mg);
+    seq++;
+    if (filled < N) filled++;
+    last_t_ms = t_ms;
+  }
+  
+  uint16_t count() const { return filled; }
+  
+  ImuFeatures features(float sample_rate_hz) const {
+    ImuFeatures f = {};
+    uint16_t n = count();
+    f.samples = n;
+    f.t_ms = last_t_ms;
+    if (n == 0) return f;
+    
+    // n * sum(x^2) - sum(x)^2 is exact in 64 bits for N <= 65536
+    uint64_t spread = (uint64_t)n * sum_mag_sq - (uint64_t)sum_mag * sum_mag;
+    f.mean_g = sum_mag / (1000.0f * n);
+    f.std_g = sqrtf((float)spread) / (1000.0f * n);
+    f.min_g = min_mag.front() / 1000.0f;
+    f.max_g = max_mag.front() / 1000.0f;
+    f.jerk_mean_g_s = sum_jerk * sample_rate_hz / (1000.0f * n);
+    f.jerk_max_g_s = max_jerk.front() * sample_rate_hz / 1000.0f;
+    f.sma_g = sum_sma / (1000.0f * n);
+    f.tilt_deg = n == N ? angle_deg(old_sum, new_sum) : 0.0f;
+    return f;
+  }
+
+private:
+  static float angle_deg(const int32_t* a, const int32_t* b) {
+    float dot = (float)a[0] * b[0] + (float)a[1] * b[1] + (float)a[2] * b[2];
+    float na = sqrtf((float)a[0] * a[0] + (float)a[1] * a[1] + (float)a[2] * a[2]);
+    float nb = sqrtf((float)b[0] * b[0] + (float)b[1] * b[1] + (float)b[2] * b[2]);
+    if (na == 0 || nb == 0) return 0.0f;
+    float c = dot / (na * nb);
+    if (c > 1.0f) c = 1.0f;
+    if (c < -1.0f) c = -1.0f;
+    return acosf(c) * 57.29578f;
+  }
+  
+  ImuFeatureSample ring[N];
+  uint32_t seq = 0;                     // Wraps; used modulo N and in differences
+  uint16_t filled = 0;
+  uint32_t sum_mag = 0, sum_jerk = 0, sum_sma = 0;
+  uint64_t sum_mag_sq = 0;
+  int32_t old_sum[3] = {0, 0, 0};
+  int32_t new_sum[3] = {0, 0, 0};
+  ImuMonoDeque<N, true> min_mag;
+  ImuMonoDeque<N, false> max_mag;
+  ImuMonoDeque<N, false> max_jerk;
+  uint32_t last_t_ms = 0;
+};
+
+// ===================================================================
+// Feature Engine
+// ===================================================================
+
+enum ImuFeatureWindowId {
+  IMU_FEATURES_SHORT,
+  IMU_FEATURES_LONG,
+  IMU_FEATURE_WINDOW_COUNT
+};
+
+typedef void (*ImuFeatureHandler)(const ImuFeatures& features, void* ctx);
+
+// lsb_per_g converts raw counts; sample_rate_hz scales jerk to g/s
+void imu_features_init(float sample_rate_hz, float lsb_per_g);
+
+// Called from wherever samples are produced; runs due subscribers
+void imu_features_push(int16_t ax, int16_t ay, int16_t az, uint32_t t_ms);
+
+// Handler runs every every_n samples in the pushing task
+bool imu_features_subscribe(ImuFeatureWindowId window, uint16_t every_n,
+                            ImuFeatureHandler handler, void* ctx);
+
+// Snapshot refreshed every IMU_FEATURE_SNAPSHOT_EVERY samples, for
+// readers in other tasks (diagnostics); not synchronised
+ImuFeatures imu_features_get(ImuFeatureWindowId window);
+
+// Features as of the last push; for subscribers that need both windows
+ImuFeatures imu_features_now(ImuFeatureWindowId window);
+
+// Shared per-sample preprocessing (counts -> mg, jerk against prev)
+ImuFeatureSample imu_feature_sample(int16_t ax, int16_t ay, int16_t az,
+                                    const ImuFeatureSample* prev, float lsb_per_g);
+
+#endif // IMU_FEATURES_H
@@ -0,0 +1,90 @@
+#include "imu_fifo.h"
+#include <string.h>
+
+// ===================================================================
+// FIFO Initialization
+// ===================================================================
+
+void imu_fifo_init(ImuFifo& fifo, const ImuFifoBus& bus, uint32_t period_us) {
+  fifo.bus = bus;
+  fifo.period_us = period_us;
+  memset(&fifo.stats, 0, sizeof(fifo.stats));
+}
+
+// ===================================================================
+// Frame Decoding
+// ===================================================================
+
+static inline int16_t be16(const uint8_t* p) {
+  return (int16_t)(((uint16_t)p[0] << 8) | p[1]);
+}
+
+void imu_fifo_decode(const uint8_t* frame, ImuRawSample& sample) {
+  sample.ax = be16(frame + 0);
+  sample.ay = be16(frame + 2);
+  sample.az = be16(frame + 4);
+  sample.gx = be16(frame + 6);
+  sample.gy = be16(frame + 8);
+  sample.gz = be16(frame + 10);
+}
+
+// ===================================================================
+// FIFO Drain
+// ===================================================================
+// Reads FIFO_COUNT once, then pulls every complete frame in bursts of
+// up to IMU_FIFO_MAX_BURST_FRAMES. The newest frame is assumed to have
+// been captured at now_us; older frames are spaced one period apart.
+// A count that is not a whole number of frames caught the chip writing
+// the next one; its bytes stay queued and are drained next time.
+// ===================================================================
+
+size_t imu_fifo_drain(ImuFifo& fifo, uint32_t now_us, ImuSampleRing& out) {
+  int queued = fifo.bus.count(fifo.bus.ctx);
+  fifo.stats.count_reads++;
+  
+  if (queued < 0) {
+    fifo.stats.bus_errors++;
+    return 0;
+  }
+  
+  // A full FIFO has overwritten its oldest bytes, so frame boundaries
+  // are lost and the contents are garbage
+  if (queued >= MPU6050_FIFO_SIZE - MPU6050_FIFO_FRAME_BYTES + 1) {
+    fifo.stats.overflows++;
+    fifo.bus.reset(fifo.bus.ctx);
+    return 0;
+  }
+  
+  size_t frames = queued / MPU6050_FIFO_FRAME_BYTES;
+  size_t delivered = 0;
+  uint8_t burst[IMU_FIFO_MAX_BURST_FRAMES * MPU6050_FIFO_FRAME_BYTES];
+  
+  while (delivered < frames) {
+    size_t n = frames - delivered;
+    if (n > IMU_FIFO_MAX_BURST_FRAMES) n = IMU_FIFO_MAX_BURST_FRAMES;
+    
+    fifo.stats.bursts++;
+    if (!fifo.bus.read(fifo.bus.ctx, burst, n * MPU6050_FIFO_FRAME_BYTES)) {
+      // Part of a frame may already have been clocked out; resync
+      fifo.stats.bus_errors++;
+      fifo.bus.reset(fifo.bus.ctx);
+      break;
+    }
+    
+    for (size_t i = 0; i < n; i++) {
+      ImuRawSample sample;
+      imu_fifo_decode(burst + i * MPU6050_FIFO_FRAME_BYTES, sample);
+      size_t age = frames - 1 - (delivered + i);
+      sample.t_us = now_us - (uint32_t)(age * fifo.period_us);
+      
+      if (out.push(sample)) {
+        fifo.stats.samples++;
+      } else {
+        fifo.stats.dropped++;
+      }
+    }
+    delivered += n;
+  }
+  
+  return delivered;
+}
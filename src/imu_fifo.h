@@ -0,0 +1,66 @@
+#ifndef IMU_FIFO_H
+#define IMU_FIFO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ring_buffer.h"
+
+// ===================================================================
+// MPU6050 FIFO Drain
+// ===================================================================
+// The MPU6050 is configured to push accel + gyro (12 bytes per sample)
+// into its 1 KB FIFO at IMU_SAMPLE_RATE_HZ. This module drains whole
+// frames with multi-byte burst reads and stamps each one with its
+// reconstructed capture time. It has no Arduino dependencies: the bus
+// is reached through ImuFifoBus so the drain logic can be driven from
+// a fake FIFO on a host build.
+// ===================================================================
+
+#define MPU6050_FIFO_FRAME_BYTES 12    // ax, ay, az, gx, gy, gz (big-endian int16)
+#define MPU6050_FIFO_SIZE        1024
+
+// ESP32 Wire buffers are 128 bytes; 10 frames per burst keeps each
+// transaction inside that limit while amortising the address phase.
+#define IMU_FIFO_MAX_BURST_FRAMES 10
+#define IMU_FIFO_RING_SIZE        128
+
+struct ImuRawSample {
+  int16_t ax, ay, az;   // Raw accelerometer counts
+  int16_t gx, gy, gz;   // Raw gyroscope counts
+  uint32_t t_us;        // Reconstructed capture time
+};
+
+typedef RingBuffer<ImuRawSample, IMU_FIFO_RING_SIZE> ImuSampleRing;
+
+// Bus access used by the drain. All calls are synchronous.
+struct ImuFifoBus {
+  int (*count)(void* ctx);                               // Bytes queued, <0 on bus error
+  bool (*read)(void* ctx, uint8_t* buf, size_t len);     // Burst read from FIFO_R_W
+  void (*reset)(void* ctx);                              // Flush FIFO (after overflow)
+  void* ctx;
+};
+
+struct ImuFifoStats {
+  uint32_t samples;      // Frames delivered to the ring
+  uint32_t bursts;       // FIFO_R_W burst transactions
+  uint32_t count_reads;  // FIFO_COUNT transactions
+  uint32_t overflows;    // FIFO overflow resets
+  uint32_t dropped;      // Frames lost because the ring was full
+  uint32_t bus_errors;
+};
+
+struct ImuFifo {
+  ImuFifoBus bus;
+  uint32_t period_us;    // Sample period configured in SMPLRT_DIV
+  ImuFifoStats stats;
+};
+
+// ===================================================================
+// FIFO Functions
+// ===================================================================
+
+void imu_fifo_init(ImuFifo& fifo, const ImuFifoBus& bus, uint32_t period_us);
+size_t imu_fifo_drain(ImuFifo& fifo, uint32_t now_us, ImuSampleRing& out);
+void imu_fifo_decode(const uint8_t* frame, ImuRawSample& sample);
+
+#endif // IMU_FIFO_H
@@ -0,0 +1,422 @@
+#include "journal.h"
+#include <math.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_partition.h>
+#endif
+
+// ===================================================================
+// Encoding
+// ===================================================================
+
+static void put_u16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+  put_u16(p, (uint16_t)v);
+  put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get_u16(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+  return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+static int16_t scaled(float v, float scale) {
+  float s = v * scale;
+  if (s >= 32767.0f) return 32767;
+  if (s <= -32768.0f) return -32768;
+  return (int16_t)lroundf(s);
+}
+
+static uint32_t crc32(const void* data, size_t len) {
+  const uint8_t* p = (const uint8_t*)data;
+  uint32_t crc = 0xFFFFFFFF;
+  while (len--) {
+    crc ^= *p++;
+    for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+  }
+  return ~crc;
+}
+
+static uint16_t crc16_update(uint16_t crc, const uint8_t* p, size_t len) {
+  while (len--) {
+    crc ^= (uint16_t)*p++ << 8;
+    for (int k = 0; k < 8; k++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+static uint16_t record_crc(uint8_t type, uint8_t len, const uint8_t* payload) {
+  uint8_t head[2] = {type, len};
+  return crc16_update(crc16_update(0xFFFF, head, 2), payload, len);
+}
+
+// ===================================================================
+// Segments
+// ===================================================================
+
+static uint32_t seg_addr(uint16_t seg) {
+  return (uint32_t)seg * JOURNAL_SEGMENT_BYTES;
+}
+
+static uint16_t seg_next(const Journal& j, uint16_t seg) {
+  return seg + 1 == j.segments ? 0 : seg + 1;
+}
+
+static uint16_t seg_prev(const Journal& j, uint16_t seg) {
+  return seg == 0 ? j.segments - 1 : seg - 1;
+}
+
+// Log offset just past the segment's last record
+static uint32_t seg_end(const Journal& j, uint16_t seg) {
+  return seg == j.head ? j.head_off : j.seg_off[seg_next(j, seg)];
+}
+
+static bool read_header(const Journal& j, uint16_t seg, uint32_t& seq, uint32_t& off) {
+  uint8_t h[JOURNAL_HEADER_BYTES];
+  if (!j.flash.read(j.flash.ctx, seg_addr(seg), h, sizeof(h))) return false;
+  if (get_u32(h) != JOURNAL_MAGIC || get_u32(h + 12) != crc32(h, 12)) return false;
+  seq = get_u32(h + 4);
+  off = get_u32(h + 8);
+  return true;
+}
+
+static bool flash_write(Journal& j, uint32_t addr, const void* data, size_t len) {
+  if (!j.flash.write(j.flash.ctx, addr, data, len)) {
+    j.stats.errors++;
+    return false;
+  }
+  j.stats.flash_bytes += len;
+  return true;
+}
+
+// Erase seg and make it the head, its first record at the head offset.
+// When it is the tail, the oldest segment goes.
+static bool open_segment(Journal& j, uint16_t seg) {
+  if (seg == j.tail && j.mounted) {
+    j.tail = seg_next(j, j.tail);
+    j.stats.overwritten++;
+  }
+  j.stats.erases++;
+  if (!j.flash.erase(j.flash.ctx, seg_addr(seg))) {
+    j.stats.errors++;
+    return false;
+  }
+  
+  uint8_t h[JOURNAL_HEADER_BYTES];
+  put_u32(h, JOURNAL_MAGIC);
+  put_u32(h + 4, j.seq + 1);
+  put_u32(h + 8, j.head_off);
+  put_u32(h + 12, crc32(h, 12));
+  if (!flash_write(j, seg_addr(seg), h, sizeof(h))) return false;
+  
+  j.seq++;
+  j.head = seg;
+  j.seg_off[seg] = j.head_off;
+  j.pos = JOURNAL_HEADER_BYTES;
+  j.buf_len = 0;
+  return true;
+}
+
+void journal_flush(Journal& j) {
+  if (j.buf_len == 0) return;
+  flash_write(j, seg_addr(j.head) + j.pos - j.buf_len, j.buf, j.buf_len);
+  j.stats.flushes++;
+  j.buf_len = 0;
+}
+
+// ===================================================================
+// Mount
+// ===================================================================
+
+// Records of the head segment from its header on; false if one fails
+// its CRC before the erased end
+static bool scan_head(Journal& j) {
+  uint32_t addr = seg_addr(j.head);
+  uint16_t pos = JOURNAL_HEADER_BYTES;
+  uint8_t rec[JOURNAL_RECORD_HEADER + JOURNAL_PAYLOAD_MAX];
+  while (pos + JOURNAL_RECORD_HEADER <= JOURNAL_SEGMENT_BYTES) {
+    if (!j.flash.read(j.flash.ctx, addr + pos, rec, JOURNAL_RECORD_HEADER)) return false;
+    if (rec[0] == 0xFF && rec[1] == 0xFF && rec[2] == 0xFF && rec[3] == 0xFF) break;
+    size_t size = JOURNAL_RECORD_HEADER + rec[1];
+    if (rec[0] == 0xFF || pos + size > JOURNAL_SEGMENT_BYTES) return false;
+    if (!j.flash.read(j.flash.ctx, addr + pos + JOURNAL_RECORD_HEADER, rec + JOURNAL_RECORD_HEADER, rec[1])) {
+      return false;
+    }
+    if (get_u16(rec + 2) != record_crc(rec[0], rec[1], rec + JOURNAL_RECORD_HEADER)) return false;
+    pos += size;
+    j.head_off += size;
+  }
+  j.pos = pos;
+  return true;
+}
+
+bool journal_mount(Journal& j, const JournalFlash& flash) {
+  j = {};
+  j.flash = flash;
+  j.segments = flash.size / JOURNAL_SEGMENT_BYTES;
+  if (j.segments > JOURNAL_MAX_SEGMENTS) j.segments = JOURNAL_MAX_SEGMENTS;
+  if (j.segments < 2) return false;
+  
+  // The newest valid segment is the head
+  bool found = false;
+  for (uint16_t s = 0; s < j.segments; s++) {
+    uint32_t seq, off;
+    if (!read_header(j, s, seq, off)) continue;
+    j.seg_off[s] = off;
+    if (!found || (int32_t)(seq - j.seq) > 0) {
+      j.head = s;
+      j.seq = seq;
+      found = true;
+    }
+  }
+  
+  if (!found) {
+    j.head = j.tail = 0;
+    j.seq = 0;
+    bool ok = open_segment(j, 0);
+    j.mounted = ok;
+    return ok;
+  }
+  
+  // Back from the head while the seqs run on and the offsets grow
+  j.tail = j.head;
+  for (uint16_t n = 1; n < j.segments; n++) {
+    uint16_t prev = seg_prev(j, j.tail);
+    uint32_t seq, off;
+    if (!read_header(j, prev, seq, off) || seq != j.seq - n || (int32_t)(j.seg_off[j.tail] - off) < 0) break;
+    j.tail = prev;
+  }
+  
+  j.head_off = j.seg_off[j.head];
+  bool clean = scan_head(j);
+  j.mounted = true;
+  if (!clean) {
+    j.stats.torn++;
+    return open_segment(j, seg_next(j, j.head));
+  }
+  return true;
+}
+
+// ===================================================================
+// Append
+// ===================================================================
+
+bool journal_append(Journal& j, JournalRecordType type, const void* payload, size_t len, uint32_t now_ms) {
+  if (!j.mounted || len > JOURNAL_PAYLOAD_MAX) {
+    j.stats.rejected++;
+    return false;
+  }
+  size_t size = JOURNAL_RECORD_HEADER + len;
+  if (j.pos + size > JOURNAL_SEGMENT_BYTES) {
+    journal_flush(j);
+    if (!open_segment(j, seg_next(j, j.head))) return false;
+  }
+  if (j.buf_len + size > JOURNAL_BUFFER_BYTES) journal_flush(j);
+  if (j.buf_len == 0) j.buf_ms = now_ms;
+  
+  // Records longer than the buffer go straight to flash
+  uint8_t head[JOURNAL_RECORD_HEADER];
+  head[0] = (uint8_t)type;
+  head[1] = (uint8_t)len;
+  put_u16(head + 2, record_crc(head[0], head[1], (const uint8_t*)payload));
+  if (size > JOURNAL_BUFFER_BYTES) {
+    uint32_t addr = seg_addr(j.head) + j.pos;
+    if (!flash_write(j, addr, head, sizeof(head)) || !flash_write(j, addr + sizeof(head), payload, len)) {
+      return false;
+    }
+  } else {
+    memcpy(j.buf + j.buf_len, head, sizeof(head));
+    memcpy(j.buf + j.buf_len + sizeof(head), payload, len);
+    j.buf_len += size;
+  }
+  j.pos += size;
+  j.head_off += size;
+  j.stats.records++;
+  j.stats.payload_bytes += len;
+  return true;
+}
+
+void journal_service(Journal& j, uint32_t now_ms) {
+  if (j.buf_len > 0 && now_ms - j.buf_ms >= JOURNAL_FLUSH_MS) journal_flush(j);
+}
+
+bool journal_log_boot(Journal& j, uint8_t reset_reason, uint32_t now_ms) {
+  uint8_t p[5];
+  put_u32(p, now_ms);
+  p[4] = reset_reason;
+  return journal_append(j, JOURNAL_REC_BOOT, p, sizeof(p), now_ms);
+}
+
+bool journal_log_sample(Journal& j, const TelemetryValues& v, uint32_t t_ms) {
+  uint8_t p[JOURNAL_SAMPLE_PAYLOAD];
+  put_u32(p, t_ms);
+  bool imu = v.flags & TELEMETRY_FLAG_IMU;
+  put_u16(p + 4, imu ? scaled(v.ax, 1000.0f) : 0);
+  put_u16(p + 6, imu ? scaled(v.ay, 1000.0f) : 0);
+  put_u16(p + 8, imu ? scaled(v.az, 1000.0f) : 0);
+  put_u16(p + 10, imu ? scaled(v.gx, 10.0f) : 0);
+  put_u16(p + 12, imu ? scaled(v.gy, 10.0f) : 0);
+  put_u16(p + 14, imu ? scaled(v.gz, 10.0f) : 0);
+  put_u16(p + 16, scaled(v.pitch_deg, 100.0f));
+  put_u16(p + 18, scaled(v.roll_deg, 100.0f));
+  put_u16(p + 20, (uint16_t)(v.flags & TELEMETRY_FLAG_TOF ? v.dist_mm : -1));
+  p[22] = v.flags & TELEMETRY_FLAG_BATTERY ? v.battery_pct : 0xFF;
+  p[23] = v.flags;
+  return journal_append(j, JOURNAL_REC_SAMPLE, p, sizeof(p), t_ms);
+}
+
+bool journal_log_gait(Journal& j, const GaitSummary& g, uint32_t t_ms) {
+  uint8_t p[JOURNAL_GAIT_PAYLOAD];
+  put_u32(p, t_ms);
+  put_u32(p + 4, g.steps);
+  put_u32(p + 8, g.plants);
+  put_u16(p + 12, g.cadence_spm);
+  put_u16(p + 14, g.stride_ms);
+  put_u16(p + 16, (uint16_t)lroundf(g.stride_cv * 1000.0f));
+  put_u16(p + 18, g.bouts);
+  put_u32(p + 20, g.walking_s);
+  put_u16(p + 24, g.bout_steps);
+  put_u16(p + 26, g.longest_bout_steps);
+  p[28] = g.walking;
+  return journal_append(j, JOURNAL_REC_GAIT, p, sizeof(p), t_ms);
+}
+
+bool journal_log_alert(Journal& j, uint32_t seq, const char* json, uint32_t t_ms) {
+  uint8_t p[JOURNAL_PAYLOAD_MAX];
+  size_t len = strlen(json);
+  if (len > sizeof(p) - 8) len = sizeof(p) - 8;
+  put_u32(p, t_ms);
+  put_u32(p + 4, seq);
+  memcpy(p + 8, json, len);
+  return journal_append(j, JOURNAL_REC_ALERT, p, 8 + len, t_ms);
+}
+
+// ===================================================================
+// Read
+// ===================================================================
+
+uint32_t journal_tail(const Journal& j) {
+  return j.seg_off[j.tail];
+}
+
+uint32_t journal_head(const Journal& j) {
+  return j.head_off;
+}
+
+size_t journal_read(Journal& j, uint32_t& offset, uint8_t* out, size_t max) {
+  if (!j.mounted) return 0;
+  uint32_t tail = journal_tail(j);
+  if ((int32_t)(offset - tail) < 0 || (int32_t)(offset - j.head_off) > 0) offset = tail;
+  if (offset == j.head_off) return 0;
+  
+  // Segments are in offset order from the tail
+  uint16_t seg = j.tail;
+  while (seg != j.head && (int32_t)(offset - seg_end(j, seg)) >= 0) seg = seg_next(j, seg);
+  uint32_t end = seg_end(j, seg);
+  size_t n = end - offset;
+  if (n > max) n = max;
+  
+  // Flash up to the buffered bytes, the buffer after
+  uint32_t pos = JOURNAL_HEADER_BYTES + (offset - j.seg_off[seg]);
+  uint32_t flushed = seg == j.head ? (uint32_t)(j.pos - j.buf_len) : JOURNAL_SEGMENT_BYTES;
+  size_t from_flash = pos < flushed ? (flushed - pos < n ? flushed - pos : n) : 0;
+  if (from_flash && !j.flash.read(j.flash.ctx, seg_addr(seg) + pos, out, from_flash)) {
+    j.stats.errors++;
+    return 0;
+  }
+  if (n > from_flash) memcpy(out + from_flash, j.buf + (pos + from_flash - flushed), n - from_flash);
+  return n;
+}
+
+// ===================================================================
+// Reader
+// ===================================================================
+
+size_t journal_parse(const uint8_t* in, size_t len, JournalRecord& rec) {
+  if (len < JOURNAL_RECORD_HEADER || len < JOURNAL_RECORD_HEADER + (size_t)in[1]) return 0;
+  rec.type = in[0];
+  rec.len = in[1];
+  rec.payload = in + JOURNAL_RECORD_HEADER;
+  rec.crc_ok = get_u16(in + 2) == record_crc(rec.type, rec.len, rec.payload);
+  return JOURNAL_RECORD_HEADER + rec.len;
+}
+
+uint32_t journal_record_ms(const JournalRecord& rec) {
+  return rec.len >= 4 ? get_u32(rec.payload) : 0;
+}
+
+bool journal_decode_sample(const JournalRecord& rec, TelemetryValues& v, uint32_t& t_ms) {
+  if (rec.type != JOURNAL_REC_SAMPLE || rec.len < JOURNAL_SAMPLE_PAYLOAD) return false;
+  const uint8_t* p = rec.payload;
+  v = {};
+  t_ms = get_u32(p);
+  v.ax = (int16_t)get_u16(p + 4) / 1000.0f;
+  v.ay = (int16_t)get_u16(p + 6) / 1000.0f;
+  v.az = (int16_t)get_u16(p + 8) / 1000.0f;
+  v.gx = (int16_t)get_u16(p + 10) / 10.0f;
+  v.gy = (int16_t)get_u16(p + 12) / 10.0f;
+  v.gz = (int16_t)get_u16(p + 14) / 10.0f;
+  v.pitch_deg = (int16_t)get_u16(p + 16) / 100.0f;
+  v.roll_deg = (int16_t)get_u16(p + 18) / 100.0f;
+  v.dist_mm = (int16_t)get_u16(p + 20);
+  v.battery_pct = p[22];
+  v.flags = p[23] & ~TELEMETRY_FLAG_ZONES;
+  v.runtime_min = 0xFFFF;
+  for (int z = 0; z < TOF_ZONE_COUNT; z++) v.zone_mm[z] = -1;
+  return true;
+}
+
+bool journal_decode_gait(const JournalRecord& rec, GaitSummary& g) {
+  if (rec.type != JOURNAL_REC_GAIT || rec.len < JOURNAL_GAIT_PAYLOAD) return false;
+  const uint8_t* p = rec.payload;
+  g = {};
+  g.t_ms = get_u32(p);
+  g.steps = get_u32(p + 4);
+  g.plants = get_u32(p + 8);
+  g.cadence_spm = get_u16(p + 12);
+  g.stride_ms = get_u16(p + 14);
+  g.stride_cv = get_u16(p + 16) / 1000.0f;
+  g.bouts = get_u16(p + 18);
+  g.walking_s = get_u32(p + 20);
+  g.bout_steps = get_u16(p + 24);
+  g.longest_bout_steps = get_u16(p + 26);
+  g.walking = p[28] != 0;
+  return true;
+}
+
+// ===================================================================
+// Partition (firmware)
+// ===================================================================
+
+#ifdef ESP_PLATFORM
+static bool part_read(void* ctx, uint32_t addr, void* data, size_t len) {
+  return esp_partition_read((const esp_partition_t*)ctx, addr, data, len) == ESP_OK;
+}
+
+static bool part_write(void* ctx, uint32_t addr, const void* data, size_t len) {
+  return esp_partition_write((const esp_partition_t*)ctx, addr, data, len) == ESP_OK;
+}
+
+static bool part_erase(void* ctx, uint32_t addr) {
+  return esp_partition_erase_range((const esp_partition_t*)ctx, addr, JOURNAL_SEGMENT_BYTES) == ESP_OK;
+}
+
+bool journal_mount_partition(Journal& j) {
+  const esp_partition_t* part = esp_partition_find_first(
+    ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)JOURNAL_PARTITION_SUBTYPE, "journal");
+  if (!part) {
+    j = {};
+    return false;
+  }
+  JournalFlash flash = {part->size, part_read, part_write, part_erase, (void*)part};
+  return journal_mount(j, flash);
+}
+#endif
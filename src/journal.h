@@ -0,0 +1,164 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "telemetry_frame.h"
+#include "gait.h"
+
+// ===================================================================
+// Telemetry Journal
+// ===================================================================
+// Append-only log of compact binary records (samples, gait summaries,
+// alerts, boots) on a dedicated flash partition, kept whether or not a
+// phone is in range and downloaded later by byte offset.
+//
+// The partition is a ring of 4 KB segments, one erase sector each,
+// written strictly in order: the only erase is of the segment the log
+// moves into, so every sector wears at the same rate and a full ring
+// overwrites the oldest segment. Segment layout:
+//   0   header  16 bytes  magic "JRN1", segment seq, log offset of the
+//                         first record, CRC-32 of the three
+//   16  records back to back; erased flash (0xFF) after the last
+// Record: u8 type, u8 payload length, u16 CRC-16/CCITT of type, length
+// and payload, then the payload. Records never span segments; the
+// unused tail of a full segment is skipped.
+//
+// The log offset counts record bytes since the journal was created, so
+// the log is one byte stream: a reader asks for the bytes from offset
+// N, and N stays valid across reconnects and resets until the ring
+// overwrites it. Records are buffered in RAM and programmed in runs of
+// up to JOURNAL_BUFFER_BYTES (when the buffer fills, the segment does,
+// or JOURNAL_FLUSH_MS passes), never rewritten; flash bytes programmed
+// per payload byte are bounded by the 4-byte record header, the
+// segment header and the unused segment tail.
+//
+// Mount trusts the longest run of segments with valid headers and
+// consecutive seqs ending at the newest, and scans the newest record
+// by record. A record cut by a reset fails its CRC; the log resumes in
+// a fresh segment after the last good record.
+//
+// Record payloads (little-endian), each starting with u32 t_ms
+// (millis() since the boot logged before it):
+//   BOOT    4 u8 reset reason (esp_reset_reason_t)
+//   SAMPLE  4 i16 x3 ax, ay, az mg; 10 i16 x3 gx, gy, gz 0.1 deg/s;
+//          16 i16 x2 pitch, roll 0.01 deg; 20 i16 dist_mm (-1 none);
+//          22 u8 battery % (0xFF none); 23 u8 TELEMETRY_FLAG_*
+//   GAIT    4 u32 steps, 8 u32 plants, 12 u16 cadence_spm,
+//          14 u16 stride_ms, 16 u16 stride_cv x 1000, 18 u16 bouts,
+//          20 u32 walking_s, 24 u16 bout_steps, 26 u16 longest,
+//          28 u8 walking
+//   ALERT   4 u32 alert seq (alert_queue.h), 8 the alert JSON
+//
+// Not thread-safe: one task appends, services and reads. Portable over
+// a JournalFlash; tools/journal_bench.cpp runs it on a file-backed
+// flash emulator.
+// ===================================================================
+
+#define JOURNAL_MAGIC            0x314E524A   // "JRN1"
+#define JOURNAL_SEGMENT_BYTES    4096         // One flash erase sector
+#define JOURNAL_HEADER_BYTES     16
+#define JOURNAL_RECORD_HEADER    4
+#define JOURNAL_PAYLOAD_MAX      255
+#define JOURNAL_MAX_SEGMENTS     256          // 1 MB partition
+#define JOURNAL_BUFFER_BYTES     256          // One flash page
+#define JOURNAL_FLUSH_MS         2000         // Longest a record waits in RAM
+#define JOURNAL_PARTITION_SUBTYPE 0x41
+
+enum JournalRecordType {
+  JOURNAL_REC_BOOT = 1,
+  JOURNAL_REC_SAMPLE = 2,
+  JOURNAL_REC_GAIT = 3,
+  JOURNAL_REC_ALERT = 4
+};
+
+#define JOURNAL_SAMPLE_PAYLOAD 24
+#define JOURNAL_GAIT_PAYLOAD   29
+
+// Flash access, addresses relative to the partition. write may assume
+// the bytes are erased; erase clears one segment.
+struct JournalFlash {
+  uint32_t size;
+  bool (*read)(void* ctx, uint32_t addr, void* data, size_t len);
+  bool (*write)(void* ctx, uint32_t addr, const void* data, size_t len);
+  bool (*erase)(void* ctx, uint32_t addr);
+  void* ctx;
+};
+
+struct JournalStats {
+  uint32_t records;
+  uint32_t payload_bytes;
+  uint32_t flash_bytes;       // Programmed: records, headers
+  uint32_t flushes;
+  uint32_t erases;
+  uint32_t overwritten;       // Segments the ring wrapped over
+  uint32_t torn;              // Records cut by a reset, found at mount
+  uint32_t errors;            // Flash operations that failed
+  uint32_t rejected;          // Appends while unmounted or too long
+};
+
+struct Journal {
+  JournalFlash flash;
+  bool mounted;
+  uint16_t segments;
+  uint16_t head;              // Segment being written
+  uint16_t tail;              // Oldest segment
+  uint32_t seq;               // The head segment's
+  uint16_t pos;               // Next record in the head, buffered included
+  uint32_t head_off;          // Log offset of the next record
+  uint32_t seg_off[JOURNAL_MAX_SEGMENTS];   // Log offset of each segment's first record
+  uint8_t buf[JOURNAL_BUFFER_BYTES];        // Ends at pos
+  uint16_t buf_len;
+  uint32_t buf_ms;            // When the oldest buffered record came
+  JournalStats stats;
+};
+
+// One record as parsed from the log
+struct JournalRecord {
+  uint8_t type;
+  uint8_t len;
+  const uint8_t* payload;
+  bool crc_ok;
+};
+
+// ===================================================================
+// Journal Functions
+// ===================================================================
+
+// Find the log on the flash, or start one; false if the flash is too
+// small or unusable
+bool journal_mount(Journal& j, const JournalFlash& flash);
+
+bool journal_append(Journal& j, JournalRecordType type, const void* payload, size_t len, uint32_t now_ms);
+bool journal_log_boot(Journal& j, uint8_t reset_reason, uint32_t now_ms);
+bool journal_log_sample(Journal& j, const TelemetryValues& v, uint32_t t_ms);
+bool journal_log_gait(Journal& j, const GaitSummary& g, uint32_t t_ms);
+bool journal_log_alert(Journal& j, uint32_t seq, const char* json, uint32_t t_ms);
+
+// Program what is buffered: due (JOURNAL_FLUSH_MS), or now
+void journal_service(Journal& j, uint32_t now_ms);
+void journal_flush(Journal& j);
+
+// Oldest and next log offsets; [tail, head) can be read
+uint32_t journal_tail(const Journal& j);
+uint32_t journal_head(const Journal& j);
+
+// Up to max log bytes from offset, buffered bytes included. An offset
+// the ring has overwritten, or one past the head (a journal created
+// since), moves to the tail first. Returns the bytes copied, 0 at the
+// head.
+size_t journal_read(Journal& j, uint32_t& offset, uint8_t* out, size_t max);
+
+// Reader side: one record from in; its size, 0 if in holds less than a
+// whole record. A record with a bad CRC still gives its size.
+size_t journal_parse(const uint8_t* in, size_t len, JournalRecord& rec);
+bool journal_decode_sample(const JournalRecord& rec, TelemetryValues& v, uint32_t& t_ms);
+bool journal_decode_gait(const JournalRecord& rec, GaitSummary& g);
+uint32_t journal_record_ms(const JournalRecord& rec);
+
+#ifdef ESP_PLATFORM
+// The "journal" data partition; false if absent
+bool journal_mount_partition(Journal& j);
+#endif
+
+#endif // JOURNAL_H
@@ -0,0 +1,102 @@
+#include "landmark_db.h"
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_partition.h>
+#endif
+
+#define LANDMARK_PARTITION_SUBTYPE  0x40
+
+// ===================================================================
+// Hash
+// ===================================================================
+// Must match tools/build_landmarks.py.
+// ===================================================================
+
+uint32_t landmark_db_hash(const uint8_t* uid, uint8_t uid_len) {
+  uint32_t h = 2166136261u;
+  for (uint8_t i = 0; i < uid_len; i++) {
+    h ^= uid[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+// ===================================================================
+// Open
+// ===================================================================
+
+bool landmark_db_open(LandmarkDB& db, const void* image, size_t len) {
+  db.header = nullptr;
+  db.slots = nullptr;
+  
+  if (!image || len < sizeof(LandmarkHeader)) return false;
+  
+  const LandmarkHeader* header = (const LandmarkHeader*)image;
+  if (header->magic != LANDMARK_DB_MAGIC) return false;
+  if (header->version != LANDMARK_DB_VERSION) return false;
+  
+  uint32_t slots = header->slot_count;
+  if (slots == 0 || (slots & (slots - 1)) != 0) return false;
+  if (header->max_probe == 0 || header->max_probe > slots) return false;
+  if (header->entry_count > slots) return false;
+  if (len < sizeof(LandmarkHeader) + (size_t)slots * sizeof(LandmarkSlot)) return false;
+  
+  db.header = header;
+  db.slots = (const LandmarkSlot*)(header + 1);
+  return true;
+}
+
+// ===================================================================
+// Lookup
+// ===================================================================
+
+const LandmarkSlot* landmark_db_lookup(const LandmarkDB& db,
+                                       const uint8_t* uid, uint8_t uid_len) {
+  if (!db.header || uid_len == 0 || uid_len > LANDMARK_UID_MAX) return nullptr;
+  
+  uint32_t mask = db.header->slot_count - 1;
+  uint32_t index = landmark_db_hash(uid, uid_len) & mask;
+  
+  for (uint16_t probe = 0; probe < db.header->max_probe; probe++) {
+    const LandmarkSlot* slot = &db.slots[(index + probe) & mask];
+    if (slot->uid_len == 0) return nullptr;   // Empty slot ends the chain
+    if (slot->uid_len == uid_len && memcmp(slot->uid, uid, uid_len) == 0) {
+      return slot;
+    }
+  }
+  return nullptr;
+}
+
+// ===================================================================
+// Flash Partition
+// ===================================================================
+
+#ifdef ESP_PLATFORM
+bool landmark_db_mount(LandmarkDB& db) {
+  db.header = nullptr;
+  db.slots = nullptr;
+  
+  const esp_partition_t* part = esp_partition_find_first(
+    ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)LANDMARK_PARTITION_SUBTYPE, "landmarks");
+  if (!part) return false;
+  
+  // Read the header first so only the populated part is mapped
+  LandmarkHeader header;
+  if (esp_partition_read(part, 0, &header, sizeof(header)) != ESP_OK) return false;
+  if (header.magic != LANDMARK_DB_MAGIC) return false;
+  if (header.slot_count > part->size / sizeof(LandmarkSlot)) return false;
+  
+  size_t len = sizeof(LandmarkHeader) + (size_t)header.slot_count * sizeof(LandmarkSlot);
+  if (len > part->size) return false;
+  
+  const void* image = nullptr;
+  spi_flash_mmap_handle_t handle;
+  if (esp_partition_mmap(part, 0, len, SPI_FLASH_MMAP_DATA, &image, &handle) != ESP_OK) {
+    return false;
+  }
+  
+  // The mapping stays for the life of the firmware
+  return landmark_db_open(db, image, len);
+}
+#endif
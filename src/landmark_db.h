@@ -0,0 +1,84 @@
+#ifndef LANDMARK_DB_H
+#define LANDMARK_DB_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================================
+// RFID Landmark Index
+// ===================================================================
+// Maps binary tag UIDs to a landmark id, category and local cue so the
+// stick can announce a landmark without the phone. The table is built
+// offline by tools/build_landmarks.py and flashed to the "landmarks"
+// data partition, which is memory-mapped and read in place: no copy,
+// no heap.
+//
+// Image layout (little-endian):
+//   header  16 bytes  magic "LMK1", version, max_probe, slot_count,
+//                     entry_count
+//   slots   16 bytes each, slot_count a power of two
+//
+// Open addressing on FNV-1a of the UID with linear probing. The builder
+// records the longest probe sequence it produced, so a lookup touches
+// at most max_probe slots whether the tag is known or not.
+// ===================================================================
+
+#define LANDMARK_DB_MAGIC    0x314B4D4C   // "LMK1"
+#define LANDMARK_DB_VERSION  1
+#define LANDMARK_UID_MAX     10           // ISO14443 triple-size UID
+
+enum LandmarkCategory {
+  LANDMARK_GENERIC,
+  LANDMARK_DOOR,
+  LANDMARK_CROSSING,
+  LANDMARK_STAIRS,
+  LANDMARK_ELEVATOR,
+  LANDMARK_RESTROOM,
+  LANDMARK_EXIT,
+  LANDMARK_CATEGORY_COUNT
+};
+
+struct LandmarkHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t max_probe;
+  uint32_t slot_count;
+  uint32_t entry_count;
+};
+
+struct LandmarkSlot {
+  uint8_t uid_len;                  // 0 = empty slot
+  uint8_t uid[LANDMARK_UID_MAX];
+  uint8_t category;                 // LandmarkCategory
+  uint16_t landmark_id;
+  uint8_t cue;                      // Local haptic/audio cue index
+  uint8_t reserved;
+} __attribute__((packed));
+
+static_assert(sizeof(LandmarkHeader) == 16, "LandmarkHeader layout");
+static_assert(sizeof(LandmarkSlot) == 16, "LandmarkSlot layout");
+
+struct LandmarkDB {
+  const LandmarkHeader* header;     // nullptr when no valid image
+  const LandmarkSlot* slots;
+};
+
+// ===================================================================
+// Landmark Functions
+// ===================================================================
+
+// Validates an image in place; false (and an empty db) if malformed
+bool landmark_db_open(LandmarkDB& db, const void* image, size_t len);
+
+// Returns the slot for this UID, or nullptr if unknown
+const LandmarkSlot* landmark_db_lookup(const LandmarkDB& db,
+                                       const uint8_t* uid, uint8_t uid_len);
+
+uint32_t landmark_db_hash(const uint8_t* uid, uint8_t uid_len);
+
+#ifdef ESP_PLATFORM
+// Maps the "landmarks" partition and opens it; false if absent/empty
+bool landmark_db_mount(LandmarkDB& db);
+#endif
+
+#endif // LANDMARK_DB_H
@@ -0,0 +1,320 @@
+#include "log.h"
+#include <stdio.h>
+#include <stdarg.h>
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+// ===================================================================
+// Ring
+// ===================================================================
+// Bounded multi-producer queue (after Vyukov): a producer claims
+// position pos by moving head on while the slot's lap says it is free,
+// fills it, and marks it full; the consumer frees it for the next lap.
+// ===================================================================
+
+#define LOG_RING_MASK (LOG_RING_SLOTS - 1)
+
+static LogRecord slots[LOG_RING_SLOTS];
+static std::atomic<uint32_t> head(0);
+static std::atomic<uint32_t> dropped(0);
+static uint32_t tail = 0;                 // Consumer only
+static uint32_t reported_dropped = 0;
+static LogStats drain_stats = {};         // Consumer side counters
+static LogClock log_clock = nullptr;
+
+void log_init(LogClock clock) {
+  log_clock = clock;
+}
+
+// Lap base of pos: what the slot's lap holds while it is free for pos
+static uint32_t lap_of(uint32_t pos) {
+  return pos & ~(uint32_t)LOG_RING_MASK;
+}
+
+LogRecord* log_claim(uint8_t level, const char* fmt, uint32_t& pos) {
+  pos = head.load(std::memory_order_relaxed);
+  for (;;) {
+    LogRecord& r = slots[pos & LOG_RING_MASK];
+    int32_t dif = (int32_t)(r.lap.load(std::memory_order_acquire) - lap_of(pos));
+    if (dif == 0) {
+      if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        r.t_ms = log_clock ? (uint32_t)log_clock() : 0;
+        r.fmt = fmt;
+        r.level = level;
+        return &r;
+      }
+    } else if (dif < 0) {
+      // Still holding the record from a lap ago
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    } else {
+      pos = head.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void log_publish(LogRecord* r, uint32_t pos) {
+  r->lap.store(lap_of(pos) + 1, std::memory_order_release);
+}
+
+// ===================================================================
+// Formatting
+// ===================================================================
+
+struct LogArgReader {
+  const uint8_t* p;
+  const uint8_t* end;
+};
+
+struct LogArg {
+  uint8_t type;                 // 0 when the arguments ran out
+  uint64_t bits;
+  const char* str;
+  uint8_t str_len;
+};
+
+static bool next_arg(LogArgReader& in, LogArg& a) {
+  a = {};
+  if (in.p >= in.end) return false;
+  a.type = *in.p++;
+  size_t n = 0;
+  switch (a.type) {
+    case LOG_ARG_I32: case LOG_ARG_U32: case LOG_ARG_F32: n = 4; break;
+    case LOG_ARG_I64: case LOG_ARG_U64: case LOG_ARG_F64: case LOG_ARG_PTR: n = 8; break;
+    case LOG_ARG_STR:
+      if (in.p >= in.end) break;
+      a.str_len = *in.p++;
+      a.str = (const char*)in.p;
+      n = a.str_len;
+      break;
+  }
+  if (n > (size_t)(in.end - in.p) || (n == 0 && a.type != LOG_ARG_STR)) {
+    in.p = in.end;
+    a.type = 0;
+    return false;
+  }
+  if (a.type != LOG_ARG_STR) memcpy(&a.bits, in.p, n);
+  in.p += n;
+  return true;
+}
+
+static int64_t arg_signed(const LogArg& a) {
+  switch (a.type) {
+    case LOG_ARG_I32: case LOG_ARG_U32: return (int32_t)(uint32_t)a.bits;
+    case LOG_ARG_F32: { float f; uint32_t b = (uint32_t)a.bits; memcpy(&f, &b, 4); return (int64_t)f; }
+    case LOG_ARG_F64: { double d; memcpy(&d, &a.bits, 8); return (int64_t)d; }
+    default: return (int64_t)a.bits;
+  }
+}
+
+static uint64_t arg_unsigned(const LogArg& a) {
+  switch (a.type) {
+    case LOG_ARG_I32: case LOG_ARG_U32: return (uint32_t)a.bits;
+    case LOG_ARG_F32: case LOG_ARG_F64: return (uint64_t)arg_signed(a);
+    default: return a.bits;
+  }
+}
+
+static double arg_double(const LogArg& a) {
+  switch (a.type) {
+    case LOG_ARG_F32: { float f; uint32_t b = (uint32_t)a.bits; memcpy(&f, &b, 4); return f; }
+    case LOG_ARG_F64: { double d; memcpy(&d, &a.bits, 8); return d; }
+    case LOG_ARG_I32: case LOG_ARG_I64: return (double)arg_signed(a);
+    default: return (double)arg_unsigned(a);
+  }
+}
+
+struct LineOut {
+  char* buf;
+  size_t max;                   // Room for the text, newline excluded
+  size_t len;
+};
+
+static void out_char(LineOut& o, char c) {
+  if (o.len < o.max) o.buf[o.len++] = c;
+}
+
+static void out_printf(LineOut& o, const char* spec, ...) __attribute__((format(printf, 2, 3)));
+static void out_printf(LineOut& o, const char* spec, ...) {
+  if (o.len >= o.max) return;
+  va_list args;
+  va_start(args, spec);
+  int n = vsnprintf(o.buf + o.len, o.max - o.len + 1, spec, args);
+  va_end(args);
+  if (n > 0) o.len += (size_t)n < o.max - o.len ? (size_t)n : o.max - o.len;
+}
+
+// One conversion of fmt from just past its '%'; returns where the
+// format carries on
+static const char* format_one(LineOut& o, const char* p, LogArgReader& in) {
+  char spec[32];
+  size_t n = 0;
+  spec[n++] = '%';
+  while (*p && strchr("-+ #0", *p) && n < 8) spec[n++] = *p++;
+  
+  // Width and precision, either of which may come from an argument
+  for (int part = 0; part < 2; part++) {
+    if (part == 1) {
+      if (*p != '.') break;
+      spec[n++] = *p++;
+    }
+    if (*p == '*') {
+      LogArg a;
+      next_arg(in, a);
+      n += snprintf(spec + n, sizeof(spec) - n, "%d", (int)arg_signed(a));
+      p++;
+    } else {
+      while (*p >= '0' && *p <= '9' && n < 20) spec[n++] = *p++;
+    }
+  }
+  while (*p && strchr("hlLqjzt", *p)) p++;
+  
+  char conv = *p;
+  if (!conv) return p;
+  p++;
+  
+  LogArg a;
+  if (!next_arg(in, a)) {
+    out_char(o, '?');
+    return p;
+  }
+  switch (conv) {
+    case 'd': case 'i':
+      spec[n++] = 'l';
+      spec[n++] = 'l';
+      spec[n++] = conv;
+      spec[n] = '\0';
+      out_printf(o, spec, (long long)arg_signed(a));
+      break;
+    case 'u': case 'o': case 'x': case 'X':
+      spec[n++] = 'l';
+      spec[n++] = 'l';
+      spec[n++] = conv;
+      spec[n] = '\0';
+      out_printf(o, spec, (unsigned long long)arg_unsigned(a));
+      break;
+    case 'c':
+      spec[n++] = 'c';
+      spec[n] = '\0';
+      out_printf(o, spec, (int)arg_signed(a));
+      break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+      spec[n++] = conv;
+      spec[n] = '\0';
+      out_printf(o, spec, arg_double(a));
+      break;
+    case 's': {
+      if (a.type != LOG_ARG_STR) {
+        out_char(o, '?');
+        break;
+      }
+      char str[LOG_STR_MAX + 1];
+      memcpy(str, a.str, a.str_len);
+      str[a.str_len] = '\0';
+      spec[n++] = 's';
+      spec[n] = '\0';
+      out_printf(o, spec, str);
+      break;
+    }
+    case 'p':
+      out_printf(o, "%p", (void*)(uintptr_t)a.bits);
+      break;
+    default:
+      out_char(o, '?');
+      break;
+  }
+  return p;
+}
+
+// [s.mmm] and the message, cut to LOG_LINE_MAX; "~" marks arguments
+// that did not fit the record
+static size_t format_record(const LogRecord& r, char* line) {
+  LineOut o = {line, LOG_LINE_MAX - 1, 0};
+  out_printf(o, "[%lu.%03lu] ", (unsigned long)(r.t_ms / 1000), (unsigned long)(r.t_ms % 1000));
+  LogArgReader in = {r.args, r.args + r.len};
+  for (const char* p = r.fmt; *p;) {
+    if (*p != '%') {
+      out_char(o, *p++);
+    } else if (p[1] == '%') {
+      out_char(o, '%');
+      p += 2;
+    } else {
+      p = format_one(o, p + 1, in);
+    }
+  }
+  if (r.truncated) out_char(o, '~');
+  line[o.len++] = '\n';
+  return o.len;
+}
+
+// ===================================================================
+// Drain
+// ===================================================================
+
+size_t log_drain(LogSink sink, void* ctx, size_t max_records) {
+  char line[LOG_LINE_MAX];
+  uint32_t waiting = head.load(std::memory_order_relaxed) - tail;
+  if (waiting > drain_stats.high_water) drain_stats.high_water = waiting;
+  
+  size_t drained = 0;
+  while (drained < max_records) {
+    LogRecord& r = slots[tail & LOG_RING_MASK];
+    if (r.lap.load(std::memory_order_acquire) != lap_of(tail) + 1) break;
+    size_t len = format_record(r, line);
+    if (r.truncated) drain_stats.truncated++;
+    r.lap.store(lap_of(tail) + LOG_RING_SLOTS, std::memory_order_release);
+    tail++;
+    drained++;
+    sink(line, len, ctx);
+  }
+  drain_stats.drained += drained;
+  
+  uint32_t lost = dropped.load(std::memory_order_relaxed);
+  if (lost != reported_dropped) {
+    uint32_t t = log_clock ? (uint32_t)log_clock() : 0;
+    int n = snprintf(line, sizeof(line), "[%lu.%03lu] log: %lu messages dropped (%lu in all)\n",
+                     (unsigned long)(t / 1000), (unsigned long)(t % 1000),
+                     (unsigned long)(lost - reported_dropped), (unsigned long)lost);
+    reported_dropped = lost;
+    sink(line, (size_t)n, ctx);
+  }
+  return drained;
+}
+
+LogStats log_get_stats() {
+  LogStats s = drain_stats;
+  s.dropped = dropped.load(std::memory_order_relaxed);
+  s.written = head.load(std::memory_order_relaxed);
+  return s;
+}
+
+// ===================================================================
+// Drain Task (firmware)
+// ===================================================================
+
+#ifdef ESP_PLATFORM
+static LogSink task_sink = nullptr;
+static void* task_ctx = nullptr;
+
+// Waits a tick between batches even while busy, so the idle task on
+// its core still runs
+static void log_task(void* param) {
+  for (;;) {
+    size_t n = log_drain(task_sink, task_ctx, LOG_DRAIN_BATCH);
+    vTaskDelay(n ? 1 : pdMS_TO_TICKS(LOG_DRAIN_IDLE_MS));
+  }
+}
+
+bool log_start_task(LogSink sink, void* ctx) {
+  task_sink = sink;
+  task_ctx = ctx;
+  BaseType_t ok = xTaskCreatePinnedToCore(
+    log_task, "log", LOG_TASK_STACK, nullptr,
+    LOG_TASK_PRIORITY, nullptr, LOG_TASK_CORE
+  );
+  return ok == pdPASS;
+}
+#endif
@@ -0,0 +1,227 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+// ===================================================================
+// Deferred Logger
+// ===================================================================
+// LOG_ERROR / LOG_WARN / LOG_INFO / LOG_DEBUG take a printf format and
+// its arguments, one line per call. The call does not format: it
+// claims a fixed-size record in a lock-free ring, stores the format
+// pointer, a millis() timestamp and the arguments as tagged binary
+// values, and returns. log_drain() formats the records and hands the
+// lines to a sink; on the stick a low-priority task drains to Serial
+// (log_start_task()), so no caller waits on the UART.
+//
+// Any task or ISR may log: a record is claimed with one
+// compare-and-swap and published by a store. When the ring is full the
+// message is dropped and counted, never waited for; the drain reports
+// drops in the log itself.
+//
+// Calls above LOG_LEVEL (a build flag, default LOG_LEVEL_INFO) compile
+// to nothing and their arguments are not evaluated.
+//
+// The format must outlive the record: use string literals. Arguments
+// take LOG_ARG_BYTES a record (a tag byte, then 4 bytes for 32-bit
+// values and floats, 8 for doubles and 64-bit values); %s arguments
+// are copied and cut short when the record runs out of room.
+// Conversions: d i u o x X c f F e E g G s p and %%, with flags, width
+// and precision (also *) as printf; length modifiers are taken from
+// the argument types, so %lu and %u print the same value.
+// ===================================================================
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_RING_SLOTS   128          // Power of two
+#define LOG_ARG_BYTES    48           // Per record: 64-byte records on the ESP32
+#define LOG_LINE_MAX     192          // Formatted line, timestamp and newline included
+#define LOG_STR_MAX      255          // One %s argument
+
+static_assert((LOG_RING_SLOTS & (LOG_RING_SLOTS - 1)) == 0, "LOG_RING_SLOTS must be a power of two");
+
+// Argument tags; 32-bit values take 4 bytes, the rest 8, strings a
+// length byte and the characters
+enum LogArgType : uint8_t {
+  LOG_ARG_I32 = 1,
+  LOG_ARG_U32,
+  LOG_ARG_I64,
+  LOG_ARG_U64,
+  LOG_ARG_F32,
+  LOG_ARG_F64,
+  LOG_ARG_STR,
+  LOG_ARG_PTR
+};
+
+struct LogRecord {
+  // Which lap of the ring the slot is on: free at lap * SLOTS, holding
+  // a record at +1. Zero-initialized storage is an empty ring.
+  std::atomic<uint32_t> lap;
+  uint32_t t_ms;
+  const char* fmt;
+  uint8_t level;
+  uint8_t len;                  // Argument bytes used
+  uint8_t truncated;            // Arguments cut to fit
+  uint8_t args[LOG_ARG_BYTES];
+};
+
+struct LogStats {
+  uint32_t written;             // Records stored
+  uint32_t drained;
+  uint32_t dropped;             // Ring full
+  uint32_t truncated;           // Records whose arguments were cut
+  uint32_t high_water;          // Most records waiting at a drain
+};
+
+typedef unsigned long (*LogClock)();
+typedef void (*LogSink)(const char* line, size_t len, void* ctx);
+
+// ===================================================================
+// Logger Functions
+// ===================================================================
+
+// Timestamps come from clock (millis() on the stick); 0 without one.
+// Records logged before this are kept.
+void log_init(LogClock clock);
+
+// Format up to max_records waiting records (and a drop report when
+// messages were lost since the last one) into sink. Returns the
+// records drained. One consumer at a time.
+size_t log_drain(LogSink sink, void* ctx, size_t max_records);
+
+LogStats log_get_stats();
+
+#ifdef ESP_PLATFORM
+#define LOG_TASK_PRIORITY  1          // Below everything but idle
+#define LOG_TASK_CORE      0          // Away from the sensing task
+#define LOG_TASK_STACK     4096       // vsnprintf with floats
+#define LOG_DRAIN_BATCH    16
+#define LOG_DRAIN_IDLE_MS  10
+
+// The drain task; false if it could not be created
+bool log_start_task(LogSink sink, void* ctx);
+#endif
+
+// Producer side, used by the macros: a slot, then publish it
+LogRecord* log_claim(uint8_t level, const char* fmt, uint32_t& pos);
+void log_publish(LogRecord* r, uint32_t pos);
+
+// ===================================================================
+// Argument Encoding
+// ===================================================================
+
+struct LogArgWriter {
+  uint8_t* p;
+  uint8_t* end;
+  bool truncated;
+};
+
+// Once one argument does not fit, none after it are stored either
+inline void log_put_raw(LogArgWriter& w, uint8_t type, const void* v, size_t n) {
+  if ((size_t)(w.end - w.p) < 1 + n) {
+    w.truncated = true;
+    w.p = w.end;
+    return;
+  }
+  *w.p++ = type;
+  memcpy(w.p, v, n);
+  w.p += n;
+}
+
+inline void log_put_str(LogArgWriter& w, const char* s) {
+  if (!s) s = "(null)";
+  size_t room = w.end - w.p;
+  if (room < 3) {
+    w.truncated = room > 0 || *s;
+    w.p = w.end;
+    return;
+  }
+  size_t max = room - 2 < LOG_STR_MAX ? room - 2 : LOG_STR_MAX;
+  size_t n = strnlen(s, max);
+  w.p[0] = LOG_ARG_STR;
+  w.p[1] = (uint8_t)n;
+  memcpy(w.p + 2, s, n);
+  w.p += 2 + n;
+  if (n == max && s[n]) {
+    w.truncated = true;
+    w.p = w.end;
+  }
+}
+
+inline void log_put(LogArgWriter& w, const char* s) { log_put_str(w, s); }
+inline void log_put(LogArgWriter& w, char* s) { log_put_str(w, s); }
+inline void log_put(LogArgWriter& w, float v) { log_put_raw(w, LOG_ARG_F32, &v, 4); }
+inline void log_put(LogArgWriter& w, double v) { log_put_raw(w, LOG_ARG_F64, &v, 8); }
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+log_put(LogArgWriter& w, T v) {
+  if (sizeof(T) <= 4) {
+    uint32_t x = (uint32_t)v;
+    log_put_raw(w, std::is_signed<T>::value ? LOG_ARG_I32 : LOG_ARG_U32, &x, 4);
+  } else {
+    uint64_t x = (uint64_t)v;
+    log_put_raw(w, std::is_signed<T>::value ? LOG_ARG_I64 : LOG_ARG_U64, &x, 8);
+  }
+}
+
+template <typename T>
+inline void log_put(LogArgWriter& w, const T* p) {
+  uint64_t x = (uintptr_t)p;
+  log_put_raw(w, LOG_ARG_PTR, &x, 8);
+}
+
+template <typename... Args>
+inline void log_write(uint8_t level, const char* fmt, const Args&... args) {
+  uint32_t pos;
+  LogRecord* r = log_claim(level, fmt, pos);
+  if (!r) return;
+  LogArgWriter w = {r->args, r->args + LOG_ARG_BYTES, false};
+  int expand[] = {0, (log_put(w, args), 0)...};
+  (void)expand;
+  r->len = (uint8_t)(w.p - r->args);
+  r->truncated = w.truncated;
+  log_publish(r, pos);
+}
+
+// ===================================================================
+// Logging Macros
+// ===================================================================
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) log_write(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) log_write(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) log_write(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) log_write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do {} while (0)
+#endif
+
+#endif // LOG_H
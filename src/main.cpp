@@ -6,13 +6,23 @@
 #include "sensors.h"
 #include "fall_detection.h"
 #include "haptics.h"
+#include "sensing_task.h"
+#include "boot.h"
+#include "journal.h"
+#include "log.h"
 
 // ===================================================================
 // Forward Declarations
 // ===================================================================
 
 void handle_sos_button(unsigned long now);
-void update_sensors(unsigned long now);
+void publish_sensing_events();
+void publish_sensing_samples();
+void publish_sample_frame(const SensingSample& sample);
+void sample_values(const SensingSample& sample, TelemetryValues& v);
+void journal_sample(const SensingSample& sample);
+uint32_t raise_alert(const char* json, AlertClass cls = ALERT_SAFETY);
+void publish_imu_stream();
 void update_rfid(unsigned long now);
 
 // ===================================================================
@@ -25,16 +35,22 @@ Config g_config;
 // State Variables
 // ===================================================================
 
-static unsigned long last_sensor_update = 0;
-static unsigned long last_rfid_poll = 0;
-static unsigned long last_battery_read = 0;
-static unsigned long last_obstacle_alert = 0;
-
 static bool sos_button_last_state = HIGH;
 static unsigned long sos_button_debounce_time = 0;
 
-static bool rfid_alert_sent = false;
-static String last_rfid_uid = "";
+static uint8_t last_rfid_uid[LANDMARK_UID_MAX];
+static uint8_t last_rfid_uid_len = 0;   // 0 = no tag in view
+
+// Samples, gait summaries and alerts kept on flash (journal.h) for
+// the JOURNAL characteristic, connected or not
+static Journal journal;
+static uint32_t journal_sample_ms = 0;
+
+// Log lines from the drain task (log.h); only it writes to Serial,
+// apart from the calibration CSV dump
+static void serial_sink(const char* line, size_t len, void* ctx) {
+  Serial.write((const uint8_t*)line, len);
+}
 
 // ===================================================================
 // Setup
@@ -42,46 +58,46 @@ static String last_rfid_uid = "";
 
 void setup() {
   Serial.begin(115200);
-  delay(1000);
+  log_init(millis);
+  log_start_task(serial_sink, nullptr);
+  boot_mark(BOOT_PHASE_SERIAL);
   
-  Serial.println("\n\n=================================");
-  Serial.println("  Smart Walking Stick Firmware  ");
-  Serial.println("  ESP32-S3 + NimBLE              ");
-  Serial.println("=================================\n");
+  LOG_INFO("=================================");
+  LOG_INFO("  Smart Walking Stick Firmware  ");
+  LOG_INFO("  ESP32-S3 + NimBLE              ");
+  LOG_INFO("=================================");
   
   pinMode(SOS_BTN, INPUT_PULLUP);
   
   // Initialize haptics (buzzer, LED, vibration motor)
   haptics_init();
+  boot_mark(BOOT_PHASE_HAPTICS);
   
-  Serial.println("Initializing sensors...");
-  
-  if (!sensors_init()) {
-    Serial.println("WARNING: Sensor initialization failed!");
-    Serial.println("Continuing without sensors (BLE test mode)...");
-    Serial.println("You can still connect via Bluetooth and test the system.");
-  } else {
-    Serial.println("All sensors initialized successfully!");
-    fall_detection_init();
+  // Sensors come up on core 0 while BLE initializes here
+  if (!boot_start_sensors()) {
+    LOG_ERROR("ERROR: Sensor bring-up task failed to start!");
   }
   
-  Serial.println("\nInitializing BLE...");
   ble_init();
+  boot_mark(BOOT_PHASE_ADVERTISING);
   
-  // Startup beep to confirm buzzer is working
-  haptics_trigger(HAPTIC_RFID);  // Quick beep
-  delay(100);
+  // Mounted after advertising starts: the scan reads every segment header
+  if (journal_mount_partition(journal)) {
+    journal_log_boot(journal, esp_reset_reason(), millis());
+    LOG_INFO("Journal: %u segments, log %lu-%lu", journal.segments,
+             (unsigned long)journal_tail(journal), (unsigned long)journal_head(journal));
+  } else {
+    LOG_ERROR("ERROR: Journal partition missing or unusable!");
+  }
+  ble_attach_journal(&journal);
+  
+  // Startup beep to confirm buzzer is working (haptics_update ends it)
+  haptics_trigger(HAPTIC_RFID);
   
-  Serial.println("\nSetup complete! Ready to go.\n");
-  Serial.print("Sensor update period: ");
-  Serial.print(g_config.sensor_period_ms);
-  Serial.println(" ms");
-  Serial.print("Obstacle threshold: ");
-  Serial.print(g_config.obstacle_threshold_mm);
-  Serial.println(" mm");
-  Serial.print("Fall threshold: ");
-  Serial.print(g_config.fall_ax_threshold);
-  Serial.println(" g");
+  LOG_INFO("Setup complete! Ready to go.");
+  LOG_INFO("Sensor update period: %u ms", g_config.sensor_period_ms);
+  LOG_INFO("Obstacle threshold: %u mm", g_config.obstacle_threshold_mm);
+  LOG_INFO("Fall threshold: %.2f g", g_config.fall_ax_threshold);
 }
 
 // ===================================================================
@@ -90,27 +106,28 @@ void setup() {
 
 void loop() {
   unsigned long now = millis();
+  sensing_record_telemetry_tick(micros());
   
   haptics_update();
   ble_update();
   
   handle_sos_button(now);
   
-  if (now - last_sensor_update >= g_config.sensor_period_ms) {
-    last_sensor_update = now;
-    update_sensors(now);
-  }
+  publish_sensing_events();
+  publish_sensing_samples();
+  publish_imu_stream();
+  fall_session_dump_service();
+  journal_service(journal, now);
   
-  if (now - last_rfid_poll >= RFID_POLL_PERIOD_MS) {
-    last_rfid_poll = now;
-    update_rfid(now);
-  }
+  // The RFID detector paces its own probes
+  update_rfid(now);
   
 #ifdef LOW_POWER
+  // The MPU6050 FIFO keeps buffering samples while the CPU sleeps
   if (LIGHT_SLEEP_ENABLED && !ble_is_connected()) {
     uint32_t sleep_time = min(
-      g_config.sensor_period_ms - (now - last_sensor_update),
-      RFID_POLL_PERIOD_MS - (now - last_rfid_poll)
+      (uint32_t)g_config.sensor_period_ms,
+      rfid_idle_ms()
     );
     if (sleep_time > 10) {
       esp_sleep_enable_timer_wakeup(sleep_time * 1000);
@@ -119,7 +136,7 @@ void loop() {
   }
 #endif
   
-  delay(10);
+  delay(TELEMETRY_LOOP_PERIOD_MS);
 }
 
 // ===================================================================
@@ -134,23 +151,24 @@ void handle_sos_button(unsigned long now) {
   if (current_state != sos_button_last_state) {
     sos_button_debounce_time = now;
     sos_button_last_state = current_state;
-    Serial.printf("SOS Button state changed to: %s\n", current_state == LOW ? "PRESSED" : "RELEASED");
+    LOG_INFO("SOS Button state changed to: %s", current_state == LOW ? "PRESSED" : "RELEASED");
   }
   
   // After debounce period, trigger action on button press (LOW)
   if (current_state == LOW && (now - sos_button_debounce_time) > SOS_DEBOUNCE_MS) {
     if (!sos_triggered) {
       sos_triggered = true;
-      Serial.println("SOS BUTTON TRIGGERED!");
+      LOG_INFO("SOS BUTTON TRIGGERED!");
       
       haptics_trigger(HAPTIC_SOS);
+      black_box_post_trigger(sensing_get_black_box(), BLACK_BOX_TRIGGER_SOS);
       
       StaticJsonDocument<64> doc;
       doc["event"] = "SOS_BUTTON_PRESSED";
       
       char json[64];
       serializeJson(doc, json);
-      ble_send_alert(json);
+      raise_alert(json);
     }
   } else if (current_state == HIGH) {
     // Reset trigger when button is released
@@ -159,113 +177,224 @@ void handle_sos_button(unsigned long now) {
 }
 
 // ===================================================================
-// Update Sensors
+// Raise Alert
 // ===================================================================
 
-void update_sensors(unsigned long now) {
-  IMUData imu = imu_read();
-  ToFData tof = tof_read();
-  BatteryData battery;
-  
-  // Read battery immediately on first call (last_battery_read == 0), then every 10 seconds
-  if (last_battery_read == 0 || (now - last_battery_read >= BATTERY_READ_PERIOD_MS)) {
-    battery = battery_read();
-    last_battery_read = now;
-  } else {
-    battery.valid = false;
-  }
-  
-  // Debug output to Serial Monitor
-  if (tof.valid) {
-    Serial.print("ToF: ");
-    Serial.print(tof.distance_mm);
-    Serial.print(" mm  ");
-  }
-  if (imu.valid) {
-    Serial.print("IMU: ax=");
-    Serial.print(imu.ax, 2);
-    Serial.print(" ay=");
-    Serial.print(imu.ay, 2);
-    Serial.print(" az=");
-    Serial.print(imu.az, 2);
-    Serial.print("  ");
-  }
-  if (battery.valid) {
-    Serial.print("Batt: ");
-    Serial.print(battery.percentage);
-    Serial.print("%");
-  }
-  if (tof.valid || imu.valid || battery.valid) {
-    Serial.println();
-  }
-  
-  if (imu.valid) {
-    fall_detection_update(imu);
-    
-    float fall_ax, fall_ay, fall_az;
-    if (fall_detection_check(fall_ax, fall_ay, fall_az)) {
-      haptics_trigger(HAPTIC_FALL);
-      
-      StaticJsonDocument<128> doc;
-      doc["event"] = "FALL_DETECTED";
-      doc["severity"] = "high";
-      doc["ax"] = fall_ax;
-      doc["ay"] = fall_ay;
-      doc["az"] = fall_az;
-      
-      char json[128];
-      serializeJson(doc, json);
-      ble_send_alert(json);
+// Queued for BLE delivery and kept in the journal under its alert seq
+// (0 for a transient alert the queue refused)
+uint32_t raise_alert(const char* json, AlertClass cls) {
+  uint32_t seq = ble_send_alert(json, cls);
+  journal_log_alert(journal, seq, json, millis());
+  return seq;
+}
+
+// ===================================================================
+// Publish Sensing Events
+// ===================================================================
+// Fall and obstacle decisions are made in the sensing task; this side
+// only does the haptics and BLE alerts. Falls are queued until a client
+// confirms them; obstacle warnings only while they are current.
+// ===================================================================
+
+void publish_sensing_events() {
+  SensingEvent event;
+  
+  while (sensing_pop_event(event)) {
+    switch (event.type) {
+      case SENSING_EVENT_FALL: {
+        haptics_trigger(HAPTIC_FALL);
+        
+        StaticJsonDocument<128> doc;
+        doc["event"] = "FALL_DETECTED";
+        doc["severity"] = "high";
+        doc["ax"] = event.ax;
+        doc["ay"] = event.ay;
+        doc["az"] = event.az;
+        if (event.capture_id) doc["capture"] = event.capture_id;
+        
+        char json[128];
+        serializeJson(doc, json);
+        raise_alert(json);
+        break;
+      }
       
-      fall_detection_reset();
+      case SENSING_EVENT_OBSTACLE: {
+        if (tof_zone_scan_is_active()) {
+          haptics_obstacle(event.zone);
+        } else {
+          haptics_trigger(HAPTIC_OBSTACLE);
+        }
+        
+        StaticJsonDocument<96> doc;
+        doc["event"] = "OBSTACLE_NEAR";
+        doc["dist_mm"] = event.distance_mm;
+        if (tof_zone_scan_is_active()) {
+          doc["dir"] = tof_zone_name(event.zone);
+        }
+        if (event.ttc_ms != 0xFFFF) {
+          doc["ttc_ms"] = event.ttc_ms;
+        }
+        
+        char json[96];
+        serializeJson(doc, json);
+        raise_alert(json, ALERT_TRANSIENT);
+        break;
+      }
     }
   }
+}
+
+// ===================================================================
+// Publish Sensing Samples
+// ===================================================================
+// JSON unless the connected client asked for binary frames
+// (telemetry_frame.h), which BLE batches (telemetry_batch.h).
+// ===================================================================
+
+void publish_sensing_samples() {
+  SensingSample sample;
   
-  if (tof.valid && tof.distance_mm > 0 && 
-      tof.distance_mm < g_config.obstacle_threshold_mm) {
-    if (now - last_obstacle_alert >= OBSTACLE_ALERT_COOLDOWN_MS) {
-      last_obstacle_alert = now;
-      
-      haptics_trigger(HAPTIC_OBSTACLE);
-      
-      StaticJsonDocument<64> doc;
-      doc["event"] = "OBSTACLE_NEAR";
-      doc["dist_mm"] = tof.distance_mm;
-      
-      char json[64];
-      serializeJson(doc, json);
-      ble_send_alert(json);
+  while (sensing_pop_sample(sample)) {
+    // Per-sample output only in LOG_LEVEL_DEBUG builds
+    if (sample.tof.valid) {
+      LOG_DEBUG("ToF: %d mm", sample.tof.distance_mm);
+    }
+    if (sample.imu.valid) {
+      LOG_DEBUG("IMU: ax=%.2f ay=%.2f az=%.2f", sample.imu.ax, sample.imu.ay, sample.imu.az);
+    }
+    if (sample.battery.valid) {
+      if (sample.battery.charging) {
+        LOG_INFO("Batt: %u%% charging", sample.battery.percentage);
+      } else if (sample.battery.runtime_min != BATTERY_RUNTIME_UNKNOWN) {
+        LOG_INFO("Batt: %u%% ~%umin", sample.battery.percentage, sample.battery.runtime_min);
+      } else {
+        LOG_INFO("Batt: %u%%", sample.battery.percentage);
+      }
+    }
+    
+    journal_sample(sample);
+    
+    if (ble_sensor_encoding() == TELEMETRY_ENCODING_BINARY) {
+      publish_sample_frame(sample);
+      continue;
     }
+    
+    // Serialize sensor data to JSON
+    StaticJsonDocument<512> doc;
+    
+    if (sample.imu.valid) {
+      JsonObject imu_obj = doc.createNestedObject("imu");
+      imu_obj["ax"] = sample.imu.ax;
+      imu_obj["ay"] = sample.imu.ay;
+      imu_obj["az"] = sample.imu.az;
+      imu_obj["gx"] = sample.imu.gx;
+      imu_obj["gy"] = sample.imu.gy;
+      imu_obj["gz"] = sample.imu.gz;
+      imu_obj["pitch"] = round(sample.pitch_deg * 10) / 10.0;
+      imu_obj["roll"] = round(sample.roll_deg * 10) / 10.0;
+    }
+    if (sample.lying_flat) doc["flat"] = true;
+    
+    if (sample.tof.valid) {
+      doc["dist_mm"] = sample.tof.distance_mm;
+    }
+    
+    if (tof_zone_scan_is_active()) {
+      JsonArray zones = doc.createNestedArray("zones");
+      for (int z = 0; z < TOF_ZONE_COUNT; z++) {
+        zones.add(sample.zone_mm[z]);
+      }
+    }
+    
+    if (sample.battery.valid) {
+      JsonObject bat_obj = doc.createNestedObject("battery");
+      bat_obj["v"] = round(sample.battery.voltage * 100) / 100.0;
+      bat_obj["pct"] = sample.battery.percentage;
+      if (sample.battery.runtime_min != BATTERY_RUNTIME_UNKNOWN) {
+        bat_obj["runtime_min"] = sample.battery.runtime_min;
+      }
+      if (sample.battery.charging) bat_obj["chg"] = true;
+    }
+    
+    if (sample.gait_valid) {
+      JsonObject gait_obj = doc.createNestedObject("gait");
+      gait_obj["steps"] = sample.gait.steps;
+      gait_obj["plants"] = sample.gait.plants;
+      gait_obj["cad"] = sample.gait.cadence_spm;
+      gait_obj["stride_ms"] = sample.gait.stride_ms;
+      gait_obj["cv"] = round(sample.gait.stride_cv * 1000) / 1000.0;
+      gait_obj["bouts"] = sample.gait.bouts;
+      gait_obj["walk_s"] = sample.gait.walking_s;
+      if (sample.gait.walking) gait_obj["walking"] = true;
+    }
+    
+    doc["ts"] = sample.timestamp_ms;
+    
+    char json[384];
+    serializeJson(doc, json);
+    ble_send_sensor_data(json);
   }
-  
-  // Serialize sensor data to JSON
-  StaticJsonDocument<256> doc;
-  
-  if (imu.valid) {
-    JsonObject imu_obj = doc.createNestedObject("imu");
-    imu_obj["ax"] = imu.ax;
-    imu_obj["ay"] = imu.ay;
-    imu_obj["az"] = imu.az;
-    imu_obj["gx"] = imu.gx;
-    imu_obj["gy"] = imu.gy;
-    imu_obj["gz"] = imu.gz;
+}
+
+void publish_sample_frame(const SensingSample& sample) {
+  TelemetryValues v;
+  sample_values(sample, v);
+  ble_send_sensor_sample(v, sample.gait_valid ? &sample.gait : nullptr);
+}
+
+void sample_values(const SensingSample& sample, TelemetryValues& v) {
+  v = {};
+  v.t_us = sample.timestamp_us;
+  if (sample.imu.valid) {
+    v.flags |= TELEMETRY_FLAG_IMU;
+    v.ax = sample.imu.ax;
+    v.ay = sample.imu.ay;
+    v.az = sample.imu.az;
+    v.gx = sample.imu.gx;
+    v.gy = sample.imu.gy;
+    v.gz = sample.imu.gz;
   }
+  v.pitch_deg = sample.pitch_deg;
+  v.roll_deg = sample.roll_deg;
+  if (sample.lying_flat) v.flags |= TELEMETRY_FLAG_FLAT;
   
-  if (tof.valid) {
-    doc["dist_mm"] = tof.distance_mm;
+  if (sample.tof.valid) {
+    v.flags |= TELEMETRY_FLAG_TOF;
+    v.dist_mm = sample.tof.distance_mm;
   }
-  
-  if (battery.valid) {
-    JsonObject bat_obj = doc.createNestedObject("battery");
-    bat_obj["v"] = battery.voltage;
-    bat_obj["pct"] = battery.percentage;
+  if (tof_zone_scan_is_active()) {
+    v.flags |= TELEMETRY_FLAG_ZONES;
+    memcpy(v.zone_mm, sample.zone_mm, sizeof(v.zone_mm));
   }
   
-  doc["ts"] = now;
-  
-  char json[256];
-  serializeJson(doc, json);
-  ble_send_sensor_data(json);
+  if (sample.battery.valid) {
+    v.flags |= TELEMETRY_FLAG_BATTERY;
+    if (sample.battery.charging) v.flags |= TELEMETRY_FLAG_CHARGING;
+    v.battery_v = sample.battery.voltage;
+    v.battery_pct = sample.battery.percentage;
+    v.runtime_min = sample.battery.runtime_min;
+  }
+}
+
+// One sample a JOURNAL_SAMPLE_PERIOD_MS or with a battery reading, and
+// every gait summary
+void journal_sample(const SensingSample& sample) {
+  if (sample.gait_valid) journal_log_gait(journal, sample.gait, sample.timestamp_ms);
+  if (!sample.battery.valid && sample.timestamp_ms - journal_sample_ms < JOURNAL_SAMPLE_PERIOD_MS) return;
+  journal_sample_ms = sample.timestamp_ms;
+  
+  TelemetryValues v;
+  sample_values(sample, v);
+  journal_log_sample(journal, v, sample.timestamp_ms);
+}
+
+// Raw IMU samples for a client that asked for the stream; the BLE
+// batch packs them into as few notifications as the MTU allows
+void publish_imu_stream() {
+  TelemetryImuSample s;
+  while (sensing_pop_imu_stream(s)) {
+    ble_stream_imu(s, 1000 / IMU_SAMPLE_RATE_HZ);
+  }
 }
 
 // ===================================================================
@@ -276,27 +405,34 @@ void update_rfid(unsigned long now) {
   RFIDData rfid = rfid_read();
   
   if (rfid.valid) {
-    String current_uid = String(rfid.uid);
+    bool is_new = rfid.uid_len != last_rfid_uid_len ||
+                  memcmp(rfid.uid_bytes, last_rfid_uid, rfid.uid_len) != 0;
     
-    if (current_uid != last_rfid_uid && !rfid_alert_sent) {
-      haptics_trigger(HAPTIC_RFID);
+    if (is_new) {
+      // Announced locally so it works without a phone connected
+      if (rfid.landmark) {
+        haptics_cue(rfid.landmark->cue);
+      } else {
+        haptics_trigger(HAPTIC_RFID);
+      }
       
-      StaticJsonDocument<64> doc;
+      StaticJsonDocument<128> doc;
       doc["event"] = "RFID_SEEN";
       doc["uid"] = rfid.uid;
+      if (rfid.landmark) {
+        doc["landmark"] = rfid.landmark->landmark_id;
+        doc["category"] = rfid.landmark->category;
+      }
       
-      char json[64];
+      char json[128];
       serializeJson(doc, json);
-      ble_send_alert(json);
+      raise_alert(json, ALERT_TRANSIENT);
       
-      rfid_alert_sent = true;
-      last_rfid_uid = current_uid;
+      memcpy(last_rfid_uid, rfid.uid_bytes, rfid.uid_len);
+      last_rfid_uid_len = rfid.uid_len;
     }
   } else {
-    if (last_rfid_uid != "") {
-      last_rfid_uid = "";
-      rfid_alert_sent = false;
-    }
+    last_rfid_uid_len = 0;
   }
 }
 
@@ -13,6 +13,12 @@
 // Both sensors use different I2C addresses (MPU6050: 0x68, VL53L1X: 0x29)
 #define I2C_SDA 19
 #define I2C_SCL 20
+#define I2C_CLOCK_HZ 400000   // Fast mode, supported by both sensors
+
+// Sensor data-ready interrupt lines (optional)
+// Comment out either line if the pin is not wired; that sensor is then polled
+#define TOF_INT  15     // VL53L1X GPIO1 (range ready)
+#define IMU_INT  16     // MPU6050 INT (data ready)
 
 // SPI Pins (for MFRC522 RFID reader)
 #define SPI_SCK  5
@@ -20,6 +26,7 @@
 #define SPI_MOSI 6
 #define RFID_CS  21
 #define RFID_RST 38
+#define RFID_IRQ 17     // MFRC522 IRQ (optional; comment out to poll ComIrqReg)
 
 // User Interface Pins
 #define SOS_BTN    26   // Active LOW with internal pullup
@@ -0,0 +1,196 @@
+#include "rfid_detect.h"
+#include <string.h>
+
+// ===================================================================
+// MFRC522 Registers and Commands
+// ===================================================================
+
+#define REG_COMMAND      0x01
+#define REG_COM_IEN      0x02
+#define REG_DIV_IEN      0x03
+#define REG_COM_IRQ      0x04
+#define REG_ERROR        0x06
+#define REG_FIFO_DATA    0x09
+#define REG_FIFO_LEVEL   0x0A
+#define REG_BIT_FRAMING  0x0D
+#define REG_TX_MODE      0x12
+#define REG_RX_MODE      0x13
+#define REG_TX_CONTROL   0x14
+#define REG_MOD_WIDTH    0x24
+
+#define CMD_IDLE         0x00
+#define CMD_TRANSCEIVE   0x0C
+#define CMD_POWER_DOWN   0x10
+
+#define IRQ_INV          0x80   // ComIEnReg: IRQ pin active low
+#define IRQ_RX           0x20
+#define IRQ_IDLE         0x10
+#define IRQ_ERR          0x02
+#define IRQ_TIMER        0x01
+#define IRQ_PUSH_PULL    0x80   // DivIEnReg
+
+#define ERR_FATAL        0x13   // BufferOvfl | ParityErr | ProtocolErr
+#define TX_ANTENNA_ON    0x03
+#define PICC_REQA        0x26
+
+// ===================================================================
+// Counted Register Access
+// ===================================================================
+
+static uint8_t reg_read(RfidDetector& det, uint8_t reg) {
+  det.stats.spi_reads++;
+  return det.io.read(det.io.ctx, reg);
+}
+
+static void reg_write(RfidDetector& det, uint8_t reg, uint8_t value) {
+  det.stats.spi_writes++;
+  det.io.write(det.io.ctx, reg, value);
+}
+
+static void enter_state(RfidDetector& det, RfidDetectState state, uint32_t now_ms) {
+  det.state = state;
+  det.state_since_ms = now_ms;
+}
+
+// ===================================================================
+// Power Control
+// ===================================================================
+
+static void reader_sleep(RfidDetector& det, uint32_t now_ms) {
+  reg_write(det, REG_TX_CONTROL, 0x80);         // Antenna drivers off
+  reg_write(det, REG_COMMAND, CMD_POWER_DOWN);  // Soft power-down
+  enter_state(det, RFID_DETECT_SLEEP, now_ms);
+}
+
+static void reader_wake(RfidDetector& det, uint32_t now_ms) {
+  reg_write(det, REG_COMMAND, CMD_IDLE);        // Leave power-down
+  reg_write(det, REG_TX_CONTROL, 0x80 | TX_ANTENNA_ON);
+  enter_state(det, RFID_DETECT_WAKING, now_ms);
+}
+
+// ===================================================================
+// Probe
+// ===================================================================
+// Same framing PICC_IsNewCardPresent() uses: 106 kBd, 7-bit REQA.
+// The chip's timer (TAuto, set up by PCD_Init) ends the probe with
+// TimerIRq when no card answers.
+// ===================================================================
+
+static void probe_start(RfidDetector& det, uint32_t now_ms) {
+  reg_write(det, REG_TX_MODE, 0x00);
+  reg_write(det, REG_RX_MODE, 0x00);
+  reg_write(det, REG_MOD_WIDTH, 0x26);
+  
+  reg_write(det, REG_COMMAND, CMD_IDLE);
+  reg_write(det, REG_COM_IRQ, 0x7F);            // Clear all IRQ bits
+  reg_write(det, REG_FIFO_LEVEL, 0x80);         // Flush FIFO
+  reg_write(det, REG_FIFO_DATA, PICC_REQA);
+  reg_write(det, REG_BIT_FRAMING, 0x07);
+  reg_write(det, REG_COMMAND, CMD_TRANSCEIVE);
+  det.irq_pending = false;
+  reg_write(det, REG_BIT_FRAMING, 0x87);        // StartSend
+  
+  det.stats.probes++;
+  enter_state(det, RFID_DETECT_PROBING, now_ms);
+}
+
+// Returns 1 = card, 0 = no card, -1 = still running
+static int probe_result(RfidDetector& det) {
+  uint8_t irq = reg_read(det, REG_COM_IRQ);
+  
+  if (irq & IRQ_RX) {
+    uint8_t err = reg_read(det, REG_ERROR);
+    if (err & ERR_FATAL) return 0;
+    return (reg_read(det, REG_FIFO_LEVEL) == 2) ? 1 : 0;   // 2-byte ATQA
+  }
+  if (irq & (IRQ_TIMER | IRQ_ERR)) return 0;
+  return -1;
+}
+
+// ===================================================================
+// Public Interface
+// ===================================================================
+
+void rfid_detect_init(RfidDetector& det, const RfidRegisterIO& io,
+                      bool use_irq, uint32_t probe_period_ms, uint32_t now_ms) {
+  det.io = io;
+  det.use_irq = use_irq;
+  det.probe_period_ms = probe_period_ms;
+  det.irq_pending = false;
+  det.last_empty_probe_ms = now_ms;
+  memset(&det.stats, 0, sizeof(det.stats));
+  
+  if (use_irq) {
+    reg_write(det, REG_COM_IEN, IRQ_INV | IRQ_RX | IRQ_ERR | IRQ_TIMER);
+    reg_write(det, REG_DIV_IEN, IRQ_PUSH_PULL);
+  }
+  
+  // Probe straight away rather than one period after boot
+  reader_sleep(det, now_ms - probe_period_ms);
+}
+
+bool rfid_detect_update(RfidDetector& det, uint32_t now_ms) {
+  uint32_t elapsed = now_ms - det.state_since_ms;
+  
+  switch (det.state) {
+    case RFID_DETECT_SLEEP:
+      if (elapsed >= det.probe_period_ms) {
+        reader_wake(det, now_ms);
+      }
+      return false;
+    
+    case RFID_DETECT_WAKING:
+      if (elapsed >= RFID_FIELD_SETTLE_MS) {
+        probe_start(det, now_ms);
+      }
+      return false;
+    
+    case RFID_DETECT_PROBING: {
+      int result = -1;
+      
+      if (!det.use_irq || det.irq_pending) {
+        if (det.irq_pending) det.stats.irqs++;
+        det.irq_pending = false;
+        result = probe_result(det);
+      }
+      
+      if (result < 0 && elapsed >= RFID_PROBE_TIMEOUT_MS) {
+        // Read ComIrqReg once before giving up: a missed edge must not
+        // hide a card that did answer
+        det.stats.timeouts++;
+        if (det.use_irq) result = probe_result(det);
+        if (result < 0) result = 0;
+      }
+      
+      if (result == 1) {
+        uint32_t latency = now_ms - det.last_empty_probe_ms;
+        det.stats.cards++;
+        det.stats.total_latency_ms += latency;
+        if (latency > det.stats.max_latency_ms) det.stats.max_latency_ms = latency;
+        enter_state(det, RFID_DETECT_CARD, now_ms);
+        return true;
+      }
+      if (result == 0) {
+        det.last_empty_probe_ms = now_ms;
+        reader_sleep(det, now_ms);
+      }
+      return false;
+    }
+    
+    case RFID_DETECT_CARD:
+      return false;
+  }
+  return false;
+}
+
+void rfid_detect_card_done(RfidDetector& det, uint32_t now_ms) {
+  det.irq_pending = false;   // Anticollision traffic also raised the IRQ
+  det.last_empty_probe_ms = now_ms;
+  reader_sleep(det, now_ms);
+}
+
+uint32_t rfid_detect_idle_ms(const RfidDetector& det, uint32_t now_ms) {
+  if (det.state != RFID_DETECT_SLEEP) return 0;
+  uint32_t elapsed = now_ms - det.state_since_ms;
+  return elapsed >= det.probe_period_ms ? 0 : det.probe_period_ms - elapsed;
+}
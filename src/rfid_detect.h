@@ -0,0 +1,83 @@
+#ifndef RFID_DETECT_H
+#define RFID_DETECT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================================
+// MFRC522 Card Detection State Machine
+// ===================================================================
+// Replaces the blocking PICC_IsNewCardPresent() poll. Between probes
+// the reader is in soft power-down with the antenna off. Each probe
+// powers up, lets the field settle, sends REQA and returns; completion
+// (ATQA or the chip's own timeout) is signalled on the IRQ pin, so no
+// SPI traffic is spent spinning on ComIrqReg. Without an IRQ line the
+// same machine polls ComIrqReg once per update instead.
+//
+// The MFRC522 has no hardware low-power card detection, so duty-cycled
+// probing is the closest it gets. All register access goes through
+// RfidRegisterIO, which lets a scripted fake register model drive the
+// machine on a host build. SPI reads and writes are counted here for
+// both modes.
+// ===================================================================
+
+#define RFID_FIELD_SETTLE_MS   5     // PICC power-up before REQA
+#define RFID_PROBE_TIMEOUT_MS  30    // Safety net if the IRQ never arrives
+
+enum RfidDetectState {
+  RFID_DETECT_SLEEP,      // Soft power-down, antenna off
+  RFID_DETECT_WAKING,     // Oscillator/antenna up, waiting for the field
+  RFID_DETECT_PROBING,    // REQA sent, waiting for IRQ or timeout
+  RFID_DETECT_CARD        // ATQA received; caller reads the UID
+};
+
+struct RfidRegisterIO {
+  uint8_t (*read)(void* ctx, uint8_t reg);
+  void (*write)(void* ctx, uint8_t reg, uint8_t value);
+  void* ctx;
+};
+
+struct RfidDetectStats {
+  uint32_t probes;
+  uint32_t cards;
+  uint32_t irqs;
+  uint32_t timeouts;          // Probes that ended without an IRQ
+  uint32_t spi_reads;
+  uint32_t spi_writes;
+  uint32_t max_latency_ms;    // Bound: detection minus last empty probe
+  uint32_t total_latency_ms;
+};
+
+struct RfidDetector {
+  RfidRegisterIO io;
+  bool use_irq;
+  uint32_t probe_period_ms;
+  RfidDetectState state;
+  uint32_t state_since_ms;
+  uint32_t last_empty_probe_ms;
+  volatile bool irq_pending;
+  RfidDetectStats stats;
+};
+
+// ===================================================================
+// Detection Functions
+// ===================================================================
+
+void rfid_detect_init(RfidDetector& det, const RfidRegisterIO& io,
+                      bool use_irq, uint32_t probe_period_ms, uint32_t now_ms);
+
+// From the IRQ pin's interrupt handler; inline so it needs no IRAM_ATTR
+static inline void rfid_detect_irq(RfidDetector& det) {
+  det.irq_pending = true;
+}
+
+// Advance the machine; returns true once when a card answers REQA
+bool rfid_detect_update(RfidDetector& det, uint32_t now_ms);
+
+// Caller finished with the card (UID read, PICC halted)
+void rfid_detect_card_done(RfidDetector& det, uint32_t now_ms);
+
+// Milliseconds the caller may sleep before the next update matters
+uint32_t rfid_detect_idle_ms(const RfidDetector& det, uint32_t now_ms);
+
+#endif // RFID_DETECT_H
@@ -0,0 +1,64 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stddef.h>
+#include <atomic>
+
+// ===================================================================
+// Fixed-Capacity Ring Buffer
+// ===================================================================
+// Lock-free for exactly one producer and one consumer (each may run in
+// its own task or ISR). N must be a power of two. No heap use; the
+// storage lives wherever the RingBuffer itself is placed.
+// ===================================================================
+
+template <typename T, size_t N>
+class RingBuffer {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "RingBuffer size must be a power of two");
+
+public:
+  RingBuffer() : head(0), tail(0) {}
+  
+  // Producer side: returns false (and drops the item) when full
+  bool push(const T& item) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= N) return false;
+    items[h & (N - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+  
+  // Consumer side: returns false when empty
+  bool pop(T& item) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    item = items[t & (N - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+  
+  // Consumer side: look at the oldest item without removing it
+  const T* peek() const {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return nullptr;
+    return &items[t & (N - 1)];
+  }
+  
+  size_t size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+  
+  bool empty() const { return size() == 0; }
+  bool full() const { return size() >= N; }
+  static constexpr size_t capacity() { return N; }
+  
+  // Consumer side only
+  void clear() { tail.store(head.load(std::memory_order_acquire), std::memory_order_release); }
+
+private:
+  T items[N];
+  std::atomic<size_t> head;
+  std::atomic<size_t> tail;
+};
+
+#endif // RING_BUFFER_H
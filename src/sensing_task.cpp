@@ -0,0 +1,436 @@
+#include "sensing_task.h"
+#include "config.h"
+#include "fall_detection.h"
+#include "sensor_events.h"
+#include "ring_buffer.h"
+#include "boot.h"
+#include "tof_tracker.h"
+#include "imu_features.h"
+#include "ahrs.h"
+#include "haptics.h"
+#include "ble.h"
+#include "black_box.h"
+#include "log.h"
+#include "gait.h"
+#include "pins.h"
+#include <esp_heap_caps.h>
+
+// ===================================================================
+// Sensing Task State
+// ===================================================================
+
+static TaskHandle_t sensing_task_handle = nullptr;
+
+static RingBuffer<SensingSample, SENSING_SAMPLE_QUEUE_SIZE> sample_queue;
+static RingBuffer<SensingEvent, SENSING_EVENT_QUEUE_SIZE> event_queue;
+static RingBuffer<TelemetryImuSample, SENSING_STREAM_QUEUE_SIZE> stream_queue;
+static volatile bool stream_enabled = false;
+static SensingQueueStats queue_stats = {0};
+
+static JitterStats sensing_jitter = {0};
+static JitterStats telemetry_jitter = {0};
+static uint32_t last_telemetry_tick_us = 0;
+
+// Owned by the sensing task
+static IMUData latest_imu = {0};
+static FallBlock fall_block = {};
+static AhrsState ahrs;
+static uint32_t obstacle_suppressed = 0;
+static ToFData latest_tof = {0};
+static TofObstacleMap obstacle_map;
+static TofTracker tof_trackers[TOF_ZONE_COUNT];
+static TofAlertPacer obstacle_pacer;
+static unsigned long last_sample_ms = 0;
+static BlackBox black_box;
+static bool sos_pressed = false;
+static GaitState gait;
+static bool gait_enabled = false;         // Needs the 100 Hz FIFO stream
+static unsigned long last_gait_ms = 0;
+
+// ===================================================================
+// Jitter Accounting
+// ===================================================================
+
+static void jitter_record(JitterStats& stats, uint32_t late_us, uint32_t period_us) {
+  stats.cycles++;
+  stats.total_late_us += late_us;
+  if (late_us > stats.max_late_us) stats.max_late_us = late_us;
+  if (late_us > SENSING_LATE_US) stats.late_cycles++;
+  if (late_us >= period_us) stats.overruns++;
+}
+
+void sensing_record_telemetry_tick(uint32_t now_us) {
+  const uint32_t period_us = TELEMETRY_LOOP_PERIOD_MS * 1000UL;
+  
+  if (last_telemetry_tick_us != 0) {
+    uint32_t interval = now_us - last_telemetry_tick_us;
+    jitter_record(telemetry_jitter, interval > period_us ? interval - period_us : 0, period_us);
+  }
+  last_telemetry_tick_us = now_us;
+}
+
+// ===================================================================
+// Black Box Recording
+// ===================================================================
+// Raw counts, as the sensor reported them, into the PSRAM ring
+// (black_box.h): one 16-byte record per sample, range or button edge.
+// The same counts feed the BLE IMU stream while a client wants it.
+// ===================================================================
+
+static int16_t raw_counts(float value, float lsb_per_unit) {
+  float counts = value * lsb_per_unit;
+  if (counts > 32767.0f) return 32767;
+  if (counts < -32768.0f) return -32768;
+  return (int16_t)lroundf(counts);
+}
+
+static void record_imu(const IMUData& imu) {
+  int16_t raw[6] = {
+    raw_counts(imu.ax, MPU6050_ACCEL_LSB_PER_G), raw_counts(imu.ay, MPU6050_ACCEL_LSB_PER_G),
+    raw_counts(imu.az, MPU6050_ACCEL_LSB_PER_G), raw_counts(imu.gx, MPU6050_GYRO_LSB_PER_DPS),
+    raw_counts(imu.gy, MPU6050_GYRO_LSB_PER_DPS), raw_counts(imu.gz, MPU6050_GYRO_LSB_PER_DPS)
+  };
+  black_box_push_imu(black_box, raw, imu.timestamp_ms);
+  
+  if (stream_enabled) {
+    TelemetryImuSample s;
+    s.t_ms = imu.timestamp_ms;
+    memcpy(s.v, raw, sizeof(s.v));
+    if (!stream_queue.push(s)) queue_stats.dropped_stream++;
+  }
+}
+
+// The SOS button is debounced and acted on in loop(); the black box
+// only wants its raw edges on the sensing timebase
+static void record_button(unsigned long now) {
+  bool pressed = digitalRead(SOS_BTN) == LOW;
+  if (pressed != sos_pressed) {
+    sos_pressed = pressed;
+    black_box_push_button(black_box, pressed, now);
+  }
+}
+
+static bool black_box_start() {
+  size_t bytes = BLACK_BOX_POOL_CHUNKS * sizeof(BlackBoxChunk);
+  void* mem = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  const char* where = "PSRAM";
+  if (!mem) {
+    bytes = BLACK_BOX_INTERNAL_CHUNKS * sizeof(BlackBoxChunk);
+    mem = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    where = "internal RAM";
+  }
+  if (!black_box_init(black_box, mem, bytes)) {
+    free(mem);
+    LOG_WARN("Sensing: Black box disabled (no memory)");
+    return false;
+  }
+  LOG_INFO("Sensing: Black box %u KB in %s", (unsigned)(bytes / 1024), where);
+  return true;
+}
+
+BlackBox& sensing_get_black_box() {
+  return black_box;
+}
+
+// ===================================================================
+// Event Publishing
+// ===================================================================
+
+static void publish_event(const SensingEvent& event) {
+  if (!event_queue.push(event)) {
+    queue_stats.dropped_events++;
+  }
+}
+
+static void publish_fall_if_confirmed() {
+  float fall_ax, fall_ay, fall_az;
+  if (fall_detection_check(fall_ax, fall_ay, fall_az)) {
+    SensingEvent event = {SENSING_EVENT_FALL, fall_detection_confirm_ms(),
+                          fall_ax, fall_ay, fall_az, 0, 0, 0, 0};
+    black_box_trigger(black_box, BLACK_BOX_TRIGGER_FALL, event.timestamp_ms);
+    event.capture_id = black_box.next_id;
+    publish_event(event);
+    fall_detection_reset();
+  }
+}
+
+// Every sample goes through the orientation filter as it arrives, so
+// a block sees the attitude as of its newest sample
+static void process_orientation(const IMUData& imu) {
+  ahrs_update(ahrs, imu.ax, imu.ay, imu.az, imu.gx, imu.gy, imu.gz, imu.timestamp_ms);
+}
+
+// FIFO samples are collected into a block and run through the fall
+// kernels together; the feature windows take them one by one
+static void process_imu_block() {
+  if (fall_block.count == 0) return;
+  for (uint8_t i = 0; i < fall_block.count; i++) {
+    imu_features_push(fall_block.ax[i], fall_block.ay[i], fall_block.az[i], fall_block.t_ms[i]);
+    if (gait_enabled) gait_push(gait, fall_block.ax[i], fall_block.ay[i], fall_block.az[i], fall_block.t_ms[i]);
+  }
+  fall_detection_set_orientation(ahrs_signals(ahrs, fall_block.t_ms[fall_block.count - 1]));
+  fall_detection_update_block(fall_block);
+  fall_block.count = 0;
+  publish_fall_if_confirmed();
+}
+
+static void process_imu(const IMUData& imu) {
+  record_imu(imu);
+  process_orientation(imu);
+  fall_block_push(fall_block, imu);
+  process_imu_block();
+}
+
+// Alerts on time-to-collision from the filtered track; targets inside
+// obstacle_threshold_mm that are not approaching still alert at the
+// slowest repeat rate. A stick lying down or swinging fast is not
+// pointing where the user walks: tracks still update, alerts are held.
+static void process_tof(const ToFData& tof) {
+  if (tof.zone >= TOF_ZONE_COUNT) return;
+  black_box_push_tof(black_box, tof.valid ? tof.distance_mm : -1, tof.zone, tof.timestamp_ms);
+  tof_map_update(obstacle_map, tof.zone, tof.distance_mm, tof.valid, tof.timestamp_ms);
+  
+  TofThreat threat = tof_tracker_update(tof_trackers[tof.zone], tof.distance_mm, tof.valid,
+                                        tof.timestamp_ms, g_config.obstacle_threshold_mm);
+  
+  AhrsSignals pose = ahrs_signals(ahrs, tof.timestamp_ms);
+  if (threat.present && (pose.flat || pose.rapid)) {
+    obstacle_suppressed++;
+    return;
+  }
+  
+  if (tof_pacer_should_alert(obstacle_pacer, threat, tof.timestamp_ms, OBSTACLE_ALERT_COOLDOWN_MS)) {
+    SensingEvent event = {SENSING_EVENT_OBSTACLE, tof.timestamp_ms, 0, 0, 0,
+                          threat.distance_mm, tof.zone, threat.ttc_ms, threat.urgency};
+    publish_event(event);
+  }
+}
+
+TofTrackStats sensing_get_tof_stats() {
+  TofTrackStats stats = {0};
+  stats.alerts = obstacle_pacer.alerts;
+  stats.suppressed = obstacle_suppressed;
+  for (int z = 0; z < TOF_ZONE_COUNT; z++) {
+    stats.outliers += tof_trackers[z].outliers;
+  }
+  return stats;
+}
+
+AhrsState sensing_get_ahrs() {
+  return ahrs;
+}
+
+GaitState sensing_get_gait() {
+  return gait;
+}
+
+// ===================================================================
+// Telemetry Snapshot
+// ===================================================================
+
+static void publish_sample(unsigned long now) {
+  SensingSample sample;
+  sample.timestamp_ms = now;
+  sample.timestamp_us = micros();
+  
+  if (imu_fifo_is_active()) {
+    // Fall detection already saw every sample; publish the newest
+    sample.imu = latest_imu;
+    latest_imu.valid = false;
+  } else {
+    sample.imu = imu_read();
+    if (sample.imu.valid) {
+      process_imu(sample.imu);
+    }
+  }
+  ahrs_pitch_roll(ahrs, sample.pitch_deg, sample.roll_deg);
+  sample.lying_flat = ahrs_signals(ahrs, now).flat;
+  
+  if (tof_irq_is_active()) {
+    sample.tof = latest_tof;
+    latest_tof.valid = false;
+  } else {
+    sample.tof = tof_read();
+    process_tof(sample.tof);
+  }
+  
+  for (int z = 0; z < TOF_ZONE_COUNT; z++) {
+    sample.zone_mm[z] = tof_map_distance(obstacle_map, z, now);
+  }
+  if (tof_zone_scan_is_active()) {
+    int16_t nearest_mm;
+    int zone = tof_map_nearest(obstacle_map, now, nearest_mm);
+    sample.tof.valid = (zone >= 0);
+    sample.tof.distance_mm = nearest_mm;
+    sample.tof.zone = zone >= 0 ? zone : TOF_ZONE_CENTRE;
+  }
+  
+  // Valid once per completed reading (every BATTERY_READ_PERIOD_MS)
+  sample.battery = battery_read();
+  
+  // Gait summary every GAIT_SUMMARY_PERIOD_MS instead of raw data
+  sample.gait_valid = gait_enabled && now - last_gait_ms >= GAIT_SUMMARY_PERIOD_MS;
+  if (sample.gait_valid) {
+    last_gait_ms = now;
+    sample.gait = gait_summary(gait, now);
+  }
+  
+  if (sample.imu.valid || sample.tof.valid) {
+    boot_mark(BOOT_PHASE_FIRST_SAMPLE);
+  }
+  
+  if (!sample_queue.push(sample)) {
+    queue_stats.dropped_samples++;
+  }
+}
+
+// Current draw for battery IR compensation, from what is switched on.
+// haptics/BLE state is owned by loop(); a stale read only shifts one
+// conversion's estimate.
+static uint16_t battery_load_estimate_ma() {
+  uint16_t load = BATTERY_BASE_LOAD_MA;
+  if (ble_is_connected()) load += BATTERY_BLE_LOAD_MA;
+  if (haptics_is_active()) load += BATTERY_HAPTIC_LOAD_MA;
+  return load;
+}
+
+// ===================================================================
+// Sensing Task
+// ===================================================================
+// Wakes on every data-ready interrupt, whenever the I2C worker has
+// finished a queued read, and at least every SENSING_CYCLE_MS. Bus
+// work is queued on every wake; jitter is measured on the periodic
+// deadline.
+// ===================================================================
+
+static void IRAM_ATTR sensing_wake_from_isr() {
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(sensing_task_handle, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+static void sensing_wake() {
+  xTaskNotifyGive(sensing_task_handle);
+}
+
+static void sensing_task(void* param) {
+  const uint32_t period_us = SENSING_CYCLE_MS * 1000UL;
+  uint32_t next_cycle_us = micros() + period_us;
+  
+  for (;;) {
+    int32_t wait_us = (int32_t)(next_cycle_us - micros());
+    if (wait_us > 0) {
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS((wait_us + 999) / 1000));
+    }
+    
+    sensors_update();
+    
+    IMUData imu;
+    while (imu_fifo_pop(imu)) {
+      record_imu(imu);
+      process_orientation(imu);
+      if (fall_block_push(fall_block, imu)) process_imu_block();
+      latest_imu = imu;
+      boot_mark(BOOT_PHASE_FIRST_SAMPLE);
+    }
+    process_imu_block();
+    
+    ToFData tof;
+    while (tof_pop(tof)) {
+      process_tof(tof);
+      latest_tof = tof;
+      if (tof.valid) boot_mark(BOOT_PHASE_FIRST_SAMPLE);
+    }
+    
+    uint32_t now_us = micros();
+    if ((int32_t)(now_us - next_cycle_us) < 0) continue;
+    
+    jitter_record(sensing_jitter, now_us - next_cycle_us, period_us);
+    next_cycle_us += period_us;
+    if ((int32_t)(now_us - next_cycle_us) >= 0) {
+      next_cycle_us = now_us + period_us;  // Fell a whole period behind; re-anchor
+    }
+    
+    unsigned long now = millis();
+    battery_update(now, battery_load_estimate_ma());
+    record_button(now);
+    black_box_service(black_box, now);
+    
+    if (now - last_sample_ms >= g_config.sensor_period_ms) {
+      last_sample_ms = now;
+      publish_sample(now);
+    }
+  }
+}
+
+// ===================================================================
+// Sensing Task Start
+// ===================================================================
+
+bool sensing_task_start() {
+  // Without the FIFO, samples arrive once per telemetry period
+  float imu_rate_hz = imu_fifo_is_active() ? IMU_SAMPLE_RATE_HZ : 1000.0f / g_config.sensor_period_ms;
+  imu_features_init(imu_rate_hz, MPU6050_ACCEL_LSB_PER_G);
+  ahrs_init(ahrs, AHRS_ALGORITHM, imu_rate_hz);
+  gait_init(gait, MPU6050_ACCEL_LSB_PER_G);
+  gait_enabled = imu_fifo_is_active();
+  tof_map_init(obstacle_map);
+  for (int z = 0; z < TOF_ZONE_COUNT; z++) {
+    tof_tracker_init(tof_trackers[z]);
+  }
+  tof_pacer_init(obstacle_pacer);
+  black_box_start();
+  
+  BaseType_t ok = xTaskCreatePinnedToCore(
+    sensing_task, "sensing", SENSING_TASK_STACK, nullptr,
+    SENSING_TASK_PRIORITY, &sensing_task_handle, SENSING_TASK_CORE
+  );
+  
+  if (ok != pdPASS) {
+    LOG_ERROR("Sensing: Task creation failed!");
+    return false;
+  }
+  
+  sensor_events_set_wake(sensing_wake_from_isr);
+  sensors_set_data_hook(sensing_wake);
+  LOG_INFO("Sensing: Task started on core %d (priority %d)",
+           SENSING_TASK_CORE, SENSING_TASK_PRIORITY);
+  return true;
+}
+
+// ===================================================================
+// Consumer Side
+// ===================================================================
+
+bool sensing_pop_sample(SensingSample& out) {
+  return sample_queue.pop(out);
+}
+
+bool sensing_pop_event(SensingEvent& out) {
+  return event_queue.pop(out);
+}
+
+bool sensing_set_imu_stream(bool enable) {
+  stream_enabled = enable && imu_fifo_is_active();
+  return stream_enabled;
+}
+
+bool sensing_imu_stream_enabled() {
+  return stream_enabled;
+}
+
+bool sensing_pop_imu_stream(TelemetryImuSample& out) {
+  return stream_queue.pop(out);
+}
+
+JitterStats sensing_task_get_jitter() {
+  return sensing_jitter;
+}
+
+JitterStats telemetry_task_get_jitter() {
+  return telemetry_jitter;
+}
+
+SensingQueueStats sensing_get_queue_stats() {
+  return queue_stats;
+}
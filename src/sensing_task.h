@@ -0,0 +1,117 @@
+#ifndef SENSING_TASK_H
+#define SENSING_TASK_H
+
+#include <Arduino.h>
+#include "sensors.h"
+#include "ahrs.h"
+#include "black_box.h"
+#include "gait.h"
+#include "telemetry_frame.h"
+
+// ===================================================================
+// Sensing Task Configuration
+// ===================================================================
+// Sensor acquisition and fall/obstacle detection run in their own
+// high-priority task on core 1; the NimBLE host runs on core 0 and the
+// Arduino loop() task (priority 1) does telemetry, haptics and BLE.
+// Samples and events cross over through lock-free SPSC ring buffers.
+// ===================================================================
+
+#define SENSING_TASK_CORE       1
+#define SENSING_TASK_PRIORITY   5
+#define SENSING_TASK_STACK      4096
+#define SENSING_CYCLE_MS        10     // Poll / housekeeping cadence
+#define SENSING_LATE_US         1000   // A cycle this late counts as jitter
+
+#define SENSING_SAMPLE_QUEUE_SIZE 8
+#define SENSING_EVENT_QUEUE_SIZE  16
+#define SENSING_STREAM_QUEUE_SIZE 64   // Raw IMU samples; 640 ms at 100 Hz
+
+#define TELEMETRY_LOOP_PERIOD_MS  10   // Nominal loop() cadence
+
+// ===================================================================
+// Hand-off Structures
+// ===================================================================
+
+// One telemetry snapshot, produced every g_config.sensor_period_ms
+struct SensingSample {
+  IMUData imu;
+  ToFData tof;                          // Nearest fresh zone when scanning
+  int16_t zone_mm[TOF_ZONE_COUNT];      // -1 = no fresh range
+  BatteryData battery;
+  float pitch_deg, roll_deg;            // AHRS attitude
+  bool lying_flat;
+  GaitSummary gait;
+  bool gait_valid;                      // Every GAIT_SUMMARY_PERIOD_MS
+  unsigned long timestamp_ms;
+  uint32_t timestamp_us;                // micros() at the same moment
+};
+
+enum SensingEventType {
+  SENSING_EVENT_FALL,
+  SENSING_EVENT_OBSTACLE
+};
+
+struct SensingEvent {
+  SensingEventType type;
+  unsigned long timestamp_ms;
+  float ax, ay, az;        // FALL: axis values at the impact spike
+  int16_t distance_mm;     // OBSTACLE: filtered range at the alert
+  uint8_t zone;            // OBSTACLE: TofZone it was seen in
+  uint16_t ttc_ms;         // OBSTACLE: time to collision, 0xFFFF if not closing
+  uint8_t urgency;         // OBSTACLE: 0 (proximity only) to 255 (imminent)
+  uint16_t capture_id;     // FALL: black box capture, 0 if none
+};
+
+// Scheduling lateness of a periodic task
+struct JitterStats {
+  uint32_t cycles;
+  uint32_t late_cycles;    // Started more than SENSING_LATE_US late
+  uint32_t overruns;       // Missed a whole period
+  uint32_t max_late_us;
+  uint64_t total_late_us;
+};
+
+struct SensingQueueStats {
+  uint32_t dropped_samples;
+  uint32_t dropped_events;
+  uint32_t dropped_stream;
+};
+
+struct TofTrackStats {
+  uint32_t alerts;
+  uint32_t outliers;       // Ranges replaced by the Hampel filter
+  uint32_t suppressed;     // Threats not alerted: stick flat or rotating fast
+};
+
+// ===================================================================
+// Sensing Task Functions
+// ===================================================================
+
+bool sensing_task_start();
+
+// Consumer side (telemetry/BLE task)
+bool sensing_pop_sample(SensingSample& out);
+bool sensing_pop_event(SensingEvent& out);
+
+// Raw IMU stream for BLE (ble_stream_imu); only with the 100 Hz FIFO.
+// Returns whether streaming is now on.
+bool sensing_set_imu_stream(bool enable);
+bool sensing_imu_stream_enabled();
+bool sensing_pop_imu_stream(TelemetryImuSample& out);
+
+// Call once per loop() pass to track the telemetry task's own jitter
+void sensing_record_telemetry_tick(uint32_t now_us);
+
+JitterStats sensing_task_get_jitter();
+JitterStats telemetry_task_get_jitter();
+SensingQueueStats sensing_get_queue_stats();
+TofTrackStats sensing_get_tof_stats();
+AhrsState sensing_get_ahrs();            // Not synchronised; diagnostics only
+GaitState sensing_get_gait();            // Not synchronised; diagnostics only
+
+// Pre/post-event capture. Other tasks use only the "any task" and
+// reader-side black_box_* functions on it.
+BlackBox& sensing_get_black_box();
+
+#endif // SENSING_TASK_H
@@ -0,0 +1,121 @@
+#include "sensor_events.h"
+#include "ring_buffer.h"
+#include <string.h>
+
+// ===================================================================
+// Event State
+// ===================================================================
+
+struct SensorEventSlot {
+  RingBuffer<uint32_t, SENSOR_EVENT_QUEUE_SIZE> queue;
+  SensorEventHandler handler;
+  void* ctx;
+  bool coalesce;
+};
+
+static SensorEventSlot slots[SENSOR_EVENT_SOURCE_COUNT];
+static SensorEventStats stats;
+static void (*wake_hook)() = nullptr;
+static uint32_t (*clock_hook)() = nullptr;
+
+// ===================================================================
+// Initialization
+// ===================================================================
+
+void sensor_events_init() {
+  for (int i = 0; i < SENSOR_EVENT_SOURCE_COUNT; i++) {
+    slots[i].queue.clear();
+    slots[i].handler = nullptr;
+    slots[i].ctx = nullptr;
+    slots[i].coalesce = false;
+  }
+  memset(&stats, 0, sizeof(stats));
+  wake_hook = nullptr;
+  clock_hook = nullptr;
+}
+
+void sensor_events_set_handler(SensorEventSource source, SensorEventHandler handler,
+                               void* ctx, bool coalesce) {
+  slots[source].handler = handler;
+  slots[source].ctx = ctx;
+  slots[source].coalesce = coalesce;
+}
+
+void sensor_events_set_wake(void (*wake)()) {
+  wake_hook = wake;
+}
+
+void sensor_events_set_clock(uint32_t (*clock_us)()) {
+  clock_hook = clock_us;
+}
+
+// ===================================================================
+// Post (interrupt context)
+// ===================================================================
+
+void SENSOR_EVENTS_ISR_ATTR sensor_events_post(SensorEventSource source, uint32_t t_us) {
+  if (slots[source].queue.push(t_us)) {
+    stats.posted[source]++;
+  } else {
+    stats.overruns[source]++;
+  }
+  
+  if (wake_hook) wake_hook();
+}
+
+// ===================================================================
+// Dispatch (task context)
+// ===================================================================
+// Each pass takes only the events queued when it reached the source,
+// so a handler slower than its own interrupt rate cannot hold the
+// other sources off. Events posted after the time used count as no
+// latency.
+// ===================================================================
+
+size_t sensor_events_dispatch(uint32_t now_us) {
+  size_t handled = 0;
+  
+  for (int i = 0; i < SENSOR_EVENT_SOURCE_COUNT; i++) {
+    SensorEventSlot& slot = slots[i];
+    size_t queued = slot.queue.size();
+    uint32_t t_us;
+    
+    while (queued > 0 && slot.queue.pop(t_us)) {
+      queued--;
+      // Fold the rest of this pass's events into this one
+      if (slot.coalesce) {
+        uint32_t newer;
+        while (queued > 0 && slot.queue.pop(newer)) {
+          queued--;
+          t_us = newer;
+          stats.dispatched[i]++;
+        }
+      }
+      
+      if (clock_hook) now_us = clock_hook();
+      int32_t latency = (int32_t)(now_us - t_us);
+      if (latency > 0 && (uint32_t)latency > stats.max_latency_us[i]) {
+        stats.max_latency_us[i] = latency;
+      }
+      stats.dispatched[i]++;
+      handled++;
+      
+      if (slot.handler) {
+        slot.handler(t_us, slot.ctx);
+      }
+    }
+  }
+  
+  return handled;
+}
+
+bool sensor_events_pending() {
+  for (int i = 0; i < SENSOR_EVENT_SOURCE_COUNT; i++) {
+    if (!slots[i].queue.empty()) return true;
+  }
+  return false;
+}
+
+SensorEventStats sensor_events_get_stats() {
+  return stats;
+}
@@ -0,0 +1,67 @@
+#ifndef SENSOR_EVENTS_H
+#define SENSOR_EVENTS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef ESP_PLATFORM
+  #include <esp_attr.h>
+  #define SENSOR_EVENTS_ISR_ATTR IRAM_ATTR
+#else
+  #define SENSOR_EVENTS_ISR_ATTR
+#endif
+
+// ===================================================================
+// Sensor Data-Ready Events
+// ===================================================================
+// GPIO interrupt handlers stamp the capture time and post it here; the
+// sensing code dispatches queued events to per-source handlers outside
+// interrupt context. Each source has its own single-producer queue, so
+// posting is lock-free. No Arduino dependencies: a host build can post
+// events from a simulated interrupt source and dispatch them.
+// ===================================================================
+
+#define SENSOR_EVENT_QUEUE_SIZE 16
+
+enum SensorEventSource {
+  SENSOR_EVENT_IMU_READY,   // MPU6050 INT (data ready)
+  SENSOR_EVENT_TOF_READY,   // VL53L1X GPIO1 (range ready)
+  SENSOR_EVENT_SOURCE_COUNT
+};
+
+// Called from sensor_events_dispatch() with the ISR capture time
+typedef void (*SensorEventHandler)(uint32_t t_us, void* ctx);
+
+struct SensorEventStats {
+  uint32_t posted[SENSOR_EVENT_SOURCE_COUNT];
+  uint32_t dispatched[SENSOR_EVENT_SOURCE_COUNT];
+  uint32_t overruns[SENSOR_EVENT_SOURCE_COUNT];        // Queue full in ISR
+  uint32_t max_latency_us[SENSOR_EVENT_SOURCE_COUNT];  // Capture to dispatch
+};
+
+// ===================================================================
+// Event Functions
+// ===================================================================
+
+void sensor_events_init();
+
+// With coalesce set, all queued events for the source are folded into
+// one handler call carrying the newest capture time (useful when the
+// handler drains a FIFO anyway).
+void sensor_events_set_handler(SensorEventSource source, SensorEventHandler handler,
+                               void* ctx, bool coalesce);
+
+// Optional hook run from the ISR after every post (e.g. to wake a task)
+void sensor_events_set_wake(void (*wake)());
+
+// Optional microsecond clock; with it, latency is taken when each
+// handler is called rather than at the start of the dispatch pass
+void sensor_events_set_clock(uint32_t (*clock_us)());
+
+void SENSOR_EVENTS_ISR_ATTR sensor_events_post(SensorEventSource source, uint32_t t_us);
+size_t sensor_events_dispatch(uint32_t now_us);
+bool sensor_events_pending();
+
+SensorEventStats sensor_events_get_stats();
+
+#endif // SENSOR_EVENTS_H
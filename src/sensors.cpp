@@ -1,10 +1,18 @@
 #include "sensors.h"
 #include "pins.h"
 #include "config.h"
+#include "sensor_events.h"
+#include "i2c_bus.h"
+#include "boot.h"
+#include "log.h"
 #include <Wire.h>
+#include <Preferences.h>
 #include <Adafruit_MPU6050.h>
 #include <Adafruit_VL53L1X.h>
 #include <MFRC522.h>
+#ifdef BATTERY_ADC
+#include <esp_adc_cal.h>
+#endif
 
 // ===================================================================
 // Sensor Objects
@@ -15,131 +23,636 @@ static Adafruit_VL53L1X vl53;
 static MFRC522 rfid(RFID_CS, RFID_RST);
 
 static RFIDData last_rfid_data = {0};
-static float battery_filtered = 0.0;
 static bool sensors_initialized = false;
 
 // Individual sensor initialization flags
 static bool mpu_initialized = false;
 static bool vl53_initialized = false;
-static bool rfid_initialized = false;
+static volatile bool rfid_initialized = false;  // Set by the boot task
+static RfidDetector rfid_detector;
+static LandmarkDB landmarks;
+static bool rfid_irq_active = false;
+
+// Battery: owned by the sensing task
+static BatteryOversampler battery_os;
+static BatteryModel battery_model;
+static BatteryData battery_latest = {0};
+static bool battery_fresh = false;
+static unsigned long battery_last_reading_ms = 0;
+#ifdef BATTERY_ADC
+static esp_adc_cal_characteristics_t battery_adc_chars;
+static esp_adc_cal_value_t battery_adc_cal = ESP_ADC_CAL_VAL_DEFAULT_VREF;
+#endif
 
 // ===================================================================
-// Sensor Initialization
+// MPU6050 FIFO Registers
 // ===================================================================
 
-bool sensors_init() {
-  Serial.println("Sensors: Initializing...");
-  
-  // Initialize single I2C bus for both sensors
-  Serial.print("I2C: Initializing on SDA=");
-  Serial.print(I2C_SDA);
-  Serial.print(", SCL=");
-  Serial.println(I2C_SCL);
-  Wire.begin(I2C_SDA, I2C_SCL);
-  
-  // Scan I2C bus to see what's connected
-  Serial.println("I2C: Scanning for devices...");
-  int devicesFound = 0;
-  for (uint8_t addr = 1; addr < 127; addr++) {
-    Wire.beginTransmission(addr);
-    if (Wire.endTransmission() == 0) {
-      Serial.print("I2C: Found device at 0x");
-      if (addr < 16) Serial.print("0");
-      Serial.print(addr, HEX);
-      if (addr == 0x29) Serial.print(" (VL53L1X)");
-      else if (addr == 0x68) Serial.print(" (MPU6050)");
-      else if (addr == 0x69) Serial.print(" (MPU6050 alt)");
-      Serial.println();
-      devicesFound++;
+#define MPU6050_ADDR          0x68
+#define VL53L1X_ADDR          0x29
+#define MPU6050_SMPLRT_DIV    0x19
+#define MPU6050_FIFO_EN       0x23
+#define MPU6050_INT_ENABLE    0x38
+#define MPU6050_USER_CTRL     0x6A
+#define MPU6050_FIFO_COUNTH   0x72
+#define MPU6050_FIFO_R_W      0x74
+
+#define MPU6050_FIFO_EN_ACCEL_GYRO 0x78  // XG | YG | ZG | ACCEL
+#define MPU6050_USER_FIFO_EN       0x40
+#define MPU6050_USER_FIFO_RESET    0x04
+#define MPU6050_INT_DATA_RDY       0x01
+
+// Gyro output rate is 1 kHz with the DLPF enabled (21 Hz band)
+#define MPU6050_GYRO_OUTPUT_HZ     1000
+
+static ImuFifo imu_fifo;
+static ImuSampleRing imu_ring;
+static bool imu_fifo_active = false;
+
+// ===================================================================
+// Data-Ready Interrupt State
+// ===================================================================
+
+static RingBuffer<ToFData, 8> tof_ring;
+static bool tof_irq_active = false;
+static bool imu_irq_active = false;
+
+// ===================================================================
+// ToF Zone Scanning
+// ===================================================================
+// Runs on the I2C worker after each range is read and before the
+// interrupt is cleared, so the next range already uses the new ROI.
+// A budget change needs ranging stopped; ROI-only changes do not.
+// ===================================================================
+
+static TofZoneScheduler tof_zones;
+static bool tof_zone_scan_active = false;
+
+static void tof_zone_apply(const TofZoneStep& step) {
+  if (step.budget_changed) {
+    vl53.stopRanging();
+    vl53.setTimingBudget(step.budget_ms);
+    vl53.VL53L1X_SetInterMeasurementInMs(step.budget_ms);
+    vl53.VL53L1X_SetROICenter(step.spad_center);
+    vl53.startRanging();
+  } else {
+    vl53.VL53L1X_SetROICenter(step.spad_center);
+  }
+}
+
+static bool tof_zones_begin() {
+#ifdef TOF_ZONE_SCAN
+  TofZoneStep step = tof_zone_scheduler_init(tof_zones);
+  if (vl53.VL53L1X_SetROI(TOF_ZONE_ROI_WIDTH, TOF_ZONE_ROI_HEIGHT) != 0) return false;
+  vl53.setTimingBudget(step.budget_ms);
+  vl53.VL53L1X_SetInterMeasurementInMs(step.budget_ms);
+  vl53.VL53L1X_SetROICenter(step.spad_center);
+  tof_zone_scan_active = true;
+  return true;
+#else
+  return false;
+#endif
+}
+
+// Returns the zone the range just read belongs to
+static uint8_t tof_zone_step(int16_t distance_mm, uint32_t t_ms) {
+  if (!tof_zone_scan_active) return TOF_ZONE_CENTRE;
+  
+  uint8_t zone = tof_zones.current;
+  tof_zone_apply(tof_zone_scheduler_advance(tof_zones, distance_mm, t_ms));
+  return zone;
+}
+
+bool tof_zone_scan_is_active() {
+  return tof_zone_scan_active;
+}
+
+TofZoneScheduler tof_zone_get_schedule() {
+  return tof_zones;
+}
+
+// Convert an ISR/FIFO micros() stamp to the millis() timebase
+static unsigned long capture_millis(uint32_t t_us) {
+  uint32_t age_us = micros() - t_us;
+  return millis() - age_us / 1000;
+}
+
+// ===================================================================
+// I2C Bus Manager
+// ===================================================================
+// Once sensors_init() finishes, every Wire access goes through the
+// i2c_bus scheduler and runs in the worker task below. The worker sits
+// one priority above the sensing task on the same core, so queued
+// transactions start as soon as they are submitted.
+// ===================================================================
+
+#define I2C_WORKER_PRIORITY   6      // One above the sensing task
+#define I2C_WORKER_STACK      4096
+#define I2C_WORKER_CORE       1
+
+#define I2C_IMU_TIMEOUT_US    5000
+#define I2C_TOF_TIMEOUT_US    20000
+#define I2C_SYNC_MARGIN_MS    50
+
+static TaskHandle_t i2c_worker_handle = nullptr;
+static SemaphoreHandle_t i2c_sync_done[I2C_PRIORITY_COUNT];
+static void (*data_hook)() = nullptr;
+static volatile bool imu_drain_queued = false;
+
+static I2CResult wire_transfer(void* ctx, uint8_t address,
+                               const uint8_t* tx, size_t tx_len,
+                               uint8_t* rx, size_t rx_len, uint32_t timeout_us) {
+  if (timeout_us > 0) {
+    Wire.setTimeOut((uint16_t)max((uint32_t)1, timeout_us / 1000));
+  }
+  
+  Wire.beginTransmission(address);
+  Wire.write(tx, tx_len);
+  uint8_t err = Wire.endTransmission(rx_len == 0);
+  if (err == 2 || err == 3) return I2C_NACK;
+  if (err == 5) return I2C_TIMEOUT;
+  if (err != 0) return I2C_BUS_ERROR;
+  
+  if (rx_len > 0) {
+    if (Wire.requestFrom(address, (uint8_t)rx_len) != rx_len) return I2C_BUS_ERROR;
+    for (size_t i = 0; i < rx_len; i++) {
+      rx[i] = Wire.read();
     }
   }
-  Serial.print("I2C: Scan complete. Found ");
-  Serial.print(devicesFound);
-  Serial.println(" device(s)");
+  return I2C_OK;
+}
+
+static uint32_t wire_now_us(void* ctx) {
+  return micros();
+}
+
+static void i2c_worker_task(void* param) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    i2c_bus_run();
+  }
+}
+
+static bool bus_submit(const I2CTransaction& txn) {
+  if (!i2c_bus_submit(txn)) return false;
+  xTaskNotifyGive(i2c_worker_handle);
+  return true;
+}
+
+static void bus_call_done(void* ctx, I2CPriority priority) {
+  xSemaphoreGive(i2c_sync_done[priority]);
+}
+
+// Run a driver call on the bus and wait for it. Only one task may call
+// this per priority level (matching the scheduler's SPSC queues). arg
+// usually lives on the caller's stack: after a timeout the call is
+// abandoned so the op never runs on it, unless it has already started.
+static I2CResult bus_call(I2CPriority priority, uint8_t address,
+                          I2CResult (*op)(void*), void* arg, uint32_t timeout_us) {
+  if (!i2c_worker_handle) return op(arg);   // Still in sensors_init()
+  
+  uint32_t seq = i2c_call_submit(priority, address, op, arg, timeout_us);
+  if (!seq) return I2C_BUS_ERROR;
+  xTaskNotifyGive(i2c_worker_handle);
+  
+  TickType_t wait = pdMS_TO_TICKS(timeout_us / 1000 + I2C_SYNC_MARGIN_MS);
+  for (;;) {
+    if (xSemaphoreTake(i2c_sync_done[priority], wait) != pdTRUE) {
+      if (i2c_call_abandon(priority, seq)) return I2C_TIMEOUT;
+      // Already running on arg; the op's deadline bounds the wait
+      wait = portMAX_DELAY;
+      continue;
+    }
+    I2CResult result;
+    if (i2c_call_finished(priority, seq, result)) return result;
+    // A wake-up meant for an earlier call: keep waiting for ours
+  }
+}
+
+static bool i2c_bus_begin() {
+  for (int i = 0; i < I2C_PRIORITY_COUNT; i++) {
+    i2c_sync_done[i] = xSemaphoreCreateBinary();
+    if (!i2c_sync_done[i]) return false;
+  }
+  
+  I2CBusBackend backend = { wire_transfer, wire_now_us, nullptr, bus_call_done };
+  i2c_bus_init(backend);
+  
+  BaseType_t ok = xTaskCreatePinnedToCore(
+    i2c_worker_task, "i2c", I2C_WORKER_STACK, nullptr,
+    I2C_WORKER_PRIORITY, &i2c_worker_handle, I2C_WORKER_CORE
+  );
+  return ok == pdPASS;
+}
+
+// ===================================================================
+// MPU6050 FIFO Bus Access
+// ===================================================================
+// These run either during sensors_init() or inside a bus transaction.
+// ===================================================================
+
+// Inside a transaction, each transfer gets what is left of its deadline
+static bool mpu_write_reg(uint8_t reg, uint8_t value) {
+  uint8_t tx[2] = { reg, value };
+  return wire_transfer(nullptr, MPU6050_ADDR, tx, 2, nullptr, 0, i2c_bus_op_remaining_us()) == I2C_OK;
+}
+
+static bool mpu_read_regs(uint8_t reg, uint8_t* buf, size_t len) {
+  return wire_transfer(nullptr, MPU6050_ADDR, &reg, 1, buf, len, i2c_bus_op_remaining_us()) == I2C_OK;
+}
+
+static int mpu_fifo_count(void* ctx) {
+  uint8_t buf[2];
+  if (!mpu_read_regs(MPU6050_FIFO_COUNTH, buf, 2)) return -1;
+  return ((int)buf[0] << 8) | buf[1];
+}
+
+static bool mpu_fifo_read(void* ctx, uint8_t* buf, size_t len) {
+  return mpu_read_regs(MPU6050_FIFO_R_W, buf, len);
+}
+
+static void mpu_fifo_reset(void* ctx) {
+  mpu_write_reg(MPU6050_USER_CTRL, MPU6050_USER_FIFO_RESET);
+  mpu_write_reg(MPU6050_USER_CTRL, MPU6050_USER_FIFO_EN);
+}
+
+static bool imu_fifo_begin() {
+  uint8_t divider = (MPU6050_GYRO_OUTPUT_HZ / IMU_SAMPLE_RATE_HZ) - 1;
+  
+  bool ok = mpu_write_reg(MPU6050_SMPLRT_DIV, divider) &&
+            mpu_write_reg(MPU6050_USER_CTRL, MPU6050_USER_FIFO_RESET) &&
+            mpu_write_reg(MPU6050_FIFO_EN, MPU6050_FIFO_EN_ACCEL_GYRO) &&
+            mpu_write_reg(MPU6050_USER_CTRL, MPU6050_USER_FIFO_EN);
+  if (!ok) return false;
+  
+  ImuFifoBus bus = { mpu_fifo_count, mpu_fifo_read, mpu_fifo_reset, nullptr };
+  uint32_t period_us = 1000000UL * (divider + 1) / MPU6050_GYRO_OUTPUT_HZ;
+  imu_fifo_init(imu_fifo, bus, period_us);
+  imu_ring.clear();
+  return true;
+}
+
+// ===================================================================
+// Bus Transactions
+// ===================================================================
+
+static void notify_data_ready(const I2CTransaction& txn, I2CResult result) {
+  if (data_hook) data_hook();
+}
+
+static I2CResult imu_drain_op(void* ctx) {
+  imu_fifo_drain(imu_fifo, micros(), imu_ring);
+  return I2C_OK;
+}
+
+static void imu_drain_done(const I2CTransaction& txn, I2CResult result) {
+  imu_drain_queued = false;
+  notify_data_ready(txn, result);
+}
+
+// ctx carries the GPIO1 capture time
+static I2CResult tof_range_op(void* ctx) {
+  ToFData data = {0};
+  int16_t distance = vl53.distance();
+  
+  if (distance > 0 && distance < 4000) {
+    data.distance_mm = distance;
+    data.valid = true;
+  } else {
+    data.distance_mm = -1;
+    data.valid = false;
+  }
+  data.timestamp_ms = capture_millis((uint32_t)(uintptr_t)ctx);
+  data.zone = tof_zone_step(data.distance_mm, data.timestamp_ms);
+  vl53.clearInterrupt();
+  
+  tof_ring.push(data);
+  return I2C_OK;
+}
+
+// ===================================================================
+// Data-Ready Interrupts
+// ===================================================================
+// ISRs only stamp the time and post an event; the handlers, which run
+// from sensors_update(), queue the bus work.
+// ===================================================================
+
+#ifdef TOF_INT
+static void IRAM_ATTR tof_ready_isr() {
+  sensor_events_post(SENSOR_EVENT_TOF_READY, micros());
+}
+#endif
+
+#ifdef IMU_INT
+static void IRAM_ATTR imu_ready_isr() {
+  sensor_events_post(SENSOR_EVENT_IMU_READY, micros());
+}
+#endif
+
+static void tof_ready_handler(uint32_t t_us, void* ctx) {
+  I2CTransaction txn = {0};
+  txn.address = VL53L1X_ADDR;
+  txn.priority = I2C_PRIORITY_NORMAL;
+  txn.op = tof_range_op;
+  txn.ctx = (void*)(uintptr_t)t_us;
+  txn.timeout_us = I2C_TOF_TIMEOUT_US;
+  txn.done = notify_data_ready;
+  
+  if (i2c_worker_handle) {
+    bus_submit(txn);
+  } else {
+    tof_range_op(txn.ctx);
+  }
+}
+
+static void imu_ready_handler(uint32_t t_us, void* ctx) {
+  imu_fifo_poll();
+}
+
+static uint32_t events_clock() {
+  return micros();
+}
+
+static void sensor_interrupts_begin() {
+  sensor_events_init();
+  sensor_events_set_clock(events_clock);
+
+#ifdef TOF_INT
+  if (vl53_initialized) {
+    sensor_events_set_handler(SENSOR_EVENT_TOF_READY, tof_ready_handler, nullptr, false);
+    pinMode(TOF_INT, INPUT);
+    // GPIO1 defaults to active high; clear so the next range raises an edge
+    attachInterrupt(digitalPinToInterrupt(TOF_INT), tof_ready_isr, RISING);
+    vl53.clearInterrupt();
+    tof_irq_active = true;
+  }
+#endif
+
+#ifdef IMU_INT
+  if (imu_fifo_active && mpu_write_reg(MPU6050_INT_ENABLE, MPU6050_INT_DATA_RDY)) {
+    // Coalesced: one FIFO drain services every sample queued so far
+    sensor_events_set_handler(SENSOR_EVENT_IMU_READY, imu_ready_handler, nullptr, true);
+    pinMode(IMU_INT, INPUT);
+    attachInterrupt(digitalPinToInterrupt(IMU_INT), imu_ready_isr, RISING);
+    imu_irq_active = true;
+  }
+#endif
+  
+  LOG_INFO("Sensors: Data-ready IRQ (IMU:%s ToF:%s)",
+           imu_irq_active ? "Y" : "N", tof_irq_active ? "Y" : "N");
+}
+
+// ===================================================================
+// Device Presence Cache
+// ===================================================================
+// Replaces the full 126-address I2C scan. Devices found on the last
+// boot go straight to begin(); anything else gets one address probe.
+// RFID, which has no cheap probe, is skipped when it was absent last
+// time (clear the cache by erasing NVS to re-detect it).
+// ===================================================================
+
+#define PRESENCE_NAMESPACE   "sensors"
+#define PRESENCE_UNKNOWN     0xFF
+
+#define SENSOR_PRESENT_MPU   0x01
+#define SENSOR_PRESENT_VL53  0x02
+#define SENSOR_PRESENT_RFID  0x04
+
+static uint8_t presence_cached = PRESENCE_UNKNOWN;
+static uint8_t presence_found = 0;
+
+static uint8_t presence_load() {
+  Preferences prefs;
+  prefs.begin(PRESENCE_NAMESPACE, true);
+  uint8_t present = prefs.getUChar("present", PRESENCE_UNKNOWN);
+  prefs.end();
+  return present;
+}
+
+static bool device_expected(uint8_t bit, uint8_t address) {
+  if (presence_cached != PRESENCE_UNKNOWN && (presence_cached & bit)) return true;
+  
+  Wire.beginTransmission(address);
+  return Wire.endTransmission() == 0;
+}
+
+// ===================================================================
+// Sensor Initialization
+// ===================================================================
+
+bool sensors_init() {
+  LOG_INFO("Sensors: Initializing...");
+  
+  // Initialize single I2C bus for both sensors (both support fast mode)
+  Wire.begin(I2C_SDA, I2C_SCL, I2C_CLOCK_HZ);
+  presence_cached = presence_load();
   
   // Try to initialize MPU6050 (address 0x68)
-  if (mpu.begin(0x68, &Wire)) {
+  if (device_expected(SENSOR_PRESENT_MPU, MPU6050_ADDR) && mpu.begin(MPU6050_ADDR, &Wire)) {
     mpu.setAccelerometerRange(MPU6050_RANGE_8_G);
     mpu.setGyroRange(MPU6050_RANGE_500_DEG);
     mpu.setFilterBandwidth(MPU6050_BAND_21_HZ);
-    Serial.println("Sensors: MPU6050 OK (0x68)");
+    LOG_INFO("Sensors: MPU6050 OK (0x68)");
     mpu_initialized = true;
+    presence_found |= SENSOR_PRESENT_MPU;
+
+#ifdef IMU_FIFO_MODE
+    imu_fifo_active = imu_fifo_begin();
+    if (imu_fifo_active) {
+      LOG_INFO("Sensors: MPU6050 FIFO at %d Hz", IMU_SAMPLE_RATE_HZ);
+    } else {
+      LOG_WARN("Sensors: MPU6050 FIFO setup failed, using single reads");
+    }
+#endif
   } else {
-    Serial.println("Sensors: MPU6050 not found (skipping)");
+    LOG_WARN("Sensors: MPU6050 not found (skipping)");
     mpu_initialized = false;
   }
+  boot_mark(BOOT_PHASE_IMU);
   
-  // Try to initialize VL53L1X (address 0x29)
-  Serial.println("Sensors: Initializing VL53L1X...");
-  delay(100); // Give sensor time to power up
-  
-  if (vl53.begin(0x29, &Wire)) {
-    Serial.println("Sensors: VL53L1X detected (0x29)");
-    delay(50);
-    
+  // Try to initialize VL53L1X (address 0x29). begin() polls the boot
+  // state itself, so no power-up delay is needed.
+  if (device_expected(SENSOR_PRESENT_VL53, VL53L1X_ADDR) && vl53.begin(VL53L1X_ADDR, &Wire)) {
+    bool scanning = tof_zones_begin();
     if (vl53.startRanging()) {
-      vl53.setTimingBudget(50);
-      Serial.println("Sensors: VL53L1X OK - Ranging started!");
+      if (!scanning) vl53.setTimingBudget(50);
+      LOG_INFO("Sensors: VL53L1X OK - Ranging started%s", scanning ? " (zone scan)" : "");
       vl53_initialized = true;
+      presence_found |= SENSOR_PRESENT_VL53;
     } else {
-      Serial.println("ERROR: VL53L1X ranging start failed!");
+      LOG_ERROR("ERROR: VL53L1X ranging start failed!");
       vl53_initialized = false;
     }
   } else {
-    Serial.println("ERROR: VL53L1X not found!");
-    Serial.println("Check: SDA=GPIO19, SCL=GPIO20, VIN=3.3V, GND connected");
+    LOG_ERROR("ERROR: VL53L1X not found!");
+    LOG_ERROR("Check: SDA=GPIO19, SCL=GPIO20, VIN=3.3V, GND connected");
     vl53_initialized = false;
   }
-  
-  // Try to initialize MFRC522
-  SPI.begin(SPI_SCK, SPI_MISO, SPI_MOSI);
-  rfid.PCD_Init();
-  
-  if (rfid.PCD_PerformSelfTest()) {
-    rfid.PCD_Init();
-    Serial.println("Sensors: MFRC522 OK");
-    rfid_initialized = true;
-  } else {
-    Serial.println("Sensors: MFRC522 not found (skipping)");
-    rfid_initialized = false;
-  }
-  
+  boot_mark(BOOT_PHASE_TOF);
+
 #ifdef BATTERY_ADC
+  // BATTERY_ADC must be an ADC1 pin (GPIO1-10): ADC2 is shared with the radio
   pinMode(BATTERY_ADC, INPUT);
+  analogReadResolution(12);
   analogSetAttenuation(ADC_11db);
-  Serial.println("Sensors: Battery monitoring enabled");
+  battery_adc_cal = esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12,
+                                             1100, &battery_adc_chars);
+  battery_model_init(battery_model, BATTERY_CAPACITY_MAH, BATTERY_INTERNAL_MOHM);
+  battery_oversampler_reset(battery_os);
+  LOG_INFO("Sensors: Battery monitoring enabled (ADC calibration: %s)",
+           battery_adc_cal_source());
 #endif
   
+  sensor_interrupts_begin();
+  
+  if (i2c_bus_begin()) {
+    LOG_INFO("Sensors: I2C bus worker started");
+  } else {
+    LOG_ERROR("ERROR: I2C bus worker failed, using direct access");
+  }
+  
   // Check if at least one sensor initialized
-  if (mpu_initialized || vl53_initialized || rfid_initialized) {
-    Serial.print("Sensors: Initialization complete (");
-    Serial.print("MPU:");
-    Serial.print(mpu_initialized ? "Y" : "N");
-    Serial.print(" VL53:");
-    Serial.print(vl53_initialized ? "Y" : "N");
-    Serial.print(" RFID:");
-    Serial.print(rfid_initialized ? "Y" : "N");
-    Serial.println(")");
+  if (mpu_initialized || vl53_initialized) {
+    LOG_INFO("Sensors: Initialization complete (MPU:%s VL53:%s)",
+             mpu_initialized ? "Y" : "N", vl53_initialized ? "Y" : "N");
     sensors_initialized = true;
     return true;
   } else {
-    Serial.println("Sensors: No sensors found!");
+    LOG_WARN("Sensors: No sensors found!");
     sensors_initialized = false;
     return false;
   }
 }
 
+// ===================================================================
+// RFID Card Detection
+// ===================================================================
+// The detector talks to the chip through the library's register
+// accessors. MFRC522::PCD_Register values are pre-shifted for the SPI
+// address byte, hence the << 1.
+// ===================================================================
+
+static uint8_t rfid_reg_read(void* ctx, uint8_t reg) {
+  return rfid.PCD_ReadRegister((MFRC522::PCD_Register)(reg << 1));
+}
+
+static void rfid_reg_write(void* ctx, uint8_t reg, uint8_t value) {
+  rfid.PCD_WriteRegister((MFRC522::PCD_Register)(reg << 1), value);
+}
+
+#ifdef RFID_IRQ
+static void IRAM_ATTR rfid_irq_isr() {
+  rfid_detect_irq(rfid_detector);
+}
+#endif
+
+static void rfid_detect_begin() {
+  RfidRegisterIO io = { rfid_reg_read, rfid_reg_write, nullptr };
+
+#ifdef RFID_IRQ
+  rfid_irq_active = true;
+#endif
+  
+  rfid_detect_init(rfid_detector, io, rfid_irq_active, RFID_POLL_PERIOD_MS, millis());
+
+#ifdef RFID_IRQ
+  // ComIEnReg inverts the line, so completion pulls it low
+  pinMode(RFID_IRQ, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(RFID_IRQ), rfid_irq_isr, FALLING);
+#endif
+  
+  LOG_INFO("Sensors: RFID detection (%s)", rfid_irq_active ? "IRQ" : "polled");
+}
+
+bool rfid_irq_is_active() {
+  return rfid_irq_active;
+}
+
+uint32_t rfid_idle_ms() {
+  if (!rfid_initialized) return UINT32_MAX;
+  return rfid_detect_idle_ms(rfid_detector, millis());
+}
+
+RfidDetectStats rfid_get_detect_stats() {
+  return rfid_detector.stats;
+}
+
+// ===================================================================
+// RFID Initialization
+// ===================================================================
+// Brought up after sampling has started: PCD_Init() holds the chip in
+// reset for ~50 ms. A VersionReg read replaces the full self-test.
+// ===================================================================
+
+bool rfid_init() {
+  if (!(presence_cached & SENSOR_PRESENT_RFID) && presence_cached != PRESENCE_UNKNOWN) {
+    LOG_INFO("Sensors: MFRC522 absent on last boot (skipping)");
+    return false;
+  }
+  
+  SPI.begin(SPI_SCK, SPI_MISO, SPI_MOSI);
+  rfid.PCD_Init();
+  
+  byte version = rfid.PCD_ReadRegister(MFRC522::VersionReg);
+  if (version != 0x00 && version != 0xFF) {
+    LOG_INFO("Sensors: MFRC522 OK (version 0x%X)", version);
+    rfid_detect_begin();
+    if (landmark_db_mount(landmarks)) {
+      LOG_INFO("Sensors: Landmark index (%lu tags)", (unsigned long)landmarks.header->entry_count);
+    }
+    rfid_initialized = true;
+    presence_found |= SENSOR_PRESENT_RFID;
+  } else {
+    LOG_WARN("Sensors: MFRC522 not found (skipping)");
+    rfid_initialized = false;
+  }
+  return rfid_initialized;
+}
+
+void sensors_save_presence() {
+  if (presence_found == presence_cached) return;
+  
+  Preferences prefs;
+  prefs.begin(PRESENCE_NAMESPACE, false);
+  prefs.putUChar("present", presence_found);
+  prefs.end();
+}
+
 // ===================================================================
 // Sensor Update (periodic maintenance)
 // ===================================================================
+// Runs the handlers for any data-ready interrupts since the last call,
+// and polls the IMU FIFO when its INT line is not wired.
+// ===================================================================
 
 void sensors_update() {
+  sensor_events_dispatch(micros());
+  
+  if (imu_fifo_active && !imu_irq_active) {
+    imu_fifo_poll();
+  }
 }
 
 // ===================================================================
 // IMU Read
 // ===================================================================
 
+static I2CResult imu_read_op(void* ctx) {
+  IMUData* data = (IMUData*)ctx;
+  
+  sensors_event_t accel, gyro, temp;
+  if (!mpu.getEvent(&accel, &gyro, &temp)) return I2C_BUS_ERROR;
+  
+  data->ax = accel.acceleration.x / 9.81;
+  data->ay = accel.acceleration.y / 9.81;
+  data->az = accel.acceleration.z / 9.81;
+  data->gx = gyro.gyro.x * 57.2958;
+  data->gy = gyro.gyro.y * 57.2958;
+  data->gz = gyro.gyro.z * 57.2958;
+  data->timestamp_ms = millis();
+  return I2C_OK;
+}
+
 IMUData imu_read() {
   IMUData data = {0};
   
@@ -148,52 +661,113 @@ IMUData imu_read() {
     return data;
   }
   
-  sensors_event_t accel, gyro, temp;
-  if (mpu.getEvent(&accel, &gyro, &temp)) {
-    data.ax = accel.acceleration.x / 9.81;
-    data.ay = accel.acceleration.y / 9.81;
-    data.az = accel.acceleration.z / 9.81;
-    data.gx = gyro.gyro.x * 57.2958;
-    data.gy = gyro.gyro.y * 57.2958;
-    data.gz = gyro.gyro.z * 57.2958;
-    data.valid = true;
-  } else {
-    data.valid = false;
-  }
-  
+  data.valid = bus_call(I2C_PRIORITY_HIGH, MPU6050_ADDR, imu_read_op, &data,
+                        I2C_IMU_TIMEOUT_US) == I2C_OK;
   return data;
 }
 
 // ===================================================================
-// ToF Read
+// IMU FIFO Acquisition
 // ===================================================================
 
-ToFData tof_read() {
-  ToFData data = {0};
+bool imu_fifo_is_active() {
+  return imu_fifo_active;
+}
+
+bool imu_fifo_poll() {
+  if (!imu_fifo_active) return false;
   
-  if (!vl53_initialized) {
-    data.distance_mm = -1;
-    data.valid = false;
-    return data;
+  if (!i2c_worker_handle) {
+    imu_fifo_drain(imu_fifo, micros(), imu_ring);
+    return true;
+  }
+  
+  // One drain empties the whole FIFO, so never queue a second
+  if (imu_drain_queued) return false;
+  
+  I2CTransaction txn = {0};
+  txn.address = MPU6050_ADDR;
+  txn.priority = I2C_PRIORITY_HIGH;
+  txn.op = imu_drain_op;
+  txn.timeout_us = I2C_IMU_TIMEOUT_US;
+  txn.done = imu_drain_done;
+  
+  imu_drain_queued = true;
+  if (!bus_submit(txn)) {
+    imu_drain_queued = false;
+    return false;
   }
+  return true;
+}
+
+bool imu_fifo_pop(IMUData& out) {
+  ImuRawSample raw;
+  if (!imu_ring.pop(raw)) return false;
+  
+  out.ax = raw.ax / MPU6050_ACCEL_LSB_PER_G;
+  out.ay = raw.ay / MPU6050_ACCEL_LSB_PER_G;
+  out.az = raw.az / MPU6050_ACCEL_LSB_PER_G;
+  out.gx = raw.gx / MPU6050_GYRO_LSB_PER_DPS;
+  out.gy = raw.gy / MPU6050_GYRO_LSB_PER_DPS;
+  out.gz = raw.gz / MPU6050_GYRO_LSB_PER_DPS;
+  
+  out.timestamp_ms = capture_millis(raw.t_us);
+  out.valid = true;
+  return true;
+}
+
+ImuFifoStats imu_fifo_get_stats() {
+  return imu_fifo.stats;
+}
+
+// ===================================================================
+// Interrupt-Driven ToF
+// ===================================================================
+
+bool tof_irq_is_active() {
+  return tof_irq_active;
+}
+
+bool tof_pop(ToFData& out) {
+  return tof_ring.pop(out);
+}
+
+void sensors_set_data_hook(void (*hook)()) {
+  data_hook = hook;
+}
+
+// ===================================================================
+// ToF Read
+// ===================================================================
+
+static I2CResult tof_poll_op(void* ctx) {
+  ToFData* data = (ToFData*)ctx;
   
   if (vl53.dataReady()) {
     int16_t distance = vl53.distance();
     
     if (distance > 0 && distance < 4000) {
-      data.distance_mm = distance;
-      data.valid = true;
-    } else {
-      data.distance_mm = -1;
-      data.valid = false;
+      data->distance_mm = distance;
+      data->valid = true;
     }
+    data->timestamp_ms = millis();
+    data->zone = tof_zone_step(data->distance_mm, data->timestamp_ms);
     
     vl53.clearInterrupt();
-  } else {
-    data.distance_mm = -1;
-    data.valid = false;
+  }
+  return I2C_OK;
+}
+
+ToFData tof_read() {
+  ToFData data = {0};
+  data.distance_mm = -1;
+  data.valid = false;
+  
+  if (!vl53_initialized) {
+    return data;
   }
   
+  bus_call(I2C_PRIORITY_NORMAL, VL53L1X_ADDR, tof_poll_op, &data, I2C_TOF_TIMEOUT_US);
   return data;
 }
 
@@ -209,7 +783,9 @@ RFIDData rfid_read() {
     return data;
   }
   
-  if (!rfid.PICC_IsNewCardPresent()) {
+  // REQA probing is non-blocking; only an answering card costs a
+  // (blocking) anticollision/select
+  if (!rfid_detect_update(rfid_detector, millis())) {
     if (last_rfid_data.valid && 
         (millis() - last_rfid_data.last_seen_ms > RFID_DEDUPLICATE_MS)) {
       last_rfid_data.valid = false;
@@ -219,65 +795,114 @@ RFIDData rfid_read() {
   }
   
   if (!rfid.PICC_ReadCardSerial()) {
+    rfid_detect_card_done(rfid_detector, millis());
     return last_rfid_data;
   }
   
-  char uid_str[20] = {0};
-  for (byte i = 0; i < rfid.uid.size; i++) {
-    sprintf(uid_str + (i * 2), "%02X", rfid.uid.uidByte[i]);
-  }
+  uint8_t uid_len = min((uint8_t)rfid.uid.size, (uint8_t)LANDMARK_UID_MAX);
+  bool is_new = !last_rfid_data.valid || uid_len != last_rfid_data.uid_len ||
+                memcmp(rfid.uid.uidByte, last_rfid_data.uid_bytes, uid_len) != 0;
   
-  bool is_new = (strcmp(uid_str, last_rfid_data.uid) != 0);
-  
-  strcpy(last_rfid_data.uid, uid_str);
+  if (is_new) {
+    static const char hex[] = "0123456789ABCDEF";
+    for (uint8_t i = 0; i < uid_len; i++) {
+      last_rfid_data.uid[2 * i] = hex[rfid.uid.uidByte[i] >> 4];
+      last_rfid_data.uid[2 * i + 1] = hex[rfid.uid.uidByte[i] & 0x0F];
+    }
+    last_rfid_data.uid[2 * uid_len] = '\0';
+    memcpy(last_rfid_data.uid_bytes, rfid.uid.uidByte, uid_len);
+    last_rfid_data.uid_len = uid_len;
+    last_rfid_data.landmark = landmark_db_lookup(landmarks, rfid.uid.uidByte, uid_len);
+  }
   last_rfid_data.valid = true;
   last_rfid_data.last_seen_ms = millis();
   
   rfid.PICC_HaltA();
   rfid.PCD_StopCrypto1();
+  rfid_detect_card_done(rfid_detector, millis());
   
   data = last_rfid_data;
   
   if (is_new) {
-    Serial.print("Sensors: RFID detected: ");
-    Serial.println(uid_str);
+    if (last_rfid_data.landmark) {
+      LOG_INFO("Sensors: RFID detected: %s (landmark %u)", last_rfid_data.uid,
+               last_rfid_data.landmark->landmark_id);
+    } else {
+      LOG_INFO("Sensors: RFID detected: %s", last_rfid_data.uid);
+    }
   }
   
   return data;
 }
 
 // ===================================================================
-// Battery Read
+// Battery Measurement
+// ===================================================================
+// One conversion per sensing cycle, so a reading never blocks the
+// task: BATTERY_OVERSAMPLE conversions at SENSING_CYCLE_MS take about
+// 0.6 s, then the ADC rests for BATTERY_READ_PERIOD_MS.
 // ===================================================================
 
-BatteryData battery_read() {
-  BatteryData data = {0};
-  
 #ifdef BATTERY_ADC
-  int adc_value = analogRead(BATTERY_ADC);
-  
-  float voltage = (adc_value / 4095.0) * 3.3 * 2.0;
-  
-  if (battery_filtered == 0.0) {
-    battery_filtered = voltage;
-  } else {
-    battery_filtered = (BATTERY_FILTER_ALPHA * voltage) + 
-                      ((1.0 - BATTERY_FILTER_ALPHA) * battery_filtered);
+// eFuse-calibrated pin voltage for a mean raw value in 1/256 LSB,
+// interpolated between adjacent codes
+static float battery_raw_to_mv(uint32_t raw_q8) {
+  uint32_t raw = raw_q8 >> 8;
+  uint32_t lo = esp_adc_cal_raw_to_voltage(raw, &battery_adc_chars);
+  uint32_t hi = esp_adc_cal_raw_to_voltage(raw < 4095 ? raw + 1 : raw, &battery_adc_chars);
+  return lo + (float)(hi - lo) * (raw_q8 & 0xFF) / 256.0f;
+}
+#endif
+
+void battery_update(unsigned long now, uint16_t load_ma) {
+#ifdef BATTERY_ADC
+  if (battery_os.count == 0 && battery_model.readings > 0 &&
+      now - battery_last_reading_ms < BATTERY_READ_PERIOD_MS) {
+    return;
   }
   
-  data.voltage = battery_filtered;
+  if (!battery_oversampler_add(battery_os, analogRead(BATTERY_ADC), load_ma)) return;
   
-  float percentage = ((battery_filtered - BATTERY_MIN_VOLTAGE) / 
-                     (BATTERY_MAX_VOLTAGE - BATTERY_MIN_VOLTAGE)) * 100.0;
-  data.percentage = constrain((int)percentage, 0, 100);
-  data.valid = true;
-#else
-  data.valid = false;
-#endif
+  float pin_mv = battery_raw_to_mv(battery_oversampler_mean_q8(battery_os));
+  uint16_t cell_mv = (uint16_t)(pin_mv * BATTERY_DIVIDER_RATIO + 0.5f);
+  BatteryEstimate est = battery_model_update(battery_model, cell_mv,
+                                             battery_oversampler_load_ma(battery_os), now);
+  battery_oversampler_reset(battery_os);
+  battery_last_reading_ms = now;
   
+  battery_latest.voltage = est.cell_mv / 1000.0f;
+  battery_latest.percentage = est.percentage;
+  battery_latest.runtime_min = est.runtime_min;
+  battery_latest.charging = est.charging;
+  battery_latest.valid = true;
+  battery_fresh = true;
+#endif
+}
+
+BatteryData battery_read() {
+  BatteryData data = battery_latest;
+  data.valid = battery_fresh;
+  battery_fresh = false;
   return data;
 }
 
+BatteryModel battery_get_model() {
+  return battery_model;
+}
+
+const char* battery_adc_cal_source() {
+#ifdef BATTERY_ADC
+  switch (battery_adc_cal) {
+    case ESP_ADC_CAL_VAL_EFUSE_TP_FIT: return "efuse_tp_fit";
+    case ESP_ADC_CAL_VAL_EFUSE_TP:     return "efuse_tp";
+    case ESP_ADC_CAL_VAL_EFUSE_VREF:   return "efuse_vref";
+    default:                           return "default_vref";
+  }
+#else
+  return "none";
+#endif
+}
+
 // ===================================================================
 // RFID Helper Functions
 // ===================================================================
@@ -2,31 +2,48 @@
 #define SENSORS_H
 
 #include <Arduino.h>
+#include "imu_fifo.h"
+#include "rfid_detect.h"
+#include "landmark_db.h"
+#include "tof_zones.h"
+#include "battery_model.h"
 
 // ===================================================================
 // Sensor Data Structures
 // ===================================================================
 
+// MPU6050 scale factors matching the ranges set in sensors_init()
+#define MPU6050_ACCEL_LSB_PER_G    4096.0   // +/-8 g
+#define MPU6050_GYRO_LSB_PER_DPS   65.5     // +/-500 deg/s
+
 struct IMUData {
   float ax, ay, az;  // Acceleration in g's
   float gx, gy, gz;  // Gyroscope in deg/s
+  unsigned long timestamp_ms;  // Capture time (millis() timebase)
   bool valid;
 };
 
 struct ToFData {
   int16_t distance_mm;  // -1 if invalid
+  unsigned long timestamp_ms;  // Capture time (millis() timebase)
+  uint8_t zone;         // TofZone the range was taken in
   bool valid;
 };
 
 struct RFIDData {
-  char uid[20];         // Hex string of UID
+  char uid[2 * LANDMARK_UID_MAX + 1];  // Hex string of UID (for the phone)
+  uint8_t uid_bytes[LANDMARK_UID_MAX];
+  uint8_t uid_len;
+  const LandmarkSlot* landmark;  // nullptr if not in the landmark index
   bool valid;
   unsigned long last_seen_ms;
 };
 
 struct BatteryData {
-  float voltage;
-  uint8_t percentage;
+  float voltage;          // Cell terminal voltage
+  uint8_t percentage;     // From the discharge curve, load-compensated
+  uint16_t runtime_min;   // BATTERY_RUNTIME_UNKNOWN when unknown
+  bool charging;
   bool valid;
 };
 
@@ -35,6 +52,8 @@ struct BatteryData {
 // ===================================================================
 
 bool sensors_init();
+bool rfid_init();
+void sensors_save_presence();
 void sensors_update();
 
 IMUData imu_read();
@@ -42,6 +61,39 @@ ToFData tof_read();
 RFIDData rfid_read();
 BatteryData battery_read();
 
+// FIFO acquisition (IMU_FIFO_MODE): poll queues a FIFO drain on the I2C
+// bus, pop hands out the drained samples one at a time with timestamps.
+bool imu_fifo_is_active();
+bool imu_fifo_poll();
+bool imu_fifo_pop(IMUData& out);
+ImuFifoStats imu_fifo_get_stats();
+
+// Interrupt-driven ToF (TOF_INT): ranges are read as soon as GPIO1
+// fires and queued here with their ISR capture time.
+bool tof_irq_is_active();
+bool tof_pop(ToFData& out);
+
+// Zone scanning (TOF_ZONE_SCAN): sweep timing and current budgets
+bool tof_zone_scan_is_active();
+TofZoneScheduler tof_zone_get_schedule();
+
+// Called (from the I2C worker) whenever queued bus work has produced
+// new IMU samples or ToF ranges
+void sensors_set_data_hook(void (*hook)());
+
+// IRQ-driven card detection (RFID_IRQ): rfid_read() is cheap to call
+// every loop; the reader sleeps between probes.
+bool rfid_irq_is_active();
+uint32_t rfid_idle_ms();
+RfidDetectStats rfid_get_detect_stats();
+
+// Battery (BATTERY_ADC): battery_update() takes one calibrated ADC
+// conversion per call and completes a reading every BATTERY_OVERSAMPLE
+// calls; battery_read() returns it once (valid = false otherwise).
+void battery_update(unsigned long now, uint16_t load_ma);
+BatteryModel battery_get_model();
+const char* battery_adc_cal_source();
+
 const char* rfid_get_current_uid();
 bool rfid_has_recent_tag();
 
@@ -0,0 +1,126 @@
+#include "telemetry_batch.h"
+#include <string.h>
+
+// ===================================================================
+// Buffer Management
+// ===================================================================
+
+void telemetry_batch_init(TelemetryBatch& b, TelemetryBatchSend send, void* ctx) {
+  b.send = send;
+  b.ctx = ctx;
+  b.stats = {};
+  b.len = 0;
+  b.imu_type = TELEMETRY_FRAME_IMU;
+  telemetry_batch_set_mtu(b, TELEMETRY_BATCH_DEFAULT_MTU);
+  telemetry_batch_reset(b);
+}
+
+void telemetry_batch_set_mtu(TelemetryBatch& b, uint16_t mtu) {
+  uint16_t payload = mtu > 3 ? mtu - 3 : 0;
+  if (payload > TELEMETRY_BATCH_MAX) payload = TELEMETRY_BATCH_MAX;
+  if (b.len > payload) telemetry_batch_flush(b);
+  b.payload = payload;
+}
+
+void telemetry_batch_reset(TelemetryBatch& b) {
+  b.len = 0;
+  b.imu_at = TELEMETRY_BATCH_NONE;
+  b.seq = 0;
+}
+
+void telemetry_batch_set_imu_type(TelemetryBatch& b, TelemetryFrameType type) {
+  b.imu_type = type;
+  b.imu_at = TELEMETRY_BATCH_NONE;
+}
+
+void telemetry_batch_flush(TelemetryBatch& b) {
+  if (b.len == 0) return;
+  b.send(b.buf, b.len, b.ctx);
+  b.stats.notifications++;
+  b.stats.bytes += b.len;
+  b.len = 0;
+  b.imu_at = TELEMETRY_BATCH_NONE;
+}
+
+// Room for a size-byte frame at the end of the buffer, sending what is
+// there first if it would not fit. The batch is due wait_ms from now
+// unless something older is due sooner.
+static uint8_t* reserve(TelemetryBatch& b, size_t size, uint32_t now_ms, uint32_t wait_ms) {
+  if (b.len > 0 && b.len + size > b.payload) {
+    b.stats.full_flushes++;
+    telemetry_batch_flush(b);
+  }
+  if (size > b.payload) b.stats.oversize++;
+  
+  uint32_t due = now_ms + wait_ms;
+  if (b.len == 0 || (int32_t)(due - b.due_ms) < 0) b.due_ms = due;
+  b.stats.frames++;
+  return b.buf + b.len;
+}
+
+// ===================================================================
+// Adding Frames
+// ===================================================================
+
+void telemetry_batch_add_sample(TelemetryBatch& b, const TelemetryValues& v, const GaitSummary* gait,
+                                uint32_t now_ms) {
+  size_t size = TELEMETRY_SAMPLE_BYTES + (gait ? TELEMETRY_GAIT_BYTES : 0);
+  uint8_t* out = reserve(b, size, now_ms, TELEMETRY_BATCH_SAMPLE_WAIT_MS);
+  size_t len = telemetry_encode_sample(v, b.seq++, out);
+  if (gait) {
+    b.stats.frames++;
+    len += telemetry_encode_gait(*gait, b.seq++, v.t_us, out + len);
+  }
+  b.len += len;
+  b.imu_at = TELEMETRY_BATCH_NONE;   // IMU frames only grow at the end
+  if (size > b.payload) telemetry_batch_flush(b);
+}
+
+void telemetry_batch_add_imu(TelemetryBatch& b, const TelemetryImuSample& s, uint8_t period_ms,
+                             uint32_t now_ms) {
+  b.stats.imu_samples++;
+  
+  // Extend the open frame while the samples stay on its time grid
+  if (b.imu_at != TELEMETRY_BATCH_NONE) {
+    uint8_t* frame = b.buf + b.imu_at;
+    int32_t skew = (int32_t)(s.t_ms - b.imu_next_ms);
+    bool on_grid = period_ms == b.imu_period_ms && skew <= period_ms / 2 && -skew <= period_ms / 2;
+    size_t n = 0;
+    if (on_grid && frame[10] < 255) {
+      n = telemetry_append_imu(frame, b.len - b.imu_at, b.payload - b.len, b.imu_prev, s);
+    }
+    if (n) {
+      b.len += n;
+      b.imu_next_ms += period_ms;
+      memcpy(b.imu_prev, s.v, sizeof(b.imu_prev));
+      return;
+    }
+  }
+  
+  // A cut IMU frame would decode as garbage; wait for a larger MTU
+  size_t size = TELEMETRY_IMU_HEADER_BYTES + TELEMETRY_IMU_SAMPLE_BYTES;
+  if (size > b.payload) {
+    b.stats.oversize++;
+    return;
+  }
+  
+  uint8_t* frame = reserve(b, size, now_ms, TELEMETRY_BATCH_IMU_WAIT_MS);
+  b.imu_at = b.len;
+  size_t len = telemetry_begin_imu(frame, (TelemetryFrameType)b.imu_type, b.seq++, s.t_ms, period_ms);
+  len += telemetry_append_imu(frame, len, TELEMETRY_IMU_SAMPLE_BYTES, b.imu_prev, s);
+  b.len += len;
+  b.imu_next_ms = s.t_ms + period_ms;
+  b.imu_period_ms = period_ms;
+  memcpy(b.imu_prev, s.v, sizeof(b.imu_prev));
+}
+
+// ===================================================================
+// Deadline
+// ===================================================================
+
+void telemetry_batch_service(TelemetryBatch& b, uint32_t now_ms) {
+  if (b.len > 0 && (int32_t)(now_ms - b.due_ms) >= 0) {
+    b.stats.deadline_flushes++;
+    telemetry_batch_flush(b);
+  }
+}
@@ -0,0 +1,88 @@
+#ifndef TELEMETRY_BATCH_H
+#define TELEMETRY_BATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "telemetry_frame.h"
+
+// ===================================================================
+// Batched Telemetry Notifications
+// ===================================================================
+// Packs binary frames (telemetry_frame.h) into as few SENSOR_DATA
+// notifications as the negotiated ATT MTU allows. Consecutive IMU
+// samples share one IMU frame, raw or delta-coded; sample and gait
+// frames are appended whole. A frame never spans notifications. A
+// notification goes out when the next frame would not fit or when the
+// oldest frame in it reaches its deadline, so 100 Hz IMU data costs a
+// handful of notifications per second instead of one per sample, and
+// the connection-event rate does not have to rise to carry it.
+//
+// The batch owns the frame sequence numbers. Not thread-safe: one
+// task adds and services. Portable; tools/telemetry_bench.cpp runs it
+// on the host.
+// ===================================================================
+
+#define TELEMETRY_BATCH_MAX          512   // ATT attribute value limit
+#define TELEMETRY_BATCH_DEFAULT_MTU  23    // Until the exchange completes
+#define TELEMETRY_BATCH_SAMPLE_WAIT_MS 50  // Sample frames: obstacle range is live
+#define TELEMETRY_BATCH_IMU_WAIT_MS  200   // IMU stream: throughput over latency
+
+#define TELEMETRY_BATCH_NONE 0xFFFF
+
+typedef void (*TelemetryBatchSend)(const uint8_t* data, size_t len, void* ctx);
+
+struct TelemetryBatchStats {
+  uint32_t imu_samples;
+  uint32_t frames;
+  uint32_t notifications;
+  uint32_t bytes;
+  uint32_t full_flushes;      // Sent because the next frame did not fit
+  uint32_t deadline_flushes;  // Sent because the oldest frame was due
+  uint32_t oversize;          // Larger than the payload: sample frames go
+                              // alone (the stack cuts them), IMU samples
+                              // are dropped
+};
+
+struct TelemetryBatch {
+  uint8_t buf[TELEMETRY_BATCH_MAX];
+  uint16_t len;
+  uint16_t payload;           // ATT MTU - 3, capped at the buffer
+  uint16_t imu_at;            // Offset of the open IMU frame, or NONE
+  uint32_t imu_next_ms;       // Expected time of its next sample
+  uint8_t imu_period_ms;
+  int16_t imu_prev[6];        // Its last sample, for deltas
+  uint8_t imu_type;           // TELEMETRY_FRAME_IMU or _IMU_DELTA
+  uint16_t seq;
+  uint32_t due_ms;            // Send by then; valid while len > 0
+  TelemetryBatchSend send;
+  void* ctx;
+  TelemetryBatchStats stats;
+};
+
+// ===================================================================
+// Telemetry Batch Functions
+// ===================================================================
+
+void telemetry_batch_init(TelemetryBatch& b, TelemetryBatchSend send, void* ctx);
+void telemetry_batch_set_mtu(TelemetryBatch& b, uint16_t mtu);
+
+// Drop anything pending and restart the sequence (new connection)
+void telemetry_batch_reset(TelemetryBatch& b);
+
+// Frame type for IMU samples from now on (raw after init)
+void telemetry_batch_set_imu_type(TelemetryBatch& b, TelemetryFrameType type);
+
+// One sample frame, plus its gait frame when gait is not null; kept in
+// the same notification
+void telemetry_batch_add_sample(TelemetryBatch& b, const TelemetryValues& v, const GaitSummary* gait,
+                                uint32_t now_ms);
+
+// One raw IMU sample taken every period_ms
+void telemetry_batch_add_imu(TelemetryBatch& b, const TelemetryImuSample& s, uint8_t period_ms,
+                             uint32_t now_ms);
+
+// Send if the oldest pending frame is due; call every loop pass
+void telemetry_batch_service(TelemetryBatch& b, uint32_t now_ms);
+void telemetry_batch_flush(TelemetryBatch& b);
+
+#endif // TELEMETRY_BATCH_H
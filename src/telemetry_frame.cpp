@@ -0,0 +1,239 @@
+#include "telemetry_frame.h"
+#include <math.h>
+#include <string.h>
+
+// ===================================================================
+// Little-Endian Fields
+// ===================================================================
+
+static void put_u16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+  put_u16(p, (uint16_t)v);
+  put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get_u16(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+  return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+// v in units of 1/scale, rounded and saturated
+static int16_t scaled(float v, float scale) {
+  float s = v * scale;
+  if (s >= 32767.0f) return 32767;
+  if (s <= -32768.0f) return -32768;
+  return (int16_t)lroundf(s);
+}
+
+static void put_header(uint8_t* out, TelemetryFrameType type, uint8_t flags, uint16_t seq, uint32_t t_us) {
+  out[0] = TELEMETRY_FRAME_MAGIC;
+  out[1] = TELEMETRY_FRAME_VERSION;
+  out[2] = (uint8_t)type;
+  out[3] = flags;
+  put_u16(out + 4, seq);
+  put_u32(out + 6, t_us);
+}
+
+static bool check_header(const uint8_t* in, size_t len, TelemetryFrameType type, size_t bytes) {
+  return len >= bytes && in[0] == TELEMETRY_FRAME_MAGIC && in[1] == TELEMETRY_FRAME_VERSION &&
+         in[2] == (uint8_t)type;
+}
+
+// ===================================================================
+// Sample Frame
+// ===================================================================
+
+size_t telemetry_encode_sample(const TelemetryValues& v, uint16_t seq, uint8_t* out) {
+  put_header(out, TELEMETRY_FRAME_SAMPLE, v.flags, seq, v.t_us);
+  
+  bool imu = v.flags & TELEMETRY_FLAG_IMU;
+  put_u16(out + 10, imu ? scaled(v.ax, 1000.0f) : 0);
+  put_u16(out + 12, imu ? scaled(v.ay, 1000.0f) : 0);
+  put_u16(out + 14, imu ? scaled(v.az, 1000.0f) : 0);
+  put_u16(out + 16, imu ? scaled(v.gx, 10.0f) : 0);
+  put_u16(out + 18, imu ? scaled(v.gy, 10.0f) : 0);
+  put_u16(out + 20, imu ? scaled(v.gz, 10.0f) : 0);
+  put_u16(out + 22, scaled(v.pitch_deg, 100.0f));
+  put_u16(out + 24, scaled(v.roll_deg, 100.0f));
+  
+  put_u16(out + 26, (uint16_t)(v.flags & TELEMETRY_FLAG_TOF ? v.dist_mm : -1));
+  for (int z = 0; z < TOF_ZONE_COUNT; z++) {
+    put_u16(out + 28 + 2 * z, (uint16_t)(v.flags & TELEMETRY_FLAG_ZONES ? v.zone_mm[z] : -1));
+  }
+  
+  bool battery = v.flags & TELEMETRY_FLAG_BATTERY;
+  float mv = v.battery_v * 1000.0f;
+  put_u16(out + 34, battery && mv > 0 ? (uint16_t)(mv > 65535.0f ? 65535 : lroundf(mv)) : 0);
+  out[36] = battery ? v.battery_pct : 0;
+  out[37] = 0;
+  put_u16(out + 38, battery ? v.runtime_min : 0xFFFF);
+  return TELEMETRY_SAMPLE_BYTES;
+}
+
+size_t telemetry_decode_sample(const uint8_t* in, size_t len, TelemetryValues& v, uint16_t& seq) {
+  if (!check_header(in, len, TELEMETRY_FRAME_SAMPLE, TELEMETRY_SAMPLE_BYTES)) return 0;
+  v.flags = in[3];
+  seq = get_u16(in + 4);
+  v.t_us = get_u32(in + 6);
+  v.ax = (int16_t)get_u16(in + 10) / 1000.0f;
+  v.ay = (int16_t)get_u16(in + 12) / 1000.0f;
+  v.az = (int16_t)get_u16(in + 14) / 1000.0f;
+  v.gx = (int16_t)get_u16(in + 16) / 10.0f;
+  v.gy = (int16_t)get_u16(in + 18) / 10.0f;
+  v.gz = (int16_t)get_u16(in + 20) / 10.0f;
+  v.pitch_deg = (int16_t)get_u16(in + 22) / 100.0f;
+  v.roll_deg = (int16_t)get_u16(in + 24) / 100.0f;
+  v.dist_mm = (int16_t)get_u16(in + 26);
+  for (int z = 0; z < TOF_ZONE_COUNT; z++) {
+    v.zone_mm[z] = (int16_t)get_u16(in + 28 + 2 * z);
+  }
+  v.battery_v = get_u16(in + 34) / 1000.0f;
+  v.battery_pct = in[36];
+  v.runtime_min = get_u16(in + 38);
+  return TELEMETRY_SAMPLE_BYTES;
+}
+
+// ===================================================================
+// Gait Frame
+// ===================================================================
+
+size_t telemetry_encode_gait(const GaitSummary& gait, uint16_t seq, uint32_t t_us, uint8_t* out) {
+  put_header(out, TELEMETRY_FRAME_GAIT, gait.walking ? TELEMETRY_FLAG_WALKING : 0, seq, t_us);
+  put_u32(out + 10, gait.steps);
+  put_u32(out + 14, gait.plants);
+  put_u16(out + 18, gait.cadence_spm);
+  put_u16(out + 20, gait.stride_ms);
+  float cv = gait.stride_cv * 1000.0f;
+  put_u16(out + 22, cv > 65535.0f ? 65535 : (uint16_t)lroundf(cv));
+  put_u16(out + 24, gait.bouts);
+  put_u32(out + 26, gait.walking_s);
+  put_u16(out + 30, gait.bout_steps);
+  put_u16(out + 32, gait.longest_bout_steps);
+  return TELEMETRY_GAIT_BYTES;
+}
+
+size_t telemetry_decode_gait(const uint8_t* in, size_t len, GaitSummary& gait, uint16_t& seq) {
+  if (!check_header(in, len, TELEMETRY_FRAME_GAIT, TELEMETRY_GAIT_BYTES)) return 0;
+  seq = get_u16(in + 4);
+  gait.t_ms = get_u32(in + 6) / 1000;
+  gait.walking = in[3] & TELEMETRY_FLAG_WALKING;
+  gait.steps = get_u32(in + 10);
+  gait.plants = get_u32(in + 14);
+  gait.cadence_spm = get_u16(in + 18);
+  gait.stride_ms = get_u16(in + 20);
+  gait.stride_cv = get_u16(in + 22) / 1000.0f;
+  gait.bouts = get_u16(in + 24);
+  gait.walking_s = get_u32(in + 26);
+  gait.bout_steps = get_u16(in + 30);
+  gait.longest_bout_steps = get_u16(in + 32);
+  return TELEMETRY_GAIT_BYTES;
+}
+
+// ===================================================================
+// IMU Frames
+// ===================================================================
+
+static size_t put_varint(uint8_t* p, uint32_t v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    p[n++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  p[n++] = (uint8_t)v;
+  return n;
+}
+
+// 0 if the varint runs past end
+static size_t get_varint(const uint8_t* p, const uint8_t* end, uint32_t& v) {
+  v = 0;
+  for (size_t n = 0; n < 3 && p + n < end; n++) {
+    v |= (uint32_t)(p[n] & 0x7F) << (7 * n);
+    if (!(p[n] & 0x80)) return n + 1;
+  }
+  return 0;
+}
+
+// Signed to unsigned with small magnitudes small: 0, -1, 1, -2 -> 0, 1, 2, 3
+static uint32_t zigzag(int32_t v) {
+  return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v) {
+  return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+size_t telemetry_begin_imu(uint8_t* out, TelemetryFrameType type, uint16_t seq, uint32_t t_ms,
+                           uint8_t period_ms) {
+  put_header(out, type, 0, seq, t_ms * 1000);
+  out[10] = 0;
+  out[11] = period_ms;
+  return TELEMETRY_IMU_HEADER_BYTES;
+}
+
+size_t telemetry_append_imu(uint8_t* frame, size_t len, size_t room, const int16_t prev[6],
+                            const TelemetryImuSample& s) {
+  uint8_t* out = frame + len;
+  size_t n = 0;
+  if (frame[2] == TELEMETRY_FRAME_IMU || frame[10] == 0) {
+    if (room < TELEMETRY_IMU_SAMPLE_BYTES) return 0;
+    for (int i = 0; i < 6; i++) {
+      put_u16(out + 2 * i, (uint16_t)s.v[i]);
+    }
+    n = TELEMETRY_IMU_SAMPLE_BYTES;
+  } else {
+    uint8_t tmp[TELEMETRY_IMU_DELTA_MAX];
+    for (int i = 0; i < 6; i++) {
+      n += put_varint(tmp + n, zigzag((int32_t)s.v[i] - prev[i]));
+    }
+    if (n > room) return 0;
+    memcpy(out, tmp, n);
+  }
+  frame[10]++;
+  return n;
+}
+
+size_t telemetry_decode_imu(const uint8_t* in, size_t len, TelemetryImuSample* out, size_t max,
+                            size_t& count, uint16_t& seq) {
+  if (!check_header(in, len, TELEMETRY_FRAME_IMU, TELEMETRY_IMU_HEADER_BYTES) &&
+      !check_header(in, len, TELEMETRY_FRAME_IMU_DELTA, TELEMETRY_IMU_HEADER_BYTES)) {
+    return 0;
+  }
+  bool delta = in[2] == TELEMETRY_FRAME_IMU_DELTA;
+  seq = get_u16(in + 4);
+  uint32_t t_ms = get_u32(in + 6) / 1000;
+  uint8_t n = in[10];
+  const uint8_t* p = in + TELEMETRY_IMU_HEADER_BYTES;
+  const uint8_t* end = in + len;
+  int16_t v[6] = {0};
+  count = 0;
+  for (uint8_t k = 0; k < n; k++) {
+    if (!delta || k == 0) {
+      if (end - p < TELEMETRY_IMU_SAMPLE_BYTES) return 0;
+      for (int i = 0; i < 6; i++) {
+        v[i] = (int16_t)get_u16(p + 2 * i);
+      }
+      p += TELEMETRY_IMU_SAMPLE_BYTES;
+    } else {
+      for (int i = 0; i < 6; i++) {
+        uint32_t z;
+        size_t used = get_varint(p, end, z);
+        if (!used) return 0;
+        v[i] = (int16_t)(v[i] + unzigzag(z));
+        p += used;
+      }
+    }
+    if (count < max) {
+      out[count].t_ms = t_ms + k * in[11];
+      memcpy(out[count].v, v, sizeof(v));
+      count++;
+    }
+  }
+  return p - in;
+}
@@ -0,0 +1,131 @@
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "gait.h"
+#include "tof_zones.h"
+
+// ===================================================================
+// Binary Telemetry Frames
+// ===================================================================
+// Fixed-layout, little-endian replacement for the per-tick sensor JSON,
+// chosen per connection (ble.h); JSON stays the default. A notification
+// carries one sample frame, followed by a gait frame when a summary is
+// due. Every frame starts with the same 10-byte header:
+//   0  u8   TELEMETRY_FRAME_MAGIC (never '{', so JSON is told apart)
+//   1  u8   version
+//   2  u8   type (TelemetryFrameType)
+//   3  u8   flags (TELEMETRY_FLAG_*)
+//   4  u16  sequence, per frame
+//   6  u32  capture time in us (micros(), wraps every ~71 min)
+// Sample frame (TELEMETRY_SAMPLE_BYTES), from offset 10:
+//   10 i16 x3  ax, ay, az in mg
+//   16 i16 x3  gx, gy, gz in 0.1 deg/s
+//   22 i16 x2  pitch, roll in 0.01 deg
+//   26 i16     dist_mm (-1 none)
+//   28 i16 x3  zone_mm left/centre/right (-1 none)
+//   34 u16     battery mV
+//   36 u8      battery %
+//   37 u8      reserved (0)
+//   38 u16     runtime_min (0xFFFF unknown)
+// Gait frame (TELEMETRY_GAIT_BYTES), from offset 10:
+//   10 u32 steps, 14 u32 plants, 18 u16 cadence_spm, 20 u16 stride_ms,
+//   22 u16 stride_cv x 1000, 24 u16 bouts, 26 u32 walking_s,
+//   30 u16 bout_steps, 32 u16 longest_bout_steps
+// IMU frame (streaming, telemetry_batch.h), t_us is the first sample's:
+//   10 u8      sample count n
+//   11 u8      sample period in ms
+//   12 i16 x6  per sample: ax, ay, az, gx, gy, gz in raw MPU6050
+//              counts (4096/g, 65.5/deg/s); n x 12 bytes
+// IMU delta frame: as the IMU frame for offsets 10-23 (the first sample
+// is the keyframe), then per further sample six zigzag varints, the
+// change of each axis from the previous sample (1-3 bytes each; LEB128,
+// low 7 bits first). Every frame starts from its own keyframe, so a
+// lost notification costs only its own samples and the next frame
+// decodes in full (the sequence number shows the gap).
+// Fields whose flag is clear are zero (or -1 for distances). New
+// fields go in a new version; decoders must reject versions they do
+// not know. Portable; tools/telemetry_bench.cpp compares it with the
+// JSON path.
+// ===================================================================
+
+#define TELEMETRY_FRAME_MAGIC    0xB5
+#define TELEMETRY_FRAME_VERSION  1
+#define TELEMETRY_HEADER_BYTES   10
+#define TELEMETRY_SAMPLE_BYTES   40
+#define TELEMETRY_GAIT_BYTES     34
+#define TELEMETRY_FRAME_MAX      (TELEMETRY_SAMPLE_BYTES + TELEMETRY_GAIT_BYTES)
+#define TELEMETRY_IMU_HEADER_BYTES 12
+#define TELEMETRY_IMU_SAMPLE_BYTES 12
+#define TELEMETRY_IMU_DELTA_MAX    18   // Six 3-byte varints
+
+enum TelemetryFrameType {
+  TELEMETRY_FRAME_SAMPLE = 1,
+  TELEMETRY_FRAME_GAIT = 2,
+  TELEMETRY_FRAME_IMU = 3,
+  TELEMETRY_FRAME_IMU_DELTA = 4
+};
+
+enum TelemetryEncoding {
+  TELEMETRY_ENCODING_JSON,
+  TELEMETRY_ENCODING_BINARY
+};
+
+// Sample frame flags
+#define TELEMETRY_FLAG_IMU       0x01
+#define TELEMETRY_FLAG_TOF       0x02
+#define TELEMETRY_FLAG_ZONES     0x04
+#define TELEMETRY_FLAG_BATTERY   0x08
+#define TELEMETRY_FLAG_CHARGING  0x10
+#define TELEMETRY_FLAG_FLAT      0x20
+// Gait frame flags
+#define TELEMETRY_FLAG_WALKING   0x01
+
+// One sensor tick in physical units; flags say which parts are valid
+struct TelemetryValues {
+  uint32_t t_us;
+  uint8_t flags;
+  float ax, ay, az;           // g
+  float gx, gy, gz;           // deg/s
+  float pitch_deg, roll_deg;
+  int16_t dist_mm;
+  int16_t zone_mm[TOF_ZONE_COUNT];
+  float battery_v;
+  uint8_t battery_pct;
+  uint16_t runtime_min;
+};
+
+// One streamed IMU sample, raw counts
+struct TelemetryImuSample {
+  uint32_t t_ms;
+  int16_t v[6];               // ax, ay, az, gx, gy, gz
+};
+
+// ===================================================================
+// Telemetry Frame Functions
+// ===================================================================
+
+// Write one frame to out (at least its *_BYTES); return its size
+size_t telemetry_encode_sample(const TelemetryValues& v, uint16_t seq, uint8_t* out);
+size_t telemetry_encode_gait(const GaitSummary& gait, uint16_t seq, uint32_t t_us, uint8_t* out);
+
+// IMU frames (type TELEMETRY_FRAME_IMU or _IMU_DELTA): begin writes an
+// empty frame (TELEMETRY_IMU_HEADER_BYTES). Append writes one sample at
+// frame + len, the frame's size so far, using at most room bytes;
+// prev is the sample appended before it (unused for the first, or in
+// raw frames). Returns the bytes written, 0 if they would not fit.
+size_t telemetry_begin_imu(uint8_t* out, TelemetryFrameType type, uint16_t seq, uint32_t t_ms,
+                           uint8_t period_ms);
+size_t telemetry_append_imu(uint8_t* frame, size_t len, size_t room, const int16_t prev[6],
+                            const TelemetryImuSample& s);
+
+// Reference decoder (host tools): the frame's size, 0 if it is not a
+// complete frame of a known version
+size_t telemetry_decode_sample(const uint8_t* in, size_t len, TelemetryValues& v, uint16_t& seq);
+size_t telemetry_decode_gait(const uint8_t* in, size_t len, GaitSummary& gait, uint16_t& seq);
+// Either IMU frame type; count is capped at max
+size_t telemetry_decode_imu(const uint8_t* in, size_t len, TelemetryImuSample* out, size_t max,
+                            size_t& count, uint16_t& seq);
+
+#endif // TELEMETRY_FRAME_H
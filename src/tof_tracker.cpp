@@ -0,0 +1,143 @@
+#include "tof_tracker.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// ===================================================================
+// Hampel Filter
+// ===================================================================
+
+static void sort_small(int16_t* v, int n) {
+  for (int i = 1; i < n; i++) {
+    int16_t x = v[i];
+    int j = i - 1;
+    while (j >= 0 && v[j] > x) {
+      v[j + 1] = v[j];
+      j--;
+    }
+    v[j + 1] = x;
+  }
+}
+
+static int16_t median_small(int16_t* v, int n) {
+  sort_small(v, n);
+  return (n & 1) ? v[n / 2] : (int16_t)((v[n / 2 - 1] + v[n / 2]) / 2);
+}
+
+// Returns the range to feed the tracker: the input, or the window
+// median if the input is an outlier
+static int16_t hampel(TofTracker& trk, int16_t x) {
+  int n = trk.window_count;
+  int16_t result = x;
+  
+  if (n >= 3) {
+    int16_t sorted[TOF_HAMPEL_WINDOW];
+    memcpy(sorted, trk.window, n * sizeof(int16_t));
+    int16_t median = median_small(sorted, n);
+    
+    int16_t dev[TOF_HAMPEL_WINDOW];
+    for (int i = 0; i < n; i++) dev[i] = (int16_t)abs(trk.window[i] - median);
+    float mad = 1.4826f * median_small(dev, n);
+    
+    float limit = TOF_HAMPEL_K * mad;
+    if (limit < TOF_HAMPEL_MIN_DEV_MM) limit = TOF_HAMPEL_MIN_DEV_MM;
+    if (fabsf((float)(x - median)) > limit) {
+      trk.outliers++;
+      result = median;
+    }
+  }
+  
+  // The raw value goes into the window so a real step is accepted once
+  // it persists for half the window
+  trk.window[trk.window_head] = x;
+  trk.window_head = (trk.window_head + 1) % TOF_HAMPEL_WINDOW;
+  if (trk.window_count < TOF_HAMPEL_WINDOW) trk.window_count++;
+  return result;
+}
+
+// ===================================================================
+// Tracker
+// ===================================================================
+
+void tof_tracker_init(TofTracker& trk) {
+  memset(&trk, 0, sizeof(trk));
+}
+
+static void track_reset(TofTracker& trk) {
+  uint32_t outliers = trk.outliers;
+  tof_tracker_init(trk);
+  trk.outliers = outliers;
+}
+
+TofThreat tof_tracker_update(TofTracker& trk, int16_t distance_mm, bool valid,
+                             uint32_t t_ms, int16_t proximity_mm) {
+  TofThreat threat = {false, -1, 0, 0xFFFF, 0};
+  
+  if (!valid || distance_mm <= 0) {
+    if (trk.tracking && t_ms - trk.last_ms > TOF_TRACK_LOST_MS) track_reset(trk);
+    return threat;
+  }
+  
+  if (trk.tracking && t_ms - trk.last_ms > TOF_TRACK_LOST_MS) track_reset(trk);
+  
+  int16_t z = hampel(trk, distance_mm);
+  
+  if (!trk.tracking) {
+    trk.distance_mm = z;
+    trk.speed_mm_s = 0;
+    trk.last_ms = t_ms;
+    trk.samples = 1;
+    trk.tracking = true;
+  } else {
+    float dt = (t_ms - trk.last_ms) * 0.001f;
+    if (dt <= 0) dt = 0.001f;
+    
+    float predicted = trk.distance_mm + trk.speed_mm_s * dt;
+    float residual = z - predicted;
+    trk.distance_mm = predicted + TOF_TRACK_ALPHA * residual;
+    trk.speed_mm_s += (TOF_TRACK_BETA / dt) * residual;
+    trk.last_ms = t_ms;
+    if (trk.samples < 0xFFFF) trk.samples++;
+  }
+  
+  threat.distance_mm = (int16_t)trk.distance_mm;
+  
+  float closing = -trk.speed_mm_s;
+  if (trk.samples >= TOF_TRACK_MIN_SAMPLES && closing >= TOF_CLOSING_MIN_MM_S) {
+    threat.closing_mm_s = (int16_t)(closing > 32767 ? 32767 : closing);
+    float ttc = trk.distance_mm / closing * 1000.0f;
+    threat.ttc_ms = (uint16_t)(ttc < 0 ? 0 : (ttc > 0xFFFE ? 0xFFFE : ttc));
+  }
+  
+  if (threat.ttc_ms < TOF_TTC_WARN_MS) {
+    threat.present = true;
+    threat.urgency = (uint8_t)(255 - (uint32_t)threat.ttc_ms * 255 / TOF_TTC_WARN_MS);
+  } else if (threat.distance_mm > 0 && threat.distance_mm < proximity_mm) {
+    threat.present = true;   // Standing close to something: lowest urgency
+  }
+  return threat;
+}
+
+// ===================================================================
+// Alert Pacing
+// ===================================================================
+
+void tof_pacer_init(TofAlertPacer& pacer) {
+  memset(&pacer, 0, sizeof(pacer));
+}
+
+bool tof_pacer_should_alert(TofAlertPacer& pacer, const TofThreat& threat,
+                            uint32_t t_ms, uint32_t max_interval_ms) {
+  if (!threat.present) return false;
+  
+  uint32_t span = max_interval_ms > TOF_ALERT_MIN_INTERVAL_MS ?
+                  max_interval_ms - TOF_ALERT_MIN_INTERVAL_MS : 0;
+  uint32_t interval = max_interval_ms - span * threat.urgency / 255;
+  
+  if (pacer.alerted && t_ms - pacer.last_alert_ms < interval) return false;
+  
+  pacer.alerted = true;
+  pacer.last_alert_ms = t_ms;
+  pacer.alerts++;
+  return true;
+}
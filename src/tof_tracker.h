@@ -0,0 +1,81 @@
+#ifndef TOF_TRACKER_H
+#define TOF_TRACKER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================================
+// ToF Obstacle Tracking
+// ===================================================================
+// Turns raw ranges into time-to-collision alerts. Each zone has one
+// tracker:
+//   1. Hampel filter over the last TOF_HAMPEL_WINDOW valid ranges. A
+//      range further than TOF_HAMPEL_K scaled MADs from the window
+//      median is replaced by the median.
+//   2. Alpha-beta filter for distance and closing speed.
+//   3. Time-to-collision = distance / closing speed.
+//
+// An alert fires when TTC drops under TOF_TTC_WARN_MS, or when a target
+// sits inside the proximity threshold. The pacer repeats alerts faster
+// as TTC shrinks, between TOF_ALERT_MIN_INTERVAL_MS and the max
+// interval. Fixed-size state, no heap, a few microseconds per sample.
+// Portable; tools/tof_replay.cpp runs it on recorded traces.
+// ===================================================================
+
+#define TOF_HAMPEL_WINDOW        5
+#define TOF_HAMPEL_K             3.0f
+#define TOF_HAMPEL_MIN_DEV_MM    40     // Never reject closer than this to the median
+
+#define TOF_TRACK_ALPHA          0.5f
+#define TOF_TRACK_BETA           0.1f
+#define TOF_TRACK_LOST_MS        400    // No valid range for this long resets the track
+#define TOF_TRACK_MIN_SAMPLES    4      // Samples before speed is trusted
+
+#define TOF_TTC_WARN_MS          2000   // Warn when a collision is this close
+#define TOF_CLOSING_MIN_MM_S     150    // Slower than this is not an approach
+#define TOF_ALERT_MIN_INTERVAL_MS 250   // Repeat rate at TTC = 0
+
+struct TofTracker {
+  int16_t window[TOF_HAMPEL_WINDOW];
+  uint8_t window_count;
+  uint8_t window_head;
+  float distance_mm;                  // Filtered
+  float speed_mm_s;                   // d(distance)/dt; negative = closing
+  uint32_t last_ms;
+  uint16_t samples;
+  bool tracking;
+  uint32_t outliers;
+};
+
+struct TofThreat {
+  bool present;           // Approaching inside TTC, or within proximity
+  int16_t distance_mm;    // Filtered
+  int16_t closing_mm_s;   // Positive when approaching
+  uint16_t ttc_ms;        // 0xFFFF when not closing
+  uint8_t urgency;        // 0-255, drives the repeat rate
+};
+
+struct TofAlertPacer {
+  uint32_t last_alert_ms;
+  bool alerted;
+  uint32_t alerts;
+};
+
+// ===================================================================
+// Tracker Functions
+// ===================================================================
+
+void tof_tracker_init(TofTracker& trk);
+
+// One range (valid = false for no target); proximity_mm is the static
+// threshold still honoured for targets that are not moving
+TofThreat tof_tracker_update(TofTracker& trk, int16_t distance_mm, bool valid,
+                             uint32_t t_ms, int16_t proximity_mm);
+
+void tof_pacer_init(TofAlertPacer& pacer);
+
+// True when this threat should raise an alert now
+bool tof_pacer_should_alert(TofAlertPacer& pacer, const TofThreat& threat,
+                            uint32_t t_ms, uint32_t max_interval_ms);
+
+#endif // TOF_TRACKER_H
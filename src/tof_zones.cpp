@@ -0,0 +1,205 @@
+#include "tof_zones.h"
+#include <string.h>
+
+// Timing budgets the VL53L1X accepts in long-distance mode, shortest first
+static const uint16_t budget_steps[] = {20, 33, 50};
+#define BUDGET_STEP_COUNT (sizeof(budget_steps) / sizeof(budget_steps[0]))
+
+#define OVERHEAD_INITIAL_MS  4    // Until a period has been measured
+#define RESTART_INITIAL_MS   4    // Until a budget change has been measured
+
+static const uint8_t zone_columns[TOF_ZONE_COUNT] = {2, 8, 13};
+static const char* const zone_names[TOF_ZONE_COUNT] = {"left", "centre", "right"};
+
+// ===================================================================
+// ROI Geometry
+// ===================================================================
+
+uint8_t tof_zone_spad_center(uint8_t x, uint8_t y) {
+  if (y > 7) return 128 + (x << 3) + (15 - y);
+  return ((15 - x) << 3) + y;
+}
+
+const char* tof_zone_name(uint8_t zone) {
+  return zone < TOF_ZONE_COUNT ? zone_names[zone] : "unknown";
+}
+
+static TofZoneStep make_step(TofZoneScheduler& sched, uint8_t zone) {
+  TofZoneStep step;
+  step.zone = zone;
+  step.spad_center = tof_zone_spad_center(zone_columns[zone], 8);
+  step.budget_ms = sched.budget_ms[zone];
+  step.budget_changed = (step.budget_ms != sched.active_budget_ms);
+  sched.active_budget_ms = step.budget_ms;
+  sched.restarted = step.budget_changed;
+  sched.current = zone;
+  return step;
+}
+
+// ===================================================================
+// Overhead Estimate
+// ===================================================================
+// Each range takes its budget plus an overhead that jitters from range
+// to range. Planning against the mean overhead fills the sweep exactly
+// and the jitter pushes half the sweeps past the target, so the plan
+// uses mean + 2 x mean deviation (the estimator TCP uses for its
+// retransmit timer), kept in 1/8 ms. A budget change stops and
+// restarts ranging; what that adds is learnt separately, since unequal
+// budgets pay it twice a sweep and equal ones never do.
+// ===================================================================
+
+static uint16_t ceil_x8(int32_t x8) {
+  return (uint16_t)((x8 + 7) / 8);
+}
+
+static void measure_overhead(TofZoneScheduler& sched, int32_t over_ms) {
+  int32_t err = over_ms * 8 - sched.overhead_avg_x8;
+  
+  if (sched.restarted) {
+    int32_t extra = err > 0 ? err : 0;
+    sched.restart_x8 = (uint16_t)(sched.restart_x8 + (extra - sched.restart_x8) / 4);
+  } else {
+    int32_t dev = err < 0 ? -err : err;
+    sched.overhead_avg_x8 = (uint16_t)(sched.overhead_avg_x8 + err / 8);
+    sched.overhead_dev_x8 = (uint16_t)(sched.overhead_dev_x8 + (dev - sched.overhead_dev_x8) / 4);
+  }
+  sched.overhead_ms = ceil_x8(sched.overhead_avg_x8 + 2 * sched.overhead_dev_x8);
+  sched.restart_ms = ceil_x8(sched.restart_x8);
+}
+
+// ===================================================================
+// Budget Allocation
+// ===================================================================
+// Every zone starts at the shortest budget. Whatever the sweep target
+// leaves after ranging overhead, and the two restarts that unequal
+// budgets cost, goes to the focus zone first (nearest target, else
+// centre), then to the others in order.
+// ===================================================================
+
+static void rebalance(TofZoneScheduler& sched) {
+  int focus = TOF_ZONE_CENTRE;
+  int16_t nearest = -1;
+  for (int z = 0; z < TOF_ZONE_COUNT; z++) {
+    if (sched.last_mm[z] > 0 && (nearest < 0 || sched.last_mm[z] < nearest)) {
+      nearest = sched.last_mm[z];
+      focus = z;
+    }
+  }
+  
+  int available = TOF_ZONE_SWEEP_TARGET_MS - TOF_ZONE_COUNT * sched.overhead_ms - 2 * sched.restart_ms;
+  int used = 0;
+  for (int z = 0; z < TOF_ZONE_COUNT; z++) {
+    sched.budget_ms[z] = budget_steps[0];
+    used += budget_steps[0];
+  }
+  
+  int order[TOF_ZONE_COUNT];
+  order[0] = focus;
+  for (int z = 0, i = 1; z < TOF_ZONE_COUNT; z++) {
+    if (z != focus) order[i++] = z;
+  }
+  
+  for (int i = 0; i < TOF_ZONE_COUNT; i++) {
+    int z = order[i];
+    for (int s = BUDGET_STEP_COUNT - 1; s > 0; s--) {
+      int extra = budget_steps[s] - sched.budget_ms[z];
+      if (used + extra <= available) {
+        sched.budget_ms[z] = budget_steps[s];
+        used += extra;
+        break;
+      }
+    }
+  }
+}
+
+// ===================================================================
+// Scheduler
+// ===================================================================
+
+TofZoneStep tof_zone_scheduler_init(TofZoneScheduler& sched) {
+  memset(&sched, 0, sizeof(sched));
+  sched.overhead_avg_x8 = OVERHEAD_INITIAL_MS * 8;
+  sched.restart_x8 = RESTART_INITIAL_MS * 8;
+  sched.overhead_ms = OVERHEAD_INITIAL_MS;
+  sched.restart_ms = RESTART_INITIAL_MS;
+  for (int z = 0; z < TOF_ZONE_COUNT; z++) sched.last_mm[z] = -1;
+  rebalance(sched);
+  return make_step(sched, TOF_ZONE_LEFT);
+}
+
+TofZoneStep tof_zone_scheduler_advance(TofZoneScheduler& sched,
+                                       int16_t distance_mm, uint32_t t_ms) {
+  sched.last_mm[sched.current] = distance_mm;
+  sched.stats.ranges++;
+  
+  if (sched.started) {
+    uint32_t period = t_ms - sched.last_range_ms;
+    int32_t over = (int32_t)period - sched.active_budget_ms;
+    if (over < 0) over = 0;
+    if (over > TOF_ZONE_SWEEP_TARGET_MS) over = TOF_ZONE_SWEEP_TARGET_MS;
+    measure_overhead(sched, over);
+  } else {
+    sched.started = true;
+    sched.sweep_start_ms = t_ms;
+  }
+  sched.last_range_ms = t_ms;
+  
+  uint8_t next = sched.current + 1;
+  if (next >= TOF_ZONE_COUNT) {
+    // Sweep boundary: measured from one last-zone range to the next;
+    // the partial first sweep is not counted
+    uint32_t sweep = t_ms - sched.sweep_start_ms;
+    if (sched.stats.ranges > TOF_ZONE_COUNT) {
+      sched.stats.sweeps++;
+      sched.stats.last_sweep_ms = (uint16_t)(sweep > 0xFFFF ? 0xFFFF : sweep);
+      if (sched.stats.last_sweep_ms > sched.stats.max_sweep_ms) {
+        sched.stats.max_sweep_ms = sched.stats.last_sweep_ms;
+      }
+      if (sweep > TOF_ZONE_SWEEP_TARGET_MS) sched.stats.slow_sweeps++;
+    }
+    sched.sweep_start_ms = t_ms;
+    rebalance(sched);
+    next = 0;
+  }
+  
+  return make_step(sched, next);
+}
+
+// ===================================================================
+// Obstacle Map
+// ===================================================================
+
+void tof_map_init(TofObstacleMap& map) {
+  for (int z = 0; z < TOF_ZONE_COUNT; z++) {
+    map.zones[z].distance_mm = -1;
+    map.zones[z].timestamp_ms = 0;
+    map.zones[z].valid = false;
+  }
+}
+
+void tof_map_update(TofObstacleMap& map, uint8_t zone, int16_t distance_mm,
+                    bool valid, uint32_t t_ms) {
+  if (zone >= TOF_ZONE_COUNT) return;
+  map.zones[zone].distance_mm = valid ? distance_mm : -1;
+  map.zones[zone].timestamp_ms = t_ms;
+  map.zones[zone].valid = valid;
+}
+
+int16_t tof_map_distance(const TofObstacleMap& map, uint8_t zone, uint32_t now_ms) {
+  const TofZoneReading& r = map.zones[zone];
+  if (!r.valid || now_ms - r.timestamp_ms > TOF_ZONE_MAX_AGE_MS) return -1;
+  return r.distance_mm;
+}
+
+int tof_map_nearest(const TofObstacleMap& map, uint32_t now_ms, int16_t& distance_mm) {
+  int zone = -1;
+  distance_mm = -1;
+  for (int z = 0; z < TOF_ZONE_COUNT; z++) {
+    int16_t d = tof_map_distance(map, z, now_ms);
+    if (d > 0 && (zone < 0 || d < distance_mm)) {
+      zone = z;
+      distance_mm = d;
+    }
+  }
+  return zone;
+}
@@ -0,0 +1,110 @@
+#ifndef TOF_ZONES_H
+#define TOF_ZONES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================================
+// VL53L1X Multi-Zone Scanning
+// ===================================================================
+// The VL53L1X's 16x16 SPAD array can be restricted to a region of
+// interest (ROI). Stepping the ROI centre across the array on
+// successive ranges turns the single-zone ranger into a coarse
+// left/centre/right scanner.
+//
+// The scheduler runs wherever ranges are read (the I2C worker). It
+// picks the next zone, and at the end of each sweep re-splits the
+// per-zone timing budgets so one sweep fits TOF_ZONE_SWEEP_TARGET_MS,
+// using the ranging overhead and jitter it has measured. The zone
+// with the nearest obstacle gets the longest budget. The obstacle map runs in
+// the consumer and keeps the latest range and its age for each zone.
+//
+// Both are portable and can be fed synthetic range streams on a host.
+// ===================================================================
+
+#define TOF_ZONE_COUNT            3
+#define TOF_ZONE_SWEEP_TARGET_MS  100   // Full sweep >= 10 Hz
+#define TOF_ZONE_MAX_AGE_MS       300   // Older map entries are stale
+
+// ROI geometry: 5 columns wide, full height. x runs across the array;
+// the receiver lens inverts the image, so swap LEFT/RIGHT centres if
+// the sensor is mounted upside down.
+#define TOF_ZONE_ROI_WIDTH   5
+#define TOF_ZONE_ROI_HEIGHT  16
+
+enum TofZone {
+  TOF_ZONE_LEFT,
+  TOF_ZONE_CENTRE,
+  TOF_ZONE_RIGHT
+};
+
+struct TofZoneStats {
+  uint32_t sweeps;
+  uint32_t ranges;
+  uint16_t last_sweep_ms;
+  uint16_t max_sweep_ms;
+  uint32_t slow_sweeps;       // Sweeps longer than the target
+};
+
+struct TofZoneScheduler {
+  uint8_t current;                        // Zone being ranged now
+  uint16_t budget_ms[TOF_ZONE_COUNT];     // Applied from the next sweep
+  uint16_t active_budget_ms;              // Budget the sensor is running
+  uint16_t overhead_ms;                   // Planned period minus budget
+  uint16_t restart_ms;                    // Planned extra for a budget change
+  uint16_t overhead_avg_x8;               // Measured, 1/8 ms
+  uint16_t overhead_dev_x8;
+  uint16_t restart_x8;
+  bool restarted;                         // Range in flight follows a budget change
+  int16_t last_mm[TOF_ZONE_COUNT];        // -1 = no target
+  uint32_t last_range_ms;
+  uint32_t sweep_start_ms;
+  bool started;
+  TofZoneStats stats;
+};
+
+// What to program into the sensor before the next range
+struct TofZoneStep {
+  uint8_t zone;
+  uint8_t spad_center;
+  uint16_t budget_ms;
+  bool budget_changed;
+};
+
+struct TofZoneReading {
+  int16_t distance_mm;        // -1 = no target
+  uint32_t timestamp_ms;
+  bool valid;
+};
+
+struct TofObstacleMap {
+  TofZoneReading zones[TOF_ZONE_COUNT];
+};
+
+// ===================================================================
+// Zone Functions
+// ===================================================================
+
+// ST's SPAD numbering for an ROI centred on column x, row y (0-15)
+uint8_t tof_zone_spad_center(uint8_t x, uint8_t y);
+const char* tof_zone_name(uint8_t zone);
+
+// Returns the first zone to program
+TofZoneStep tof_zone_scheduler_init(TofZoneScheduler& sched);
+
+// A range for sched.current arrived at t_ms (distance -1 if none);
+// returns the zone to range next
+TofZoneStep tof_zone_scheduler_advance(TofZoneScheduler& sched,
+                                       int16_t distance_mm, uint32_t t_ms);
+
+void tof_map_init(TofObstacleMap& map);
+void tof_map_update(TofObstacleMap& map, uint8_t zone, int16_t distance_mm,
+                    bool valid, uint32_t t_ms);
+
+// Nearest fresh target; returns its zone or -1 if none
+int tof_map_nearest(const TofObstacleMap& map, uint32_t now_ms, int16_t& distance_mm);
+
+// Range for one zone, or -1 if invalid or stale
+int16_t tof_map_distance(const TofObstacleMap& map, uint8_t zone, uint32_t now_ms);
+
+#endif // TOF_ZONES_H
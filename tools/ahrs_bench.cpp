@@ -0,0 +1,372 @@
+// ===================================================================
+// AHRS Accuracy Check and Benchmark (host)
+// ===================================================================
+// Runs the Madgwick and Mahony filters (src/ahrs) over IMU traces with
+// a known attitude and reports the attitude error (angle between the
+// true and estimated gravity direction, so it is defined at any pitch),
+// the pitch/roll error, and the cost per update.
+//
+// Trace CSV, one sample per line:  t_ms,ax,ay,az,gx,gy,gz,pitch,roll
+//   ax..az  g;  gx..gz  deg/s;  pitch, roll  reference attitude in
+//   degrees (e.g. from motion capture or a reference IMU)
+//
+//   g++ -O2 -std=c++17 -Isrc tools/ahrs_bench.cpp src/ahrs.cpp -o ahrs_bench
+//   ./ahrs_bench trace1.csv ...
+//   ./ahrs_bench --synthetic [--write DIR]
+//
+// Add -DAHRS_EXACT_INV_SQRT to both files to compare against the exact
+// normalisation. The first SETTLE_MS of each trace are not scored.
+// ===================================================================
+
+#include "ahrs.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define RATE_HZ     100
+#define SETTLE_MS   1000
+#define DEG         0.017453293
+
+struct Sample {
+  uint32_t t_ms;
+  float ax, ay, az;
+  float gx, gy, gz;
+  float pitch, roll;      // Reference, degrees
+};
+
+struct Trace {
+  std::string name;
+  std::vector<Sample> samples;
+  int32_t fall_ms;        // Synthetic falls: when the stick starts to fall, else -1
+  int32_t impact_ms;      // ... and when it hits the ground
+};
+
+struct Result {
+  double err_sq = 0, err_max = 0;
+  double pr_sq = 0;       // Pitch and roll, pooled
+  size_t scored = 0;
+  double cycles = 0;
+  size_t updates = 0;
+};
+
+static uint64_t cycles_now() {
+#ifdef HAVE_TSC
+  return __rdtsc();
+#else
+  auto ns = std::chrono::steady_clock::now().time_since_epoch();
+  return (uint64_t)(std::chrono::duration<double, std::nano>(ns).count() * 3.0);
+#endif
+}
+
+// ===================================================================
+// Trace Loading
+// ===================================================================
+
+static bool load_trace(const char* path, Trace& trace) {
+  FILE* f = fopen(path, "r");
+  if (!f) return false;
+  trace.name = path;
+  trace.fall_ms = -1;
+  trace.impact_ms = -1;
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    Sample s;
+    unsigned long t;
+    if (sscanf(line, "%lu,%f,%f,%f,%f,%f,%f,%f,%f", &t, &s.ax, &s.ay, &s.az,
+               &s.gx, &s.gy, &s.gz, &s.pitch, &s.roll) == 9) {
+      s.t_ms = (uint32_t)t;
+      trace.samples.push_back(s);
+    }
+  }
+  fclose(f);
+  return true;
+}
+
+static void write_trace(const Trace& trace, const char* dir, int index) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%02d_%s.csv", dir, index, trace.name.c_str());
+  FILE* f = fopen(path, "w");
+  if (!f) return;
+  for (const Sample& s : trace.samples) {
+    fprintf(f, "%u,%.4f,%.4f,%.4f,%.3f,%.3f,%.3f,%.3f,%.3f\n", s.t_ms, s.ax, s.ay, s.az,
+            s.gx, s.gy, s.gz, s.pitch, s.roll);
+  }
+  fclose(f);
+}
+
+// ===================================================================
+// Synthesis
+// ===================================================================
+// True attitude is integrated from a body-rate profile in fine
+// substeps (double precision). The gyro reads the rate plus a constant
+// bias and noise; the accelerometer reads gravity in the sensor frame
+// plus linear acceleration and noise, as on a cane.
+// ===================================================================
+
+struct Quat {
+  double w, x, y, z;
+};
+
+static Quat integrate(Quat q, double wx, double wy, double wz, double dt) {
+  double angle = std::sqrt(wx * wx + wy * wy + wz * wz) * dt;
+  if (angle < 1e-12) return q;
+  double s = std::sin(angle / 2) / (angle / dt), c = std::cos(angle / 2);
+  Quat d = {c, wx * s, wy * s, wz * s};
+  Quat r = {q.w * d.w - q.x * d.x - q.y * d.y - q.z * d.z,
+            q.w * d.x + q.x * d.w + q.y * d.z - q.z * d.y,
+            q.w * d.y - q.x * d.z + q.y * d.w + q.z * d.x,
+            q.w * d.z + q.x * d.y - q.y * d.x + q.z * d.w};
+  double n = std::sqrt(r.w * r.w + r.x * r.x + r.y * r.y + r.z * r.z);
+  return {r.w / n, r.x / n, r.y / n, r.z / n};
+}
+
+// Gravity direction in the sensor frame (what a still accelerometer reads)
+static void gravity(const Quat& q, double& vx, double& vy, double& vz) {
+  vx = 2 * (q.x * q.z - q.w * q.y);
+  vy = 2 * (q.w * q.x + q.y * q.z);
+  vz = q.w * q.w - q.x * q.x - q.y * q.y + q.z * q.z;
+}
+
+typedef void (*RateFn)(double t, double& wx, double& wy, double& wz, double& lin_z);
+
+static Trace synth(const char* name, RateFn rate, double seconds, double start_pitch_deg,
+                   uint32_t seed, int32_t fall_ms = -1, int32_t impact_ms = -1) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> gyro_noise(0.0, 0.08), accel_noise(0.0, 0.02);
+  std::uniform_real_distribution<double> u(-1.5, 1.5);
+  double bias[3] = {u(rng), u(rng), u(rng)};     // deg/s
+  
+  Trace trace{name, {}, fall_ms, impact_ms};
+  Quat q = {std::cos(start_pitch_deg * DEG / 2), 0, std::sin(start_pitch_deg * DEG / 2), 0};
+  const int sub = 10;
+  double dt = 1.0 / RATE_HZ;
+  for (uint32_t i = 0; i < seconds * RATE_HZ; i++) {
+    double t = i * dt, wx = 0, wy = 0, wz = 0, lin = 0;
+    for (int k = 0; k < sub; k++) {
+      rate(t + k * dt / sub, wx, wy, wz, lin);
+      q = integrate(q, wx * DEG, wy * DEG, wz * DEG, dt / sub);
+    }
+    rate(t + dt, wx, wy, wz, lin);
+    double vx, vy, vz;
+    gravity(q, vx, vy, vz);
+    Sample s;
+    s.t_ms = (uint32_t)std::lround(t * 1000);
+    s.ax = (float)(vx + accel_noise(rng));
+    s.ay = (float)(vy + accel_noise(rng));
+    s.az = (float)(vz + lin + accel_noise(rng));
+    s.gx = (float)(wx + bias[0] + gyro_noise(rng));
+    s.gy = (float)(wy + bias[1] + gyro_noise(rng));
+    s.gz = (float)(wz + bias[2] + gyro_noise(rng));
+    s.pitch = (float)(std::asin(std::fmax(-1.0, std::fmin(1.0, -vx))) / DEG);
+    s.roll = (float)(std::atan2(vy, vz) / DEG);
+    trace.samples.push_back(s);
+  }
+  return trace;
+}
+
+// Cane swing while walking: pitch +/-15 deg, some roll, heel strikes
+static void rate_walk(double t, double& wx, double& wy, double& wz, double& lin) {
+  double f = 1.8;
+  wy = 15 * 2 * M_PI * f * std::cos(2 * M_PI * f * t);
+  wx = 5 * 2 * M_PI * (f / 2) * std::cos(2 * M_PI * (f / 2) * t);
+  wz = 10 * std::sin(0.5 * t);
+  double phase = std::fmod(t * f, 1.0);
+  lin = phase < 0.04 ? 0.8 : 0.0;
+}
+
+// Slow lean to 80 degrees and back
+static void rate_tilt(double t, double& wx, double& wy, double& wz, double& lin) {
+  wx = wz = lin = 0;
+  wy = t < 2 ? 0 : t < 6 ? 20 : t < 8 ? 0 : t < 12 ? -20 : 0;
+}
+
+// Twirling about the shaft while tilted 20 degrees (start pitch)
+static void rate_spin(double t, double& wx, double& wy, double& wz, double& lin) {
+  wx = wy = lin = 0;
+  wz = t < 1 ? 0 : 360;
+}
+
+// Falls over: 0.35 s at ~250 deg/s, impact, then lies still
+static void rate_fall(double t, double& wx, double& wy, double& wz, double& lin) {
+  wx = wz = lin = 0;
+  wy = t < 3 ? 3 * std::sin(2 * t) : t < 3.35 ? 250 : 0;
+  if (t >= 3.35 && t < 3.38) lin = 4.0;
+}
+
+static std::vector<Trace> synthetic_traces() {
+  std::vector<Trace> traces;
+  for (uint32_t seed = 1; seed <= 5; seed++) {
+    traces.push_back(synth("walk", rate_walk, 30, 10, seed));
+    traces.push_back(synth("tilt_sweep", rate_tilt, 14, 0, seed + 100));
+    traces.push_back(synth("spin", rate_spin, 10, 20, seed + 200));
+    traces.push_back(synth("fall", rate_fall, 8, 0, seed + 300, 3000, 3350));
+  }
+  return traces;
+}
+
+// ===================================================================
+// Replay
+// ===================================================================
+
+static void reference_gravity(const Sample& s, double& vx, double& vy, double& vz) {
+  double p = s.pitch * DEG, r = s.roll * DEG;
+  vx = -std::sin(p);
+  vy = std::sin(r) * std::cos(p);
+  vz = std::cos(r) * std::cos(p);
+}
+
+static double wrap_deg(double d) {
+  while (d > 180) d -= 360;
+  while (d < -180) d += 360;
+  return d;
+}
+
+// Worst case over the fall traces, relative to the start of the fall
+#define NEVER INT32_MIN
+
+struct SignalTimes {
+  int32_t rapid_ms = NEVER;  // Latest first rapid flag
+  int32_t flat_ms = NEVER;   // Latest first flat flag after the impact
+  bool missed = false;       // A trace never raised one of them
+  bool flat_before = false;  // Flat flagged before the fall (wrong)
+};
+
+static void replay(const Trace& trace, AhrsAlgorithm algorithm, Result& r, SignalTimes* sig) {
+  AhrsState ahrs;
+  ahrs_init(ahrs, algorithm, RATE_HZ);
+  
+  std::vector<float> q(trace.samples.size() * 4);
+  uint64_t c0 = cycles_now();
+  for (size_t i = 0; i < trace.samples.size(); i++) {
+    const Sample& s = trace.samples[i];
+    ahrs_update(ahrs, s.ax, s.ay, s.az, s.gx, s.gy, s.gz, s.t_ms);
+    q[i * 4] = ahrs.q0;
+    q[i * 4 + 1] = ahrs.q1;
+    q[i * 4 + 2] = ahrs.q2;
+    q[i * 4 + 3] = ahrs.q3;
+  }
+  r.cycles += (double)(cycles_now() - c0);
+  r.updates += trace.samples.size();
+  
+  // Signals need a second pass so the timed loop stays clean
+  if (sig && trace.fall_ms >= 0) {
+    int32_t rapid_ms = NEVER, flat_ms = NEVER;
+    ahrs_init(ahrs, algorithm, RATE_HZ);
+    for (const Sample& s : trace.samples) {
+      ahrs_update(ahrs, s.ax, s.ay, s.az, s.gx, s.gy, s.gz, s.t_ms);
+      AhrsSignals now = ahrs_signals(ahrs, s.t_ms);
+      int32_t rel = (int32_t)s.t_ms - trace.fall_ms;
+      if (now.rapid && rapid_ms == NEVER) rapid_ms = rel;
+      if (now.flat && rel < trace.impact_ms - trace.fall_ms) sig->flat_before = true;
+      else if (now.flat && flat_ms == NEVER) flat_ms = rel;
+    }
+    sig->missed |= rapid_ms == NEVER || flat_ms == NEVER;
+    if (rapid_ms > sig->rapid_ms) sig->rapid_ms = rapid_ms;
+    if (flat_ms > sig->flat_ms) sig->flat_ms = flat_ms;
+  }
+  
+  for (size_t i = 0; i < trace.samples.size(); i++) {
+    const Sample& s = trace.samples[i];
+    if (s.t_ms - trace.samples[0].t_ms < SETTLE_MS) continue;
+    AhrsState at = ahrs;
+    at.q0 = q[i * 4];
+    at.q1 = q[i * 4 + 1];
+    at.q2 = q[i * 4 + 2];
+    at.q3 = q[i * 4 + 3];
+    
+    double tx, ty, tz;
+    reference_gravity(s, tx, ty, tz);
+    double ex = 2 * (at.q1 * at.q3 - at.q0 * at.q2);
+    double ey = 2 * (at.q0 * at.q1 + at.q2 * at.q3);
+    double ez = at.q0 * at.q0 - at.q1 * at.q1 - at.q2 * at.q2 + at.q3 * at.q3;
+    double dot = std::fmax(-1.0, std::fmin(1.0, (tx * ex + ty * ey + tz * ez) /
+                                                std::sqrt(ex * ex + ey * ey + ez * ez)));
+    double err = std::acos(dot) / DEG;
+    r.err_sq += err * err;
+    if (err > r.err_max) r.err_max = err;
+    
+    float pitch, roll;
+    ahrs_pitch_roll(at, pitch, roll);
+    double dp = wrap_deg(pitch - s.pitch);
+    double dr = std::fabs(s.pitch) < 80 ? wrap_deg(roll - s.roll) : 0;   // Roll undefined near +/-90
+    r.pr_sq += (dp * dp + dr * dr) / 2;
+    r.scored++;
+  }
+}
+
+static void report(const char* name, const Result& r) {
+  printf("  %-9s attitude rms %5.2f max %6.2f deg  pitch/roll rms %5.2f deg  %6.1f cycles/update\n",
+         name, std::sqrt(r.err_sq / std::max<size_t>(r.scored, 1)), r.err_max,
+         std::sqrt(r.pr_sq / std::max<size_t>(r.scored, 1)), r.cycles / std::max<size_t>(r.updates, 1));
+}
+
+int main(int argc, char** argv) {
+  std::vector<Trace> traces;
+  const char* write_dir = nullptr;
+  
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--synthetic") == 0) {
+      std::vector<Trace> synth = synthetic_traces();
+      traces.insert(traces.end(), synth.begin(), synth.end());
+    } else if (strcmp(argv[i], "--write") == 0 && i + 1 < argc) {
+      write_dir = argv[++i];
+    } else {
+      Trace trace;
+      if (!load_trace(argv[i], trace)) {
+        perror(argv[i]);
+        return 1;
+      }
+      traces.push_back(trace);
+    }
+  }
+  if (traces.empty()) {
+    fprintf(stderr, "usage: %s [--synthetic] [--write DIR] [trace.csv ...]\n", argv[0]);
+    return 1;
+  }
+
+#ifdef AHRS_EXACT_INV_SQRT
+  printf("exact 1/sqrt normalisation\n");
+#else
+  printf("fast inverse-sqrt normalisation\n");
+#endif
+  std::vector<std::string> names;
+  for (const Trace& t : traces) {
+    bool seen = false;
+    for (const std::string& n : names) seen |= n == t.name;
+    if (!seen) names.push_back(t.name);
+  }
+  
+  const struct { const char* name; AhrsAlgorithm algorithm; } filters[] = {
+    {"madgwick", AHRS_MADGWICK}, {"mahony", AHRS_MAHONY}
+  };
+  for (size_t i = 0; i < traces.size(); i++) {
+    if (write_dir) write_trace(traces[i], write_dir, (int)i);
+  }
+  for (const std::string& n : names) {
+    printf("%s\n", n.c_str());
+    for (const auto& f : filters) {
+      Result r;
+      SignalTimes sig;
+      for (const Trace& t : traces) {
+        if (t.name == n) replay(t, f.algorithm, r, &sig);
+      }
+      report(f.name, r);
+      if (sig.rapid_ms != NEVER || sig.missed) {
+        printf("            fall start to rapid %+d ms, to flat %+d ms (latest)%s%s\n",
+               sig.rapid_ms, sig.flat_ms, sig.missed ? ", MISSED" : "",
+               sig.flat_before ? ", flat before impact" : "");
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,450 @@
+// ===================================================================
+// Alert Queue Simulation (host)
+// ===================================================================
+// Drives the firmware's alert queue (src/alert_queue) on a virtual
+// clock against a mock ALERTS transport and a mock client, through the
+// cases the stick has to survive:
+//   offline      alerts raised with nobody connected, replayed in order
+//                on connect; stale obstacle alerts dropped unsent
+//   lossy        --runs random sessions: alerts at random times, links
+//                that drop and come back, sends and confirmations lost
+//                at --loss, both indication and app-ack clients
+//   stall        a client that never acks: bounded retries, then the
+//                alert waits for the next connection
+//   overflow     more alerts than slots while offline
+//   burst        an SOS with nobody connected, then 20 obstacle alerts
+//                500 ms apart: the obstacles never push the SOS out
+//   reset        the RTC store survives a reset: pending alerts are
+//                restored and the sequence continues; a record torn by
+//                the reset is dropped alone; a push cut short before the
+//                header was sealed; power-on garbage gives an empty queue
+// The client keeps the first copy of each seq (retries duplicate) and
+// every safety alert must reach it exactly once, in order, unless the
+// ring overflowed. Also reports the cost of a push.
+//
+//   g++ -O2 -std=c++17 -Isrc tools/alert_queue_sim.cpp src/alert_queue.cpp -o alert_queue_sim
+//   ./alert_queue_sim [--runs N] [--loss P] [--seed N] [-v]
+// ===================================================================
+
+#include "alert_queue.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#define STEP_MS        10     // Loop pass
+#define RTT_MS         30     // Send to confirmation or ack
+
+static bool verbose = false;
+
+// ===================================================================
+// Mock Transport and Client
+// ===================================================================
+
+enum AckMode {
+  ACK_INDICATION,     // ATT confirmation: alert_queue_confirm
+  ACK_APP,            // Client writes {"ack":seq}: alert_queue_ack
+  ACK_NONE            // Notifications to a client that never acks
+};
+
+struct Reply {
+  uint32_t at_ms;
+  uint32_t link_id;
+  uint32_t seq;
+};
+
+struct Mock {
+  bool subscribed = false;
+  uint32_t link_id = 0;
+  AckMode mode = ACK_INDICATION;
+  double loss = 0;               // Sends and replies lost
+  std::mt19937* rng = nullptr;
+  uint32_t now_ms = 0;
+  std::vector<Reply> replies;
+  
+  // Client side
+  std::vector<uint32_t> received;   // First copy of each seq, in order
+  std::vector<bool> replayed;
+  uint32_t duplicates = 0;
+  uint32_t out_of_order = 0;
+  uint32_t last_seq = 0;
+  
+  bool lost() {
+    return loss > 0 && std::uniform_real_distribution<double>(0, 1)(*rng) < loss;
+  }
+};
+
+static bool mock_send(const char* json, size_t len, void* ctx) {
+  Mock& m = *(Mock*)ctx;
+  if (!m.subscribed) return false;
+  if (verbose) printf("  %6u ms  send %.*s\n", m.now_ms, (int)len, json);
+  if (m.lost()) return true;
+  
+  uint32_t seq = strtoul(json + 7, nullptr, 10);   // {"seq":N,
+  if (seq <= m.last_seq) {
+    m.duplicates++;
+  } else {
+    if (!m.received.empty() && seq < m.received.back()) m.out_of_order++;
+    m.received.push_back(seq);
+    m.replayed.push_back(strstr(json, "\"replay\":true") != nullptr);
+    m.last_seq = seq;
+  }
+  if (m.mode != ACK_NONE && !m.lost()) m.replies.push_back({m.now_ms + RTT_MS, m.link_id, seq});
+  return true;
+}
+
+static void mock_link(Mock& m, AlertQueue& q, bool up) {
+  m.subscribed = up;
+  m.link_id++;
+  m.replies.clear();
+  alert_queue_link(q, up, m.now_ms);
+}
+
+// One loop pass: replies that are due, then the queue
+static void step(Mock& m, AlertQueue& q) {
+  for (size_t i = 0; i < m.replies.size();) {
+    const Reply r = m.replies[i];
+    if ((int32_t)(m.now_ms - r.at_ms) < 0) {
+      i++;
+      continue;
+    }
+    m.replies.erase(m.replies.begin() + i);
+    if (r.link_id != m.link_id) continue;
+    if (m.mode == ACK_INDICATION) {
+      alert_queue_confirm(q, m.now_ms);
+    } else {
+      alert_queue_ack(q, r.seq, m.now_ms);
+    }
+  }
+  alert_queue_service(q, m.now_ms);
+}
+
+static void run_for(Mock& m, AlertQueue& q, uint32_t ms) {
+  for (uint32_t t = 0; t < ms; t += STEP_MS) {
+    step(m, q);
+    m.now_ms += STEP_MS;
+  }
+}
+
+static void push(Mock& m, AlertQueue& q, const char* event, AlertClass cls, std::vector<uint32_t>* safety) {
+  char json[64];
+  snprintf(json, sizeof(json), "{\"event\":\"%s\"}", event);
+  uint32_t seq = alert_queue_push(q, json, cls, m.now_ms);
+  if (safety && cls == ALERT_SAFETY) safety->push_back(seq);
+}
+
+// ===================================================================
+// Checks
+// ===================================================================
+
+static int failures = 0;
+
+static void expect(bool ok, const char* scenario, const char* what) {
+  if (ok) return;
+  printf("  FAIL %s: %s\n", scenario, what);
+  failures++;
+}
+
+// Every expected seq received once, in order (others may interleave)
+static bool received_all(const Mock& m, const std::vector<uint32_t>& expected) {
+  size_t at = 0;
+  for (uint32_t seq : m.received) {
+    if (at < expected.size() && seq == expected[at]) at++;
+  }
+  return at == expected.size() && m.out_of_order == 0;
+}
+
+static void print_stats(const char* name, const AlertQueue& q, const Mock& m) {
+  const AlertQueueStats& s = q.stats;
+  printf("%-9s  pushed %3u  sends %4u  retries %3u  delivered %3u  replayed %3u  stalls %u  "
+         "overwritten %u  dropped %u  expired %u  restored %u  corrupt %u  dup %u\n",
+         name, s.pushed, s.sends, s.retries, s.delivered, s.replayed, s.stalls, s.overwritten, s.dropped,
+         s.expired, s.restored, s.corrupt, m.duplicates);
+}
+
+// ===================================================================
+// Scenarios
+// ===================================================================
+
+static void scenario_offline(std::mt19937& rng) {
+  AlertStore store = {};
+  AlertQueue q;
+  Mock m;
+  m.rng = &rng;
+  alert_queue_open(q, &store, mock_send, &m, 0);
+  
+  std::vector<uint32_t> safety;
+  push(m, q, "FALL_DETECTED", ALERT_SAFETY, &safety);
+  run_for(m, q, 1000);
+  push(m, q, "OBSTACLE_NEAR", ALERT_TRANSIENT, nullptr);
+  run_for(m, q, 500);
+  push(m, q, "SOS_BUTTON_PRESSED", ALERT_SAFETY, &safety);
+  run_for(m, q, 5000);
+  mock_link(m, q, true);
+  run_for(m, q, 1000);
+  
+  print_stats("offline", q, m);
+  expect(received_all(m, safety) && m.received.size() == 2, "offline", "safety alerts replayed in order");
+  expect(m.replayed.size() == 2 && m.replayed[0] && m.replayed[1], "offline", "marked as replays");
+  expect(q.stats.expired == 1, "offline", "stale obstacle alert dropped");
+  expect(alert_queue_pending(q) == 0, "offline", "queue drained");
+}
+
+static void scenario_lossy(std::mt19937& rng, int runs, double loss) {
+  AckMode modes[2] = {ACK_INDICATION, ACK_APP};
+  const char* names[2] = {"lossy/ind", "lossy/app"};
+  for (int k = 0; k < 2; k++) {
+    AlertQueueStats total = {};
+    uint32_t dup = 0;
+    for (int run = 0; run < runs; run++) {
+      AlertStore store = {};
+      AlertQueue q;
+      Mock m;
+      m.rng = &rng;
+      m.mode = modes[k];
+      m.loss = loss;
+      alert_queue_open(q, &store, mock_send, &m, 0);
+      
+      // Half an hour: an alert every ~30 s, connections of ~5 s with
+      // ~10 s between them
+      std::vector<uint32_t> safety;
+      std::uniform_int_distribution<int> dice(0, 999);
+      for (uint32_t t = 0; t < 1800000; t += STEP_MS) {
+        if (dice(rng) < 1 && dice(rng) < 333) push(m, q, dice(rng) < 300 ? "OBSTACLE_NEAR" : "FALL_DETECTED",
+                                dice(rng) < 300 ? ALERT_TRANSIENT : ALERT_SAFETY, &safety);
+        if (dice(rng) < 2 && (m.subscribed || dice(rng) < 500)) mock_link(m, q, !m.subscribed);
+        step(m, q);
+        m.now_ms += STEP_MS;
+      }
+      // A clean reconnect drains what is left, stalled or not
+      if (m.subscribed) mock_link(m, q, false);
+      mock_link(m, q, true);
+      m.loss = 0;
+      run_for(m, q, 30000);
+      
+      // At heavy loss stalled connections can fill the ring; the
+      // overwritten alerts then show in the stats instead
+      bool ok = alert_queue_pending(q) == 0 && (received_all(m, safety) || (q.stats.overwritten && !m.out_of_order));
+      if (!ok) {
+        printf("  run %d: %zu safety alerts, %zu received, %zu pending\n", run, safety.size(), m.received.size(),
+               alert_queue_pending(q));
+      }
+      expect(ok, names[k], "every safety alert delivered once, in order");
+      
+      const AlertQueueStats& s = q.stats;
+      total.pushed += s.pushed;
+      total.sends += s.sends;
+      total.retries += s.retries;
+      total.delivered += s.delivered;
+      total.replayed += s.replayed;
+      total.stalls += s.stalls;
+      total.overwritten += s.overwritten;
+      total.expired += s.expired;
+      dup += m.duplicates;
+    }
+    AlertQueue sum = {};
+    sum.stats = total;
+    Mock m;
+    m.duplicates = dup;
+    print_stats(names[k], sum, m);
+  }
+}
+
+static void scenario_stall(std::mt19937& rng) {
+  AlertStore store = {};
+  AlertQueue q;
+  Mock m;
+  m.rng = &rng;
+  m.mode = ACK_NONE;
+  alert_queue_open(q, &store, mock_send, &m, 0);
+  
+  mock_link(m, q, true);
+  std::vector<uint32_t> safety;
+  push(m, q, "FALL_DETECTED", ALERT_SAFETY, &safety);
+  run_for(m, q, 60000);
+  expect(q.stats.sends == ALERT_MAX_ATTEMPTS && q.stats.stalls == 1, "stall", "retries bounded per connection");
+  expect(alert_queue_pending(q) == 1, "stall", "alert kept after the last attempt");
+  
+  // A client that acks picks it up on the next connection
+  mock_link(m, q, false);
+  m.mode = ACK_APP;
+  mock_link(m, q, true);
+  run_for(m, q, 1000);
+  print_stats("stall", q, m);
+  expect(alert_queue_pending(q) == 0 && q.stats.delivered == 1, "stall", "delivered after reconnect");
+}
+
+static void scenario_overflow(std::mt19937& rng) {
+  AlertStore store = {};
+  AlertQueue q;
+  Mock m;
+  m.rng = &rng;
+  alert_queue_open(q, &store, mock_send, &m, 0);
+  
+  std::vector<uint32_t> safety;
+  int n = ALERT_QUEUE_SIZE + 4;
+  for (int i = 0; i < n; i++) {
+    push(m, q, "SOS_BUTTON_PRESSED", ALERT_SAFETY, &safety);
+    run_for(m, q, 100);
+  }
+  mock_link(m, q, true);
+  run_for(m, q, 2000);
+  print_stats("overflow", q, m);
+  
+  std::vector<uint32_t> kept(safety.end() - ALERT_QUEUE_SIZE, safety.end());
+  expect(q.stats.overwritten == 4, "overflow", "oldest alerts overwritten");
+  expect(received_all(m, kept) && m.received.size() == ALERT_QUEUE_SIZE, "overflow", "newest ring delivered");
+}
+
+// Disconnected, an SOS waits at the head while the user walks on;
+// obstacle alerts must not wrap the ring over it
+static void scenario_burst(std::mt19937& rng) {
+  AlertStore store = {};
+  AlertQueue q;
+  Mock m;
+  m.rng = &rng;
+  alert_queue_open(q, &store, mock_send, &m, 0);
+  
+  std::vector<uint32_t> safety;
+  push(m, q, "SOS_BUTTON_PRESSED", ALERT_SAFETY, &safety);
+  int refused = 0;
+  for (int i = 0; i < 20; i++) {
+    run_for(m, q, 500);
+    if (alert_queue_push(q, "{\"event\":\"OBSTACLE_NEAR\"}", ALERT_TRANSIENT, m.now_ms) == 0) refused++;
+  }
+  expect(q.stats.overwritten == 0, "burst", "SOS overwritten by obstacle alerts");
+  expect(refused == 20 - (ALERT_QUEUE_SIZE - 1) && (int)q.stats.dropped == refused, "burst",
+         "obstacles beyond the ring refused");
+  
+  mock_link(m, q, true);
+  run_for(m, q, 2000);
+  
+  // Once the SOS is out, obstacle alerts queue and go out again
+  std::vector<uint32_t> after;
+  push(m, q, "OBSTACLE_NEAR", ALERT_TRANSIENT, nullptr);
+  after.push_back(alert_queue_next_seq(q) - 1);
+  run_for(m, q, 1000);
+  print_stats("burst", q, m);
+  
+  expect(received_all(m, safety), "burst", "SOS delivered after the burst");
+  expect(received_all(m, after) && q.stats.expired + q.stats.delivered == q.stats.pushed, "burst",
+         "queued obstacles sent or expired, new one sent");
+  expect(alert_queue_pending(q) == 0, "burst", "queue drained");
+}
+
+static void scenario_reset(std::mt19937& rng) {
+  AlertStore rtc = {};
+  AlertQueue q;
+  Mock m;
+  m.rng = &rng;
+  alert_queue_open(q, &rtc, mock_send, &m, 0);
+  
+  // Two delivered, then three raised after the client left
+  mock_link(m, q, true);
+  push(m, q, "FALL_DETECTED", ALERT_SAFETY, nullptr);
+  push(m, q, "SOS_BUTTON_PRESSED", ALERT_SAFETY, nullptr);
+  run_for(m, q, 500);
+  mock_link(m, q, false);
+  std::vector<uint32_t> safety;
+  push(m, q, "FALL_DETECTED", ALERT_SAFETY, &safety);
+  push(m, q, "OBSTACLE_NEAR", ALERT_TRANSIENT, nullptr);
+  push(m, q, "SOS_BUTTON_PRESSED", ALERT_SAFETY, &safety);
+  push(m, q, "FALL_DETECTED", ALERT_SAFETY, &safety);
+  uint32_t next = alert_queue_next_seq(q);
+  
+  // Warm reset: RTC memory kept, a new queue adopts it
+  AlertStore kept = rtc;
+  Mock m2;
+  m2.rng = &rng;
+  AlertQueue q2;
+  size_t restored = alert_queue_open(q2, &kept, mock_send, &m2, 0);
+  expect(restored == 3 && q2.stats.expired == 1, "reset", "safety alerts restored, obstacle dropped");
+  expect(alert_queue_next_seq(q2) == next, "reset", "sequence continues");
+  uint32_t seq = alert_queue_push(q2, "{\"event\":\"SOS_BUTTON_PRESSED\"}", ALERT_SAFETY, 0);
+  safety.push_back(seq);
+  mock_link(m2, q2, true);
+  run_for(m2, q2, 1000);
+  print_stats("reset", q2, m2);
+  expect(received_all(m2, safety) && m2.received.size() == 4, "reset", "restored alerts replayed first");
+  expect(m2.replayed[0] && m2.replayed[2], "reset", "restored alerts marked as replays");
+  
+  // Reset in the middle of writing one record: only that one is lost
+  AlertStore torn = rtc;
+  torn.slots[safety[1] & (ALERT_QUEUE_SIZE - 1)].json[3] ^= 0x40;
+  AlertQueue q3;
+  restored = alert_queue_open(q3, &torn, mock_send, &m2, 0);
+  expect(restored == 2 && q3.stats.corrupt == 1, "reset", "torn record dropped alone");
+  
+  // Reset after a record was written but before the header moved on
+  AlertStore cut = rtc;
+  cut.next_seq = next - 1;
+  cut.crc ^= 1;
+  AlertQueue q4;
+  restored = alert_queue_open(q4, &cut, mock_send, &m2, 0);
+  expect(restored == 3 && alert_queue_next_seq(q4) == next, "reset", "sequence recovered from the records");
+  
+  // Power-on: random memory
+  AlertStore cold;
+  for (size_t i = 0; i < sizeof(cold); i++) ((uint8_t*)&cold)[i] = (uint8_t)rng();
+  AlertQueue q5;
+  restored = alert_queue_open(q5, &cold, mock_send, &m2, 0);
+  expect(restored == 0 && alert_queue_pending(q5) == 0 && alert_queue_next_seq(q5) == 1, "reset",
+         "power-on starts empty");
+}
+
+// Cost of a push into a ring that is always full: the worst case
+static void measure_push() {
+  AlertStore store = {};
+  AlertQueue q;
+  Mock m;
+  alert_queue_open(q, &store, mock_send, &m, 0);
+  const char* json = "{\"event\":\"FALL_DETECTED\",\"severity\":\"high\",\"ax\":-2.41,\"ay\":0.87,\"az\":3.12,\"capture\":17}";
+  const int n = 200000;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < n; i++) alert_queue_push(q, json, ALERT_SAFETY, i);
+  auto t1 = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+  printf("\npush: %.0f ns (%zu-byte alert, full ring); store %zu bytes\n", ns, strlen(json), sizeof(AlertStore));
+}
+
+// ===================================================================
+// Main
+// ===================================================================
+
+int main(int argc, char** argv) {
+  int runs = 50;
+  double loss = 0.2;
+  uint32_t seed = 1;
+  
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--runs") && i + 1 < argc) {
+      runs = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--loss") && i + 1 < argc) {
+      loss = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "-v")) {
+      verbose = true;
+    } else {
+      fprintf(stderr, "usage: %s [--runs N] [--loss P] [--seed N] [-v]\n", argv[0]);
+      return 1;
+    }
+  }
+  
+  std::mt19937 rng(seed);
+  printf("%d lossy runs at %.0f%% loss, %d slots, %d attempts per connection\n\n", runs, loss * 100,
+         ALERT_QUEUE_SIZE, ALERT_MAX_ATTEMPTS);
+  scenario_offline(rng);
+  scenario_lossy(rng, runs, loss);
+  scenario_stall(rng);
+  scenario_overflow(rng);
+  scenario_burst(rng);
+  scenario_reset(rng);
+  measure_push();
+  
+  printf("%s\n", failures ? "FAIL" : "ok");
+  return failures ? 1 : 0;
+}
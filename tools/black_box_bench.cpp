@@ -0,0 +1,202 @@
+// ===================================================================
+// Black Box Check and Benchmark (host)
+// ===================================================================
+// Streams synthetic 100 Hz IMU, 30 Hz ToF and button edges into the
+// black box (src/black_box) with falls and SOS presses at fixed times,
+// the way the sensing task does. For every capture it checks that the
+// IMU samples run without gaps or repeats from BLACK_BOX_PRE_MS before
+// the trigger to BLACK_BOX_POST_MS after the last merged trigger, then
+// times append and trigger on their own.
+//
+//   g++ -O2 -std=c++17 -Isrc tools/black_box_bench.cpp src/black_box.cpp -o black_box_bench
+//   ./black_box_bench [pool_chunks]
+// ===================================================================
+
+#include "black_box.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#define IMU_PERIOD_MS 10
+#define TOF_PERIOD_MS 33
+
+struct Trigger {
+  uint32_t t_ms;
+  BlackBoxTrigger type;
+  bool posted;             // From another task (SOS), applied by service
+};
+
+static BlackBox box;
+
+// ===================================================================
+// Capture Check
+// ===================================================================
+
+struct CaptureReport {
+  uint16_t id;
+  const char* trigger;
+  uint8_t triggers;
+  uint8_t chunks;
+  int32_t first_ms;        // Relative to the trigger
+  int32_t last_ms;
+  uint32_t imu;
+  uint32_t gaps;
+  uint32_t tof;
+  uint32_t buttons;
+};
+
+static bool check_capture(uint16_t id, CaptureReport& r) {
+  const BlackBoxEvent* ev = black_box_find_event(box, id);
+  if (!ev) return false;
+  r = {};
+  r.id = id;
+  r.trigger = black_box_trigger_name(ev->trigger);
+  r.triggers = ev->triggers;
+  r.chunks = ev->count;
+  
+  int64_t prev_t = -1;
+  uint16_t prev_n = 0;
+  BlackBoxChunk chunk;
+  for (uint8_t i = 0; black_box_copy_chunk(box, id, i, chunk); i++) {
+    for (uint16_t k = 0; k < chunk.count; k++) {
+      const BlackBoxRecord& rec = chunk.records[k];
+      int64_t t = (int64_t)chunk.t0_ms + rec.dt_ms;
+      if (rec.type == BLACK_BOX_RECORD_TOF) r.tof++;
+      if (rec.type == BLACK_BOX_RECORD_BUTTON) r.buttons++;
+      if (rec.type != BLACK_BOX_RECORD_IMU) continue;
+      // v[5] carries the sample number: consecutive means nothing lost
+      uint16_t n = (uint16_t)rec.v[5];
+      if (prev_t < 0) {
+        r.first_ms = (int32_t)(t - ev->trigger_ms);
+      } else if ((uint16_t)(n - prev_n) != 1 || t - prev_t != IMU_PERIOD_MS) {
+        r.gaps++;
+      }
+      prev_t = t;
+      prev_n = n;
+      r.imu++;
+    }
+  }
+  r.last_ms = (int32_t)(prev_t - ev->trigger_ms);
+  return true;
+}
+
+// ===================================================================
+// Timing
+// ===================================================================
+
+static double ns_per(std::chrono::steady_clock::duration d, size_t n) {
+  return std::chrono::duration<double, std::nano>(d).count() / n;
+}
+
+static void time_ops(void* mem, size_t bytes) {
+  black_box_init(box, mem, bytes);
+  const size_t n = 2000000;
+  int16_t raw[6] = {100, -200, 4096, 5, -5, 0};
+  
+  auto t0 = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < n; i++) {
+    raw[5] = (int16_t)i;
+    black_box_push_imu(box, raw, (uint32_t)(i * IMU_PERIOD_MS));
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  
+  // Trigger + post window + release, repeated
+  const size_t rounds = 2000;
+  uint32_t t = (uint32_t)(n * IMU_PERIOD_MS);
+  std::chrono::steady_clock::duration trig = {};
+  for (size_t r = 0; r < rounds; r++) {
+    auto a = std::chrono::steady_clock::now();
+    black_box_trigger(box, BLACK_BOX_TRIGGER_FALL, t);
+    trig += std::chrono::steady_clock::now() - a;
+    for (uint32_t k = 0; k < (BLACK_BOX_POST_MS + BLACK_BOX_PRE_MS) / IMU_PERIOD_MS; k++) {
+      t += IMU_PERIOD_MS;
+      black_box_push_imu(box, raw, t);
+      black_box_service(box, t);
+    }
+    black_box_post_release(box, box.next_id);
+  }
+  
+  printf("\nappend: %.1f ns/sample   trigger: %.0f ns   (%zu-byte records, %zu-byte chunks)\n",
+         ns_per(t1 - t0, n), ns_per(trig, rounds), sizeof(BlackBoxRecord), sizeof(BlackBoxChunk));
+}
+
+// ===================================================================
+// Main
+// ===================================================================
+
+int main(int argc, char** argv) {
+  size_t pool_chunks = argc > 1 ? strtoul(argv[1], nullptr, 10) : 448;
+  size_t bytes = pool_chunks * sizeof(BlackBoxChunk);
+  std::vector<uint8_t> mem(bytes);
+  if (!black_box_init(box, mem.data(), bytes)) {
+    fprintf(stderr, "pool of %zu chunks is too small (need %d)\n", pool_chunks, BLACK_BOX_EVENT_MAX_CHUNKS + 2);
+    return 1;
+  }
+  
+  // Second SOS merges into the first fall; the last few overflow the slots
+  const Trigger triggers[] = {
+    {40000, BLACK_BOX_TRIGGER_FALL, false},
+    {42000, BLACK_BOX_TRIGGER_SOS, true},
+    {120000, BLACK_BOX_TRIGGER_SOS, true},
+    {125000, BLACK_BOX_TRIGGER_FALL, false},
+    {200000, BLACK_BOX_TRIGGER_FALL, false},
+    {260000, BLACK_BOX_TRIGGER_FALL, false},
+    {330000, BLACK_BOX_TRIGGER_SOS, true},
+  };
+  const size_t trigger_count = sizeof(triggers) / sizeof(triggers[0]);
+  const uint32_t end_ms = 360000;
+  
+  size_t next = 0;
+  uint16_t imu_n = 0;
+  bool pressed = false;
+  int16_t raw[6] = {0, 0, 4096, 0, 0, 0};
+  for (uint32_t t = 0; t < end_ms; t++) {
+    if (t % IMU_PERIOD_MS == 0) {
+      raw[0] = (int16_t)(t % 2000);
+      raw[5] = (int16_t)imu_n++;
+      black_box_push_imu(box, raw, t);
+    }
+    if (t % TOF_PERIOD_MS == 0) black_box_push_tof(box, (int16_t)(800 + t % 400), (t / TOF_PERIOD_MS) % 3, t);
+    if (next < trigger_count && t == triggers[next].t_ms) {
+      if (triggers[next].type == BLACK_BOX_TRIGGER_SOS) {
+        pressed = true;
+        black_box_push_button(box, true, t);
+      }
+      if (triggers[next].posted) {
+        black_box_post_trigger(box, triggers[next].type);
+      } else {
+        black_box_trigger(box, triggers[next].type, t);
+      }
+      next++;
+    }
+    if (pressed && next > 0 && t == triggers[next - 1].t_ms + 300) {
+      pressed = false;
+      black_box_push_button(box, false, t);
+    }
+    if (t % IMU_PERIOD_MS == 0) black_box_service(box, t);
+  }
+  
+  printf("pool %u chunks (%zu KB), history %.1f s, %u records, %u dropped\n",
+         box.pool_chunks, bytes / 1024, black_box_history_ms(box) / 1000.0,
+         box.stats.records, box.stats.dropped);
+  printf("captures %u  merged %u  evicted %u\n\n", box.stats.captures, box.stats.merged, box.stats.evicted);
+  printf("  id  trigger  n  chunks   first_ms  last_ms   imu  gaps  tof  btn\n");
+  
+  int failures = 0;
+  for (uint16_t id = 1; id <= box.next_id; id++) {
+    CaptureReport r;
+    if (!check_capture(id, r)) {
+      printf("  %2u  (evicted)\n", id);
+      continue;
+    }
+    bool ok = r.gaps == 0 && r.first_ms <= -BLACK_BOX_PRE_MS + IMU_PERIOD_MS * BLACK_BOX_CHUNK_RECORDS &&
+              r.last_ms >= BLACK_BOX_POST_MS - IMU_PERIOD_MS;
+    if (!ok) failures++;
+    printf("  %2u  %-7s %2u  %6u  %9d  %7d  %4u  %4u  %3u  %3u  %s\n", r.id, r.trigger, r.triggers,
+           r.chunks, r.first_ms, r.last_ms, r.imu, r.gaps, r.tof, r.buttons, ok ? "ok" : "FAIL");
+  }
+  
+  time_ops(mem.data(), bytes);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""
+Smart Walking Stick Firmware - Landmark Index Builder
+Builds the open-addressing landmark table (src/landmark_db.h) from a CSV
+and writes the image to flash into the "landmarks" partition.
+
+CSV columns: uid,landmark_id,category,cue[,name]
+  uid          hex UID as printed by the firmware, e.g. A1B2C3D4
+  landmark_id  0-65535, resolved to a name by the phone app
+  category     name (door, crossing, ...) or number
+  cue          local haptic cue index (0 = default RFID beep)
+  name         ignored here, kept for humans
+
+Usage:
+  python3 tools/build_landmarks.py landmarks.csv -o landmarks.bin
+  python3 tools/build_landmarks.py --random 20000 -o bench.bin
+  esptool.py --chip esp32s3 write_flash 0x290000 landmarks.bin
+"""
+
+import argparse
+import csv
+import random
+import struct
+import sys
+
+MAGIC = 0x314B4D4C  # "LMK1"
+VERSION = 1
+UID_MAX = 10
+HEADER = struct.Struct("<IHHII")
+SLOT = struct.Struct("<B10sBHBx")
+PARTITION_SIZE = 0x100000  # Must match partitions.csv
+
+CATEGORIES = ["generic", "door", "crossing", "stairs", "elevator", "restroom", "exit"]
+
+
+def fnv1a(data):
+    h = 2166136261
+    for b in data:
+        h ^= b
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def parse_category(value):
+    value = value.strip().lower()
+    if value.isdigit():
+        return int(value)
+    return CATEGORIES.index(value)
+
+
+def load_csv(path):
+    entries = []
+    with open(path, newline="") as f:
+        for row in csv.reader(f):
+            if not row or row[0].startswith("#") or row[0].strip().lower() == "uid":
+                continue
+            uid = bytes.fromhex(row[0].strip())
+            if not 1 <= len(uid) <= UID_MAX:
+                raise ValueError(f"bad UID length: {row[0]}")
+            entries.append((uid, int(row[1]), parse_category(row[2]), int(row[3])))
+    return entries
+
+
+def random_entries(count, seed):
+    rng = random.Random(seed)
+    uids = set()
+    while len(uids) < count:
+        uids.add(bytes(rng.getrandbits(8) for _ in range(rng.choice((4, 7)))))
+    return [(uid, i & 0xFFFF, i % len(CATEGORIES), i % 7) for i, uid in enumerate(sorted(uids))]
+
+
+def build(entries, load):
+    slot_count = 1
+    while slot_count * load < len(entries):
+        slot_count *= 2
+
+    slots = [None] * slot_count
+    mask = slot_count - 1
+    max_probe = 1
+    seen = set()
+
+    for entry in entries:
+        uid = entry[0]
+        if uid in seen:
+            raise ValueError(f"duplicate UID: {uid.hex().upper()}")
+        seen.add(uid)
+
+        # Robin Hood insertion: a tag far from its home slot displaces one
+        # closer to home, which keeps the worst-case probe length short.
+        # Runs stay contiguous, so the firmware's plain linear probe works.
+        pos = fnv1a(uid) & mask
+        dist = 0
+        while slots[pos] is not None:
+            resident_dist = (pos - (fnv1a(slots[pos][0]) & mask)) & mask
+            if resident_dist < dist:
+                slots[pos], entry = entry, slots[pos]
+                max_probe = max(max_probe, dist + 1)
+                dist = resident_dist
+            pos = (pos + 1) & mask
+            dist += 1
+        slots[pos] = entry
+        max_probe = max(max_probe, dist + 1)
+
+    out = bytearray(HEADER.pack(MAGIC, VERSION, max_probe, slot_count, len(entries)))
+    for entry in slots:
+        if entry is None:
+            out += bytes(SLOT.size)
+        else:
+            uid, landmark_id, category, cue = entry
+            out += SLOT.pack(len(uid), uid.ljust(UID_MAX, b"\0"), category, landmark_id, cue)
+    return bytes(out), max_probe
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build the RFID landmark index")
+    parser.add_argument("csv", nargs="?", help="landmark CSV")
+    parser.add_argument("-o", "--output", required=True, help="output image")
+    parser.add_argument("--load", type=float, default=0.75, help="max load factor")
+    parser.add_argument("--random", type=int, help="generate N random tags instead")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    if args.random:
+        entries = random_entries(args.random, args.seed)
+    elif args.csv:
+        entries = load_csv(args.csv)
+    else:
+        parser.error("need a CSV or --random N")
+
+    image, max_probe = build(entries, args.load)
+    if len(image) > PARTITION_SIZE:
+        print(f"Image is {len(image)} bytes, partition holds {PARTITION_SIZE}", file=sys.stderr)
+        return 1
+
+    with open(args.output, "wb") as f:
+        f.write(image)
+
+    print(f"{len(entries)} landmarks, {(len(image) - HEADER.size) // SLOT.size} slots, "
+          f"max probe {max_probe}, {len(image)} bytes -> {args.output}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
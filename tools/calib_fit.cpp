@@ -0,0 +1,310 @@
+// ===================================================================
+// Calibration Fit (host)
+// ===================================================================
+// Runs the firmware's calibration fit (src/calibration_engine) on a
+// saved session and prints the fitted fall_ax_threshold,
+// fall_motion_threshold and fall_stillness_ms with the confidence
+// report, per-trial margins, and how the firmware defaults would have
+// done on the same trials.
+//
+// Session CSV, as printed by the calibration "dump" command, one
+// sample per line (lines starting with '#' are ignored):
+//   trial,label,t_ms,ax,ay,az
+//   label   fall or adl; ax, ay, az in g; t_ms from the trial start
+//
+//   g++ -O2 -std=c++17 -Isrc tools/calib_fit.cpp src/calibration_engine.cpp src/fall_kernels.cpp -o calib_fit
+//   ./calib_fit session.csv
+//   ./calib_fit --synthetic [--seed N] [--falls N] [--adls N] [--write session.csv]
+// ===================================================================
+
+#include "calibration_engine.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#define LSB_PER_G 4096.0f   // MPU6050 at +/-8 g
+#define RATE_HZ   100
+
+// Firmware defaults (config.h)
+#define DEFAULT_IMPACT_G   0.96f
+#define DEFAULT_MOTION_G   1.22f
+#define DEFAULT_STILL_MS   300
+
+struct Trial {
+  uint8_t label;
+  std::string kind;
+  std::vector<CalibSample> samples;
+};
+
+static int16_t counts(float g) {
+  float c = g * LSB_PER_G;
+  if (c > 32767.0f) return 32767;
+  if (c < -32768.0f) return -32768;
+  return (int16_t)std::lround(c);
+}
+
+// ===================================================================
+// Session Loading
+// ===================================================================
+
+static bool load_session(const char* path, std::vector<Trial>& trials) {
+  FILE* f = fopen(path, "r");
+  if (!f) return false;
+  char line[160];
+  int current = -1;
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == '#') continue;
+    int trial;
+    char label[8];
+    unsigned t;
+    float ax, ay, az;
+    if (sscanf(line, "%d,%7[^,],%u,%f,%f,%f", &trial, label, &t, &ax, &ay, &az) != 6) continue;
+    if (trial != current) {
+      current = trial;
+      trials.push_back({(uint8_t)(strcmp(label, "fall") == 0 ? CALIB_LABEL_FALL : CALIB_LABEL_ADL), label, {}});
+    }
+    trials.back().samples.push_back({counts(ax), counts(ay), counts(az), (uint16_t)t});
+  }
+  fclose(f);
+  return true;
+}
+
+static void write_session(const std::vector<Trial>& trials, const char* path) {
+  FILE* f = fopen(path, "w");
+  if (!f) return;
+  fprintf(f, "# trial,label,t_ms,ax,ay,az\n");
+  for (size_t k = 0; k < trials.size(); k++) {
+    for (const CalibSample& s : trials[k].samples) {
+      fprintf(f, "%zu,%s,%u,%.3f,%.3f,%.3f\n", k, calib_label_name(trials[k].label), s.t_ms,
+              s.ax / LSB_PER_G, s.ay / LSB_PER_G, s.az / LSB_PER_G);
+    }
+  }
+  fclose(f);
+}
+
+// ===================================================================
+// Synthesis
+// ===================================================================
+// Short staged trials as a calibration session would record them:
+// falls onto a mat (stagger, brief free fall, impact, lying still with
+// small movements), and the movements that must not alert: kerb taps
+// while walking, a recovered stumble, and sitting down hard with the
+// cane held (impact, then fidgeting rather than stillness).
+// ===================================================================
+
+struct Synth {
+  Trial trial;
+  std::mt19937 rng;
+  uint16_t t = 0;
+  float tilt = 0.1f;
+  
+  Synth(uint8_t label, const char* kind, uint32_t seed) : rng(seed) {
+    trial.label = label;
+    trial.kind = kind;
+  }
+  
+  float uniform(float lo, float hi) { return std::uniform_real_distribution<float>(lo, hi)(rng); }
+  float gauss(float sd) { return std::normal_distribution<float>(0.0f, sd)(rng); }
+  
+  void emit(float scale, float lx, float ly, float lz, float noise) {
+    trial.samples.push_back({counts(scale * std::sin(tilt) + lx + gauss(noise)), counts(ly + gauss(noise)),
+                             counts(scale * std::cos(tilt) + lz + gauss(noise)), t});
+    t += 1000 / RATE_HZ;
+  }
+  
+  void walk(float seconds, float tap_g) {
+    float step_hz = uniform(1.6f, 2.1f);
+    uint32_t step_len = (uint32_t)(RATE_HZ / step_hz);
+    for (uint32_t i = 0; i < seconds * RATE_HZ; i++) {
+      uint32_t in_step = i % step_len;
+      float lz = 0.2f * std::sin(2.0f * (float)M_PI * in_step / step_len);
+      if (in_step == 0) lz += tap_g > 0 ? uniform(0.6f, 1.0f) * tap_g : 0.35f;
+      emit(1.0f, 0.05f * std::sin(i * 0.2f), 0.0f, lz, 0.03f);
+    }
+  }
+  
+  void fidget(float seconds, float amp, float noise) {
+    for (uint32_t i = 0; i < seconds * RATE_HZ; i++) {
+      float m = amp * (std::sin(i * 0.37f) + 0.6f * std::sin(i * 0.11f));
+      emit(1.0f, m, 0.5f * m, m, noise);
+    }
+  }
+  
+  void impact(float peak_g) {
+    for (int i = 0; i < 3; i++) {
+      float p = peak_g / (1 + 2 * i);
+      emit(1.0f, 0.3f * p * uniform(-1, 1), 0.3f * p * uniform(-1, 1), p, 0.05f);
+    }
+  }
+};
+
+static Trial synth_fall(uint32_t seed) {
+  Synth s(CALIB_LABEL_FALL, "fall", seed);
+  s.walk(s.uniform(1.0f, 2.5f), 0.0f);
+  s.fidget(s.uniform(0.2f, 0.5f), 0.3f, 0.05f);      // Stagger
+  for (int i = (int)(s.uniform(0.1f, 0.25f) * RATE_HZ); i > 0; i--) s.emit(s.uniform(0.2f, 0.5f), 0, 0, 0, 0.03f);
+  s.tilt = s.uniform(1.0f, 1.55f);
+  s.impact(s.uniform(2.2f, 5.5f));
+  s.fidget(s.uniform(0.2f, 0.5f), 0.15f, 0.04f);     // Settling
+  while (s.t < 8000) s.fidget(0.5f, s.uniform(0.0f, 0.03f), s.uniform(0.01f, 0.04f));
+  return s.trial;
+}
+
+static Trial synth_taps(uint32_t seed) {
+  Synth s(CALIB_LABEL_ADL, "kerb_taps", seed);
+  s.walk(8.0f, s.uniform(1.4f, 2.6f));
+  return s.trial;
+}
+
+static Trial synth_stumble(uint32_t seed) {
+  Synth s(CALIB_LABEL_ADL, "stumble", seed);
+  s.walk(s.uniform(1.5f, 3.0f), 0.0f);
+  s.fidget(0.3f, 0.35f, 0.05f);
+  s.impact(s.uniform(2.0f, 3.6f));
+  s.fidget(s.uniform(0.3f, 0.6f), 0.3f, 0.05f);
+  while (s.t < 8000) s.walk(1.0f, 0.0f);
+  return s.trial;
+}
+
+static Trial synth_sit(uint32_t seed) {
+  Synth s(CALIB_LABEL_ADL, "sit_down", seed);
+  s.walk(s.uniform(1.5f, 3.0f), 0.0f);
+  s.tilt = s.uniform(0.2f, 0.5f);
+  s.impact(s.uniform(1.6f, 2.6f));
+  while (s.t < 8000) s.fidget(0.5f, s.uniform(0.08f, 0.25f), 0.03f);
+  return s.trial;
+}
+
+static std::vector<Trial> synthetic_session(uint32_t seed, int falls, int adls) {
+  std::vector<Trial> trials;
+  uint32_t k = seed * 100003;
+  for (int i = 0; i < falls; i++) trials.push_back(synth_fall(k + 11 * i + 1));
+  for (int i = 0; i < adls; i++) {
+    switch (i % 3) {
+      case 0: trials.push_back(synth_taps(k + 11 * i + 2)); break;
+      case 1: trials.push_back(synth_stumble(k + 11 * i + 3)); break;
+      default: trials.push_back(synth_sit(k + 11 * i + 4)); break;
+    }
+  }
+  return trials;
+}
+
+// ===================================================================
+// Report
+// ===================================================================
+
+static void build_session(const std::vector<Trial>& trials, std::vector<CalibSample>& mem,
+                          CalibSession& session) {
+  size_t total = 0;
+  for (const Trial& tr : trials) total += tr.samples.size();
+  mem.resize(total);
+  calib_session_init(session, mem.data(), mem.size() * sizeof(CalibSample), LSB_PER_G);
+  
+  // Through the firmware's recording path, one FIFO-sized block at a time
+  for (const Trial& tr : trials) {
+    if (!calib_trial_start(session, (CalibLabel)tr.label, 0, CALIB_TRIAL_MAX_MS)) break;
+    for (size_t i = 0; i < tr.samples.size(); i += 16) {
+      int16_t ax[16], ay[16], az[16];
+      uint32_t t[16];
+      uint8_t n = 0;
+      for (size_t j = i; j < tr.samples.size() && n < 16; j++, n++) {
+        ax[n] = tr.samples[j].ax;
+        ay[n] = tr.samples[j].ay;
+        az[n] = tr.samples[j].az;
+        t[n] = tr.samples[j].t_ms;
+      }
+      calib_trial_push(session, ax, ay, az, t, n);
+    }
+    calib_trial_stop(session);
+  }
+}
+
+// Detected under one fixed set of thresholds, by the same replay rule
+static int detections(const std::vector<Trial>& trials, uint8_t label, float impact_g,
+                      float motion_g, uint16_t still_ms) {
+  int hits = 0;
+  for (const Trial& tr : trials) {
+    if (tr.label != label) continue;
+    bool potential = false, run = false;
+    uint32_t since = 0, start = 0;
+    bool hit = false;
+    for (const CalibSample& s : tr.samples) {
+      float a = std::sqrt((float)s.ax * s.ax + (float)s.ay * s.ay + (float)s.az * s.az) / LSB_PER_G;
+      if (!potential) {
+        if (a > 1.0f + impact_g) { potential = true; start = s.t_ms; run = false; }
+      } else if (a < motion_g) {
+        if (!run) { run = true; since = s.t_ms; }
+        if (s.t_ms - since >= still_ms) { hit = true; break; }
+      } else {
+        run = false;
+        if (s.t_ms - start > CALIB_CONFIRM_WINDOW_MS) potential = false;
+      }
+    }
+    hits += hit;
+  }
+  return hits;
+}
+
+int main(int argc, char** argv) {
+  std::vector<Trial> trials;
+  bool synthetic = false;
+  uint32_t seed = 1;
+  int falls = 5, adls = 9;
+  const char* write_path = nullptr;
+  
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--synthetic") == 0) synthetic = true;
+    else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = strtoul(argv[++i], nullptr, 10);
+    else if (strcmp(argv[i], "--falls") == 0 && i + 1 < argc) falls = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--adls") == 0 && i + 1 < argc) adls = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--write") == 0 && i + 1 < argc) write_path = argv[++i];
+    else if (!load_session(argv[i], trials)) {
+      fprintf(stderr, "cannot read %s\n", argv[i]);
+      return 1;
+    }
+  }
+  if (synthetic) trials = synthetic_session(seed, falls, adls);
+  if (trials.empty()) {
+    fprintf(stderr, "usage: %s session.csv | --synthetic [--seed N] [--falls N] [--adls N] [--write F]\n", argv[0]);
+    return 1;
+  }
+  if (trials.size() > CALIB_MAX_TRIALS) {
+    fprintf(stderr, "using the first %d of %zu trials\n", CALIB_MAX_TRIALS, trials.size());
+    trials.resize(CALIB_MAX_TRIALS);
+  }
+  if (write_path) write_session(trials, write_path);
+  
+  std::vector<CalibSample> mem;
+  CalibSession session;
+  build_session(trials, mem, session);
+  
+  std::vector<uint8_t> grid(CALIB_FIT_SCRATCH);
+  CalibFit fit;
+  auto t0 = std::chrono::steady_clock::now();
+  bool ok = calib_fit(session, grid.data(), fit);
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+  if (!ok) {
+    fprintf(stderr, "fit failed: %s\n", fit.error);
+    return 1;
+  }
+  
+  printf("%zu trials (%u falls, %u adl), %u samples; fit over %d grid points in %.1f ms\n\n",
+         trials.size(), fit.falls, fit.adls, session.used, CALIB_GRID_POINTS, ms);
+  printf("fit:      fall_ax_threshold %.2f g   fall_motion_threshold %.2f g   fall_stillness_ms %u\n",
+         fit.fall_ax_threshold, fit.fall_motion_threshold, fit.fall_stillness_ms);
+  printf("          falls %u/%u  adl alerts %u/%u  youden %.2f  auc %.2f  robustness %.2f  clearance %u  confidence %s\n",
+         fit.tp, fit.falls, fit.fp, fit.adls, fit.youden, fit.auc, fit.robustness, fit.clearance,
+         calib_confidence_name(fit.confidence));
+  printf("margins:  weakest fall %.2f g vs strongest adl %.2f g; fall still runs >= %u ms, adl <= %u ms\n",
+         fit.fall_peak_min_g, fit.adl_peak_max_g, fit.fall_run_min_ms, fit.adl_run_max_ms);
+  printf("defaults: falls %d/%u  adl alerts %d/%u  (%.2f g, %.2f g, %u ms)\n",
+         detections(trials, CALIB_LABEL_FALL, DEFAULT_IMPACT_G, DEFAULT_MOTION_G, DEFAULT_STILL_MS), fit.falls,
+         detections(trials, CALIB_LABEL_ADL, DEFAULT_IMPACT_G, DEFAULT_MOTION_G, DEFAULT_STILL_MS), fit.adls,
+         DEFAULT_IMPACT_G, DEFAULT_MOTION_G, DEFAULT_STILL_MS);
+  return 0;
+}
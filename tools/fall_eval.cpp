@@ -0,0 +1,550 @@
+// ===================================================================
+// Fall Classifier Evaluation (host)
+// ===================================================================
+// Replays accelerometer recordings through the firmware's feature engine
+// (src/imu_features) and fall classifier (src/fall_classifier), and
+// through the impact/stillness state machine it replaces, and reports
+// precision/recall per fall event and cycles per inference.
+//
+// Recording CSV, one sample per line:  t_ms,ax,ay,az,label
+//   ax, ay, az   acceleration in g (cane frame, z along the shaft)
+//   label        1 on the impact samples of a real fall, else 0
+//
+// A fall counts as detected if an alert fires within DETECT_WINDOW_MS of
+// its first labelled sample; every other alert is a false positive.
+//
+//   g++ -O2 -std=c++17 -Isrc tools/fall_eval.cpp src/fall_classifier.cpp src/imu_features.cpp -o fall_eval
+//   ./fall_eval rec1.csv rec2.csv ...
+//   ./fall_eval --synthetic [--seed N] [--write DIR]
+//   ./fall_eval --synthetic --features train.csv   (input to train_fall_model.py)
+//
+// Cycles come from the TSC on x86 and are estimated from wall time
+// elsewhere (at the nominal clock given by --ghz, default 3.0).
+// ===================================================================
+
+#include "fall_classifier.h"
+#include "imu_features.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define LSB_PER_G          4096.0f   // MPU6050 at +/-8 g
+#define RATE_HZ            100
+#define DETECT_WINDOW_MS   3000
+
+// Firmware defaults (config.h / fall_detection.cpp)
+#define IMPACT_G           1.96f
+#define STILL_G            1.22f
+#define STILLNESS_MS       300
+#define CONFIRM_WINDOW_MS  2000
+
+// Training labels: a window is a fall if the impact is old enough for
+// the aftermath to be in it; windows with an impact outside these
+// bounds are left out of the training set
+#define LABEL_MIN_AGE_MS   700
+#define LABEL_MAX_AGE_MS   2300
+
+static double nominal_ghz = 3.0;
+
+static uint64_t cycles_now() {
+#ifdef HAVE_TSC
+  return __rdtsc();
+#else
+  auto ns = std::chrono::steady_clock::now().time_since_epoch();
+  return (uint64_t)(std::chrono::duration<double, std::nano>(ns).count() * nominal_ghz);
+#endif
+}
+
+struct Sample {
+  uint32_t t_ms;
+  int16_t ax, ay, az;
+  uint8_t label;
+};
+
+struct Recording {
+  std::string name;
+  std::vector<Sample> samples;
+  std::vector<uint32_t> falls;   // First labelled sample of each fall
+};
+
+struct Result {
+  uint32_t falls = 0;
+  uint32_t detected = 0;
+  uint32_t false_alerts = 0;
+  uint32_t inferences = 0;
+  double cycles_total = 0;
+  uint64_t cycles_max = 0;
+};
+
+static int16_t counts(float g) {
+  float c = g * LSB_PER_G;
+  if (c > 32767.0f) return 32767;
+  if (c < -32768.0f) return -32768;
+  return (int16_t)std::lround(c);
+}
+
+static void index_falls(Recording& rec) {
+  rec.falls.clear();
+  uint8_t prev = 0;
+  for (const Sample& s : rec.samples) {
+    if (s.label && !prev) rec.falls.push_back(s.t_ms);
+    prev = s.label;
+  }
+}
+
+// ===================================================================
+// Recording Loading
+// ===================================================================
+
+static bool load_recording(const char* path, Recording& rec) {
+  FILE* f = fopen(path, "r");
+  if (!f) return false;
+  rec.name = path;
+  char line[160];
+  while (fgets(line, sizeof(line), f)) {
+    unsigned long t;
+    float ax, ay, az;
+    int label = 0;
+    if (sscanf(line, "%lu,%f,%f,%f,%d", &t, &ax, &ay, &az, &label) >= 4) {
+      rec.samples.push_back({(uint32_t)t, counts(ax), counts(ay), counts(az), (uint8_t)(label == 1)});
+    }
+  }
+  fclose(f);
+  index_falls(rec);
+  return true;
+}
+
+static void write_recording(const Recording& rec, const char* dir, int index) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%03d_%s.csv", dir, index, rec.name.c_str());
+  FILE* f = fopen(path, "w");
+  if (!f) return;
+  for (const Sample& s : rec.samples) {
+    fprintf(f, "%u,%.4f,%.4f,%.4f,%u\n", s.t_ms, s.ax / LSB_PER_G, s.ay / LSB_PER_G,
+            s.az / LSB_PER_G, s.label);
+  }
+  fclose(f);
+}
+
+// ===================================================================
+// Synthesis
+// ===================================================================
+// The cane frame: z along the shaft, gravity on z while it is upright.
+// Each scenario strings together segments of a walking person; only
+// "fall" contains labelled samples. The negatives are the usual false
+// alarms of an impact/stillness rule: the tip striking a kerb, a
+// stumble the user recovers from, leaning the cane on a chair, and the
+// cane dropped on the floor (long free fall, hard bounce, dead still).
+// ===================================================================
+
+struct Synth {
+  Recording rec;
+  std::mt19937 rng;
+  uint32_t t = 0;
+  float tilt = 0;        // Shaft angle from vertical (rad)
+  float heading = 0;     // Direction of the tilt in the x/y plane
+  float sway_phase = 0;
+  
+  Synth(const char* name, uint32_t seed) : rng(seed) { rec.name = name; }
+  
+  float uniform(float lo, float hi) { return std::uniform_real_distribution<float>(lo, hi)(rng); }
+  float gauss(float sd) { return std::normal_distribution<float>(0.0f, sd)(rng); }
+  
+  // Gravity for the current tilt, scaled, plus linear acceleration
+  void emit(float scale, float lx, float ly, float lz, float noise, uint8_t label = 0) {
+    float gx = std::sin(tilt) * std::cos(heading);
+    float gy = std::sin(tilt) * std::sin(heading);
+    float gz = std::cos(tilt);
+    rec.samples.push_back({t, counts(scale * gx + lx + gauss(noise)), counts(scale * gy + ly + gauss(noise)),
+                           counts(scale * gz + lz + gauss(noise)), label});
+    t += 1000 / RATE_HZ;
+  }
+  
+  void walk(float seconds, float tap_chance) {
+    float step_hz = uniform(1.6f, 2.1f);
+    float amp = uniform(0.12f, 0.28f);
+    float heel = uniform(0.2f, 0.5f);
+    uint32_t n = (uint32_t)(seconds * RATE_HZ);
+    uint32_t step_len = (uint32_t)(RATE_HZ / step_hz);
+    float tap = 0;
+    for (uint32_t i = 0; i < n; i++) {
+      uint32_t in_step = i % step_len;
+      if (in_step == 0) tap = uniform(0, 1) < tap_chance ? uniform(1.0f, 2.4f) : 0.0f;
+      float phase = 2.0f * (float)M_PI * in_step / step_len;
+      float lz = amp * std::sin(phase);
+      if (in_step < 3) lz += heel * (3 - in_step) / 3.0f + (in_step == 0 ? tap : 0.0f);
+      sway_phase += (float)M_PI * step_hz / RATE_HZ;
+      tilt = 0.12f + 0.08f * std::sin(sway_phase);
+      emit(1.0f, 0.1f * std::sin(sway_phase), 0.05f * std::cos(phase), lz, 0.03f);
+    }
+  }
+  
+  // Move the shaft angle to target over the given time, with some shake
+  void turn(float target, float seconds, float shake) {
+    uint32_t n = (uint32_t)(seconds * RATE_HZ);
+    float from = tilt;
+    for (uint32_t i = 0; i < n; i++) {
+      tilt = from + (target - from) * (i + 1) / n;
+      emit(1.0f, gauss(shake), gauss(shake), gauss(shake), 0.02f);
+    }
+  }
+  
+  void hold(float seconds, float noise, float move_chance) {
+    uint32_t n = (uint32_t)(seconds * RATE_HZ);
+    float move = 0;
+    for (uint32_t i = 0; i < n; i++) {
+      if (move <= 0 && uniform(0, 1) < move_chance / RATE_HZ) move = uniform(0.08f, 0.3f);
+      float m = move > 0 ? move : 0.0f;
+      if (move > 0) move -= 0.01f;
+      emit(1.0f, m * std::sin(i * 0.4f), 0, m * std::cos(i * 0.3f), noise);
+    }
+  }
+  
+  void free_fall(float seconds, float scale, float spin) {
+    uint32_t n = (uint32_t)(seconds * RATE_HZ);
+    for (uint32_t i = 0; i < n; i++) {
+      emit(scale, spin * uniform(0, 1), spin * uniform(0, 1), 0, 0.03f);
+    }
+  }
+  
+  void impact(float peak_g, uint8_t samples, uint8_t label) {
+    for (uint8_t i = 0; i < samples; i++) {
+      float p = peak_g / (1 + 2 * i);
+      emit(1.0f, 0.4f * p * uniform(-1, 1), 0.4f * p * uniform(-1, 1), p, 0.05f, label);
+    }
+  }
+};
+
+static Recording synth_walk(uint32_t seed) {
+  Synth s("walk", seed);
+  s.walk(s.uniform(12, 20), 0.02f);
+  return s.rec;
+}
+
+static Recording synth_kerb_taps(uint32_t seed) {
+  Synth s("kerb_taps", seed);
+  s.walk(s.uniform(12, 20), 0.25f);
+  return s.rec;
+}
+
+static Recording synth_stumble(uint32_t seed) {
+  Synth s("stumble", seed);
+  s.walk(s.uniform(4, 10), 0.02f);
+  s.turn(s.uniform(0.3f, 0.6f), s.uniform(0.2f, 0.4f), 0.4f);
+  s.impact(s.uniform(2.2f, 3.8f), 3, 0);
+  s.turn(0.1f, s.uniform(0.3f, 0.6f), 0.3f);
+  s.walk(s.uniform(5, 8), 0.02f);
+  return s.rec;
+}
+
+static Recording synth_lean(uint32_t seed) {
+  Synth s("lean_on_chair", seed);
+  s.walk(s.uniform(4, 10), 0.02f);
+  s.hold(s.uniform(0.5f, 1.5f), 0.02f, 0.5f);
+  s.turn(s.uniform(0.5f, 1.2f), s.uniform(0.6f, 1.2f), 0.05f);
+  s.impact(s.uniform(1.6f, 2.6f), 2, 0);
+  s.hold(s.uniform(4, 8), 0.008f, 0.0f);
+  return s.rec;
+}
+
+static Recording synth_drop(uint32_t seed) {
+  Synth s("cane_drop", seed);
+  s.walk(s.uniform(4, 10), 0.02f);
+  s.free_fall(s.uniform(0.3f, 0.5f), s.uniform(0.0f, 0.15f), 0.2f);
+  s.tilt = s.uniform(1.45f, 1.57f);
+  s.impact(s.uniform(3.5f, 7.9f), 2, 0);
+  for (int b = (int)s.uniform(1, 3); b > 0; b--) {
+    s.free_fall(s.uniform(0.06f, 0.15f), 0.1f, 0.1f);
+    s.impact(s.uniform(1.5f, 3.0f), 1, 0);
+  }
+  s.hold(s.uniform(2.5f, 6), 0.006f, 0.0f);
+  s.turn(0.12f, 1.0f, 0.15f);               // Picked up
+  s.walk(s.uniform(3, 6), 0.02f);
+  return s.rec;
+}
+
+static Recording synth_fall(uint32_t seed) {
+  Synth s("fall", seed);
+  s.walk(s.uniform(4, 10), 0.02f);
+  s.turn(s.uniform(0.4f, 0.8f), s.uniform(0.3f, 0.8f), s.uniform(0.2f, 0.5f));   // Stagger
+  s.free_fall(s.uniform(0.1f, 0.25f), s.uniform(0.25f, 0.6f), 0.1f);
+  s.tilt = s.uniform(0.9f, 1.55f);
+  s.impact(s.uniform(2.4f, 6.0f), 3, 1);
+  s.hold(s.uniform(5, 8), s.uniform(0.015f, 0.05f), s.uniform(0.3f, 1.5f));
+  return s.rec;
+}
+
+static std::vector<Recording> synthetic_recordings(uint32_t seed, int count) {
+  std::vector<Recording> recs;
+  for (int i = 0; i < count; i++) {
+    uint32_t k = seed * 100003 + i * 7;
+    recs.push_back(synth_walk(k + 1));
+    recs.push_back(synth_kerb_taps(k + 2));
+    recs.push_back(synth_stumble(k + 3));
+    recs.push_back(synth_lean(k + 4));
+    recs.push_back(synth_drop(k + 5));
+    recs.push_back(synth_fall(k + 6));
+    recs.push_back(synth_fall(k + 7000001));
+  }
+  for (Recording& rec : recs) index_falls(rec);
+  return recs;
+}
+
+// ===================================================================
+// Scoring
+// ===================================================================
+
+static void score_alerts(const Recording& rec, const std::vector<uint32_t>& alerts, Result& r) {
+  r.falls += rec.falls.size();
+  for (uint32_t fall : rec.falls) {
+    for (uint32_t a : alerts) {
+      if (a >= fall && a - fall <= DETECT_WINDOW_MS) {
+        r.detected++;
+        break;
+      }
+    }
+  }
+  for (uint32_t a : alerts) {
+    bool matched = false;
+    for (uint32_t fall : rec.falls) matched |= a >= fall && a - fall <= DETECT_WINDOW_MS;
+    if (!matched) r.false_alerts++;
+  }
+}
+
+static void add(Result& total, const Result& r) {
+  total.falls += r.falls;
+  total.detected += r.detected;
+  total.false_alerts += r.false_alerts;
+  total.inferences += r.inferences;
+  total.cycles_total += r.cycles_total;
+  if (r.cycles_max > total.cycles_max) total.cycles_max = r.cycles_max;
+}
+
+static void report(const char* name, const Result& r) {
+  uint32_t alerts = r.detected + r.false_alerts;
+  printf("%-14s falls %4u  detected %4u  false %4u  precision %.3f  recall %.3f",
+         name, r.falls, r.detected, r.false_alerts,
+         alerts ? (double)r.detected / alerts : 0.0, r.falls ? (double)r.detected / r.falls : 0.0);
+  if (r.inferences) {
+    printf("  %u inferences, cycles mean %.0f max %llu", r.inferences,
+           r.cycles_total / r.inferences, (unsigned long long)r.cycles_max);
+  }
+  printf("\n");
+}
+
+// ===================================================================
+// Classifier Replay
+// ===================================================================
+// Same gating as fall_detection.cpp: an inference every
+// FALL_CLASSIFIER_EVERY samples, only while the long window holds an
+// impact, none for FALL_CLASSIFIER_REFRACTORY_MS after an alert.
+// ===================================================================
+
+struct ClassifierRun {
+  const FallClassifier* classifier;
+  const Recording* rec;
+  Result* result;
+  FILE* features_out;
+  std::vector<uint32_t> alerts;
+  bool alerted;
+  uint32_t last_alert_ms;
+};
+
+static int training_label(const Recording& rec, uint32_t t_ms) {
+  int label = 0;
+  for (uint32_t fall : rec.falls) {
+    if (fall > t_ms || t_ms - fall > IMU_FEATURE_LONG_WINDOW * 1000 / RATE_HZ + 300) continue;
+    uint32_t age = t_ms - fall;
+    if (age < LABEL_MIN_AGE_MS || age > LABEL_MAX_AGE_MS) return -1;
+    label = 1;
+  }
+  return label;
+}
+
+static void on_long_window(const ImuFeatures& long_window, void* ctx) {
+  ClassifierRun& run = *(ClassifierRun*)ctx;
+  if (long_window.samples < IMU_FEATURE_LONG_WINDOW || long_window.max_g <= IMPACT_G) return;
+  if (run.alerted && long_window.t_ms - run.last_alert_ms < FALL_CLASSIFIER_REFRACTORY_MS) return;
+  
+  float features[FALL_FEATURE_COUNT];
+  fall_features_extract(imu_features_now(IMU_FEATURES_SHORT), long_window, features);
+  
+  if (run.features_out) {
+    int label = training_label(*run.rec, long_window.t_ms);
+    if (label >= 0) {
+      fprintf(run.features_out, "%d", label);
+      for (int f = 0; f < FALL_FEATURE_COUNT; f++) fprintf(run.features_out, ",%.5f", features[f]);
+      fprintf(run.features_out, "\n");
+    }
+  }
+  
+  uint64_t c0 = cycles_now();
+  int32_t score = run.classifier->score(features);
+  uint64_t c1 = cycles_now();
+  run.result->inferences++;
+  run.result->cycles_total += (double)(c1 - c0);
+  if (c1 - c0 > run.result->cycles_max) run.result->cycles_max = c1 - c0;
+  
+  if (score > run.classifier->threshold) {
+    run.alerts.push_back(long_window.t_ms);
+    run.alerted = true;
+    run.last_alert_ms = long_window.t_ms;
+  }
+}
+
+static ClassifierRun classifier_run;
+
+static void replay_classifier(const Recording& rec, Result& r, FILE* features_out) {
+  classifier_run.rec = &rec;
+  classifier_run.result = &r;
+  classifier_run.features_out = features_out;
+  classifier_run.alerts.clear();
+  classifier_run.alerted = false;
+  
+  imu_features_init(RATE_HZ, LSB_PER_G);
+  for (const Sample& s : rec.samples) imu_features_push(s.ax, s.ay, s.az, s.t_ms);
+  score_alerts(rec, classifier_run.alerts, r);
+}
+
+// ===================================================================
+// State Machine Replay
+// ===================================================================
+// The detect_update() rule with the default thresholds; the sensing
+// task resets it as soon as it confirms.
+// ===================================================================
+
+static void replay_state_machine(const Recording& rec, Result& r) {
+  enum { IDLE, POTENTIAL } state = IDLE;
+  uint32_t potential_ms = 0, still_since = 0;
+  bool still_run = false;
+  std::vector<uint32_t> alerts;
+  
+  for (const Sample& s : rec.samples) {
+    float mag = std::sqrt((float)s.ax * s.ax + (float)s.ay * s.ay + (float)s.az * s.az) / LSB_PER_G;
+    if (state == IDLE) {
+      if (mag > IMPACT_G) {
+        state = POTENTIAL;
+        potential_ms = s.t_ms;
+        still_run = false;
+      }
+    } else if (mag < STILL_G) {
+      if (!still_run) {
+        still_run = true;
+        still_since = s.t_ms;
+      }
+      if (s.t_ms - still_since >= STILLNESS_MS) {
+        alerts.push_back(s.t_ms);
+        state = IDLE;
+      }
+    } else {
+      still_run = false;
+      if (s.t_ms - potential_ms > CONFIRM_WINDOW_MS) state = IDLE;
+    }
+  }
+  score_alerts(rec, alerts, r);
+}
+
+int main(int argc, char** argv) {
+  std::vector<Recording> recs;
+  const char* write_dir = nullptr;
+  const char* features_path = nullptr;
+  uint32_t seed = 1;
+  int synth_count = 40;
+  bool synthetic = false;
+  
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--synthetic") == 0) {
+      synthetic = true;
+    } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+      synth_count = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = (uint32_t)atol(argv[++i]);
+    } else if (strcmp(argv[i], "--write") == 0 && i + 1 < argc) {
+      write_dir = argv[++i];
+    } else if (strcmp(argv[i], "--features") == 0 && i + 1 < argc) {
+      features_path = argv[++i];
+    } else if (strcmp(argv[i], "--ghz") == 0 && i + 1 < argc) {
+      nominal_ghz = atof(argv[++i]);
+    } else {
+      Recording rec;
+      if (!load_recording(argv[i], rec)) {
+        perror(argv[i]);
+        return 1;
+      }
+      recs.push_back(rec);
+    }
+  }
+  if (synthetic) {
+    std::vector<Recording> synth = synthetic_recordings(seed, synth_count);
+    recs.insert(recs.end(), synth.begin(), synth.end());
+  }
+  
+  if (recs.empty()) {
+    fprintf(stderr, "usage: %s [--synthetic [--seed N] [--count N]] [--write DIR] "
+                    "[--features FILE] [recording.csv ...]\n", argv[0]);
+    return 1;
+  }
+  
+  FILE* features_out = nullptr;
+  if (features_path) {
+    features_out = fopen(features_path, "w");
+    if (!features_out) {
+      perror(features_path);
+      return 1;
+    }
+  }
+  
+  classifier_run.classifier = &fall_classifier_trees;
+  imu_features_subscribe(IMU_FEATURES_LONG, FALL_CLASSIFIER_EVERY, on_long_window, &classifier_run);
+  
+  Result classifier, state_machine;
+  std::vector<std::string> names;
+  std::vector<Result> by_name[2];
+  for (size_t i = 0; i < recs.size(); i++) {
+    if (write_dir) write_recording(recs[i], write_dir, (int)i);
+    
+    size_t k = 0;
+    while (k < names.size() && names[k] != recs[i].name) k++;
+    if (k == names.size()) {
+      names.push_back(recs[i].name);
+      by_name[0].push_back(Result());
+      by_name[1].push_back(Result());
+    }
+    Result one[2];
+    replay_classifier(recs[i], one[0], features_out);
+    replay_state_machine(recs[i], one[1]);
+    add(classifier, one[0]);
+    add(state_machine, one[1]);
+    add(by_name[0][k], one[0]);
+    add(by_name[1][k], one[1]);
+  }
+  if (features_out) fclose(features_out);
+  
+  printf("%zu recordings, classifier %s\n", recs.size(), fall_classifier_trees.name);
+  if (synthetic) {
+    printf("  %-14s %5s  %-17s  %-17s\n", "", "falls", "classifier", "state machine");
+    for (size_t k = 0; k < names.size(); k++) {
+      printf("  %-14s %5u  det %4u false %4u  det %4u false %4u\n", names[k].c_str(),
+             by_name[0][k].falls, by_name[0][k].detected, by_name[0][k].false_alerts,
+             by_name[1][k].detected, by_name[1][k].false_alerts);
+    }
+  }
+#ifdef HAVE_TSC
+  printf("cycles/inference (TSC)\n");
+#else
+  printf("cycles/inference (estimated at %.1f GHz)\n", nominal_ghz);
+#endif
+  report("classifier", classifier);
+  report("state machine", state_machine);
+  return 0;
+}
@@ -0,0 +1,176 @@
+// ===================================================================
+// Fall Kernel Check and Microbenchmark (host)
+// ===================================================================
+// Runs the scalar and vector fall kernels (src/fall_kernels) on the same
+// blocks, fails if any magnitude, mask or peak differs, then reports
+// cycles per sample for both.
+//
+//   g++ -O2 -std=c++17 -Isrc tools/fall_kernel_bench.cpp src/fall_kernels.cpp -o fall_kernel_bench
+//   ./fall_kernel_bench [blocks]
+//
+// Cycles come from the TSC on x86 and are estimated from wall time
+// elsewhere (at the nominal clock given by --ghz, default 3.0).
+// ===================================================================
+
+#include "fall_kernels.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define LSB_PER_G 4096.0f
+
+static double nominal_ghz = 3.0;
+
+static uint64_t cycles_now() {
+#ifdef HAVE_TSC
+  return __rdtsc();
+#else
+  auto ns = std::chrono::steady_clock::now().time_since_epoch();
+  return (uint64_t)(std::chrono::duration<double, std::nano>(ns).count() * nominal_ghz);
+#endif
+}
+
+// ===================================================================
+// Block Generation
+// ===================================================================
+
+// Walking with occasional impacts, plus the int16 extremes
+static FallBlock make_block(std::mt19937& rng, uint8_t count, uint32_t t0) {
+  std::normal_distribution<float> noise(0.0f, 0.15f);
+  std::uniform_real_distribution<float> u(0.0f, 1.0f);
+  FallBlock block;
+  block.count = count;
+  for (uint8_t i = 0; i < count; i++) {
+    float gait = 0.3f * std::sin((t0 + i * 10) * 0.012f);
+    float ax = noise(rng), ay = noise(rng), az = 1.0f + gait + noise(rng);
+    float p = u(rng);
+    if (p < 0.05f) {
+      ax *= 12; ay *= 12; az *= 3.5f;                      // Impact
+    } else if (p < 0.07f) {
+      ax = ay = az = 0;                                    // Free fall
+    }
+    block.ax[i] = (int16_t)std::lround(std::fmax(-32768.f, std::fmin(32767.f, ax * LSB_PER_G)));
+    block.ay[i] = (int16_t)std::lround(std::fmax(-32768.f, std::fmin(32767.f, ay * LSB_PER_G)));
+    block.az[i] = (int16_t)std::lround(std::fmax(-32768.f, std::fmin(32767.f, az * LSB_PER_G)));
+    if (p > 0.995f) block.ax[i] = block.ay[i] = block.az[i] = -32768;
+    block.t_ms[i] = t0 + i * 10;
+  }
+  return block;
+}
+
+// ===================================================================
+// Equivalence Check
+// ===================================================================
+
+static bool same_scan(const FallBlockScan& a, const FallBlockScan& b) {
+  return a.impact_mask == b.impact_mask && a.still_mask == b.still_mask &&
+         a.peak_sq == b.peak_sq && a.peak_index == b.peak_index;
+}
+
+static bool check(const std::vector<FallBlock>& blocks, const FallKernelThresholds& thr) {
+  for (size_t n = 0; n < blocks.size(); n++) {
+    const FallBlock& block = blocks[n];
+    uint32_t ms[FALL_BLOCK_MAX], mv[FALL_BLOCK_MAX];
+    fall_kernel_magsq_scalar(block, ms);
+    fall_kernel_magsq_vector(block, mv);
+    if (memcmp(ms, mv, block.count * sizeof(uint32_t)) != 0) {
+      fprintf(stderr, "block %zu: magnitudes differ\n", n);
+      return false;
+    }
+    
+    FallBlockScan ss, sv;
+    fall_kernel_scan_scalar(ms, block.count, thr, ss);
+    fall_kernel_scan_vector(ms, block.count, thr, sv);
+    if (!same_scan(ss, sv)) {
+      fprintf(stderr, "block %zu (n=%u): scalar %08x/%08x peak %u@%u, vector %08x/%08x peak %u@%u\n",
+              n, block.count, ss.impact_mask, ss.still_mask, ss.peak_sq, ss.peak_index,
+              sv.impact_mask, sv.still_mask, sv.peak_sq, sv.peak_index);
+      return false;
+    }
+  }
+  return true;
+}
+
+// ===================================================================
+// Timing
+// ===================================================================
+
+typedef void (*MagsqFn)(const FallBlock&, uint32_t*);
+typedef void (*ScanFn)(const uint32_t*, uint8_t, const FallKernelThresholds&, FallBlockScan&);
+
+static double time_path(const std::vector<FallBlock>& blocks, const FallKernelThresholds& thr,
+                        MagsqFn magsq, ScanFn scan, uint32_t& sink) {
+  size_t samples = 0;
+  uint64_t best = UINT64_MAX;
+  for (int rep = 0; rep < 5; rep++) {
+    uint64_t t0 = cycles_now();
+    for (const FallBlock& block : blocks) {
+      uint32_t mag_sq[FALL_BLOCK_MAX];
+      FallBlockScan out;
+      magsq(block, mag_sq);
+      scan(mag_sq, block.count, thr, out);
+      sink += out.impact_mask ^ out.still_mask ^ out.peak_sq;
+    }
+    uint64_t t1 = cycles_now();
+    if (t1 - t0 < best) best = t1 - t0;
+  }
+  for (const FallBlock& block : blocks) samples += block.count;
+  return (double)best / samples;
+}
+
+int main(int argc, char** argv) {
+  size_t count = 20000;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--ghz") == 0 && i + 1 < argc) {
+      nominal_ghz = atof(argv[++i]);
+    } else {
+      count = (size_t)atol(argv[i]);
+    }
+  }
+  
+  // Firmware defaults: impact above 1.96 g, still below 1.22 g
+  FallKernelThresholds thr;
+  thr.impact_sq = fall_kernel_above_sq(1.96f, LSB_PER_G);
+  thr.still_sq = fall_kernel_below_sq(1.22f, LSB_PER_G);
+  
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> size(0, FALL_BLOCK_MAX);
+  std::vector<FallBlock> mixed, full, burst;
+  for (size_t i = 0; i < count; i++) {
+    mixed.push_back(make_block(rng, (uint8_t)size(rng), (uint32_t)i * 320));
+    full.push_back(make_block(rng, FALL_BLOCK_MAX, (uint32_t)i * 320));
+    burst.push_back(make_block(rng, 10, (uint32_t)i * 100));   // One FIFO burst
+  }
+  
+  if (!check(mixed, thr) || !check(full, thr) || !check(burst, thr)) {
+    printf("FAIL: scalar and vector kernels disagree\n");
+    return 1;
+  }
+  printf("%zu blocks x 3 sets: scalar and vector results identical\n", count);
+
+#ifdef HAVE_TSC
+  printf("cycles/sample (TSC)\n");
+#else
+  printf("cycles/sample (estimated at %.1f GHz)\n", nominal_ghz);
+#endif
+  uint32_t sink = 0;
+  const struct { const char* name; const std::vector<FallBlock>* blocks; } sets[] = {
+    {"32-sample", &full}, {"10-sample", &burst}, {"mixed", &mixed}
+  };
+  for (const auto& set : sets) {
+    double scalar = time_path(*set.blocks, thr, fall_kernel_magsq_scalar, fall_kernel_scan_scalar, sink);
+    double vector = time_path(*set.blocks, thr, fall_kernel_magsq_vector, fall_kernel_scan_vector, sink);
+    printf("  %-10s scalar %6.2f  vector %6.2f  (%.2fx)\n", set.name, scalar, vector, scalar / vector);
+  }
+  printf("(checksum %08x)\n", sink);
+  return 0;
+}
@@ -0,0 +1,683 @@
+// ===================================================================
+// Fall Detection Replay (host)
+// ===================================================================
+// Runs the firmware's fall detection (src/fall_detection.cpp, built
+// unchanged against the tools/host Arduino stand-in) over IMU traces on
+// a virtual clock, fed the way the sensing task feeds it: AHRS update
+// per sample, imu_features_push, then fall_detection_update_block every
+// --block samples. Reports detection latency from impact, false alerts
+// per hour and samples per second, for the thresholds given on the
+// command line (defaults from Config()).
+//
+// Traces are split over --jobs worker processes (detection state is
+// global, so one process per core); each worker loads or synthesises
+// its own share and sends results back over a pipe.
+//
+// Trace files, and directories of them:
+//   *.csv   t_ms,ax,ay,az[,gx,gy,gz],label   g and deg/s; label 1 on the
+//           impact samples of a real fall (fall_eval.cpp recordings load)
+//   *.ftr   "FALLTRC1", then 18-byte little-endian records:
+//           uint32 t_ms, int16 ax,ay,az,gx,gy,gz (raw MPU6050 counts at
+//           +/-8 g, +/-500 deg/s), uint8 label, uint8 reserved
+// Without files, --traces N of each synthetic scenario (fall_eval's
+// negatives and falls, with gyro) are replayed; --write DIR saves them.
+//
+//   g++ -O2 -std=c++17 -Itools/host -Isrc tools/fall_replay.cpp src/fall_detection.cpp src/fall_kernels.cpp src/fall_classifier.cpp src/imu_features.cpp src/calibration_engine.cpp src/ahrs.cpp src/log.cpp -o fall_replay
+//   ./fall_replay [--traces N] [--seed N] [--jobs N] [--block N] [--speed X]
+//                 [--impact G] [--still G] [--stillness MS]
+//                 [--state-machine | --classifier]
+//                 [-v] [--echo] [--write DIR] [trace.csv|trace.ftr|dir ...]
+//
+// The fall decision follows FALL_USE_CLASSIFIER unless --state-machine
+// or --classifier picks one.
+// --speed X paces replay at X times real time (0, the default: flat
+// out); --echo shows the module's log (with --jobs 1), drained after
+// every block as the stick's log task would.
+// ===================================================================
+
+#include "fall_detection.h"
+#include "imu_features.h"
+#include "config.h"
+#include "log.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <map>
+#include <random>
+#include <string>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#define RATE_HZ          100
+#define PERIOD_MS        (1000 / RATE_HZ)
+#define DETECT_WINDOW_MS 3000      // An alert this soon after an impact found it
+#define TRACE_GAP_MS     60000     // Virtual time between traces, past every refractory
+#define MAX_LATENCIES    8         // Per trace, sent back to the parent
+
+#define TRACE_MAGIC      "FALLTRC1"
+#define TRACE_RECORD     18
+
+Config g_config;
+
+struct Sample {
+  uint32_t t_ms;
+  int16_t ax, ay, az;
+  int16_t gx, gy, gz;
+  uint8_t label;
+};
+
+struct Trace {
+  std::string name;
+  std::vector<Sample> samples;
+};
+
+// Fixed size so a worker can write it to the pipe in one go
+struct TraceResult {
+  uint32_t index;
+  uint32_t samples;
+  uint32_t duration_ms;
+  uint16_t falls;
+  uint16_t detected;
+  uint16_t false_alerts;
+  uint16_t latency_count;
+  uint16_t latency_ms[MAX_LATENCIES];
+  uint64_t ns;
+  char name[48];
+};
+
+struct Options {
+  int traces = 100;
+  uint32_t seed = 1;
+  int jobs = 0;
+  int block = 1;
+  double speed = 0;
+  bool state_machine = false;
+  bool classifier = false;
+  bool verbose = false;
+  bool echo = false;
+  const char* write_dir = nullptr;
+  FallParams params;
+  std::vector<std::string> files;
+};
+
+static int16_t counts(float v, float lsb) {
+  float c = v * lsb;
+  if (c > 32767.0f) return 32767;
+  if (c < -32768.0f) return -32768;
+  return (int16_t)std::lround(c);
+}
+
+// ===================================================================
+// Trace Files
+// ===================================================================
+
+static bool ends_with(const std::string& s, const char* suffix) {
+  size_t n = strlen(suffix);
+  return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+static bool load_csv(const std::string& path, Trace& trace) {
+  FILE* f = fopen(path.c_str(), "r");
+  if (!f) return false;
+  char line[200];
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == '#') continue;
+    unsigned long t;
+    float v[7] = {};
+    int n = sscanf(line, "%lu,%f,%f,%f,%f,%f,%f,%f", &t, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6]);
+    if (n < 4) continue;
+    // 5 fields: fall_eval's t,ax,ay,az,label; 7 or 8: with gyro
+    bool gyro = n >= 7;
+    int label = n == 5 ? (int)v[3] : n == 8 ? (int)v[6] : 0;
+    Sample s;
+    s.t_ms = (uint32_t)t;
+    s.ax = counts(v[0], MPU6050_ACCEL_LSB_PER_G);
+    s.ay = counts(v[1], MPU6050_ACCEL_LSB_PER_G);
+    s.az = counts(v[2], MPU6050_ACCEL_LSB_PER_G);
+    s.gx = gyro ? counts(v[3], MPU6050_GYRO_LSB_PER_DPS) : 0;
+    s.gy = gyro ? counts(v[4], MPU6050_GYRO_LSB_PER_DPS) : 0;
+    s.gz = gyro ? counts(v[5], MPU6050_GYRO_LSB_PER_DPS) : 0;
+    s.label = label == 1;
+    trace.samples.push_back(s);
+  }
+  fclose(f);
+  return true;
+}
+
+// Records are little-endian, as is every host this builds on
+static bool load_binary(const std::string& path, Trace& trace) {
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f) return false;
+  char magic[8];
+  bool ok = fread(magic, 1, 8, f) == 8 && memcmp(magic, TRACE_MAGIC, 8) == 0;
+  uint8_t rec[TRACE_RECORD];
+  while (ok && fread(rec, 1, TRACE_RECORD, f) == TRACE_RECORD) {
+    Sample s;
+    memcpy(&s.t_ms, rec, 4);
+    memcpy(&s.ax, rec + 4, 2);
+    memcpy(&s.ay, rec + 6, 2);
+    memcpy(&s.az, rec + 8, 2);
+    memcpy(&s.gx, rec + 10, 2);
+    memcpy(&s.gy, rec + 12, 2);
+    memcpy(&s.gz, rec + 14, 2);
+    s.label = rec[16] == 1;
+    trace.samples.push_back(s);
+  }
+  fclose(f);
+  return ok;
+}
+
+static bool load_trace(const std::string& path, Trace& trace) {
+  trace.name = path;
+  return ends_with(path, ".ftr") ? load_binary(path, trace) : load_csv(path, trace);
+}
+
+static void write_binary(const Trace& trace, const std::string& path) {
+  FILE* f = fopen(path.c_str(), "wb");
+  if (!f) return;
+  fwrite(TRACE_MAGIC, 1, 8, f);
+  for (const Sample& s : trace.samples) {
+    uint8_t rec[TRACE_RECORD] = {};
+    memcpy(rec, &s.t_ms, 4);
+    memcpy(rec + 4, &s.ax, 2);
+    memcpy(rec + 6, &s.ay, 2);
+    memcpy(rec + 8, &s.az, 2);
+    memcpy(rec + 10, &s.gx, 2);
+    memcpy(rec + 12, &s.gy, 2);
+    memcpy(rec + 14, &s.gz, 2);
+    rec[16] = s.label;
+    fwrite(rec, 1, TRACE_RECORD, f);
+  }
+  fclose(f);
+}
+
+// Files as given; directories contribute their .csv and .ftr files
+static void expand_paths(const std::vector<std::string>& args, std::vector<std::string>& files) {
+  for (const std::string& arg : args) {
+    struct stat st;
+    if (stat(arg.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+      std::vector<std::string> found;
+      if (DIR* dir = opendir(arg.c_str())) {
+        while (dirent* e = readdir(dir)) {
+          std::string name = e->d_name;
+          if (ends_with(name, ".csv") || ends_with(name, ".ftr")) found.push_back(arg + "/" + name);
+        }
+        closedir(dir);
+      }
+      std::sort(found.begin(), found.end());
+      files.insert(files.end(), found.begin(), found.end());
+    } else {
+      files.push_back(arg);
+    }
+  }
+}
+
+// ===================================================================
+// Synthesis
+// ===================================================================
+// fall_eval.cpp's scenarios in the cane frame (z along the shaft), plus
+// the gyro: the shaft's tilt rate about the axis across the tilt
+// direction, and random spin while the stick tumbles.
+// ===================================================================
+
+struct Synth {
+  Trace trace;
+  std::mt19937 rng;
+  uint32_t t = 0;
+  float tilt = 0;          // Shaft angle from vertical (rad)
+  float last_tilt = 0;
+  float heading = 0;       // Direction of the tilt in the x/y plane
+  float sway_phase = 0;
+  float spin_dps = 0;
+  
+  Synth(const char* name, uint32_t seed) : rng(seed) {
+    trace.name = name;
+    heading = uniform(0, 2.0f * (float)M_PI);
+  }
+  
+  float uniform(float lo, float hi) { return std::uniform_real_distribution<float>(lo, hi)(rng); }
+  float gauss(float sd) { return std::normal_distribution<float>(0.0f, sd)(rng); }
+  
+  void emit(float scale, float lx, float ly, float lz, float noise, uint8_t label = 0) {
+    float gx = std::sin(tilt) * std::cos(heading);
+    float gy = std::sin(tilt) * std::sin(heading);
+    float gz = std::cos(tilt);
+    float rate_dps = (tilt - last_tilt) * RATE_HZ * 57.2958f;
+    last_tilt = tilt;
+    Sample s;
+    s.t_ms = t;
+    s.ax = counts(scale * gx + lx + gauss(noise), MPU6050_ACCEL_LSB_PER_G);
+    s.ay = counts(scale * gy + ly + gauss(noise), MPU6050_ACCEL_LSB_PER_G);
+    s.az = counts(scale * gz + lz + gauss(noise), MPU6050_ACCEL_LSB_PER_G);
+    s.gx = counts(-std::sin(heading) * rate_dps + gauss(1.0f + spin_dps), MPU6050_GYRO_LSB_PER_DPS);
+    s.gy = counts(std::cos(heading) * rate_dps + gauss(1.0f + spin_dps), MPU6050_GYRO_LSB_PER_DPS);
+    s.gz = counts(gauss(1.0f + spin_dps), MPU6050_GYRO_LSB_PER_DPS);
+    s.label = label;
+    trace.samples.push_back(s);
+    t += PERIOD_MS;
+  }
+  
+  void walk(float seconds, float tap_chance) {
+    float step_hz = uniform(1.6f, 2.1f);
+    float amp = uniform(0.12f, 0.28f);
+    float heel = uniform(0.2f, 0.5f);
+    uint32_t n = (uint32_t)(seconds * RATE_HZ);
+    uint32_t step_len = (uint32_t)(RATE_HZ / step_hz);
+    float tap = 0;
+    for (uint32_t i = 0; i < n; i++) {
+      uint32_t in_step = i % step_len;
+      if (in_step == 0) tap = uniform(0, 1) < tap_chance ? uniform(1.0f, 2.4f) : 0.0f;
+      float phase = 2.0f * (float)M_PI * in_step / step_len;
+      float lz = amp * std::sin(phase);
+      if (in_step < 3) lz += heel * (3 - in_step) / 3.0f + (in_step == 0 ? tap : 0.0f);
+      sway_phase += (float)M_PI * step_hz / RATE_HZ;
+      tilt = 0.12f + 0.08f * std::sin(sway_phase);
+      emit(1.0f, 0.1f * std::sin(sway_phase), 0.05f * std::cos(phase), lz, 0.03f);
+    }
+  }
+  
+  void turn(float target, float seconds, float shake) {
+    uint32_t n = (uint32_t)(seconds * RATE_HZ);
+    float from = tilt;
+    for (uint32_t i = 0; i < n; i++) {
+      tilt = from + (target - from) * (i + 1) / n;
+      emit(1.0f, gauss(shake), gauss(shake), gauss(shake), 0.02f);
+    }
+  }
+  
+  void hold(float seconds, float noise, float move_chance) {
+    uint32_t n = (uint32_t)(seconds * RATE_HZ);
+    float move = 0;
+    for (uint32_t i = 0; i < n; i++) {
+      if (move <= 0 && uniform(0, 1) < move_chance / RATE_HZ) move = uniform(0.08f, 0.3f);
+      float m = move > 0 ? move : 0.0f;
+      if (move > 0) move -= 0.01f;
+      emit(1.0f, m * std::sin(i * 0.4f), 0, m * std::cos(i * 0.3f), noise);
+    }
+  }
+  
+  void free_fall(float seconds, float scale, float spin) {
+    uint32_t n = (uint32_t)(seconds * RATE_HZ);
+    spin_dps = spin * 600.0f;
+    for (uint32_t i = 0; i < n; i++) {
+      emit(scale, spin * uniform(0, 1), spin * uniform(0, 1), 0, 0.03f);
+    }
+    spin_dps = 0;
+  }
+  
+  void impact(float peak_g, uint8_t samples, uint8_t label) {
+    for (uint8_t i = 0; i < samples; i++) {
+      float p = peak_g / (1 + 2 * i);
+      emit(1.0f, 0.4f * p * uniform(-1, 1), 0.4f * p * uniform(-1, 1), p, 0.05f, label);
+    }
+  }
+  
+  // Lands at a new angle over the next sample or two
+  void land(float target) {
+    turn(target, 0.02f, 0.3f);
+  }
+};
+
+#define SCENARIO_COUNT 7
+
+static Trace synthetic_trace(int scenario, uint32_t seed) {
+  switch (scenario) {
+    case 0: {
+      Synth s("walk", seed);
+      s.walk(s.uniform(12, 20), 0.02f);
+      return s.trace;
+    }
+    case 1: {
+      Synth s("kerb_taps", seed);
+      s.walk(s.uniform(12, 20), 0.25f);
+      return s.trace;
+    }
+    case 2: {
+      Synth s("stumble", seed);
+      s.walk(s.uniform(4, 10), 0.02f);
+      s.turn(s.uniform(0.3f, 0.6f), s.uniform(0.2f, 0.4f), 0.4f);
+      s.impact(s.uniform(2.2f, 3.8f), 3, 0);
+      s.turn(0.1f, s.uniform(0.3f, 0.6f), 0.3f);
+      s.walk(s.uniform(5, 8), 0.02f);
+      return s.trace;
+    }
+    case 3: {
+      Synth s("lean_on_chair", seed);
+      s.walk(s.uniform(4, 10), 0.02f);
+      s.hold(s.uniform(0.5f, 1.5f), 0.02f, 0.5f);
+      s.turn(s.uniform(0.5f, 1.2f), s.uniform(0.6f, 1.2f), 0.05f);
+      s.impact(s.uniform(1.6f, 2.6f), 2, 0);
+      s.hold(s.uniform(4, 8), 0.008f, 0.0f);
+      return s.trace;
+    }
+    case 4: {
+      Synth s("cane_drop", seed);
+      s.walk(s.uniform(4, 10), 0.02f);
+      s.free_fall(s.uniform(0.3f, 0.5f), s.uniform(0.0f, 0.15f), 0.2f);
+      s.land(s.uniform(1.45f, 1.57f));
+      s.impact(s.uniform(3.5f, 7.9f), 2, 0);
+      for (int b = (int)s.uniform(1, 3); b > 0; b--) {
+        s.free_fall(s.uniform(0.06f, 0.15f), 0.1f, 0.1f);
+        s.impact(s.uniform(1.5f, 3.0f), 1, 0);
+      }
+      s.hold(s.uniform(2.5f, 6), 0.006f, 0.0f);
+      s.turn(0.12f, 1.0f, 0.15f);
+      s.walk(s.uniform(3, 6), 0.02f);
+      return s.trace;
+    }
+    default: {
+      Synth s("fall", seed);
+      s.walk(s.uniform(4, 10), 0.02f);
+      s.turn(s.uniform(0.4f, 0.8f), s.uniform(0.3f, 0.8f), s.uniform(0.2f, 0.5f));
+      s.free_fall(s.uniform(0.1f, 0.25f), s.uniform(0.25f, 0.6f), 0.1f);
+      s.land(s.uniform(0.9f, 1.55f));
+      s.impact(s.uniform(2.4f, 6.0f), 3, 1);
+      s.hold(s.uniform(5, 8), s.uniform(0.015f, 0.05f), s.uniform(0.3f, 1.5f));
+      return s.trace;
+    }
+  }
+}
+
+// Two of the seven are falls, as in fall_eval
+static Trace make_trace(const Options& opt, uint32_t index) {
+  if (!opt.files.empty()) {
+    Trace trace;
+    if (!load_trace(opt.files[index], trace)) fprintf(stderr, "cannot read %s\n", opt.files[index].c_str());
+    return trace;
+  }
+  return synthetic_trace(index % SCENARIO_COUNT, opt.seed * 100003 + index * 7 + 1);
+}
+
+// ===================================================================
+// Replay
+// ===================================================================
+
+static uint32_t clock_base = 0;   // Virtual time of the current trace's t = 0
+
+static void echo_sink(const char* line, size_t len, void* ctx) {
+  (void)ctx;
+  if (Serial.echo) fwrite(line, 1, len, stdout);
+}
+
+static TraceResult replay(const Options& opt, const Trace& trace, uint32_t index) {
+  TraceResult r = {};
+  r.index = index;
+  snprintf(r.name, sizeof(r.name), "%s", trace.name.c_str());
+  if (trace.samples.empty()) return r;
+  
+  AhrsState ahrs;
+  ahrs_init(ahrs, AHRS_ALGORITHM, RATE_HZ);
+  imu_features_init(RATE_HZ, MPU6050_ACCEL_LSB_PER_G);
+  fall_detection_init();
+  if (opt.state_machine) fall_detection_set_classifier(nullptr);
+  if (opt.classifier) fall_detection_set_classifier(&fall_classifier_trees);
+  fall_detection_reset();
+  
+  std::vector<uint32_t> impacts, alerts;
+  uint8_t prev_label = 0;
+  uint32_t t0 = trace.samples.front().t_ms;
+  FallBlock block;
+  block.count = 0;
+  
+  auto wall0 = std::chrono::steady_clock::now();
+  for (size_t k = 0; k < trace.samples.size(); k++) {
+    const Sample& s = trace.samples[k];
+    uint32_t t = clock_base + (s.t_ms - t0);
+    if (opt.speed > 0) {
+      auto due = wall0 + std::chrono::microseconds((int64_t)((t - clock_base) * 1000.0 / opt.speed));
+      std::this_thread::sleep_until(due);
+    }
+    host_millis = t;
+    if (s.label && !prev_label) impacts.push_back(t);
+    prev_label = s.label;
+    
+    // As the sensing task: AHRS per sample, the rest per block
+    ahrs_update(ahrs, s.ax / (float)MPU6050_ACCEL_LSB_PER_G, s.ay / (float)MPU6050_ACCEL_LSB_PER_G,
+                s.az / (float)MPU6050_ACCEL_LSB_PER_G, s.gx / (float)MPU6050_GYRO_LSB_PER_DPS,
+                s.gy / (float)MPU6050_GYRO_LSB_PER_DPS, s.gz / (float)MPU6050_GYRO_LSB_PER_DPS, t);
+    uint8_t i = block.count++;
+    block.ax[i] = s.ax;
+    block.ay[i] = s.ay;
+    block.az[i] = s.az;
+    block.t_ms[i] = t;
+    if (block.count < opt.block && k + 1 < trace.samples.size()) continue;
+    
+    for (uint8_t j = 0; j < block.count; j++) {
+      imu_features_push(block.ax[j], block.ay[j], block.az[j], block.t_ms[j]);
+    }
+    fall_detection_set_orientation(ahrs_signals(ahrs, t));
+    fall_detection_update_block(block);
+    block.count = 0;
+    log_drain(echo_sink, nullptr, LOG_RING_SLOTS);
+    
+    float ax, ay, az;
+    if (fall_detection_check(ax, ay, az)) {
+      alerts.push_back(t);    // Published now, with the block
+      fall_detection_reset();
+    }
+  }
+  auto wall1 = std::chrono::steady_clock::now();
+  
+  r.samples = trace.samples.size();
+  r.duration_ms = trace.samples.back().t_ms - t0 + PERIOD_MS;
+  r.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wall1 - wall0).count();
+  clock_base += r.duration_ms + TRACE_GAP_MS;
+  
+  r.falls = impacts.size();
+  for (uint32_t impact : impacts) {
+    for (uint32_t a : alerts) {
+      if (a < impact || a - impact > DETECT_WINDOW_MS) continue;
+      r.detected++;
+      if (r.latency_count < MAX_LATENCIES) r.latency_ms[r.latency_count++] = a - impact;
+      break;
+    }
+  }
+  for (uint32_t a : alerts) {
+    bool matched = false;
+    for (uint32_t impact : impacts) matched |= a >= impact && a - impact <= DETECT_WINDOW_MS;
+    if (!matched) r.false_alerts++;
+  }
+  return r;
+}
+
+static void run_worker(const Options& opt, uint32_t total, int worker, int jobs, FILE* out) {
+  Serial.echo = opt.echo;
+  log_init(millis);
+  fall_detection_set_params(opt.params);
+  for (uint32_t i = worker; i < total; i += jobs) {
+    Trace trace = make_trace(opt, i);
+    if (opt.write_dir) {
+      char path[512];
+      snprintf(path, sizeof(path), "%s/%05u_%s.ftr", opt.write_dir, i, trace.name.c_str());
+      write_binary(trace, path);
+    }
+    TraceResult r = replay(opt, trace, i);
+    fwrite(&r, sizeof(r), 1, out);
+  }
+  fflush(out);
+}
+
+// One process per job, results over a pipe each
+static bool run_parallel(const Options& opt, uint32_t total, std::vector<TraceResult>& results) {
+  int jobs = opt.jobs < (int)total ? opt.jobs : (int)total;
+  if (jobs <= 1) {
+    FILE* tmp = tmpfile();
+    if (!tmp) return false;
+    run_worker(opt, total, 0, 1, tmp);
+    rewind(tmp);
+    TraceResult r;
+    while (fread(&r, sizeof(r), 1, tmp) == 1) results.push_back(r);
+    fclose(tmp);
+    return true;
+  }
+  
+  std::vector<FILE*> pipes;
+  std::vector<pid_t> pids;
+  for (int w = 0; w < jobs; w++) {
+    int fd[2];
+    if (pipe(fd) != 0) return false;
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+      close(fd[0]);
+      for (FILE* p : pipes) fclose(p);
+      FILE* out = fdopen(fd[1], "wb");
+      run_worker(opt, total, w, jobs, out);
+      fclose(out);
+      _exit(0);
+    }
+    close(fd[1]);
+    pipes.push_back(fdopen(fd[0], "rb"));
+    pids.push_back(pid);
+  }
+  
+  bool ok = true;
+  for (FILE* p : pipes) {
+    TraceResult r;
+    while (fread(&r, sizeof(r), 1, p) == 1) results.push_back(r);
+    fclose(p);
+  }
+  for (pid_t pid : pids) {
+    int status = 0;
+    waitpid(pid, &status, 0);
+    ok &= WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  }
+  std::sort(results.begin(), results.end(),
+            [](const TraceResult& a, const TraceResult& b) { return a.index < b.index; });
+  return ok;
+}
+
+// ===================================================================
+// Report
+// ===================================================================
+
+struct Totals {
+  uint64_t samples = 0;
+  uint64_t duration_ms = 0;
+  uint64_t ns = 0;
+  uint32_t traces = 0;
+  uint32_t falls = 0;
+  uint32_t detected = 0;
+  uint32_t false_alerts = 0;
+  std::vector<uint16_t> latencies;
+  
+  void add(const TraceResult& r) {
+    traces++;
+    samples += r.samples;
+    duration_ms += r.duration_ms;
+    ns += r.ns;
+    falls += r.falls;
+    detected += r.detected;
+    false_alerts += r.false_alerts;
+    latencies.insert(latencies.end(), r.latency_ms, r.latency_ms + r.latency_count);
+  }
+  
+  double false_per_hour() const {
+    return duration_ms ? false_alerts * 3600000.0 / duration_ms : 0;
+  }
+};
+
+static uint16_t percentile(std::vector<uint16_t>& v, double p) {
+  if (v.empty()) return 0;
+  size_t k = (size_t)std::ceil(p * v.size()) - 1;
+  std::nth_element(v.begin(), v.begin() + k, v.end());
+  return v[k];
+}
+
+static void report_latency(Totals& t) {
+  if (t.latencies.empty()) return;
+  double sum = 0;
+  for (uint16_t l : t.latencies) sum += l;
+  printf("latency from impact: mean %.0f ms  p50 %u  p95 %u  max %u\n", sum / t.latencies.size(),
+         percentile(t.latencies, 0.5), percentile(t.latencies, 0.95), percentile(t.latencies, 1.0));
+}
+
+// ===================================================================
+// Main
+// ===================================================================
+
+int main(int argc, char** argv) {
+  Options opt;
+  opt.params = fall_params_from_config();
+  opt.jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  std::vector<std::string> paths;
+  
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    bool more = i + 1 < argc;
+    if (!strcmp(a, "--traces") && more) opt.traces = atoi(argv[++i]);
+    else if (!strcmp(a, "--seed") && more) opt.seed = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(a, "--jobs") && more) opt.jobs = atoi(argv[++i]);
+    else if (!strcmp(a, "--block") && more) opt.block = atoi(argv[++i]);
+    else if (!strcmp(a, "--speed") && more) opt.speed = atof(argv[++i]);
+    else if (!strcmp(a, "--impact") && more) opt.params.impact_g = atof(argv[++i]);
+    else if (!strcmp(a, "--still") && more) opt.params.still_g = atof(argv[++i]);
+    else if (!strcmp(a, "--stillness") && more) opt.params.stillness_ms = atoi(argv[++i]);
+    else if (!strcmp(a, "--write") && more) opt.write_dir = argv[++i];
+    else if (!strcmp(a, "--state-machine")) opt.state_machine = true;
+    else if (!strcmp(a, "--classifier")) opt.classifier = true;
+    else if (!strcmp(a, "-v")) opt.verbose = true;
+    else if (!strcmp(a, "--echo")) opt.echo = true;
+    else if (a[0] == '-') {
+      fprintf(stderr, "unknown option %s\n", a);
+      return 1;
+    } else paths.push_back(a);
+  }
+  if (opt.block < 1) opt.block = 1;
+  if (opt.block > FALL_BLOCK_MAX) opt.block = FALL_BLOCK_MAX;
+  if (opt.jobs < 1) opt.jobs = 1;
+  expand_paths(paths, opt.files);
+  uint32_t total = opt.files.empty() ? opt.traces * SCENARIO_COUNT : opt.files.size();
+  
+  printf("impact > 1 + %.2f g, still < %.2f g for %u ms, %s, blocks of %d, %d jobs\n",
+         opt.params.impact_g, opt.params.still_g, opt.params.stillness_ms,
+         opt.classifier || (FALL_USE_CLASSIFIER && !opt.state_machine) ? fall_classifier_trees.name : "state machine",
+         opt.block, opt.jobs);
+  
+  std::vector<TraceResult> results;
+  auto wall0 = std::chrono::steady_clock::now();
+  if (!run_parallel(opt, total, results)) {
+    fprintf(stderr, "worker failed\n");
+    return 1;
+  }
+  double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall0).count();
+  
+  Totals all;
+  std::map<std::string, Totals> by_name;
+  for (const TraceResult& r : results) {
+    all.add(r);
+    if (opt.files.empty()) by_name[r.name].add(r);
+    if (opt.verbose) {
+      printf("%-40s %6.1f s  falls %u  detected %u  false %u", r.name, r.duration_ms / 1000.0,
+             r.falls, r.detected, r.false_alerts);
+      for (int l = 0; l < r.latency_count; l++) printf("  %u ms", r.latency_ms[l]);
+      printf("\n");
+    }
+  }
+  
+  if (!by_name.empty()) {
+    printf("\nscenario        traces  falls  detected  false  false/h\n");
+    for (auto& kv : by_name) {
+      Totals& t = kv.second;
+      printf("%-14s %7u  %5u  %8u  %5u  %7.2f\n", kv.first.c_str(), t.traces, t.falls, t.detected,
+             t.false_alerts, t.false_per_hour());
+    }
+  }
+  
+  printf("\n%u traces, %.2f h of data, %llu samples\n", all.traces, all.duration_ms / 3600000.0,
+         (unsigned long long)all.samples);
+  printf("falls detected %u of %u (%.1f%%), false alerts %u (%.2f per hour)\n", all.detected, all.falls,
+         all.falls ? 100.0 * all.detected / all.falls : 0.0, all.false_alerts, all.false_per_hour());
+  report_latency(all);
+  printf("%.2f s wall: %.2fM samples/s (%.0fx real time), %.2fM samples/s per job\n", wall_s,
+         all.samples / wall_s / 1e6, all.duration_ms / 1000.0 / wall_s,
+         all.ns ? all.samples * 1e3 / all.ns : 0.0);
+  return 0;
+}
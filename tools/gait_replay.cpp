@@ -0,0 +1,310 @@
+// ===================================================================
+// Gait Replay (host)
+// ===================================================================
+// Runs the firmware's gait engine (src/gait) over accelerometer traces
+// and checks step counts against ground truth, then times gait_push().
+// Synthetic traces are cane walks: bouts at 60-120 steps/min with
+// stride-time jitter and a stick plant every other step, separated by
+// standing, fidgeting, kerb taps and leaning the cane against a chair,
+// none of which are steps.
+//
+// Recorded traces are CSV, one sample per line ('#' lines ignored):
+//   t_ms,ax,ay,az[,step]     ax, ay, az in g; step 1 on each true step
+//
+//   g++ -O2 -std=c++17 -Isrc tools/gait_replay.cpp src/gait.cpp -o gait_replay
+//   ./gait_replay [--traces N] [--seed N] [--write trace.csv]
+//   ./gait_replay trace.csv [more.csv ...]
+// ===================================================================
+
+#include "gait.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#define LSB_PER_G 4096.0f   // MPU6050 at +/-8 g
+#define RATE_HZ   100
+#define PERIOD_MS (1000 / RATE_HZ)
+
+struct Sample {
+  int16_t ax, ay, az;
+  uint32_t t_ms;
+  bool step;                // Ground truth
+};
+
+struct Trace {
+  std::string name;
+  std::vector<Sample> samples;
+  uint32_t bouts = 0;       // Ground truth, synthetic only
+  uint32_t plants = 0;
+  double stride_cv = 0;     // Of the generated stride times, pooled over bouts
+};
+
+static int16_t counts(float g) {
+  float c = g * LSB_PER_G;
+  if (c > 32767.0f) return 32767;
+  if (c < -32768.0f) return -32768;
+  return (int16_t)std::lround(c);
+}
+
+// ===================================================================
+// Trace Loading
+// ===================================================================
+
+static bool load_trace(const char* path, Trace& trace) {
+  FILE* f = fopen(path, "r");
+  if (!f) return false;
+  trace.name = path;
+  char line[160];
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == '#') continue;
+    unsigned t;
+    float ax, ay, az;
+    int step = 0;
+    if (sscanf(line, "%u,%f,%f,%f,%d", &t, &ax, &ay, &az, &step) < 4) continue;
+    trace.samples.push_back({counts(ax), counts(ay), counts(az), t, step != 0});
+  }
+  fclose(f);
+  return true;
+}
+
+static void write_trace(const Trace& trace, const char* path) {
+  FILE* f = fopen(path, "w");
+  if (!f) return;
+  fprintf(f, "# t_ms,ax,ay,az,step\n");
+  for (const Sample& s : trace.samples) {
+    fprintf(f, "%u,%.3f,%.3f,%.3f,%d\n", s.t_ms, s.ax / LSB_PER_G, s.ay / LSB_PER_G,
+            s.az / LSB_PER_G, s.step ? 1 : 0);
+  }
+  fclose(f);
+}
+
+// ===================================================================
+// Synthesis
+// ===================================================================
+
+struct Synth {
+  Trace trace;
+  std::mt19937 rng;
+  uint32_t t = 0;
+  float tilt = 0.2f;        // Cane angle from vertical (rad)
+  std::vector<double> strides;   // Relative to the bout's mean stride
+  uint32_t last_step[2] = {0, 0};
+  uint32_t steps = 0;
+  
+  explicit Synth(uint32_t seed) : rng(seed) {}
+  
+  float uniform(float lo, float hi) { return std::uniform_real_distribution<float>(lo, hi)(rng); }
+  float gauss(float sd) { return std::normal_distribution<float>(0.0f, sd)(rng); }
+  
+  void emit(float lin, float lx, float ly, float noise, bool step = false) {
+    float g = 1.0f + lin;
+    trace.samples.push_back({counts(g * std::sin(tilt) + lx + gauss(noise)), counts(ly + gauss(noise)),
+                             counts(g * std::cos(tilt) + gauss(noise)), t, step});
+    t += PERIOD_MS;
+  }
+  
+  void stand(float seconds, float fidget) {
+    for (uint32_t i = 0; i < seconds * RATE_HZ; i++) {
+      float m = fidget * (std::sin(i * 0.21f) + 0.5f * std::sin(i * 0.07f));
+      emit(0.3f * m, m, 0.5f * m, 0.01f);
+    }
+  }
+  
+  // One walking bout: |a| peaks a quarter into each step (heel strike)
+  // and the plant spike leads it
+  void walk(int count, float spm, float amp, float jitter) {
+    trace.bouts++;
+    steps = 0;
+    float mean_ms = 60000.0f / spm;
+    for (int k = 0; k < count; k++) {
+      uint32_t len = (uint32_t)std::lround(mean_ms * (1.0f + gauss(jitter)) / PERIOD_MS);
+      if (len < 30) len = 30;
+      bool plant = k % 2 == 0;
+      if (plant) trace.plants++;
+      uint32_t strike_ms = t + len / 4 * PERIOD_MS;
+      if (steps >= 2) strides.push_back((double)(strike_ms - last_step[steps % 2]) / (2 * mean_ms));
+      last_step[steps % 2] = strike_ms;
+      steps++;
+      float a = amp * uniform(0.8f, 1.2f);
+      for (uint32_t i = 0; i < len; i++) {
+        float ph = (float)i / len;
+        float lin = a * (std::sin(2.0f * (float)M_PI * ph) + 0.25f * std::sin(4.0f * (float)M_PI * ph + 0.8f));
+        uint32_t at = len / 4;
+        if (plant && i >= at - 3 && i < at - 1) lin += uniform(0.5f, 1.0f) / (1 + 2 * (i - at + 3));
+        emit(lin, 0.05f * std::sin(6.28f * ph), 0.0f, 0.03f, i == at);
+      }
+    }
+  }
+  
+  void kerb_taps(int count) {
+    for (int k = 0; k < count; k++) {
+      stand(uniform(0.8f, 1.6f), 0.02f);
+      emit(uniform(1.0f, 2.5f), 0, 0, 0.05f);
+      emit(0.3f, 0, 0, 0.05f);
+    }
+  }
+  
+  // Cane leaned on a chair: slow tilt, then still
+  void lean() {
+    float from = tilt, to = uniform(0.9f, 1.3f);
+    for (int i = 0; i < 100; i++) {
+      tilt = from + (to - from) * i / 100.0f;
+      emit(0.0f, 0, 0, 0.01f);
+    }
+    stand(uniform(2.0f, 4.0f), 0.0f);
+    tilt = from;
+  }
+};
+
+static Trace synthetic_trace(uint32_t seed) {
+  Synth s(seed);
+  s.trace.name = "synthetic-" + std::to_string(seed);
+  s.stand(2.0f, 0.02f);
+  int bouts = 3 + seed % 3;
+  for (int b = 0; b < bouts; b++) {
+    float spm = s.uniform(60.0f, 120.0f);
+    // Slower walkers move the cane less
+    float amp = 0.08f + 0.25f * (spm - 60.0f) / 60.0f;
+    s.walk((int)s.uniform(12, 60), spm, amp, s.uniform(0.02f, 0.08f));
+    switch ((seed + b) % 3) {
+      case 0: s.stand(s.uniform(3.0f, 8.0f), 0.03f); break;
+      case 1: s.kerb_taps(3); break;
+      default: s.lean(); break;
+    }
+  }
+  s.stand(3.0f, 0.02f);
+  
+  double sum = 0, sum_sq = 0;
+  for (double v : s.strides) {
+    sum += v;
+    sum_sq += v * v;
+  }
+  size_t n = s.strides.size();
+  if (n > 1) s.trace.stride_cv = std::sqrt(n * sum_sq - sum * sum) / sum;
+  return s.trace;
+}
+
+// ===================================================================
+// Replay
+// ===================================================================
+
+struct Result {
+  uint32_t true_steps;
+  uint32_t steps;
+  uint32_t plants;
+  uint16_t bouts;
+  uint32_t walking_s;
+  double cadence_err;       // Mean |detected - true| spm while walking
+  float stride_cv;
+  uint32_t rejected;
+};
+
+static Result replay(const Trace& trace) {
+  GaitState gait;
+  gait_init(gait, LSB_PER_G);
+  Result r = {};
+  
+  // True cadence from the last two true steps, compared every second
+  uint32_t prev_step = 0, last_step = 0;
+  double err_sum = 0;
+  uint32_t err_n = 0;
+  for (const Sample& s : trace.samples) {
+    gait_push(gait, s.ax, s.ay, s.az, s.t_ms);
+    if (s.step) {
+      r.true_steps++;
+      prev_step = last_step;
+      last_step = s.t_ms;
+    }
+    if (s.t_ms % 1000 == 0) {
+      GaitSummary sum = gait_summary(gait, s.t_ms);
+      if (sum.walking && sum.cadence_spm && prev_step && s.t_ms - last_step < 1500) {
+        err_sum += std::fabs(sum.cadence_spm - 60000.0 / (last_step - prev_step));
+        err_n++;
+      }
+      r.stride_cv = sum.walking ? sum.stride_cv : r.stride_cv;
+    }
+  }
+  GaitSummary sum = gait_summary(gait, trace.samples.empty() ? 0 : trace.samples.back().t_ms);
+  r.steps = sum.steps;
+  r.plants = sum.plants;
+  r.bouts = sum.bouts;
+  r.walking_s = sum.walking_s;
+  r.cadence_err = err_n ? err_sum / err_n : 0;
+  r.rejected = gait.rejected;
+  return r;
+}
+
+static double ns_per_sample(const std::vector<Trace>& traces) {
+  size_t n = 0;
+  volatile uint32_t sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int rep = 0; rep < 20; rep++) {
+    for (const Trace& trace : traces) {
+      GaitState gait;
+      gait_init(gait, LSB_PER_G);
+      for (const Sample& s : trace.samples) sink += gait_push(gait, s.ax, s.ay, s.az, s.t_ms);
+      n += trace.samples.size();
+    }
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  (void)sink;
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+}
+
+// ===================================================================
+// Main
+// ===================================================================
+
+int main(int argc, char** argv) {
+  int count = 20;
+  uint32_t seed = 1;
+  const char* write_path = nullptr;
+  std::vector<Trace> traces;
+  
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--traces") && i + 1 < argc) {
+      count = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--write") && i + 1 < argc) {
+      write_path = argv[++i];
+    } else {
+      Trace trace;
+      if (!load_trace(argv[i], trace)) {
+        fprintf(stderr, "cannot read %s\n", argv[i]);
+        return 1;
+      }
+      traces.push_back(trace);
+    }
+  }
+  bool synthetic = traces.empty();
+  if (synthetic) {
+    for (int i = 0; i < count; i++) traces.push_back(synthetic_trace(seed * 1000 + i));
+    if (write_path) write_trace(traces[0], write_path);
+  }
+  
+  printf("trace                 true  steps   err%%  plants  bouts  walk_s  cad_err  cv_true  cv     rej\n");
+  uint64_t total_true = 0, total_steps = 0;
+  double worst = 0;
+  for (const Trace& trace : traces) {
+    Result r = replay(trace);
+    double err = r.true_steps ? 100.0 * ((double)r.steps - r.true_steps) / r.true_steps : 0;
+    if (std::fabs(err) > worst) worst = std::fabs(err);
+    total_true += r.true_steps;
+    total_steps += r.steps;
+    printf("%-20s %5u  %5u  %+5.1f  %3u/%-3u %2u/%-2u  %6u  %7.1f  %7.3f  %5.3f  %3u\n",
+           trace.name.c_str(), r.true_steps, r.steps, err, r.plants, trace.plants, r.bouts,
+           trace.bouts, r.walking_s, r.cadence_err, trace.stride_cv, r.stride_cv, r.rejected);
+  }
+  
+  double total_err = total_true ? 100.0 * ((double)total_steps - total_true) / total_true : 0;
+  printf("\nsteps %llu of %llu (%+.1f%%), worst trace %.1f%%\n", (unsigned long long)total_steps,
+         (unsigned long long)total_true, total_err, worst);
+  printf("gait_push: %.1f ns/sample, GaitState %zu bytes\n", ns_per_sample(traces), sizeof(GaitState));
+  return 0;
+}
@@ -0,0 +1,68 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// ===================================================================
+// Host Arduino Stand-in
+// ===================================================================
+// Just enough of the Arduino core to build the detection modules
+// (fall_detection.cpp and what it includes) natively, for
+// tools/fall_replay.cpp. Put this directory before src on the include
+// path:
+//   millis()/micros()    virtual clock: host_millis, set by the harness
+//   Serial               silent unless Serial.echo is set
+//   ESP.getCycleCount()  TSC on x86, steady_clock nanoseconds elsewhere
+// Each process has one clock; run traces in parallel as processes.
+// ===================================================================
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+inline uint32_t host_millis = 0;
+
+inline unsigned long millis() { return host_millis; }
+inline unsigned long micros() { return host_millis * 1000UL; }
+
+struct HostSerial {
+  bool echo = false;
+  
+  int printf(const char* fmt, ...) {
+    if (!echo) return 0;
+    va_list args;
+    va_start(args, fmt);
+    int n = vprintf(fmt, args);
+    va_end(args);
+    return n;
+  }
+  size_t print(const char* s) { return echo ? ::printf("%s", s) : 0; }
+  size_t print(long v) { return echo ? ::printf("%ld", v) : 0; }
+  size_t print(double v, int digits = 2) { return echo ? ::printf("%.*f", digits, v) : 0; }
+  size_t println(const char* s = "") { return echo ? ::printf("%s\n", s) : 0; }
+  int availableForWrite() { return 256; }
+};
+
+inline HostSerial Serial;
+
+struct HostEsp {
+  uint32_t getCycleCount() {
+#if defined(__x86_64__) || defined(__i386__)
+    return (uint32_t)__rdtsc();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+};
+
+inline HostEsp ESP;
+
+#endif // HOST_ARDUINO_H
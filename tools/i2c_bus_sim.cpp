@@ -0,0 +1,608 @@
+// ===================================================================
+// I2C Bus Scheduler Simulation (host)
+// ===================================================================
+// Runs the firmware's I2C scheduler (src/i2c_bus) against a mock bus
+// backend: a virtual microsecond clock and a 400 kHz bus model (22.5 us
+// a byte plus a fixed cost per transfer) with the MPU6050 (0x68) and
+// VL53L1X (0x29) attached. Transactions submitted by other tasks while
+// a transfer is on the bus are submitted at their own times.
+//   unit       priority order, a higher-priority submit from a callback
+//              going next, deadlines that expire in the queue (no bus
+//              time spent) and on the bus (the backend gets what is
+//              left), NACKs, a full queue, completion callbacks and the
+//              stats that count them
+//   abandon    synchronous calls (i2c_call_*): a caller that times out
+//              before its op starts leaves its arg untouched and gets
+//              no wake-up, the next call does not see the late
+//              completion, a call already running can't be abandoned,
+//              and an op is held to its deadline
+//   load       the stick's traffic for --seconds: IMU FIFO drains at
+//              --imu-hz (HIGH), ToF range reads every 50 ms with a
+//              clock-stretched read now and then (NORMAL), six register
+//              dumps once a second (LOW); queue wait per priority and
+//              bus utilisation, then the same traffic at one priority
+//              for comparison
+//   cost       host time per submit + run with a zero-time backend
+//
+//   g++ -O2 -std=c++17 -Isrc tools/i2c_bus_sim.cpp src/i2c_bus.cpp -o i2c_bus_sim
+//   ./i2c_bus_sim [--seconds N] [--imu-hz N] [--seed N] [-v]
+// ===================================================================
+
+#include "i2c_bus.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#define MPU_ADDR        0x68
+#define TOF_ADDR        0x29
+#define BYTE_US         22.5      // 9 bits at 400 kHz
+#define TRANSFER_US     40        // Start, stop, driver overhead
+#define HOUSEKEEPING_BURST 6      // Register dumps queued together
+
+static bool verbose = false;
+static int failures = 0;
+
+static void expect(bool ok, const char* scenario, const char* what) {
+  if (ok) return;
+  printf("  FAIL %s: %s\n", scenario, what);
+  failures++;
+}
+
+// ===================================================================
+// Mock Backend
+// ===================================================================
+
+struct Arrival {
+  uint64_t t_us;
+  int kind;
+};
+
+struct MockBus {
+  uint64_t now = 0;
+  uint32_t transfers = 0;
+  uint32_t stretch_us = 0;          // Added to the next transfer
+  uint32_t last_timeout_us = 0;     // What the scheduler passed down
+  uint64_t wire_us = 0;             // Time spent on the wire
+  
+  // Submitted at their own times as the clock passes them
+  std::vector<Arrival> arrivals;
+  size_t next_arrival = 0;
+  void (*arrive)(const Arrival& a) = nullptr;
+};
+
+static MockBus mock;
+static uint32_t call_wakes[I2C_PRIORITY_COUNT];   // call_done, as a semaphore count
+
+static void mock_advance(uint64_t us) {
+  uint64_t end = mock.now + us;
+  while (mock.next_arrival < mock.arrivals.size() && mock.arrivals[mock.next_arrival].t_us <= end) {
+    const Arrival& a = mock.arrivals[mock.next_arrival++];
+    if (a.t_us > mock.now) mock.now = a.t_us;
+    if (mock.arrive) mock.arrive(a);
+  }
+  mock.now = end;
+}
+
+static I2CResult mock_transfer(void* ctx, uint8_t address, const uint8_t* tx, size_t tx_len,
+                               uint8_t* rx, size_t rx_len, uint32_t timeout_us) {
+  (void)ctx;
+  (void)tx;
+  mock.transfers++;
+  mock.last_timeout_us = timeout_us;
+  if (address != MPU_ADDR && address != TOF_ADDR) {
+    uint64_t t = TRANSFER_US + (uint64_t)BYTE_US;
+    mock.wire_us += t;
+    mock_advance(t);
+    return I2C_NACK;
+  }
+  size_t bytes = 1 + tx_len + (rx_len ? 1 + rx_len : 0);
+  uint64_t t = TRANSFER_US + (uint64_t)(bytes * BYTE_US) + mock.stretch_us;
+  mock.stretch_us = 0;
+  if (timeout_us && t > timeout_us) {
+    mock.wire_us += timeout_us;
+    mock_advance(timeout_us);
+    return I2C_TIMEOUT;
+  }
+  for (size_t i = 0; i < rx_len; i++) rx[i] = (uint8_t)(address + i);
+  mock.wire_us += t;
+  mock_advance(t);
+  return I2C_OK;
+}
+
+static uint32_t mock_now(void* ctx) {
+  (void)ctx;
+  return (uint32_t)mock.now;
+}
+
+static void mock_call_done(void* ctx, I2CPriority priority) {
+  (void)ctx;
+  call_wakes[priority]++;
+}
+
+static void mock_reset() {
+  mock = MockBus();
+  memset(call_wakes, 0, sizeof(call_wakes));
+  I2CBusBackend backend = {mock_transfer, mock_now, nullptr, mock_call_done};
+  i2c_bus_init(backend);
+}
+
+// ===================================================================
+// Unit Checks
+// ===================================================================
+
+struct Done {
+  int tag;
+  I2CResult result;
+  uint32_t at_us;
+};
+
+static std::vector<Done> done_log;
+
+static void log_done(const I2CTransaction& txn, I2CResult result) {
+  done_log.push_back({(int)(intptr_t)txn.ctx, result, (uint32_t)mock.now});
+}
+
+static I2CTransaction make_txn(int tag, I2CPriority p, uint8_t address, uint32_t timeout_us) {
+  static uint8_t reg = 0x3B;
+  static uint8_t rx[16];
+  I2CTransaction txn = {};
+  txn.address = address;
+  txn.priority = p;
+  txn.tx = &reg;
+  txn.tx_len = 1;
+  txn.rx = rx;
+  txn.rx_len = sizeof(rx);
+  txn.timeout_us = timeout_us;
+  txn.done = log_done;
+  txn.ctx = (void*)(intptr_t)tag;
+  return txn;
+}
+
+// From a NORMAL callback: a HIGH transaction jumps the rest of NORMAL
+static void submit_high_once(const I2CTransaction& txn, I2CResult result) {
+  log_done(txn, result);
+  static bool sent = false;
+  if (!sent) {
+    sent = true;
+    i2c_bus_submit(make_txn(99, I2C_PRIORITY_HIGH, MPU_ADDR, 0));
+  }
+}
+
+static void scenario_unit() {
+  const char* name = "unit";
+  
+  // Submitted low to high; run high to low, FIFO within a level
+  mock_reset();
+  done_log.clear();
+  i2c_bus_submit(make_txn(1, I2C_PRIORITY_LOW, MPU_ADDR, 0));
+  i2c_bus_submit(make_txn(2, I2C_PRIORITY_NORMAL, TOF_ADDR, 0));
+  i2c_bus_submit(make_txn(3, I2C_PRIORITY_NORMAL, TOF_ADDR, 0));
+  i2c_bus_submit(make_txn(4, I2C_PRIORITY_HIGH, MPU_ADDR, 0));
+  expect(i2c_bus_pending(), name, "submitted work not pending");
+  expect(i2c_bus_run() == 4 && !i2c_bus_pending(), name, "run did not empty the queues");
+  bool order = done_log.size() == 4 && done_log[0].tag == 4 && done_log[1].tag == 2 &&
+               done_log[2].tag == 3 && done_log[3].tag == 1;
+  expect(order, name, "not run in priority order");
+  bool all_ok = true;
+  for (const Done& d : done_log) all_ok &= d.result == I2C_OK;
+  expect(all_ok, name, "callback result");
+  
+  // A HIGH submit from a callback runs before the remaining NORMAL one
+  mock_reset();
+  done_log.clear();
+  I2CTransaction a = make_txn(5, I2C_PRIORITY_NORMAL, TOF_ADDR, 0);
+  a.done = submit_high_once;
+  i2c_bus_submit(a);
+  i2c_bus_submit(make_txn(6, I2C_PRIORITY_NORMAL, TOF_ADDR, 0));
+  i2c_bus_run();
+  order = done_log.size() == 3 && done_log[0].tag == 5 && done_log[1].tag == 99 && done_log[2].tag == 6;
+  expect(order, name, "higher priority submitted mid-run did not go next");
+  
+  // Deadline passed in the queue: no bus time, TIMEOUT to the callback
+  mock_reset();
+  done_log.clear();
+  mock.stretch_us = 2000;
+  i2c_bus_submit(make_txn(7, I2C_PRIORITY_HIGH, MPU_ADDR, 0));
+  i2c_bus_submit(make_txn(8, I2C_PRIORITY_NORMAL, TOF_ADDR, 1000));
+  i2c_bus_run();
+  I2CBusStats s = i2c_bus_get_stats();
+  expect(done_log.size() == 2 && done_log[1].tag == 8 && done_log[1].result == I2C_TIMEOUT, name,
+         "expired transaction not timed out");
+  expect(mock.transfers == 1, name, "expired transaction used the bus");
+  expect(s.timeouts[I2C_PRIORITY_NORMAL] == 1 && s.completed[I2C_PRIORITY_HIGH] == 1, name,
+         "timeout stats");
+  expect(s.max_wait_us[I2C_PRIORITY_NORMAL] >= 2000, name, "queue wait not measured");
+  
+  // Deadline on the bus: the backend gets what is left of it
+  mock_reset();
+  done_log.clear();
+  i2c_bus_submit(make_txn(9, I2C_PRIORITY_HIGH, MPU_ADDR, 0));
+  i2c_bus_submit(make_txn(10, I2C_PRIORITY_NORMAL, TOF_ADDR, 5000));
+  uint32_t first = TRANSFER_US + (uint32_t)(19 * BYTE_US);
+  i2c_bus_run();
+  expect(mock.last_timeout_us == 5000 - first, name, "remaining deadline not passed to the backend");
+  mock.stretch_us = 10000;
+  uint32_t submitted = (uint32_t)mock.now;
+  i2c_bus_submit(make_txn(11, I2C_PRIORITY_NORMAL, TOF_ADDR, 5000));
+  i2c_bus_run();
+  expect(done_log.back().tag == 11 && done_log.back().result == I2C_TIMEOUT, name,
+         "stretched transfer not timed out");
+  expect(done_log.back().at_us == submitted + 5000, name, "timeout overran its deadline");
+  
+  // NACK, a full queue, no callback
+  mock_reset();
+  done_log.clear();
+  i2c_bus_submit(make_txn(12, I2C_PRIORITY_LOW, 0x50, 0));
+  int accepted = 1;
+  for (int i = 0; i < I2C_BUS_QUEUE_SIZE + 2; i++) {
+    I2CTransaction t = make_txn(20 + i, I2C_PRIORITY_HIGH, MPU_ADDR, 0);
+    if (i == 0) t.done = nullptr;
+    accepted += i2c_bus_submit(t);
+  }
+  expect(accepted == 1 + I2C_BUS_QUEUE_SIZE, name, "full queue accepted a submit");
+  i2c_bus_run();
+  s = i2c_bus_get_stats();
+  expect(s.rejected[I2C_PRIORITY_HIGH] == 2, name, "rejections not counted");
+  expect(s.failed[I2C_PRIORITY_LOW] == 1 && done_log.back().result == I2C_NACK, name, "NACK not reported");
+  expect(done_log.size() == (size_t)I2C_BUS_QUEUE_SIZE, name, "callbacks missing or extra");
+  expect(s.busy_us == mock.wire_us, name, "busy time differs from time on the wire");
+  uint8_t util = i2c_bus_utilization_pct();
+  expect(util == 100, name, "back-to-back transfers not 100% utilisation");
+  
+  printf("%-7s priority order, mid-run preemption, deadlines in queue and on bus, NACK, full queue\n", name);
+}
+
+// ===================================================================
+// Abandoned Calls
+// ===================================================================
+
+// Stands in for the caller's stack frame the op writes into
+struct CallFrame {
+  int written;
+  uint32_t seq;
+  uint32_t stretch_us;              // Clock stretch on the op's transfer
+  bool overrun;                     // Then a second transfer with no deadline
+  bool abandon_inside;              // Caller times out while the op runs
+  bool abandon_refused;
+};
+
+static I2CResult frame_op(void* arg) {
+  CallFrame& f = *(CallFrame*)arg;
+  uint8_t reg = 0x3B;
+  uint8_t rx[12];
+  mock.stretch_us = f.stretch_us;
+  I2CResult r = mock_transfer(nullptr, MPU_ADDR, &reg, 1, rx, sizeof(rx), i2c_bus_op_remaining_us());
+  if (f.overrun) {
+    mock.stretch_us = 10000;
+    mock_transfer(nullptr, MPU_ADDR, &reg, 1, rx, sizeof(rx), 0);
+  }
+  if (f.abandon_inside) f.abandon_refused = !i2c_call_abandon(I2C_PRIORITY_HIGH, f.seq);
+  f.written++;
+  return r;
+}
+
+static void scenario_abandon() {
+  const char* name = "abandon";
+  const I2CPriority p = I2C_PRIORITY_HIGH;
+  I2CResult result;
+  
+  // Caller times out while its call is still queued behind a slow one
+  mock_reset();
+  CallFrame a = {}, b = {};
+  a.seq = i2c_call_submit(p, MPU_ADDR, frame_op, &a, 2000);
+  expect(a.seq != 0, name, "submit rejected");
+  mock_advance(3000);
+  expect(i2c_call_abandon(p, a.seq), name, "queued call not abandoned");
+  b.seq = i2c_call_submit(p, MPU_ADDR, frame_op, &b, 2000);
+  expect(!i2c_call_finished(p, b.seq, result), name, "next call finished before it ran");
+  i2c_bus_run();
+  expect(a.written == 0, name, "abandoned op wrote into its caller's frame");
+  expect(mock.transfers == 1, name, "abandoned op used the bus");
+  expect(call_wakes[p] == 1, name, "abandoned call woke its caller");
+  expect(!i2c_call_finished(p, a.seq, result), name, "abandoned call reported finished");
+  bool got = i2c_call_finished(p, b.seq, result);
+  expect(got && result == I2C_OK && b.written == 1, name, "next call did not get its own result");
+  expect(!i2c_call_finished(p, b.seq, result), name, "result collected twice");
+  I2CBusStats s = i2c_bus_get_stats();
+  expect(s.timeouts[p] == 1 && s.completed[p] == 1, name, "abandon stats");
+  
+  // A full queue of abandoned calls: further submits are refused until
+  // the worker has drained them, then the slots are free again
+  mock_reset();
+  CallFrame frames[I2C_BUS_QUEUE_SIZE] = {};
+  for (CallFrame& f : frames) {
+    f.seq = i2c_call_submit(p, MPU_ADDR, frame_op, &f, 2000);
+    i2c_call_abandon(p, f.seq);
+  }
+  CallFrame extra = {};
+  bool refused = true;
+  for (int i = 0; i < 2; i++) refused &= i2c_call_submit(p, MPU_ADDR, frame_op, &extra, 2000) == 0;
+  expect(refused, name, "submit accepted with every slot held");
+  i2c_bus_run();
+  int written = 0;
+  for (const CallFrame& f : frames) written += f.written;
+  expect(written == 0 && call_wakes[p] == 0, name, "abandoned ops ran or woke the caller");
+  extra.seq = i2c_call_submit(p, MPU_ADDR, frame_op, &extra, 2000);
+  i2c_bus_run();
+  got = extra.seq && i2c_call_finished(p, extra.seq, result);
+  expect(got && extra.written == 1, name, "slots not freed after the abandoned calls drained");
+  
+  // Timeout while the op runs: abandon refused, the caller keeps waiting
+  mock_reset();
+  CallFrame c = {};
+  c.abandon_inside = true;
+  c.seq = i2c_call_submit(p, MPU_ADDR, frame_op, &c, 2000);
+  i2c_bus_run();
+  got = i2c_call_finished(p, c.seq, result);
+  expect(c.abandon_refused, name, "running call abandoned");
+  expect(got && call_wakes[p] == 1 && c.written == 1, name, "running call not completed");
+  
+  // Op deadline: a stretched transfer inside the op gets what is left,
+  // and an op that finishes late is reported as timed out
+  mock_reset();
+  CallFrame d = {}, e = {};
+  d.stretch_us = 10000;
+  uint32_t submitted = (uint32_t)mock.now;
+  d.seq = i2c_call_submit(p, MPU_ADDR, frame_op, &d, 5000);
+  i2c_bus_run();
+  got = i2c_call_finished(p, d.seq, result);
+  expect(got && result == I2C_TIMEOUT && mock.now == submitted + 5000, name,
+         "stretched transfer in an op overran its deadline");
+  e.overrun = true;
+  e.seq = i2c_call_submit(p, MPU_ADDR, frame_op, &e, 5000);
+  i2c_bus_run();
+  got = i2c_call_finished(p, e.seq, result);
+  expect(got && result == I2C_TIMEOUT, name, "late op not reported as timed out");
+  expect(i2c_bus_op_remaining_us() == 0, name, "deadline left set outside an op");
+  
+  printf("%-7s abandoned calls skip their op and wake nobody, no stale completion, op deadlines\n", name);
+}
+
+// ===================================================================
+// Load
+// ===================================================================
+
+enum Kind { KIND_IMU, KIND_TOF, KIND_HOUSEKEEPING, KIND_COUNT };
+
+static const char* kind_names[KIND_COUNT] = {"IMU drain", "ToF range", "housekeeping"};
+
+struct LoadState {
+  bool flat;                        // Everything at one priority
+  uint32_t imu_frames;              // FIFO frames per drain
+  std::mt19937* rng;
+  double stretch_p;
+  uint32_t waiting[KIND_COUNT];     // Submitted, not started
+  uint32_t inversions;              // Started with a more urgent kind waiting
+  uint32_t max_op_us[KIND_COUNT];
+  std::vector<uint32_t> wait_us[KIND_COUNT];
+  std::vector<uint32_t> done_us[KIND_COUNT];
+  uint32_t submitted[KIND_COUNT];
+  uint32_t rejected[KIND_COUNT];
+};
+
+static LoadState load;
+
+struct OpCtx {
+  int kind;
+  uint32_t submit_us;
+};
+
+static OpCtx op_ctx[KIND_COUNT][I2C_BUS_QUEUE_SIZE * 4];
+static uint32_t op_next[KIND_COUNT];
+
+// The firmware's driver calls, as transfers on the mock bus
+static I2CResult load_op(void* ctx) {
+  OpCtx& c = *(OpCtx*)ctx;
+  load.waiting[c.kind]--;
+  for (int k = 0; k < c.kind; k++) {
+    if (load.waiting[k] && !load.flat) load.inversions++;
+  }
+  load.wait_us[c.kind].push_back((uint32_t)mock.now - c.submit_us);
+  
+  uint64_t start = mock.now;
+  uint8_t tx[3] = {0};
+  uint8_t rx[128];
+  I2CResult r = I2C_OK;
+  switch (c.kind) {
+    case KIND_IMU:
+      // FIFO_COUNT, then the frames in bursts of 10
+      r = mock_transfer(nullptr, MPU_ADDR, tx, 1, rx, 2, 0);
+      for (uint32_t left = load.imu_frames; left > 0 && r == I2C_OK;) {
+        uint32_t n = left < 10 ? left : 10;
+        r = mock_transfer(nullptr, MPU_ADDR, tx, 1, rx, n * 12, 0);
+        left -= n;
+      }
+      break;
+    case KIND_TOF:
+      // Distance (16-bit register), then clear the interrupt
+      if (std::uniform_real_distribution<double>(0, 1)(*load.rng) < load.stretch_p) {
+        mock.stretch_us = 4000;
+      }
+      r = mock_transfer(nullptr, TOF_ADDR, tx, 2, rx, 2, 0);
+      if (r == I2C_OK) r = mock_transfer(nullptr, TOF_ADDR, tx, 3, nullptr, 0, 0);
+      break;
+    default:
+      r = mock_transfer(nullptr, MPU_ADDR, tx, 1, rx, 64, 0);
+      break;
+  }
+  uint32_t took = (uint32_t)(mock.now - start);
+  if (took > load.max_op_us[c.kind]) load.max_op_us[c.kind] = took;
+  return r;
+}
+
+static void load_done(const I2CTransaction& txn, I2CResult result) {
+  (void)result;
+  OpCtx& c = *(OpCtx*)txn.ctx;
+  load.done_us[c.kind].push_back((uint32_t)mock.now - c.submit_us);
+}
+
+static void load_arrive(const Arrival& a) {
+  static const I2CPriority prio[KIND_COUNT] = {I2C_PRIORITY_HIGH, I2C_PRIORITY_NORMAL, I2C_PRIORITY_LOW};
+  static const uint8_t addr[KIND_COUNT] = {MPU_ADDR, TOF_ADDR, MPU_ADDR};
+  OpCtx& c = op_ctx[a.kind][op_next[a.kind]++ % (I2C_BUS_QUEUE_SIZE * 4)];
+  c.kind = a.kind;
+  c.submit_us = (uint32_t)mock.now;
+  
+  I2CTransaction txn = {};
+  txn.address = addr[a.kind];
+  txn.priority = load.flat ? I2C_PRIORITY_NORMAL : prio[a.kind];
+  txn.op = load_op;
+  txn.done = load_done;
+  txn.ctx = &c;
+  load.submitted[a.kind]++;
+  if (i2c_bus_submit(txn)) {
+    load.waiting[a.kind]++;
+  } else {
+    load.rejected[a.kind]++;
+  }
+}
+
+static uint32_t percentile(std::vector<uint32_t> v, double p) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  return v[(size_t)(p * (v.size() - 1))];
+}
+
+static uint32_t run_load(const char* name, bool flat, uint32_t seconds, uint32_t imu_hz, uint32_t seed) {
+  std::mt19937 rng(seed);
+  mock_reset();
+  load = LoadState();
+  load.flat = flat;
+  load.rng = &rng;
+  load.stretch_p = 0.05;
+  load.imu_frames = imu_hz / 100;     // Drained every 10 ms
+  if (load.imu_frames == 0) load.imu_frames = 1;
+  memset(op_next, 0, sizeof(op_next));
+  
+  // ToF and housekeeping on their own clocks, not in step with the IMU
+  uint64_t end = (uint64_t)seconds * 1000000;
+  std::uniform_int_distribution<uint32_t> jitter(0, 9999);
+  for (uint64_t t = 10000; t < end; t += 10000) mock.arrivals.push_back({t, KIND_IMU});
+  for (uint64_t t = 0; t < end; t += 50000) mock.arrivals.push_back({t + jitter(rng), KIND_TOF});
+  for (uint64_t t = 0; t < end; t += 1000000) {
+    uint64_t at = t + jitter(rng) * 50;
+    for (int i = 0; i < HOUSEKEEPING_BURST; i++) mock.arrivals.push_back({at, KIND_HOUSEKEEPING});
+  }
+  std::stable_sort(mock.arrivals.begin(), mock.arrivals.end(),
+                   [](const Arrival& a, const Arrival& b) { return a.t_us < b.t_us; });
+  mock.arrive = load_arrive;
+  
+  // The worker: idle until something is submitted, then run it all
+  i2c_bus_reset_stats();
+  while (mock.next_arrival < mock.arrivals.size()) {
+    if (!i2c_bus_pending()) {
+      mock_advance(mock.arrivals[mock.next_arrival].t_us - mock.now);
+    }
+    i2c_bus_run();
+  }
+  I2CBusStats s = i2c_bus_get_stats();
+  uint8_t util = i2c_bus_utilization_pct();
+  
+  printf("%-7s %s, bus %u%% busy, %u priority inversions\n", name,
+         flat ? "one priority" : "by priority", util, load.inversions);
+  for (int k = 0; k < KIND_COUNT; k++) {
+    printf("        %-12s %6u submitted %3u rejected  wait p50 %5u p99 %5u max %5u us  done max %5u us\n",
+           kind_names[k], load.submitted[k], load.rejected[k], percentile(load.wait_us[k], 0.5),
+           percentile(load.wait_us[k], 0.99), percentile(load.wait_us[k], 1.0),
+           percentile(load.done_us[k], 1.0));
+  }
+  if (verbose) {
+    for (int p = 0; p < I2C_PRIORITY_COUNT; p++) {
+      printf("        prio %d: completed %u failed %u timeouts %u rejected %u max wait %u us mean %.0f us\n", p,
+             s.completed[p], s.failed[p], s.timeouts[p], s.rejected[p], s.max_wait_us[p],
+             s.completed[p] ? (double)s.total_wait_us[p] / s.completed[p] : 0.0);
+    }
+  }
+  
+  uint32_t completed = 0;
+  for (int p = 0; p < I2C_PRIORITY_COUNT; p++) completed += s.completed[p];
+  uint32_t started = 0;
+  for (int k = 0; k < KIND_COUNT; k++) started += load.wait_us[k].size();
+  expect(completed == started && started == load.done_us[0].size() + load.done_us[1].size() +
+         load.done_us[2].size(), name, "callbacks and stats disagree with the transactions run");
+  expect(s.busy_us == mock.wire_us, name, "busy time differs from time on the wire");
+  expect(load.inversions == 0, name, "a less urgent transaction started ahead of a waiting one");
+  if (!flat) {
+    // An IMU drain waits for at most the transaction already on the bus
+    uint32_t longest = std::max(load.max_op_us[KIND_TOF], load.max_op_us[KIND_HOUSEKEEPING]);
+    expect(percentile(load.wait_us[KIND_IMU], 1.0) <= longest, name,
+           "IMU drain waited behind more than one transaction");
+  }
+  return percentile(load.wait_us[KIND_IMU], 1.0);
+}
+
+// ===================================================================
+// Cost
+// ===================================================================
+
+static I2CResult null_transfer(void* ctx, uint8_t address, const uint8_t* tx, size_t tx_len,
+                               uint8_t* rx, size_t rx_len, uint32_t timeout_us) {
+  (void)ctx;
+  (void)address;
+  (void)tx;
+  (void)tx_len;
+  (void)rx;
+  (void)rx_len;
+  (void)timeout_us;
+  return I2C_OK;
+}
+
+static uint32_t steady_now(void* ctx) {
+  (void)ctx;
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void measure_cost() {
+  I2CBusBackend backend = {null_transfer, steady_now, nullptr, nullptr};
+  i2c_bus_init(backend);
+  I2CTransaction txn = make_txn(0, I2C_PRIORITY_HIGH, MPU_ADDR, 5000);
+  txn.done = nullptr;
+  const int rounds = 200000;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    txn.priority = (I2CPriority)(i % I2C_PRIORITY_COUNT);
+    i2c_bus_submit(txn);
+    if (i % 4 == 3) i2c_bus_run();
+  }
+  i2c_bus_run();
+  auto t1 = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / rounds;
+  printf("cost    %.0f ns a transaction to queue and dispatch (host, zero-time backend)\n", ns);
+}
+
+int main(int argc, char** argv) {
+  uint32_t seconds = 60;
+  uint32_t imu_hz = 1000;
+  uint32_t seed = 1;
+  
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+      seconds = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--imu-hz") && i + 1 < argc) {
+      imu_hz = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "-v")) {
+      verbose = true;
+    } else {
+      fprintf(stderr, "usage: %s [--seconds N] [--imu-hz N] [--seed N] [-v]\n", argv[0]);
+      return 1;
+    }
+  }
+  
+  printf("400 kHz mock bus, %d-slot queues, IMU at %u Hz drained every 10 ms\n\n", I2C_BUS_QUEUE_SIZE, imu_hz);
+  scenario_unit();
+  scenario_abandon();
+  uint32_t prio_wait = run_load("load", false, seconds, imu_hz, seed);
+  uint32_t flat_wait = run_load("flat", true, seconds, imu_hz, seed);
+  printf("        worst IMU drain wait %u us by priority, %u us at one priority\n", prio_wait, flat_wait);
+  measure_cost();
+  
+  printf("%s\n", failures ? "FAIL" : "ok");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,414 @@
+// ===================================================================
+// IMU Stream Codec Benchmark (host)
+// ===================================================================
+// Streams raw 6-axis IMU traces through the firmware's notification
+// batch (src/telemetry_batch) as raw IMU frames and as delta frames
+// (keyframe + zigzag varint deltas, src/telemetry_frame), decodes every
+// notification with the reference decoder and reports, per trace kind:
+// bytes per sample, compression ratio against raw frames, notifications
+// per second and encode cycles per sample. Decoding must give back
+// every sample exactly. It then drops --loss of the notifications and
+// checks that the decoder resyncs at the next frame: every sample of a
+// delivered notification is exact and each gap shows in the sequence.
+//
+// Synthetic traces (--traces N of each kind at --rate Hz) have MPU6050
+// noise at +/-8 g, +/-500 deg/s: cane walking with heel strikes, a fall
+// (walk, tumble, impact, lying still) and standing still. Recorded
+// traces use fall_replay.cpp's formats:
+//   *.csv   t_ms,ax,ay,az[,gx,gy,gz][,...]   g and deg/s (gait_replay
+//           recordings, without gyro, load too)
+//   *.ftr   "FALLTRC1", then 18-byte records (see fall_replay.cpp)
+// Cycles are host TSC ticks through telemetry_batch_add_imu(), so they
+// compare the two codecs rather than predict the ESP32's count.
+//
+//   g++ -O2 -std=c++17 -Isrc tools/imu_codec_bench.cpp src/telemetry_frame.cpp src/telemetry_batch.cpp -o imu_codec_bench
+//   ./imu_codec_bench [--traces N] [--rate HZ] [--mtu N] [--loss P] [--seed N] [trace.csv|trace.ftr ...]
+// ===================================================================
+
+#include "telemetry_batch.h"
+#include "telemetry_frame.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define LSB_PER_G        4096.0f   // MPU6050 at +/-8 g
+#define LSB_PER_DPS      65.5f     // and +/-500 deg/s
+#define ACCEL_NOISE_G    0.0035f   // rms, 400 ug/sqrt(Hz) over the 44 Hz DLPF
+#define GYRO_NOISE_DPS   0.04f
+#define LOOP_MS          10        // Sensing task cycle: samples arrive in bursts
+
+#define TRACE_MAGIC      "FALLTRC1"
+#define TRACE_RECORD     18
+
+struct Trace {
+  std::string name;
+  std::string kind;
+  uint8_t period_ms;
+  std::vector<TelemetryImuSample> samples;
+};
+
+static int16_t counts(float v, float lsb) {
+  float c = v * lsb;
+  if (c > 32767.0f) return 32767;
+  if (c < -32768.0f) return -32768;
+  return (int16_t)std::lround(c);
+}
+
+static uint64_t cycles_now() {
+#ifdef HAVE_TSC
+  return __rdtsc();
+#else
+  auto ns = std::chrono::steady_clock::now().time_since_epoch();
+  return (uint64_t)(std::chrono::duration<double, std::nano>(ns).count() * 3.0);
+#endif
+}
+
+// ===================================================================
+// Trace Loading
+// ===================================================================
+
+static bool ends_with(const std::string& s, const char* suffix) {
+  size_t n = strlen(suffix);
+  return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+static bool load_csv(const std::string& path, Trace& trace) {
+  FILE* f = fopen(path.c_str(), "r");
+  if (!f) return false;
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == '#') continue;
+    unsigned t;
+    float v[6] = {0};
+    int n = sscanf(line, "%u,%f,%f,%f,%f,%f,%f", &t, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]);
+    if (n < 4) continue;
+    if (n < 7) v[3] = v[4] = v[5] = 0;   // No gyro (or a label column)
+    TelemetryImuSample s;
+    s.t_ms = t;
+    for (int i = 0; i < 6; i++) s.v[i] = counts(v[i], i < 3 ? LSB_PER_G : LSB_PER_DPS);
+    trace.samples.push_back(s);
+  }
+  fclose(f);
+  return true;
+}
+
+static bool load_binary(const std::string& path, Trace& trace) {
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f) return false;
+  char magic[8];
+  bool ok = fread(magic, 1, 8, f) == 8 && memcmp(magic, TRACE_MAGIC, 8) == 0;
+  uint8_t rec[TRACE_RECORD];
+  while (ok && fread(rec, 1, TRACE_RECORD, f) == TRACE_RECORD) {
+    TelemetryImuSample s;
+    s.t_ms = rec[0] | rec[1] << 8 | rec[2] << 16 | (uint32_t)rec[3] << 24;
+    for (int i = 0; i < 6; i++) s.v[i] = (int16_t)(rec[4 + 2 * i] | rec[5 + 2 * i] << 8);
+    trace.samples.push_back(s);
+  }
+  fclose(f);
+  return ok;
+}
+
+static bool load_trace(const std::string& path, Trace& trace) {
+  trace.name = path;
+  trace.kind = "recorded";
+  bool ok = ends_with(path, ".ftr") ? load_binary(path, trace) : load_csv(path, trace);
+  if (!ok || trace.samples.size() < 2) return false;
+  // Sample period from the median step
+  std::vector<uint32_t> steps;
+  for (size_t i = 1; i < trace.samples.size(); i++) {
+    steps.push_back(trace.samples[i].t_ms - trace.samples[i - 1].t_ms);
+  }
+  std::nth_element(steps.begin(), steps.begin() + steps.size() / 2, steps.end());
+  uint32_t period = steps[steps.size() / 2];
+  trace.period_ms = period == 0 ? 1 : period > 255 ? 255 : period;
+  return true;
+}
+
+// ===================================================================
+// Synthesis
+// ===================================================================
+
+struct Synth {
+  Trace trace;
+  std::mt19937 rng;
+  uint32_t t = 0;
+  float pitch = 0.2f;       // Cane angle from vertical (rad), swing plane
+  float roll = 0.0f;
+  float rate_hz;
+  
+  Synth(uint32_t seed, float rate) : rng(seed), rate_hz(rate) {}
+  
+  float uniform(float lo, float hi) { return std::uniform_real_distribution<float>(lo, hi)(rng); }
+  float gauss(float sd) { return std::normal_distribution<float>(0.0f, sd)(rng); }
+  
+  // Gravity seen through the current tilt, plus linear acceleration
+  // (g) and body rates (deg/s)
+  void emit(float lin_z, float lin_x, float gx, float gy, float gz) {
+    float g = 1.0f + lin_z;
+    float v[6] = {
+      g * std::sin(pitch) + lin_x + gauss(ACCEL_NOISE_G),
+      g * std::sin(roll) * std::cos(pitch) + gauss(ACCEL_NOISE_G),
+      g * std::cos(pitch) * std::cos(roll) + gauss(ACCEL_NOISE_G),
+      gx + gauss(GYRO_NOISE_DPS), gy + gauss(GYRO_NOISE_DPS), gz + gauss(GYRO_NOISE_DPS)
+    };
+    TelemetryImuSample s;
+    s.t_ms = t;
+    for (int i = 0; i < 6; i++) s.v[i] = counts(v[i], i < 3 ? LSB_PER_G : LSB_PER_DPS);
+    trace.samples.push_back(s);
+    t += trace.period_ms;
+  }
+  
+  uint32_t n(float seconds) { return (uint32_t)(seconds * rate_hz); }
+  
+  void still(float seconds) {
+    for (uint32_t i = 0; i < n(seconds); i++) emit(0, 0, 0, 0, 0);
+  }
+  
+  // The cane swings forward each step and lands with a heel strike
+  void walk(float seconds) {
+    float stride_s = uniform(0.9f, 1.3f);
+    float amp = uniform(0.15f, 0.3f);
+    float base = pitch;
+    for (uint32_t i = 0; i < n(seconds); i++) {
+      float ph = 2.0f * (float)M_PI * i / (stride_s * rate_hz);
+      float prev = pitch;
+      pitch = base + amp * std::sin(ph);
+      roll = 0.05f * std::sin(0.5f * ph);
+      float rate_dps = (pitch - prev) * rate_hz * 57.3f;
+      float strike = std::fmod(ph, 2.0f * (float)M_PI) < 0.3f ? uniform(0.3f, 0.8f) : 0.0f;
+      emit(0.15f * std::sin(2 * ph) + strike, 0.1f * std::cos(ph), 3.0f * std::sin(0.5f * ph), rate_dps,
+           5.0f * std::sin(ph + 1.0f));
+    }
+    pitch = base;
+  }
+  
+  // Tumble, impact, then lying on the floor
+  void fall() {
+    float from = pitch, to = uniform(1.3f, 1.6f);
+    uint32_t tumble = n(0.6f);
+    for (uint32_t i = 0; i < tumble; i++) {
+      float prev = pitch;
+      pitch = from + (to - from) * i / tumble;
+      float rate_dps = (pitch - prev) * rate_hz * 57.3f;
+      emit(-0.7f, 0.2f, uniform(-40, 40), rate_dps, uniform(-60, 60));
+    }
+    float peak = uniform(3.0f, 6.0f);
+    uint32_t impact = n(0.08f);
+    for (uint32_t i = 0; i < impact; i++) {
+      float decay = std::exp(-5.0f * i / impact);
+      emit(peak * decay * (i % 2 ? -0.6f : 1.0f), 0.5f * peak * decay, uniform(-150, 150) * decay,
+           uniform(-150, 150) * decay, uniform(-150, 150) * decay);
+    }
+    still(5.0f);
+  }
+};
+
+static Trace synthetic_trace(const char* kind, uint32_t seed, float rate) {
+  Synth s(seed, rate);
+  s.trace.kind = kind;
+  s.trace.name = std::string(kind) + "-" + std::to_string(seed);
+  s.trace.period_ms = (uint8_t)std::lround(1000.0f / rate);
+  if (!strcmp(kind, "walking")) {
+    s.walk(s.uniform(20, 40));
+  } else if (!strcmp(kind, "fall")) {
+    s.walk(s.uniform(3, 6));
+    s.fall();
+  } else {
+    s.still(s.uniform(10, 20));
+  }
+  return s.trace;
+}
+
+// ===================================================================
+// Encode and Decode
+// ===================================================================
+
+struct Sink {
+  std::vector<std::vector<uint8_t>> sent;
+};
+
+static void sink_send(const uint8_t* data, size_t len, void* ctx) {
+  ((Sink*)ctx)->sent.emplace_back(data, data + len);
+}
+
+struct CodecResult {
+  uint64_t samples = 0;
+  uint64_t bytes = 0;
+  uint64_t notifications = 0;
+  double seconds = 0;
+  double cycles = 0;
+  uint64_t mismatched = 0;   // Lossless decode
+  // With notifications dropped
+  uint64_t dropped = 0;
+  uint64_t lost_samples = 0;
+  uint64_t gaps_seen = 0;
+  uint64_t resync_bad = 0;   // Delivered samples that decoded wrong
+};
+
+// Samples arrive a sensing cycle at a time, as sensing_pop_imu_stream()
+// hands them to ble_stream_imu()
+static Sink encode(const Trace& trace, TelemetryFrameType type, uint16_t mtu, double& cycles) {
+  Sink sink;
+  static TelemetryBatch batch;
+  telemetry_batch_init(batch, sink_send, &sink);
+  telemetry_batch_set_mtu(batch, mtu);
+  telemetry_batch_set_imu_type(batch, type);
+  uint64_t spent = 0;
+  size_t i = 0;
+  uint32_t t0 = trace.samples.front().t_ms;
+  for (uint32_t now = t0; i < trace.samples.size(); now += LOOP_MS) {
+    uint64_t c0 = cycles_now();
+    while (i < trace.samples.size() && (int32_t)(trace.samples[i].t_ms - now) < LOOP_MS) {
+      telemetry_batch_add_imu(batch, trace.samples[i++], trace.period_ms, now);
+    }
+    spent += cycles_now() - c0;
+    telemetry_batch_service(batch, now);
+  }
+  telemetry_batch_flush(batch);
+  cycles = (double)spent;
+  return sink;
+}
+
+// Decodes the notifications kept (all, or those not dropped) and checks
+// each sample against the trace by position in the stream
+static void decode(const Trace& trace, const Sink& sink, const std::vector<bool>& keep, CodecResult& r,
+                   bool lossy) {
+  TelemetryImuSample got[255];
+  size_t next = 0;          // Index in the trace of the next sample sent
+  int32_t last_seq = -1;
+  for (size_t k = 0; k < sink.sent.size(); k++) {
+    const std::vector<uint8_t>& n = sink.sent[k];
+    size_t at = 0;
+    while (at < n.size()) {
+      size_t count = 0;
+      uint16_t seq;
+      size_t used = telemetry_decode_imu(n.data() + at, n.size() - at, got, 255, count, seq);
+      if (!used) {
+        r.mismatched++;
+        break;
+      }
+      if (keep[k]) {
+        if (last_seq >= 0 && ((seq - last_seq - 1) & 0xFFFF)) r.gaps_seen++;
+        last_seq = seq;
+        for (size_t j = 0; j < count; j++) {
+          const TelemetryImuSample& want = trace.samples[next + j];
+          bool same = next + j < trace.samples.size() && !memcmp(got[j].v, want.v, sizeof(want.v));
+          if (!same) (lossy ? r.resync_bad : r.mismatched)++;
+        }
+      } else {
+        r.lost_samples += count;
+      }
+      next += count;
+      at += used;
+    }
+  }
+  if (!lossy) r.mismatched += trace.samples.size() - (next < trace.samples.size() ? next : trace.samples.size());
+}
+
+static void run_codec(const Trace& trace, TelemetryFrameType type, uint16_t mtu, double loss, std::mt19937& rng,
+                      CodecResult& r) {
+  double cycles;
+  Sink sink = encode(trace, type, mtu, cycles);
+  r.samples += trace.samples.size();
+  r.cycles += cycles;
+  r.notifications += sink.sent.size();
+  r.seconds += trace.samples.size() * trace.period_ms / 1000.0;
+  for (const std::vector<uint8_t>& n : sink.sent) r.bytes += n.size();
+  
+  std::vector<bool> keep(sink.sent.size(), true);
+  decode(trace, sink, keep, r, false);
+  
+  // The first notification is always kept so gaps are measurable
+  std::bernoulli_distribution drop(loss);
+  for (size_t k = 1; k < keep.size(); k++) {
+    keep[k] = !drop(rng);
+    r.dropped += !keep[k];
+  }
+  decode(trace, sink, keep, r, true);
+}
+
+// ===================================================================
+// Main
+// ===================================================================
+
+int main(int argc, char** argv) {
+  int count = 10;
+  float rate = 100.0f;
+  uint16_t mtu = 247;
+  double loss = 0.02;
+  uint32_t seed = 1;
+  std::vector<Trace> traces;
+  
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--traces") && i + 1 < argc) {
+      count = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--rate") && i + 1 < argc) {
+      rate = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--mtu") && i + 1 < argc) {
+      mtu = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--loss") && i + 1 < argc) {
+      loss = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = strtoul(argv[++i], nullptr, 10);
+    } else {
+      Trace trace;
+      if (!load_trace(argv[i], trace)) {
+        fprintf(stderr, "cannot read %s\n", argv[i]);
+        return 1;
+      }
+      traces.push_back(trace);
+    }
+  }
+  if (rate < 1.0f || rate > 1000.0f) rate = 100.0f;
+  if (traces.empty()) {
+    const char* kinds[] = {"walking", "fall", "still"};
+    for (const char* kind : kinds) {
+      for (int i = 0; i < count; i++) traces.push_back(synthetic_trace(kind, seed * 1000 + i, rate));
+    }
+  }
+  
+  std::vector<std::string> kinds;
+  for (const Trace& t : traces) {
+    bool seen = false;
+    for (const std::string& k : kinds) seen |= k == t.kind;
+    if (!seen) kinds.push_back(t.kind);
+  }
+  
+  printf("MTU %u, %.0f Hz, %.0f%% of notifications dropped for the resync check\n\n", mtu, rate, loss * 100);
+  printf("kind       codec   samples  B/sample  ratio  notify/s  cycles/sample  exact  resync (lost/gaps/bad)\n");
+  bool ok = true;
+  std::mt19937 rng(seed);
+  for (const std::string& kind : kinds) {
+    CodecResult raw, delta;
+    for (const Trace& t : traces) {
+      if (t.kind != kind) continue;
+      run_codec(t, TELEMETRY_FRAME_IMU, mtu, loss, rng, raw);
+      run_codec(t, TELEMETRY_FRAME_IMU_DELTA, mtu, loss, rng, delta);
+    }
+    const CodecResult* rs[2] = {&raw, &delta};
+    const char* names[2] = {"raw", "delta"};
+    for (int c = 0; c < 2; c++) {
+      const CodecResult& r = *rs[c];
+      double per = r.samples ? (double)r.bytes / r.samples : 0;
+      printf("%-9s  %-5s  %8llu  %8.2f  %5.2f  %8.1f  %13.1f  %5s  %llu/%llu/%llu\n", kind.c_str(), names[c],
+             (unsigned long long)r.samples, per, r.bytes ? (double)raw.bytes / r.bytes : 0,
+             r.seconds ? r.notifications / r.seconds : 0, r.samples ? r.cycles / r.samples : 0,
+             r.mismatched ? "NO" : "yes", (unsigned long long)r.lost_samples, (unsigned long long)r.gaps_seen,
+             (unsigned long long)r.resync_bad);
+      ok &= r.mismatched == 0 && r.resync_bad == 0 && r.gaps_seen >= (r.dropped ? 1 : 0);
+    }
+  }
+  printf("\nraw samples are %d bytes before framing; %s\n", TELEMETRY_IMU_SAMPLE_BYTES, ok ? "ok" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+// ===================================================================
+// IMU Feature Window Check and Benchmark (host)
+// ===================================================================
+// Feeds a synthetic accelerometer stream through ImuFeatureWindow<N>
+// (src/imu_features), checks every feature against a brute-force
+// recompute over the same window, then times push() for window lengths
+// from 16 to 4096 samples. Per-sample cost should not grow with N.
+//
+//   g++ -O2 -std=c++17 -Isrc tools/imu_feature_bench.cpp src/imu_features.cpp -o imu_feature_bench
+//   ./imu_feature_bench
+// ===================================================================
+
+#include "imu_features.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#define LSB_PER_G 4096.0f
+#define RATE_HZ   100.0f
+
+struct RawSample {
+  int16_t ax, ay, az;
+};
+
+// Walking, with a stumble and a tilt every few seconds
+static std::vector<RawSample> make_stream(size_t count, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<float> noise(0.0f, 0.05f);
+  std::vector<RawSample> stream;
+  for (size_t i = 0; i < count; i++) {
+    float t = i / RATE_HZ;
+    float tilt = (i / 400) % 2 ? 0.6f : 0.0f;
+    float ax = std::sin(tilt) + noise(rng);
+    float ay = 0.2f * std::sin(t * 6.0f) + noise(rng);
+    float az = std::cos(tilt) + 0.3f * std::sin(t * 12.0f) + noise(rng);
+    if (i % 977 == 0) ax += 3.0f;
+    stream.push_back({(int16_t)std::lround(ax * LSB_PER_G), (int16_t)std::lround(ay * LSB_PER_G),
+                      (int16_t)std::lround(az * LSB_PER_G)});
+  }
+  return stream;
+}
+
+// ===================================================================
+// Brute-Force Reference
+// ===================================================================
+
+static ImuFeatures reference(const std::vector<ImuFeatureSample>& s, size_t end, size_t n) {
+  ImuFeatures f = {};
+  size_t begin = end - n;
+  double sum = 0, sum_sq = 0, jerk = 0, sma = 0;
+  uint16_t lo = 65535, hi = 0, jerk_hi = 0;
+  double old_v[3] = {0, 0, 0}, new_v[3] = {0, 0, 0};
+  for (size_t i = begin; i < end; i++) {
+    sum += s[i].mag_mg;
+    sum_sq += (double)s[i].mag_mg * s[i].mag_mg;
+    jerk += s[i].jerk_mg;
+    sma += s[i].sma_mg;
+    if (s[i].mag_mg < lo) lo = s[i].mag_mg;
+    if (s[i].mag_mg > hi) hi = s[i].mag_mg;
+    if (s[i].jerk_mg > jerk_hi) jerk_hi = s[i].jerk_mg;
+    double* half = (i - begin) < n / 2 ? old_v : new_v;
+    half[0] += s[i].ax;
+    half[1] += s[i].ay;
+    half[2] += s[i].az;
+  }
+  f.samples = (uint16_t)n;
+  f.mean_g = (float)(sum / n / 1000.0);
+  f.std_g = (float)(std::sqrt(std::fmax(0.0, sum_sq / n - (sum / n) * (sum / n))) / 1000.0);
+  f.min_g = lo / 1000.0f;
+  f.max_g = hi / 1000.0f;
+  f.jerk_mean_g_s = (float)(jerk / n * RATE_HZ / 1000.0);
+  f.jerk_max_g_s = jerk_hi * RATE_HZ / 1000.0f;
+  f.sma_g = (float)(sma / n / 1000.0);
+  double dot = old_v[0] * new_v[0] + old_v[1] * new_v[1] + old_v[2] * new_v[2];
+  double na = std::sqrt(old_v[0] * old_v[0] + old_v[1] * old_v[1] + old_v[2] * old_v[2]);
+  double nb = std::sqrt(new_v[0] * new_v[0] + new_v[1] * new_v[1] + new_v[2] * new_v[2]);
+  f.tilt_deg = (float)(std::acos(std::fmax(-1.0, std::fmin(1.0, dot / (na * nb)))) * 180.0 / M_PI);
+  return f;
+}
+
+static bool close(float a, float b, float tol) {
+  return std::fabs(a - b) <= tol * std::fmax(1.0f, std::fabs(b));
+}
+
+template <uint16_t N>
+static bool check(const std::vector<RawSample>& stream) {
+  ImuFeatureWindow<N> window;
+  window.reset();
+  std::vector<ImuFeatureSample> samples;
+  for (size_t i = 0; i < stream.size(); i++) {
+    const RawSample& r = stream[i];
+    samples.push_back(imu_feature_sample(r.ax, r.ay, r.az, i ? &samples.back() : nullptr, LSB_PER_G));
+    window.push(samples.back(), (uint32_t)i * 10);
+    if (i + 1 < N || i % 37 != 0) continue;
+    
+    ImuFeatures got = window.features(RATE_HZ);
+    ImuFeatures want = reference(samples, i + 1, N);
+    if (got.samples != want.samples || got.min_g != want.min_g || got.max_g != want.max_g ||
+        got.jerk_max_g_s != want.jerk_max_g_s || !close(got.mean_g, want.mean_g, 1e-5f) ||
+        !close(got.std_g, want.std_g, 1e-3f) || !close(got.jerk_mean_g_s, want.jerk_mean_g_s, 1e-5f) ||
+        !close(got.sma_g, want.sma_g, 1e-5f) || std::fabs(got.tilt_deg - want.tilt_deg) > 0.05f) {
+      printf("N=%u sample %zu: mismatch (mean %.5f/%.5f std %.5f/%.5f tilt %.3f/%.3f)\n", N, i,
+             got.mean_g, want.mean_g, got.std_g, want.std_g, got.tilt_deg, want.tilt_deg);
+      return false;
+    }
+  }
+  return true;
+}
+
+// ===================================================================
+// Timing
+// ===================================================================
+
+template <uint16_t N>
+static void time_window(const std::vector<ImuFeatureSample>& samples) {
+  static ImuFeatureWindow<N> window;
+  window.reset();
+  float sink = 0;
+  
+  auto t0 = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < samples.size(); i++) {
+    window.push(samples[i], (uint32_t)i);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  sink += window.features(RATE_HZ).mean_g;
+  
+  double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / samples.size();
+  printf("  N=%-5u push %6.2f ns/sample  (features() %s)\n", N, ns, sink > 0 ? "ok" : "?");
+}
+
+int main() {
+  std::vector<RawSample> stream = make_stream(20000, 1);
+  if (!check<16>(stream) || !check<64>(stream) || !check<256>(stream) || !check<1024>(stream)) {
+    printf("FAIL\n");
+    return 1;
+  }
+  printf("features match brute force for N = 16, 64, 256, 1024\n");
+  
+  std::vector<RawSample> long_stream = make_stream(2000000, 2);
+  std::vector<ImuFeatureSample> samples;
+  samples.reserve(long_stream.size());
+  for (size_t i = 0; i < long_stream.size(); i++) {
+    const RawSample& r = long_stream[i];
+    samples.push_back(imu_feature_sample(r.ax, r.ay, r.az, i ? &samples.back() : nullptr, LSB_PER_G));
+  }
+  
+  printf("push() cost, %zu samples\n", samples.size());
+  time_window<16>(samples);
+  time_window<64>(samples);
+  time_window<256>(samples);
+  time_window<1024>(samples);
+  time_window<4096>(samples);
+  return 0;
+}
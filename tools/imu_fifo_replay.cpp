@@ -0,0 +1,337 @@
+// ===================================================================
+// IMU FIFO Replay (host)
+// ===================================================================
+// Replays an MPU6050 byte stream through the firmware's FIFO drain
+// (src/imu_fifo) on a virtual clock. A fake FIFO stands in for the
+// chip: it appends one 12-byte frame per sample period, holds at most
+// 1 KB and overwrites its oldest bytes when full, as the MPU6050 does.
+// Each frame encodes its sample number and a check word, so every
+// sample that reaches the ring can be checked for order, garbling and
+// timestamp error against its true capture time.
+//   steady     100 Hz and 1 kHz, drained every --drain ms: no loss
+//   partial    FIFO_COUNT read while a frame is half written: whole
+//              frames drained, the half frame left for the next poll,
+//              nothing lost and no reset
+//   overflow   the drain stalls long enough for the FIFO to wrap
+//   bus        burst reads that fail part way through
+//   ring       a consumer too slow for the sample ring
+// After a fault the drain must resync: frames it throws away are
+// accounted for, and nothing garbled or out of order is delivered.
+// Also reports I2C transactions per sample against one getEvent() each.
+//
+//   g++ -O2 -std=c++17 -Isrc tools/imu_fifo_replay.cpp src/imu_fifo.cpp -o imu_fifo_replay
+//   ./imu_fifo_replay [--seconds N] [--drain MS] [--seed N] [-v]
+// ===================================================================
+
+#include "imu_fifo.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <vector>
+
+static bool verbose = false;
+
+// ===================================================================
+// Fake FIFO
+// ===================================================================
+
+struct FifoByte {
+  uint32_t frame;
+  uint8_t value;
+};
+
+struct FakeFifo {
+  std::deque<FifoByte> bytes;
+  std::vector<uint8_t> discarded;   // Per frame: bytes thrown away
+  uint32_t produced = 0;            // Frames started
+  bool half_written = false;        // Newest frame has only 6 bytes in
+  
+  // Faults
+  std::mt19937* rng = nullptr;
+  double partial_p = 0;             // FIFO_COUNT catches a frame half written
+  double read_fail_p = 0;           // Burst read fails part way
+  
+  uint32_t count_reads = 0;
+  uint32_t partial_counts = 0;
+  uint32_t failed_reads = 0;
+  uint32_t resets = 0;
+};
+
+static void frame_bytes(uint32_t k, uint8_t* out) {
+  int16_t v[6];
+  v[0] = (int16_t)(k & 0xFFFF);
+  v[1] = (int16_t)(k >> 16);
+  v[2] = (int16_t)~(v[0] ^ v[1]);
+  v[3] = (int16_t)(v[0] * 3 + v[1]);
+  v[4] = (int16_t)(k * 2654435761u >> 16);
+  v[5] = (int16_t)(v[4] ^ 0x5A5A);
+  for (int i = 0; i < 6; i++) {
+    out[2 * i] = (uint8_t)((uint16_t)v[i] >> 8);
+    out[2 * i + 1] = (uint8_t)v[i];
+  }
+}
+
+// The frame number a sample carries, or -1 if it is not one frame
+static int64_t frame_of(const ImuRawSample& s) {
+  uint32_t k = (uint16_t)s.ax | ((uint32_t)(uint16_t)s.ay << 16);
+  uint8_t b[12];
+  frame_bytes(k, b);
+  ImuRawSample expect;
+  imu_fifo_decode(b, expect);
+  if (s.az != expect.az || s.gx != expect.gx || s.gy != expect.gy || s.gz != expect.gz) return -1;
+  return k;
+}
+
+static void fifo_discard_front(FakeFifo& f) {
+  f.discarded[f.bytes.front().frame] = 1;
+  f.bytes.pop_front();
+}
+
+static void fifo_append(FakeFifo& f, uint32_t k, int from, int to) {
+  uint8_t b[12];
+  frame_bytes(k, b);
+  for (int i = from; i < to; i++) {
+    if (f.bytes.size() >= MPU6050_FIFO_SIZE) fifo_discard_front(f);
+    f.bytes.push_back({k, b[i]});
+  }
+}
+
+// One sample period: the chip writes the next frame
+static void fifo_produce(FakeFifo& f) {
+  if (f.half_written) {
+    fifo_append(f, f.produced - 1, 6, 12);
+    f.half_written = false;
+  }
+  f.discarded.push_back(0);
+  fifo_append(f, f.produced++, 0, 12);
+}
+
+static int fake_count(void* ctx) {
+  FakeFifo& f = *(FakeFifo*)ctx;
+  f.count_reads++;
+  if (!f.half_written && f.partial_p > 0 && std::uniform_real_distribution<double>(0, 1)(*f.rng) < f.partial_p) {
+    // The next sample lands mid-read: half of it is in the count
+    f.discarded.push_back(0);
+    fifo_append(f, f.produced++, 0, 6);
+    f.half_written = true;
+    f.partial_counts++;
+  }
+  return (int)(f.bytes.size() < MPU6050_FIFO_SIZE ? f.bytes.size() : MPU6050_FIFO_SIZE);
+}
+
+static bool fake_read(void* ctx, uint8_t* buf, size_t len) {
+  FakeFifo& f = *(FakeFifo*)ctx;
+  size_t n = len;
+  bool fail = f.read_fail_p > 0 && std::uniform_real_distribution<double>(0, 1)(*f.rng) < f.read_fail_p;
+  if (fail) {
+    n = std::uniform_int_distribution<size_t>(0, len - 1)(*f.rng);
+    f.failed_reads++;
+  }
+  for (size_t i = 0; i < n && !f.bytes.empty(); i++) {
+    buf[i] = f.bytes.front().value;
+    // Clocked out but never delivered
+    if (fail) f.discarded[f.bytes.front().frame] = 1;
+    f.bytes.pop_front();
+  }
+  return !fail;
+}
+
+static void fake_reset(void* ctx) {
+  FakeFifo& f = *(FakeFifo*)ctx;
+  while (!f.bytes.empty()) fifo_discard_front(f);
+  if (f.half_written) {
+    f.discarded[f.produced - 1] = 1;
+    f.half_written = false;
+  }
+  f.resets++;
+}
+
+// ===================================================================
+// Replay
+// ===================================================================
+
+struct Run {
+  const char* name;
+  uint32_t rate_hz;
+  double partial_p;
+  double read_fail_p;
+  uint32_t stall_every_ms;          // Drain skipped for stall_ms this often
+  uint32_t stall_ms;
+  uint32_t pop_every_ms;            // Consumer period (0: every drain)
+};
+
+struct Result {
+  uint32_t produced;
+  uint32_t delivered;
+  uint32_t garbled;
+  uint32_t out_of_order;
+  uint32_t duplicates;
+  uint32_t discarded;
+  uint32_t queued;                  // Whole frames left in the FIFO
+  uint32_t max_ts_err_us;
+  ImuFifoStats stats;
+  uint32_t partial_counts;
+  uint32_t failed_reads;
+  uint32_t resets;
+};
+
+static Result replay(const Run& run, uint32_t seconds, uint32_t drain_ms, std::mt19937& rng) {
+  FakeFifo f;
+  f.rng = &rng;
+  f.partial_p = run.partial_p;
+  f.read_fail_p = run.read_fail_p;
+  
+  uint32_t period_us = 1000000 / run.rate_hz;
+  ImuFifo fifo;
+  ImuFifoBus bus = {fake_count, fake_read, fake_reset, &f};
+  imu_fifo_init(fifo, bus, period_us);
+  static ImuSampleRing ring;
+  ring.clear();
+  
+  Result r = {};
+  int64_t last = -1;
+  uint32_t end_us = seconds * 1000000u;
+  uint32_t next_drain = drain_ms * 1000;
+  uint32_t next_pop = 0;
+  
+  // Frame k is captured at (k + 1) * period_us
+  for (uint32_t now = 0; now <= end_us; now += 100) {
+    while ((uint64_t)(f.produced + 1) * period_us <= now) fifo_produce(f);
+    bool last_pass = now + 100 > end_us;
+    if (now < next_drain && !last_pass) continue;
+    // The sensing task wakes up to 2 ms late
+    next_drain = now + drain_ms * 1000 + std::uniform_int_distribution<uint32_t>(0, 20)(rng) * 100;
+    
+    bool stalled = run.stall_every_ms && now % (run.stall_every_ms * 1000) < run.stall_ms * 1000;
+    if (!stalled) imu_fifo_drain(fifo, now, ring);
+    
+    if (run.pop_every_ms && now < next_pop && !last_pass) continue;
+    next_pop = now + run.pop_every_ms * 1000;
+    ImuRawSample s;
+    while (ring.pop(s)) {
+      int64_t k = frame_of(s);
+      if (k < 0) {
+        r.garbled++;
+        continue;
+      }
+      if (k == last) r.duplicates++;
+      else if (k < last) r.out_of_order++;
+      last = k;
+      r.delivered++;
+      if (f.discarded[k]) r.garbled++;   // Delivered and thrown away
+      
+      uint32_t truth = (uint32_t)(k + 1) * period_us;
+      uint32_t err = s.t_us > truth ? s.t_us - truth : truth - s.t_us;
+      if (err > r.max_ts_err_us) r.max_ts_err_us = err;
+    }
+  }
+  
+  r.produced = f.produced - (f.half_written ? 1 : 0);
+  for (uint32_t k = 0; k < r.produced; k++) r.discarded += f.discarded[k];
+  std::vector<uint8_t> seen(f.produced, 0);
+  for (const FifoByte& b : f.bytes) {
+    if (!seen[b.frame] && !f.discarded[b.frame] && b.frame < r.produced) r.queued++;
+    seen[b.frame] = 1;
+  }
+  r.stats = fifo.stats;
+  r.partial_counts = f.partial_counts;
+  r.failed_reads = f.failed_reads;
+  r.resets = f.resets;
+  return r;
+}
+
+// ===================================================================
+// Checks
+// ===================================================================
+
+static int failures = 0;
+
+static void expect(bool ok, const char* run, const char* what) {
+  if (ok) return;
+  printf("  FAIL %s: %s\n", run, what);
+  failures++;
+}
+
+static void check(const Run& run, const Result& r, bool lossless) {
+  const ImuFifoStats& s = r.stats;
+  uint32_t period_us = 1000000 / run.rate_hz;
+  printf("%-9s %5u Hz  frames %7u  delivered %7u  discarded %5u  ring drops %5u  resets %4u  "
+         "ts err %4u us  xfers/sample %.3f\n",
+         run.name, run.rate_hz, r.produced, r.delivered, r.discarded, s.dropped, r.resets,
+         r.max_ts_err_us, r.delivered ? (double)(s.count_reads + s.bursts) / r.delivered : 0.0);
+  if (verbose) {
+    printf("          count reads %u  bursts %u  overflows %u  bus errors %u  partial counts %u  "
+           "failed reads %u\n", s.count_reads, s.bursts, s.overflows, s.bus_errors, r.partial_counts,
+           r.failed_reads);
+  }
+  
+  expect(r.garbled == 0, run.name, "garbled or discarded frame delivered");
+  expect(r.out_of_order == 0 && r.duplicates == 0, run.name, "samples out of order or repeated");
+  expect(r.max_ts_err_us < period_us, run.name, "timestamp off by a sample period or more");
+  expect(r.delivered + s.dropped + r.discarded + r.queued == r.produced, run.name,
+         "frames unaccounted for");
+  expect(s.overflows + s.bus_errors == r.resets, run.name, "FIFO reset without a counted cause");
+  if (lossless) {
+    expect(r.discarded == 0 && s.dropped == 0 && r.resets == 0, run.name, "frames lost");
+  } else {
+    expect(r.resets > 0 || s.dropped > 0, run.name, "fault never happened");
+    // Resynced: the tail of the run is delivered
+    expect(r.delivered > r.produced / 2, run.name, "drain did not recover");
+  }
+}
+
+int main(int argc, char** argv) {
+  uint32_t seconds = 60;
+  uint32_t drain_ms = 10;
+  uint32_t seed = 1;
+  
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+      seconds = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--drain") && i + 1 < argc) {
+      drain_ms = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "-v")) {
+      verbose = true;
+    } else {
+      fprintf(stderr, "usage: %s [--seconds N] [--drain MS] [--seed N] [-v]\n", argv[0]);
+      return 1;
+    }
+  }
+  
+  std::mt19937 rng(seed);
+  printf("%u s per run, drained every %u ms, bursts of %d frames, %d-slot ring\n\n", seconds, drain_ms,
+         IMU_FIFO_MAX_BURST_FRAMES, IMU_FIFO_RING_SIZE);
+  
+  const Run steady[] = {
+    {"steady", 100, 0, 0, 0, 0, 0},
+    {"steady", 1000, 0, 0, 0, 0, 0},
+  };
+  for (const Run& run : steady) check(run, replay(run, seconds, drain_ms, rng), true);
+  
+  const Run partial[] = {
+    {"partial", 100, 0.2, 0, 0, 0, 0},
+    {"partial", 1000, 0.2, 0, 0, 0, 0},
+  };
+  for (const Run& run : partial) {
+    Result r = replay(run, seconds, drain_ms, rng);
+    check(run, r, true);
+    expect(r.partial_counts > 0, run.name, "no count caught a frame half written");
+    expect(r.stats.overflows == 0, run.name, "partial count taken for an overflow");
+  }
+  
+  // 1 kHz fills the 1 KB FIFO in 85 ms
+  const Run faults[] = {
+    {"overflow", 1000, 0, 0, 5000, 150, 0},
+    {"bus", 1000, 0, 0.01, 0, 0, 0},
+    {"ring", 1000, 0, 0, 0, 0, 200},
+  };
+  for (const Run& run : faults) check(run, replay(run, seconds, drain_ms, rng), false);
+  
+  printf("\none getEvent() per sample is 1 transaction a sample\n");
+  printf("%s\n", failures ? "FAIL" : "ok");
+  return failures ? 1 : 0;
+}
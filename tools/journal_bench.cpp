@@ -0,0 +1,449 @@
+// ===================================================================
+// Telemetry Journal Benchmark (host)
+// ===================================================================
+// Runs the firmware's journal (src/journal) on a file-backed NOR flash
+// emulator: erase sets a 4 KB sector to 0xFF, a write can only clear
+// bits (a write that would set one is counted as a violation), and
+// every erase is counted per sector. Three parts:
+//   endurance  --days of telemetry as the firmware logs it (a sample a
+//              second, gait every 10 s, an alert every ~30 min, a boot
+//              every ~8 h with a remount): flash bytes programmed per
+//              payload byte, erases per sector (min/max: the wear
+//              spread), history held, append cost
+//   sync       the whole log downloaded in notification-sized chunks
+//              (--mtu) as the JOURNAL characteristic sends them, the link
+//              dropping every ~--drop chunks and resuming at the last
+//              offset; every record must arrive once, intact, in order
+//   power      --trials random power cuts mid-write: after the
+//              remount the log must read back as an exact prefix of
+//              what was appended, and keep appending after it
+//
+//   g++ -O2 -std=c++17 -Isrc tools/journal_bench.cpp src/journal.cpp -o journal_bench
+//   ./journal_bench [--days N] [--size KB] [--mtu N] [--drop N] [--trials N] [--seed N] [--file PATH]
+// ===================================================================
+
+#include "journal.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+// ===================================================================
+// File-Backed Flash Emulator
+// ===================================================================
+
+struct FileFlash {
+  int fd = -1;
+  uint32_t size = 0;
+  std::vector<uint32_t> erases;
+  uint64_t programmed = 0;
+  uint32_t violations = 0;
+  int64_t budget = -1;        // Bytes left before the power cut, -1 none
+  bool dead = false;
+};
+
+static bool ff_read(void* ctx, uint32_t addr, void* data, size_t len) {
+  FileFlash& f = *(FileFlash*)ctx;
+  if (f.dead || addr + len > f.size) return false;
+  return pread(f.fd, data, len, addr) == (ssize_t)len;
+}
+
+static bool ff_write(void* ctx, uint32_t addr, const void* data, size_t len) {
+  FileFlash& f = *(FileFlash*)ctx;
+  if (f.dead || addr + len > f.size) return false;
+  size_t n = len;
+  if (f.budget >= 0 && (int64_t)n > f.budget) {
+    n = (size_t)f.budget;
+    f.dead = true;
+  }
+  std::vector<uint8_t> cell(n);
+  if (pread(f.fd, cell.data(), n, addr) != (ssize_t)n) return false;
+  const uint8_t* p = (const uint8_t*)data;
+  for (size_t i = 0; i < n; i++) {
+    if ((cell[i] & p[i]) != p[i]) f.violations++;
+    cell[i] &= p[i];
+  }
+  if (pwrite(f.fd, cell.data(), n, addr) != (ssize_t)n) return false;
+  f.programmed += n;
+  if (f.budget >= 0) f.budget -= n;
+  return !f.dead;
+}
+
+static bool ff_erase(void* ctx, uint32_t addr) {
+  FileFlash& f = *(FileFlash*)ctx;
+  if (f.dead || addr % JOURNAL_SEGMENT_BYTES || addr + JOURNAL_SEGMENT_BYTES > f.size) return false;
+  std::vector<uint8_t> ff(JOURNAL_SEGMENT_BYTES, 0xFF);
+  if (pwrite(f.fd, ff.data(), ff.size(), addr) != (ssize_t)ff.size()) return false;
+  f.erases[addr / JOURNAL_SEGMENT_BYTES]++;
+  return true;
+}
+
+// A new flash image holds random bits, as a part from the factory might
+static bool ff_open(FileFlash& f, const char* path, uint32_t size, std::mt19937& rng) {
+  f = FileFlash();
+  f.fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (f.fd < 0) return false;
+  f.size = size;
+  f.erases.assign(size / JOURNAL_SEGMENT_BYTES, 0);
+  std::vector<uint8_t> junk(size);
+  for (uint8_t& b : junk) b = (uint8_t)rng();
+  return pwrite(f.fd, junk.data(), size, 0) == (ssize_t)size;
+}
+
+static JournalFlash ff_bind(FileFlash& f) {
+  return {f.size, ff_read, ff_write, ff_erase, &f};
+}
+
+// ===================================================================
+// Reference Log
+// ===================================================================
+// What was appended, by log offset, to check reads against
+
+struct Appended {
+  uint32_t offset;
+  uint8_t type;
+  std::vector<uint8_t> payload;
+};
+
+struct Workload {
+  std::mt19937 rng;
+  uint32_t t_ms = 0;
+  uint32_t steps = 0;
+  uint32_t alert_seq = 0;
+};
+
+// One second of firmware logging: a sample, and now and then a gait
+// summary or an alert
+static void log_second(Journal& j, Workload& w, std::vector<Appended>* ref, double& append_ns, uint64_t& appends) {
+  std::normal_distribution<float> noise(0.0f, 1.0f);
+  w.t_ms += 1000;
+  
+  TelemetryValues v = {};
+  v.flags = TELEMETRY_FLAG_IMU | TELEMETRY_FLAG_TOF;
+  v.ax = 0.02f * noise(w.rng);
+  v.ay = 0.02f * noise(w.rng);
+  v.az = 1.0f + 0.05f * noise(w.rng);
+  v.gx = 3.0f * noise(w.rng);
+  v.gy = 3.0f * noise(w.rng);
+  v.gz = 3.0f * noise(w.rng);
+  v.pitch_deg = 80.0f + noise(w.rng);
+  v.roll_deg = noise(w.rng);
+  v.dist_mm = 400 + (int16_t)(w.rng() % 3000);
+  if (w.t_ms % 10000 == 0) {
+    v.flags |= TELEMETRY_FLAG_BATTERY;
+    v.battery_pct = 80;
+  }
+  
+  auto timed = [&](auto fn) {
+    uint32_t off = journal_head(j);
+    auto t0 = std::chrono::steady_clock::now();
+    fn();
+    auto t1 = std::chrono::steady_clock::now();
+    append_ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+    appends++;
+    if (ref) {
+      // Re-read the record just written: the reference is what the
+      // encoder produced
+      uint8_t rec[JOURNAL_RECORD_HEADER + JOURNAL_PAYLOAD_MAX];
+      uint32_t at = off;
+      size_t n = journal_read(j, at, rec, sizeof(rec));
+      JournalRecord r;
+      if (at == off && journal_parse(rec, n, r)) {
+        ref->push_back({off, r.type, std::vector<uint8_t>(r.payload, r.payload + r.len)});
+      }
+    }
+  };
+  
+  timed([&] { journal_log_sample(j, v, w.t_ms); });
+  if (w.t_ms % 10000 == 0) {
+    GaitSummary g = {};
+    w.steps += w.rng() % 20;
+    g.steps = w.steps;
+    g.plants = w.steps;
+    g.cadence_spm = 96;
+    g.stride_ms = 1250;
+    g.stride_cv = 0.04f;
+    g.walking = true;
+    timed([&] { journal_log_gait(j, g, w.t_ms); });
+  }
+  if (w.rng() % 1800 == 0) {
+    char json[96];
+    snprintf(json, sizeof(json), "{\"event\":\"OBSTACLE_NEAR\",\"dist_mm\":%u,\"dir\":\"left\"}",
+             (unsigned)(300 + w.rng() % 500));
+    timed([&] { journal_log_alert(j, ++w.alert_seq, json, w.t_ms); });
+  }
+  journal_service(j, w.t_ms);
+}
+
+// ===================================================================
+// Sync
+// ===================================================================
+// As the JOURNAL characteristic sends it: u32 offset, then log bytes
+
+struct SyncResult {
+  uint32_t notifications = 0;
+  uint64_t bytes = 0;
+  uint32_t reconnects = 0;
+  uint32_t records = 0;
+  uint32_t bad_crc = 0;
+  uint32_t mismatches = 0;
+};
+
+static SyncResult run_sync(Journal& j, const std::vector<Appended>& ref, uint16_t mtu, int drop_every,
+                           std::mt19937& rng) {
+  SyncResult r;
+  size_t room = mtu - 3 - 4;
+  std::vector<uint8_t> chunk(room);
+  std::vector<uint8_t> pending;      // Bytes of a record not yet whole
+  uint32_t client_off = 0;           // Contiguous end of what arrived
+  uint32_t record_off = 0;           // Log offset of pending[0]
+  bool started = false;
+  
+  size_t next_ref = 0;
+  uint32_t sent_off = client_off;
+  while (true) {
+    uint32_t off = sent_off;
+    size_t n = journal_read(j, off, chunk.data(), room);
+    if (n == 0) break;
+    r.notifications++;
+    r.bytes += 4 + n;
+    sent_off = off + n;
+    
+    // The link drops: this notification is lost, the client resumes
+    if (drop_every > 0 && rng() % drop_every == 0) {
+      r.reconnects++;
+      sent_off = client_off;
+      continue;
+    }
+    
+    // Client: a jump forward means the ring overwrote what it asked for
+    if (!started || off != client_off) {
+      pending.clear();
+      record_off = off;
+      started = true;
+    }
+    pending.insert(pending.end(), chunk.begin(), chunk.begin() + n);
+    client_off = off + n;
+    
+    size_t at = 0;
+    JournalRecord rec;
+    while (size_t size = journal_parse(pending.data() + at, pending.size() - at, rec)) {
+      uint32_t rec_off = record_off + at;
+      while (next_ref < ref.size() && ref[next_ref].offset < rec_off) next_ref++;
+      bool same = next_ref < ref.size() && ref[next_ref].offset == rec_off && ref[next_ref].type == rec.type &&
+                  ref[next_ref].payload.size() == rec.len &&
+                  memcmp(ref[next_ref].payload.data(), rec.payload, rec.len) == 0;
+      if (!same) r.mismatches++;
+      if (!rec.crc_ok) r.bad_crc++;
+      r.records++;
+      at += size;
+    }
+    pending.erase(pending.begin(), pending.begin() + at);
+    record_off += at;
+  }
+  return r;
+}
+
+// ===================================================================
+// Power Cuts
+// ===================================================================
+
+// Append until the cut, remount, and compare what reads back
+static bool power_trial(const char* path, uint32_t size, std::mt19937& rng, uint32_t& lost, uint32_t& torn) {
+  FileFlash f;
+  if (!ff_open(f, path, size, rng)) return false;
+  Journal j;
+  journal_mount(j, ff_bind(f));
+  
+  Workload w;
+  w.rng.seed(rng());
+  std::vector<Appended> ref;
+  double ns = 0;
+  uint64_t appends = 0;
+  for (int s = 0; s < 600; s++) log_second(j, w, &ref, ns, appends);
+  
+  // Cut somewhere in the next few minutes of writes
+  f.budget = rng() % 20000;
+  for (int s = 0; s < 600 && !f.dead; s++) log_second(j, w, &ref, ns, appends);
+  size_t appended = ref.size();
+  
+  f.dead = false;
+  f.budget = -1;
+  Journal j2;
+  if (!journal_mount(j2, ff_bind(f))) return false;
+  torn += j2.stats.torn;
+  
+  // Everything that reads back is the start of what was appended
+  std::vector<uint8_t> all(journal_head(j2) - journal_tail(j2));
+  uint32_t off = journal_tail(j2);
+  size_t got = 0;
+  while (size_t n = journal_read(j2, off, all.data() + got, all.size() - got)) {
+    got += n;
+    off += n;
+  }
+  size_t at = 0, k = 0;
+  while (k < ref.size() && ref[k].offset < journal_tail(j2)) k++;
+  JournalRecord rec;
+  bool ok = got == all.size();
+  while (size_t n = journal_parse(all.data() + at, got - at, rec)) {
+    ok &= rec.crc_ok && k < ref.size() && ref[k].type == rec.type && ref[k].payload.size() == rec.len &&
+          memcmp(ref[k].payload.data(), rec.payload, rec.len) == 0;
+    at += n;
+    k++;
+  }
+  ok &= at == got;
+  lost += appended - k;
+  
+  // And the log goes on after it
+  uint32_t head = journal_head(j2);
+  for (int s = 0; s < 60; s++) log_second(j2, w, nullptr, ns, appends);
+  journal_flush(j2);
+  Journal j3;
+  ok &= journal_mount(j3, ff_bind(f)) && journal_head(j3) > head && j3.stats.torn == 0;
+  ok &= f.violations == 0;
+  close(f.fd);
+  return ok;
+}
+
+// ===================================================================
+// Main
+// ===================================================================
+
+int main(int argc, char** argv) {
+  double days = 3;
+  uint32_t size_kb = 384;         // The "journal" partition in partitions.csv
+  uint16_t mtu = 247;
+  int drop = 200;
+  int trials = 200;
+  uint32_t seed = 1;
+  const char* path = "journal_bench.img";
+  
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--days") && i + 1 < argc) {
+      days = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--size") && i + 1 < argc) {
+      size_kb = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--mtu") && i + 1 < argc) {
+      mtu = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--drop") && i + 1 < argc) {
+      drop = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--trials") && i + 1 < argc) {
+      trials = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--file") && i + 1 < argc) {
+      path = argv[++i];
+    } else {
+      fprintf(stderr, "usage: %s [--days N] [--size KB] [--mtu N] [--drop N] [--trials N] [--seed N] [--file PATH]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+  if (mtu < 23) mtu = 23;
+  uint32_t size = size_kb * 1024 / JOURNAL_SEGMENT_BYTES * JOURNAL_SEGMENT_BYTES;
+  
+  std::mt19937 rng(seed);
+  FileFlash f;
+  if (!ff_open(f, path, size, rng)) {
+    fprintf(stderr, "cannot create %s\n", path);
+    return 1;
+  }
+  bool ok = true;
+  
+  // Endurance, remounting at each simulated boot
+  Journal j;
+  journal_mount(j, ff_bind(f));
+  Workload w;
+  w.rng.seed(seed);
+  std::vector<Appended> ref;
+  JournalStats total = {};
+  double ns = 0;
+  uint64_t appends = 0;
+  uint32_t seconds = (uint32_t)(days * 86400);
+  uint32_t boots = 0;
+  auto add = [&](const JournalStats& s) {
+    total.records += s.records;
+    total.payload_bytes += s.payload_bytes;
+    total.flash_bytes += s.flash_bytes;
+    total.flushes += s.flushes;
+    total.erases += s.erases;
+    total.overwritten += s.overwritten;
+    total.torn += s.torn;
+    total.errors += s.errors;
+  };
+  for (uint32_t s = 0; s < seconds; s++) {
+    if (s > 0 && s % (8 * 3600) == 0) {
+      journal_flush(j);
+      add(j.stats);
+      journal_mount(j, ff_bind(f));
+      journal_log_boot(j, 1, 0);
+      boots++;
+    }
+    log_second(j, w, s + 86400 >= seconds ? &ref : nullptr, ns, appends);
+  }
+  journal_flush(j);
+  add(j.stats);
+  
+  uint32_t emin = UINT32_MAX, emax = 0;
+  for (uint32_t e : f.erases) {
+    if (e < emin) emin = e;
+    if (e > emax) emax = e;
+  }
+  uint32_t span = journal_head(j) - journal_tail(j);
+  double per_s = (double)total.payload_bytes / seconds;
+  double record_bytes = total.payload_bytes + total.records * (double)JOURNAL_RECORD_HEADER;
+  printf("%.1f days on %u KB (%u segments), %u boots\n", days, size / 1024, j.segments, boots);
+  printf("records %u, payload %.1f B/s, %.1f B/record\n", total.records, per_s,
+         (double)total.payload_bytes / total.records);
+  printf("programmed/payload %.3f (record headers alone %.3f), %u flushes (%.0f B each)\n",
+         (double)f.programmed / total.payload_bytes, record_bytes / total.payload_bytes, total.flushes,
+         (double)f.programmed / (total.flushes ? total.flushes : 1));
+  printf("erases per sector min %u max %u (%.1f a day), ring held %.1f h\n", emin, emax, emax / days,
+         span / (per_s + JOURNAL_RECORD_HEADER * (double)total.records / seconds) / 3600);
+  printf("append %.0f ns mean (host), write violations %u, errors %u\n", ns / appends, f.violations, total.errors);
+  ok &= f.violations == 0 && total.errors == 0 && emax - emin <= 1;
+  
+  // Sync the whole ring over a link that keeps dropping
+  double flash_ns = 0;
+  {
+    auto t0 = std::chrono::steady_clock::now();
+    SyncResult r = run_sync(j, ref, mtu, drop, rng);
+    auto t1 = std::chrono::steady_clock::now();
+    flash_ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    uint32_t expected = 0;
+    for (const Appended& a : ref) expected += a.offset >= journal_tail(j);
+    printf("\nsync at MTU %u: %u records in %u notifications (%.1f KB, %.1f%% offset overhead), "
+           "%u reconnects, bad CRC %u, mismatched %u, %.1f us/notification (host)\n",
+           mtu, r.records, r.notifications, r.bytes / 1024.0, 400.0 * r.notifications / r.bytes, r.reconnects,
+           r.bad_crc, r.mismatches, flash_ns / 1000 / (r.notifications ? r.notifications : 1));
+    ok &= r.records == expected && r.bad_crc == 0 && r.mismatches == 0;
+  }
+  
+  // An offset the ring has overwritten starts at the tail
+  {
+    uint32_t off = journal_tail(j) - 1;
+    uint8_t b[8];
+    journal_read(j, off, b, sizeof(b));
+    ok &= off == journal_tail(j);
+  }
+  close(f.fd);
+  
+  // Power cuts
+  uint32_t lost = 0, torn = 0;
+  int failed = 0;
+  for (int t = 0; t < trials; t++) {
+    if (!power_trial(path, 64 * 1024, rng, lost, torn)) failed++;
+  }
+  printf("\npower cuts: %d trials, %d failed, %u torn records found, %.1f records lost a cut "
+         "(buffered up to %d ms)\n",
+         trials, failed, torn, trials ? (double)lost / trials : 0.0, JOURNAL_FLUSH_MS);
+  ok &= failed == 0;
+  unlink(path);
+  
+  printf("%s\n", ok ? "ok" : "FAIL");
+  return ok ? 0 : 1;
+}
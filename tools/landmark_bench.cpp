@@ -0,0 +1,69 @@
+// ===================================================================
+// Landmark Lookup Benchmark (host)
+// ===================================================================
+// Times landmark_db_lookup() over every tag in an image plus the same
+// number of unknown UIDs.
+//
+//   python3 tools/build_landmarks.py --random 20000 -o bench.bin
+//   g++ -O2 -std=c++17 -Isrc tools/landmark_bench.cpp src/landmark_db.cpp -o landmark_bench
+//   ./landmark_bench bench.bin
+// ===================================================================
+
+#include "landmark_db.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s landmarks.bin\n", argv[0]);
+    return 1;
+  }
+  
+  FILE* f = fopen(argv[1], "rb");
+  if (!f) {
+    perror(argv[1]);
+    return 1;
+  }
+  std::vector<uint8_t> image;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) image.insert(image.end(), buf, buf + n);
+  fclose(f);
+  
+  LandmarkDB db;
+  if (!landmark_db_open(db, image.data(), image.size())) {
+    fprintf(stderr, "invalid landmark image\n");
+    return 1;
+  }
+  
+  // Known tags straight from the table, unknown ones by flipping a byte
+  std::vector<LandmarkSlot> known;
+  for (uint32_t i = 0; i < db.header->slot_count; i++) {
+    if (db.slots[i].uid_len) known.push_back(db.slots[i]);
+  }
+  std::vector<LandmarkSlot> unknown = known;
+  for (LandmarkSlot& s : unknown) s.uid[0] ^= 0x5A;
+  
+  const int rounds = 100;
+  uint32_t hits = 0, misses = 0;
+  
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    for (const LandmarkSlot& s : known) hits += landmark_db_lookup(db, s.uid, s.uid_len) != nullptr;
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    for (const LandmarkSlot& s : unknown) misses += landmark_db_lookup(db, s.uid, s.uid_len) == nullptr;
+  }
+  auto t2 = std::chrono::steady_clock::now();
+  
+  double hit_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / (rounds * known.size());
+  double miss_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / (rounds * unknown.size());
+  
+  printf("%zu tags, %u slots, max probe %u\n", known.size(), db.header->slot_count, db.header->max_probe);
+  printf("hit:  %.1f ns/lookup (%u/%zu found)\n", hit_ns, hits, rounds * known.size());
+  printf("miss: %.1f ns/lookup (%u/%zu rejected)\n", miss_ns, misses, rounds * unknown.size());
+  return (hits == rounds * known.size()) ? 0 : 1;
+}
@@ -0,0 +1,316 @@
+// ===================================================================
+// Deferred Logger Benchmark (host)
+// ===================================================================
+// Runs the firmware's logger (src/log) natively:
+//   format     LOG_* output against snprintf for the same format and
+//              arguments (conversions, flags, width, precision, *)
+//   strip      a LOG_DEBUG above LOG_LEVEL does not evaluate its
+//              arguments
+//   producers  --threads tasks log concurrently while one drains, flat
+//              out and then one message per --pace us each: every
+//              message arrives once, intact and in order per producer,
+//              or is counted as dropped
+//   cost       cycles per log call (the caller's side), per drop on a
+//              full ring, and per record formatted by the drain,
+//              against snprintf of the same line
+//
+//   g++ -O2 -std=c++17 -pthread -Isrc tools/log_bench.cpp src/log.cpp -o log_bench
+//   ./log_bench [--threads N] [--messages N] [--pace US] [--calls N]
+// ===================================================================
+
+#include "log.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC
+#endif
+
+static uint64_t cycles_now() {
+#ifdef HAVE_TSC
+  return __rdtsc();
+#else
+  auto ns = std::chrono::steady_clock::now().time_since_epoch();
+  return (uint64_t)(std::chrono::duration<double, std::nano>(ns).count() * 3.0);
+#endif
+}
+
+static unsigned long host_ms() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ===================================================================
+// Sinks
+// ===================================================================
+
+static void collect(const char* line, size_t len, void* ctx) {
+  ((std::vector<std::string>*)ctx)->emplace_back(line, len);
+}
+
+static void discard(const char* line, size_t len, void* ctx) {
+  (void)line;
+  *(size_t*)ctx += len;
+}
+
+// The message after "[s.mmm] ", without the newline
+static std::string message(const std::string& line) {
+  size_t at = line.find("] ");
+  std::string m = at == std::string::npos ? line : line.substr(at + 2);
+  if (!m.empty() && m.back() == '\n') m.pop_back();
+  return m;
+}
+
+static void drain_all(std::vector<std::string>& out) {
+  while (log_drain(collect, &out, 64)) {}
+}
+
+// ===================================================================
+// Format
+// ===================================================================
+
+static int format_failures = 0;
+static int format_cases = 0;
+
+#define CHECK_FORMAT(...) do {                                        \
+    char ref[LOG_LINE_MAX];                                           \
+    snprintf(ref, sizeof(ref), __VA_ARGS__);                          \
+    LOG_INFO(__VA_ARGS__);                                            \
+    std::vector<std::string> got;                                     \
+    drain_all(got);                                                   \
+    format_cases++;                                                   \
+    if (got.size() != 1 || message(got[0]) != ref) {                  \
+      format_failures++;                                              \
+      printf("  FORMAT %s: got \"%s\" want \"%s\"\n", #__VA_ARGS__,   \
+             got.empty() ? "" : message(got[0]).c_str(), ref);        \
+    }                                                                 \
+  } while (0)
+
+static bool run_format() {
+  uint8_t u8 = 200;
+  int16_t i16 = -1234;
+  uint16_t u16 = 65000;
+  long l = -70000;
+  unsigned long ul = 4000000000UL;
+  long long ll = -5000000000LL;
+  unsigned long long ull = 18000000000000000000ULL;
+  size_t z = 123456;
+  float f = 1.2345f;
+  double d = -0.000123456;
+  const char* s = "ToF";
+  char buf[16] = "dynamic";
+  
+  CHECK_FORMAT("plain text");
+  CHECK_FORMAT("BLE: Client connected (DLE rc=%d, 2M PHY rc=%d)", 0, -3);
+  CHECK_FORMAT("%u %d %u %ld %lu", (unsigned)u8, (int)i16, (unsigned)u16, l, ul);
+  CHECK_FORMAT("%lld %llu %zu", ll, ull, z);
+  CHECK_FORMAT("%x %X %08x %#o %-6d| %+d % d", 0xbeefu, 0xbeefu, 0x1fu, 8u, 42, 7, 7);
+  CHECK_FORMAT("%.3f g, %6.1f, %-8.2f|, %e, %g", f, (double)f, 2.5, d, d);
+  CHECK_FORMAT("%.0f %.1f %G", 99.5f, 0.05f, 1e-10);
+  CHECK_FORMAT("%s %s %-6s| %6s| %.2s", s, buf, s, s, buf);
+  CHECK_FORMAT("%c%c %%d 100%%", 'o', 'k');
+  CHECK_FORMAT("%*d|%-*d|%.*f", 5, 42, 4, 7, 2, 3.14159);
+  CHECK_FORMAT("%5u%%", 93u);
+  CHECK_FORMAT("  %-13s %6lu us", "advertising", 48213UL);
+  CHECK_FORMAT("Sensors: MFRC522 OK (version 0x%X)", 0x92);
+  
+  // Arguments past the record's room: what fits is stored, "~" ends the line
+  std::string big(200, 'j');
+  LogStats before = log_get_stats();
+  LOG_INFO("BLE Sensor: %s (%d)", big.c_str(), 7);
+  std::vector<std::string> got;
+  drain_all(got);
+  LogStats after = log_get_stats();
+  bool cut_ok = got.size() == 1 && after.truncated == before.truncated + 1 &&
+                message(got[0]).back() == '~' && message(got[0]).find("(?)") != std::string::npos;
+  if (!cut_ok) printf("  FORMAT truncated record: got \"%s\"\n", got.empty() ? "" : got[0].c_str());
+  
+  printf("format: %d cases, %d mismatches; long argument %s\n", format_cases, format_failures,
+         cut_ok ? "cut and marked" : "WRONG");
+  return format_failures == 0 && cut_ok;
+}
+
+// ===================================================================
+// Strip
+// ===================================================================
+
+static int evaluated = 0;
+
+static int side_effect() {
+  return ++evaluated;
+}
+
+static bool run_strip() {
+  LOG_DEBUG("never %d", side_effect());
+  LOG_INFO("always %d", side_effect());
+  std::vector<std::string> got;
+  drain_all(got);
+  bool ok = LOG_LEVEL < LOG_LEVEL_DEBUG ? evaluated == 1 && got.size() == 1 : evaluated == 2;
+  printf("strip: LOG_LEVEL %d, %d of 2 calls evaluated, %zu line(s) %s\n", LOG_LEVEL, evaluated,
+         got.size(), ok ? "ok" : "WRONG");
+  return ok;
+}
+
+// ===================================================================
+// Producers
+// ===================================================================
+
+static bool run_producers(int threads, uint32_t messages, uint32_t pace_us) {
+  LogStats before = log_get_stats();
+  std::atomic<int> running(threads);
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; t++) {
+    pool.emplace_back([t, messages, pace_us, &running] {
+      for (uint32_t n = 0; n < messages; n++) {
+        LOG_INFO("producer %d message %lu %s %.2f", t, (unsigned long)n, "payload", n * 0.5);
+        if (pace_us) {
+          std::this_thread::sleep_for(std::chrono::microseconds(pace_us));
+        } else if ((n & 255) == 0) {
+          std::this_thread::yield();
+        }
+      }
+      running--;
+    });
+  }
+  
+  std::vector<std::string> lines;
+  std::vector<long> last(threads, -1);
+  uint64_t delivered = 0, garbled = 0, reordered = 0;
+  auto check = [&] {
+    for (const std::string& line : lines) {
+      std::string m = message(line);
+      if (m.compare(0, 4, "log:") == 0) continue;
+      int t = -1;
+      unsigned long n = 0;
+      double v = 0;
+      char word[16];
+      if (sscanf(m.c_str(), "producer %d message %lu %15s %lf", &t, &n, word, &v) != 4 || t < 0 ||
+          t >= threads || strcmp(word, "payload") || v != n * 0.5) {
+        garbled++;
+        continue;
+      }
+      if ((long)n <= last[t]) reordered++;
+      last[t] = (long)n;
+      delivered++;
+    }
+    lines.clear();
+  };
+  while (running > 0) {
+    if (!log_drain(collect, &lines, 32)) std::this_thread::yield();
+    check();
+  }
+  for (std::thread& th : pool) th.join();
+  drain_all(lines);
+  check();
+  
+  LogStats after = log_get_stats();
+  uint64_t dropped = after.dropped - before.dropped;
+  uint64_t total = (uint64_t)threads * messages;
+  bool ok = garbled == 0 && reordered == 0 && delivered + dropped == total;
+  printf("producers %s: %d x %u messages, %llu delivered, %llu dropped (%.1f%%), %llu garbled, "
+         "%llu out of order %s\n",
+         pace_us ? "paced" : "flat out", threads, messages, (unsigned long long)delivered, (unsigned long long)dropped,
+         100.0 * dropped / total, (unsigned long long)garbled, (unsigned long long)reordered,
+         ok ? "ok" : "WRONG");
+  return ok;
+}
+
+// ===================================================================
+// Cost
+// ===================================================================
+
+static void run_cost(uint32_t calls) {
+  const int batch = LOG_RING_SLOTS / 2;
+  size_t bytes = 0;
+  float ax = 0.98f;
+  const char* tag = "ToF";
+  
+  // Caller side: the ring is drained between batches, outside the timing
+  uint64_t logged = 0;
+  for (uint32_t i = 0; i < calls; i += batch) {
+    uint64_t c0 = cycles_now();
+    for (int k = 0; k < batch; k++) LOG_INFO("%s: %d mm ax=%.2f", tag, (int)(i + k), ax);
+    logged += cycles_now() - c0;
+    while (log_drain(discard, &bytes, LOG_RING_SLOTS)) {}
+  }
+  
+  // A full ring: the call only counts the drop
+  for (int k = 0; k < LOG_RING_SLOTS; k++) LOG_INFO("fill %d", k);
+  uint64_t c0 = cycles_now();
+  for (uint32_t i = 0; i < calls; i++) LOG_INFO("%s: %d mm ax=%.2f", tag, (int)i, ax);
+  uint64_t drop = cycles_now() - c0;
+  while (log_drain(discard, &bytes, LOG_RING_SLOTS)) {}
+  
+  // Drain side: format and hand to the sink
+  uint64_t drained = 0, formatted = 0;
+  for (uint32_t i = 0; i < calls; i += batch) {
+    for (int k = 0; k < batch; k++) LOG_INFO("%s: %d mm ax=%.2f", tag, (int)(i + k), ax);
+    uint64_t c1 = cycles_now();
+    formatted += log_drain(discard, &bytes, LOG_RING_SLOTS);
+    drained += cycles_now() - c1;
+  }
+  
+  // What the caller paid before: formatting in place
+  char line[LOG_LINE_MAX];
+  uint64_t c2 = cycles_now();
+  for (uint32_t i = 0; i < calls; i++) {
+    snprintf(line, sizeof(line), "%s: %d mm ax=%.2f", tag, (int)i, (double)ax);
+    __asm__ volatile("" : : "r"(line) : "memory");
+  }
+  uint64_t inline_fmt = cycles_now() - c2;
+  
+  uint32_t rounded = (calls / batch) * batch;
+  printf("cost: log call %.0f cycles, dropped call %.0f, drain %.0f per record, "
+         "snprintf of the same line %.0f (%s)\n",
+         (double)logged / rounded, (double)drop / calls, (double)drained / std::max<uint64_t>(formatted, 1),
+         (double)inline_fmt / calls,
+#ifdef HAVE_TSC
+         "TSC"
+#else
+         "ns x 3"
+#endif
+  );
+  printf("      at 115200 baud the same %zu-byte line takes %.0f us on the UART\n",
+         strlen(line) + 10, (strlen(line) + 10) * 10 * 1e6 / 115200);
+}
+
+// ===================================================================
+// Main
+// ===================================================================
+
+int main(int argc, char** argv) {
+  int threads = 4;
+  uint32_t messages = 200000;
+  uint32_t calls = 1000000;
+  uint32_t pace_us = 20;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--messages") && i + 1 < argc) {
+      messages = (uint32_t)atol(argv[++i]);
+    } else if (!strcmp(argv[i], "--pace") && i + 1 < argc) {
+      pace_us = (uint32_t)atol(argv[++i]);
+    } else if (!strcmp(argv[i], "--calls") && i + 1 < argc) {
+      calls = (uint32_t)atol(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [--threads N] [--messages N] [--pace US] [--calls N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (threads < 1) threads = 1;
+  
+  log_init(host_ms);
+  bool ok = run_format();
+  ok &= run_strip();
+  ok &= run_producers(threads, messages, 0);
+  ok &= run_producers(threads, messages / 10, pace_us);
+  run_cost(calls);
+  printf("%s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,401 @@
+// ===================================================================
+// RFID Detection Simulation (host)
+// ===================================================================
+// Runs the firmware's MFRC522 card detection machine (src/rfid_detect)
+// against a scripted fake of the reader's registers, on a virtual
+// millisecond clock. The fake models what the machine relies on:
+// soft power-down and the antenna drivers, the field settle time,
+// REQA by Transceive + StartSend, an ATQA 1 ms later from every idle
+// card in the field (CollErr when more than one answers), TimerIRq
+// from TAuto 25 ms after an unanswered REQA, ComIEnReg gating the IRQ
+// pin, and HLTA leaving a card silent until it leaves the field.
+// The loop calls update every --tick ms, as update_rfid() does.
+//   present    a tag held to the stick, halted after each read, taken
+//              away and brought back: one detection per presentation,
+//              latency within one probe period
+//   removed    tags that leave before the next probe are not reported,
+//              and nothing is reported with the field empty
+//   collision  two tags at once: both read, one after the other
+//   noise      an ATQA with a protocol error is not a card
+//   asleep     no REQA, and so no card, while the reader is powered down
+//   lost irq   IRQ mode with the line dead: every probe ends on the
+//              timeout, and a tag is still read
+// Each runs with the IRQ line and polled; SPI reads and writes per
+// second, antenna duty and latency are reported for both.
+//
+//   g++ -O2 -std=c++17 -Isrc tools/rfid_detect_sim.cpp src/rfid_detect.cpp -o rfid_detect_sim
+//   ./rfid_detect_sim [--period MS] [--tick MS] [-v]
+// ===================================================================
+
+#include "rfid_detect.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Registers, as the machine uses them
+#define REG_COMMAND      0x01
+#define REG_COM_IEN      0x02
+#define REG_COM_IRQ      0x04
+#define REG_ERROR        0x06
+#define REG_FIFO_DATA    0x09
+#define REG_FIFO_LEVEL   0x0A
+#define REG_BIT_FRAMING  0x0D
+#define REG_TX_CONTROL   0x14
+
+#define CMD_IDLE         0x00
+#define CMD_TRANSCEIVE   0x0C
+#define CMD_POWER_DOWN   0x10
+#define IRQ_RX           0x20
+#define IRQ_IDLE         0x10
+#define IRQ_TIMER        0x01
+#define ERR_PROTOCOL     0x01
+#define ERR_COLL         0x08
+
+#define TAUTO_MS         25     // PCD_Init's timer
+#define ATQA_MS          1
+#define SETTLE_NEEDED_MS 3      // Field on before a tag can answer
+
+static bool verbose = false;
+static int failures = 0;
+
+static void expect(bool ok, const char* scenario, const char* what) {
+  if (ok) return;
+  printf("  FAIL %s: %s\n", scenario, what);
+  failures++;
+}
+
+// ===================================================================
+// Fake MFRC522
+// ===================================================================
+
+struct Tag {
+  uint32_t uid;
+  uint32_t arrive_ms;
+  uint32_t leave_ms;
+  bool halted;
+};
+
+struct FakeReader {
+  uint8_t regs[64];
+  uint32_t now_ms;
+  uint32_t antenna_on_ms;           // When TxControl last switched on
+  uint32_t antenna_total_ms;
+  bool reqa_in_fifo;
+  int32_t answer_at_ms;             // Pending ComIrqReg update, -1 none
+  uint8_t answer_irq;
+  uint8_t answer_err;
+  uint8_t answer_level;
+  bool noise;                       // Next ATQA arrives corrupted
+  std::vector<Tag> tags;
+  RfidDetector* det;                // IRQ pin goes here
+  bool irq_wired;                   // False: the edge never arrives
+  uint32_t reqas;
+  uint32_t reqas_asleep;            // StartSend while powered down
+};
+
+static FakeReader fake;
+
+static bool antenna_on() {
+  return (fake.regs[REG_TX_CONTROL] & 0x03) == 0x03;
+}
+
+static bool powered_down() {
+  return fake.regs[REG_COMMAND] & CMD_POWER_DOWN;
+}
+
+static bool in_field(const Tag& t) {
+  return fake.now_ms >= t.arrive_ms && fake.now_ms < t.leave_ms;
+}
+
+// IRQ pin: ComIEnReg enables which ComIrqReg bits drive it
+static void fake_raise(uint8_t irq) {
+  fake.regs[REG_COM_IRQ] |= irq;
+  if (fake.irq_wired && (fake.regs[REG_COM_IEN] & irq & 0x7F)) rfid_detect_irq(*fake.det);
+}
+
+static void fake_start_send() {
+  fake.reqas++;
+  if (powered_down() || !antenna_on()) {
+    fake.reqas_asleep++;
+    fake.answer_at_ms = fake.now_ms + TAUTO_MS;
+    fake.answer_irq = IRQ_TIMER;
+    fake.answer_err = 0;
+    fake.answer_level = 0;
+    return;
+  }
+  int answering = 0;
+  bool settled = fake.now_ms - fake.antenna_on_ms >= SETTLE_NEEDED_MS;
+  for (const Tag& t : fake.tags) answering += settled && in_field(t) && !t.halted;
+  if (answering > 0) {
+    fake.answer_at_ms = fake.now_ms + ATQA_MS;
+    fake.answer_irq = IRQ_RX | IRQ_IDLE;
+    fake.answer_err = answering > 1 ? ERR_COLL : 0;
+    if (fake.noise) fake.answer_err |= ERR_PROTOCOL;
+    fake.noise = false;
+    fake.answer_level = 2;
+  } else {
+    fake.answer_at_ms = fake.now_ms + TAUTO_MS;
+    fake.answer_irq = IRQ_TIMER;
+    fake.answer_err = 0;
+    fake.answer_level = 0;
+  }
+}
+
+static uint8_t fake_read(void* ctx, uint8_t reg) {
+  (void)ctx;
+  return fake.regs[reg & 0x3F];
+}
+
+static void fake_write(void* ctx, uint8_t reg, uint8_t value) {
+  (void)ctx;
+  reg &= 0x3F;
+  switch (reg) {
+    case REG_COM_IRQ:
+      // Bit 7 set: set the marked bits, else clear them
+      if (value & 0x80) fake.regs[reg] |= value & 0x7F;
+      else fake.regs[reg] &= ~value;
+      return;
+    case REG_FIFO_LEVEL:
+      if (value & 0x80) {
+        fake.regs[REG_FIFO_LEVEL] = 0;
+        fake.reqa_in_fifo = false;
+      }
+      return;
+    case REG_FIFO_DATA:
+      fake.reqa_in_fifo = value == 0x26;
+      fake.regs[REG_FIFO_LEVEL]++;
+      return;
+    case REG_TX_CONTROL: {
+      bool was_on = antenna_on();
+      fake.regs[reg] = value;
+      if (!was_on && antenna_on()) fake.antenna_on_ms = fake.now_ms;
+      if (was_on && !antenna_on()) fake.antenna_total_ms += fake.now_ms - fake.antenna_on_ms;
+      return;
+    }
+    case REG_COMMAND:
+      fake.regs[reg] = value;
+      if ((value & 0x0F) == CMD_IDLE) fake.answer_at_ms = -1;
+      return;
+    case REG_BIT_FRAMING:
+      fake.regs[reg] = value;
+      if ((value & 0x80) && (fake.regs[REG_COMMAND] & 0x0F) == CMD_TRANSCEIVE && fake.reqa_in_fifo) {
+        fake_start_send();
+      }
+      return;
+    default:
+      fake.regs[reg] = value;
+      return;
+  }
+}
+
+static void fake_tick() {
+  if (fake.answer_at_ms >= 0 && (int32_t)fake.now_ms >= fake.answer_at_ms) {
+    fake.answer_at_ms = -1;
+    fake.regs[REG_ERROR] = fake.answer_err;
+    fake.regs[REG_FIFO_LEVEL] = fake.answer_level;
+    fake_raise(fake.answer_irq);
+  }
+  // A tag that leaves the field forgets HLTA
+  for (Tag& t : fake.tags) {
+    if (!in_field(t)) t.halted = false;
+  }
+}
+
+// ===================================================================
+// Scenarios
+// ===================================================================
+
+struct Reading {
+  uint32_t uid;
+  uint32_t at_ms;
+};
+
+struct Outcome {
+  std::vector<Reading> reads;
+  RfidDetectStats stats;
+  uint32_t duration_ms;
+  uint32_t antenna_ms;
+  uint32_t reqas_asleep;
+};
+
+// The loop: update every tick; on a card, read the first answering tag
+// (anticollision picks one) and halt it, as rfid_read() does
+static Outcome run(const std::vector<Tag>& tags, bool use_irq, uint32_t period_ms, uint32_t tick_ms,
+                   uint32_t duration_ms, uint32_t noise_at_ms = 0, bool irq_wired = true) {
+  static RfidDetector det;
+  fake = FakeReader();
+  fake.answer_at_ms = -1;
+  fake.tags = tags;
+  fake.det = &det;
+  fake.irq_wired = irq_wired;
+  fake.regs[REG_COMMAND] = CMD_IDLE;
+  
+  RfidRegisterIO io = {fake_read, fake_write, nullptr};
+  rfid_detect_init(det, io, use_irq, period_ms, 0);
+  
+  Outcome out = {};
+  for (fake.now_ms = 0; fake.now_ms < duration_ms; fake.now_ms++) {
+    if (noise_at_ms && fake.now_ms == noise_at_ms) fake.noise = true;
+    fake_tick();
+    if (fake.now_ms % tick_ms) continue;
+    if (!rfid_detect_update(det, fake.now_ms)) continue;
+    
+    for (Tag& t : fake.tags) {
+      if (in_field(t) && !t.halted) {
+        out.reads.push_back({t.uid, fake.now_ms});
+        t.halted = true;
+        break;
+      }
+    }
+    rfid_detect_card_done(det, fake.now_ms);
+  }
+  if (antenna_on()) fake.antenna_total_ms += fake.now_ms - fake.antenna_on_ms;
+  out.stats = det.stats;
+  out.duration_ms = duration_ms;
+  out.antenna_ms = fake.antenna_total_ms;
+  out.reqas_asleep = fake.reqas_asleep;
+  return out;
+}
+
+static void report(const char* name, bool use_irq, const Outcome& o) {
+  const RfidDetectStats& s = o.stats;
+  double secs = o.duration_ms / 1000.0;
+  printf("%-9s %-6s  reads %2zu  probes %4u  irqs %4u  timeouts %3u  SPI %5.0f rd/s %5.0f wr/s  "
+         "antenna %4.1f%%  latency max %3u ms\n",
+         name, use_irq ? "irq" : "polled", o.reads.size(), s.probes, s.irqs, s.timeouts,
+         s.spi_reads / secs, s.spi_writes / secs, 100.0 * o.antenna_ms / o.duration_ms, s.max_latency_ms);
+  if (verbose) {
+    for (const Reading& r : o.reads) printf("          read %08X at %u ms\n", r.uid, r.at_ms);
+  }
+}
+
+static uint32_t bound_ms(uint32_t period_ms, uint32_t tick_ms) {
+  // Just missed an empty probe: its timeout, a full period asleep, the
+  // settle, the ATQA, then the next tick for each step
+  return TAUTO_MS + period_ms + RFID_FIELD_SETTLE_MS + ATQA_MS + 2 * tick_ms;
+}
+
+static uint32_t present_spi_reads[2];
+
+static void scenario_present(bool use_irq, uint32_t period_ms, uint32_t tick_ms) {
+  const char* name = "present";
+  // Held 3 s, away 1 s, back for 2 s
+  std::vector<Tag> tags = {{0xA1, 500, 3500, false}, {0xA1, 4500, 6500, false}};
+  Outcome o = run(tags, use_irq, period_ms, tick_ms, 8000);
+  report(name, use_irq, o);
+  present_spi_reads[use_irq] = o.stats.spi_reads;
+  bool ok = o.reads.size() == 2 && o.reads[0].uid == 0xA1 && o.reads[1].uid == 0xA1;
+  expect(ok, name, "not one read per presentation");
+  if (ok) {
+    expect(o.reads[0].at_ms - 500 <= bound_ms(period_ms, tick_ms), name, "first read late");
+    expect(o.reads[1].at_ms - 4500 <= bound_ms(period_ms, tick_ms), name, "second read late");
+  }
+  expect(o.stats.max_latency_ms <= bound_ms(period_ms, tick_ms), name, "reported latency over bound");
+  expect(o.stats.cards == 2, name, "card count");
+  if (use_irq) {
+    expect(o.stats.timeouts == 0, name, "probe ended without the IRQ");
+    expect(o.stats.irqs == o.stats.probes || o.stats.irqs + 1 == o.stats.probes, name,
+           "a probe's IRQ went missing");
+  }
+  // Asleep between probes: the field is on for the settle and the REQA
+  double duty = (double)o.antenna_ms / o.duration_ms;
+  expect(duty < (RFID_FIELD_SETTLE_MS + TAUTO_MS + 2.0 * tick_ms) / period_ms, name, "antenna left on");
+}
+
+static void scenario_removed(bool use_irq, uint32_t period_ms, uint32_t tick_ms) {
+  const char* name = "removed";
+  // A tag swept past between probes, then an empty field
+  uint32_t brief = period_ms > 20 ? period_ms / 4 : 5;
+  std::vector<Tag> tags = {{0xB2, 1000 + RFID_FIELD_SETTLE_MS + TAUTO_MS + tick_ms, 0, false}};
+  tags[0].leave_ms = tags[0].arrive_ms + brief;
+  Outcome o = run(tags, use_irq, period_ms, tick_ms, 5000);
+  report(name, use_irq, o);
+  expect(o.reads.size() <= 1, name, "tag read twice");
+  expect(o.stats.cards == o.reads.size(), name, "card reported with no tag to read");
+  for (const Reading& r : o.reads) expect(r.at_ms < tags[0].leave_ms + tick_ms, name, "read after it left");
+}
+
+static void scenario_collision(bool use_irq, uint32_t period_ms, uint32_t tick_ms) {
+  const char* name = "collision";
+  std::vector<Tag> tags = {{0xC1, 700, 4000, false}, {0xC2, 700, 4000, false}};
+  Outcome o = run(tags, use_irq, period_ms, tick_ms, 5000);
+  report(name, use_irq, o);
+  bool both = o.reads.size() == 2 && o.reads[0].uid != o.reads[1].uid;
+  expect(both, name, "both tags not read once each");
+  if (both) {
+    // The second answers alone at the next probe
+    expect(o.reads[1].at_ms - o.reads[0].at_ms <= bound_ms(period_ms, tick_ms), name, "second tag late");
+  }
+}
+
+static void scenario_noise(bool use_irq, uint32_t period_ms, uint32_t tick_ms) {
+  const char* name = "noise";
+  std::vector<Tag> tags = {{0xD1, 1000, 4000, false}};
+  // The first ATQA after the tag arrives is corrupted
+  Outcome o = run(tags, use_irq, period_ms, tick_ms, 5000, 1000);
+  report(name, use_irq, o);
+  expect(o.reads.size() == 1, name, "tag not read once");
+  if (!o.reads.empty()) {
+    expect(o.reads[0].at_ms - 1000 > period_ms, name, "corrupted ATQA taken for a card");
+    expect(o.reads[0].at_ms - 1000 <= 2 * bound_ms(period_ms, tick_ms), name,
+           "no read at the probe after the corrupted one");
+  }
+}
+
+static void scenario_asleep(bool use_irq, uint32_t period_ms, uint32_t tick_ms) {
+  const char* name = "asleep";
+  std::vector<Tag> tags = {{0xE1, 0, 10000, false}};
+  Outcome o = run(tags, use_irq, period_ms, tick_ms, 10000);
+  expect(o.reqas_asleep == 0, name, "REQA sent with the reader powered down");
+  expect(o.reads.size() == 1, name, "tag in the field at boot not read once");
+}
+
+static void scenario_lost_irq(uint32_t period_ms, uint32_t tick_ms) {
+  const char* name = "lost irq";
+  std::vector<Tag> tags = {{0xF1, 500, 3000, false}};
+  Outcome o = run(tags, true, period_ms, tick_ms, 4000, 0, false);
+  report(name, true, o);
+  expect(o.stats.irqs == 0, name, "IRQ counted on a dead line");
+  expect(o.stats.timeouts == o.stats.probes, name, "probe ended without the timeout");
+  expect(o.reads.size() == 1, name, "tag not read once");
+  if (!o.reads.empty()) {
+    expect(o.reads[0].at_ms - 500 <= bound_ms(period_ms, tick_ms) + RFID_PROBE_TIMEOUT_MS, name, "read late");
+  }
+}
+
+int main(int argc, char** argv) {
+  uint32_t period_ms = 100;
+  uint32_t tick_ms = 10;
+  
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--period") && i + 1 < argc) {
+      period_ms = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--tick") && i + 1 < argc) {
+      tick_ms = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "-v")) {
+      verbose = true;
+    } else {
+      fprintf(stderr, "usage: %s [--period MS] [--tick MS] [-v]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (tick_ms == 0) tick_ms = 1;
+  
+  printf("probe every %u ms, update every %u ms, detection bound %u ms\n\n", period_ms, tick_ms,
+         bound_ms(period_ms, tick_ms));
+  for (int irq = 1; irq >= 0; irq--) {
+    scenario_present(irq, period_ms, tick_ms);
+    scenario_removed(irq, period_ms, tick_ms);
+    scenario_collision(irq, period_ms, tick_ms);
+    scenario_noise(irq, period_ms, tick_ms);
+    scenario_asleep(irq, period_ms, tick_ms);
+  }
+  scenario_lost_irq(period_ms, tick_ms);
+  
+  // The IRQ line saves the ComIrqReg polls while a probe is in flight
+  expect(present_spi_reads[1] < present_spi_reads[0], "irq", "no fewer SPI reads than polled");
+  
+  printf("%s\n", failures ? "FAIL" : "ok");
+  return failures ? 1 : 0;
+}
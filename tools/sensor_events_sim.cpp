@@ -0,0 +1,285 @@
+// ===================================================================
+// Sensor Event Dispatch Simulation (host)
+// ===================================================================
+// Runs the firmware's data-ready event dispatch (src/sensor_events)
+// against a simulated interrupt source:
+//   queue      on a virtual clock: every event dispatched once, in
+//              order, with its ISR capture time; coalesced sources fold
+//              a backlog into one call carrying the newest time; posts
+//              to a full queue count as overruns; the wake hook runs
+//              per post; latency stats match capture-to-dispatch
+//   live       an interrupt thread fires the IMU (--imu-hz) and ToF
+//              (50 ms timing budget) while a sensing thread sleeps
+//              until woken and dispatches, as on the stick: latency
+//              p50/p99/max per source, overruns
+//   slow       the same with a handler that holds the sensing thread
+//              for --busy ms: IMU events coalesce or overrun, but ToF
+//              ranges are still consumed within the timing budget and
+//              the latency stats still match what the handlers saw
+// One thread posts both sources, as one core's GPIO ISR would, so each
+// queue keeps a single producer.
+//
+//   g++ -O2 -std=c++17 -pthread -Isrc tools/sensor_events_sim.cpp src/sensor_events.cpp -o sensor_events_sim
+//   ./sensor_events_sim [--seconds N] [--imu-hz N] [--busy MS] [-v]
+// ===================================================================
+
+#include "sensor_events.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define TOF_BUDGET_US 50000
+
+static bool verbose = false;
+static int failures = 0;
+
+static void expect(bool ok, const char* scenario, const char* what) {
+  if (ok) return;
+  printf("  FAIL %s: %s\n", scenario, what);
+  failures++;
+}
+
+// ===================================================================
+// Queue Checks (virtual clock)
+// ===================================================================
+
+struct Recorder {
+  std::vector<uint32_t> t_us;
+};
+
+static void record(uint32_t t_us, void* ctx) {
+  ((Recorder*)ctx)->t_us.push_back(t_us);
+}
+
+static uint32_t wakes = 0;
+
+static void count_wake() {
+  wakes++;
+}
+
+static void scenario_queue() {
+  const char* name = "queue";
+  Recorder imu, tof;
+  sensor_events_init();
+  sensor_events_set_handler(SENSOR_EVENT_IMU_READY, record, &imu, true);
+  sensor_events_set_handler(SENSOR_EVENT_TOF_READY, record, &tof, false);
+  wakes = 0;
+  sensor_events_set_wake(count_wake);
+  
+  // One of each, dispatched at once
+  sensor_events_post(SENSOR_EVENT_IMU_READY, 1000);
+  sensor_events_post(SENSOR_EVENT_TOF_READY, 1200);
+  expect(sensor_events_pending(), name, "posted events not pending");
+  expect(sensor_events_dispatch(1500) == 2, name, "dispatch count");
+  expect(!sensor_events_pending(), name, "events left after dispatch");
+  expect(imu.t_us.size() == 1 && imu.t_us[0] == 1000, name, "IMU capture time");
+  expect(tof.t_us.size() == 1 && tof.t_us[0] == 1200, name, "ToF capture time");
+  
+  // A backlog: ToF handled one by one in order, IMU folded into the newest
+  imu.t_us.clear();
+  tof.t_us.clear();
+  for (uint32_t i = 0; i < 10; i++) {
+    sensor_events_post(SENSOR_EVENT_IMU_READY, 10000 + i * 1000);
+    if (i % 2 == 0) sensor_events_post(SENSOR_EVENT_TOF_READY, 10000 + i * 1000);
+  }
+  expect(sensor_events_dispatch(25000) == 6, name, "backlog dispatch count");
+  expect(imu.t_us.size() == 1 && imu.t_us[0] == 19000, name, "coalesced IMU call not the newest");
+  bool in_order = tof.t_us.size() == 5;
+  for (size_t i = 0; in_order && i < tof.t_us.size(); i++) in_order = tof.t_us[i] == 10000 + i * 2000;
+  expect(in_order, name, "ToF events not delivered once each, in order");
+  
+  SensorEventStats s = sensor_events_get_stats();
+  expect(s.posted[SENSOR_EVENT_IMU_READY] == 11 && s.dispatched[SENSOR_EVENT_IMU_READY] == 11, name,
+         "coalesced events not counted as dispatched");
+  expect(s.posted[SENSOR_EVENT_TOF_READY] == 6 && s.dispatched[SENSOR_EVENT_TOF_READY] == 6, name,
+         "ToF posted/dispatched counts");
+  // Oldest ToF waited 15 ms; coalescing measures the newest IMU event
+  expect(s.max_latency_us[SENSOR_EVENT_TOF_READY] == 15000, name, "ToF max latency");
+  expect(s.max_latency_us[SENSOR_EVENT_IMU_READY] == 6000, name, "IMU max latency");
+  expect(wakes == 17, name, "wake hook not run per post");
+  
+  // Overrun: more posts than slots before the task runs
+  for (uint32_t i = 0; i < SENSOR_EVENT_QUEUE_SIZE + 4; i++) {
+    sensor_events_post(SENSOR_EVENT_TOF_READY, 30000 + i);
+  }
+  s = sensor_events_get_stats();
+  expect(s.overruns[SENSOR_EVENT_TOF_READY] == 4, name, "overruns not counted");
+  tof.t_us.clear();
+  sensor_events_dispatch(40000);
+  expect(tof.t_us.size() == SENSOR_EVENT_QUEUE_SIZE && tof.t_us.front() == 30000, name,
+         "queued events lost on overrun");
+  
+  // No handler: still drained and counted
+  sensor_events_set_handler(SENSOR_EVENT_TOF_READY, nullptr, nullptr, false);
+  sensor_events_post(SENSOR_EVENT_TOF_READY, 50000);
+  expect(sensor_events_dispatch(50100) == 1 && !sensor_events_pending(), name, "unhandled event kept");
+  
+  printf("%-6s  posted %u/%u  dispatched %u/%u  overruns %u/%u  max latency %u/%u us  (IMU/ToF)\n", name,
+         s.posted[0], s.posted[1], s.dispatched[0], s.dispatched[1], s.overruns[0], s.overruns[1],
+         s.max_latency_us[0], s.max_latency_us[1]);
+}
+
+// ===================================================================
+// Live Dispatch (threads)
+// ===================================================================
+
+static std::chrono::steady_clock::time_point clock0;
+
+static uint32_t now_us() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - clock0).count();
+}
+
+// The sensing task's notification
+static std::mutex wake_mutex;
+static std::condition_variable wake_cv;
+static bool woken = false;
+
+static void wake_task() {
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex);
+    woken = true;
+  }
+  wake_cv.notify_one();
+}
+
+struct LiveSource {
+  std::vector<uint32_t> latency_us;   // Measured in the handler
+  uint32_t calls = 0;
+  uint32_t last_t_us = 0;
+  uint32_t out_of_order = 0;
+  uint32_t busy_ms = 0;               // Held in the handler
+};
+
+static void live_handler(uint32_t t_us, void* ctx) {
+  LiveSource& src = *(LiveSource*)ctx;
+  uint32_t now = now_us();
+  src.latency_us.push_back(now - t_us);
+  if (src.calls && t_us <= src.last_t_us) src.out_of_order++;
+  src.last_t_us = t_us;
+  src.calls++;
+  if (src.busy_ms) std::this_thread::sleep_for(std::chrono::milliseconds(src.busy_ms));
+}
+
+static uint32_t percentile(std::vector<uint32_t> v, double p) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  return v[(size_t)(p * (v.size() - 1))];
+}
+
+static void scenario_live(const char* name, uint32_t seconds, uint32_t imu_hz, uint32_t busy_ms) {
+  LiveSource imu, tof;
+  imu.busy_ms = busy_ms;
+  sensor_events_init();
+  sensor_events_set_handler(SENSOR_EVENT_IMU_READY, live_handler, &imu, true);
+  sensor_events_set_handler(SENSOR_EVENT_TOF_READY, live_handler, &tof, false);
+  sensor_events_set_wake(wake_task);
+  sensor_events_set_clock(now_us);
+  clock0 = std::chrono::steady_clock::now();
+  woken = false;
+  
+  std::atomic<bool> running(true);
+  uint32_t tof_fired = 0, imu_fired = 0;
+  std::thread isr([&]() {
+    uint32_t imu_period = 1000000 / imu_hz;
+    uint32_t next_imu = imu_period, next_tof = TOF_BUDGET_US;
+    uint32_t end = seconds * 1000000u;
+    for (;;) {
+      uint32_t next = std::min(next_imu, next_tof);
+      if (next >= end) break;
+      std::this_thread::sleep_until(clock0 + std::chrono::microseconds(next));
+      uint32_t t = now_us();
+      if (next == next_imu) {
+        sensor_events_post(SENSOR_EVENT_IMU_READY, t);
+        imu_fired++;
+        next_imu += imu_period;
+      }
+      if (next == next_tof) {
+        sensor_events_post(SENSOR_EVENT_TOF_READY, t);
+        tof_fired++;
+        next_tof += TOF_BUDGET_US;
+      }
+    }
+    running = false;
+    wake_task();
+  });
+  
+  // The sensing task: sleep until woken, dispatch everything queued
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(wake_mutex);
+      wake_cv.wait_for(lock, std::chrono::milliseconds(100), [] { return woken; });
+      woken = false;
+    }
+    sensor_events_dispatch(now_us());
+    if (!running && !sensor_events_pending()) break;
+  }
+  isr.join();
+  
+  SensorEventStats s = sensor_events_get_stats();
+  printf("%-6s  IMU %4u Hz: %6u fired, %6u calls, %4u overruns, latency p50 %5u p99 %5u max %6u us\n",
+         name, imu_hz, imu_fired, imu.calls, s.overruns[SENSOR_EVENT_IMU_READY],
+         percentile(imu.latency_us, 0.5), percentile(imu.latency_us, 0.99),
+         percentile(imu.latency_us, 1.0));
+  printf("        ToF   20 Hz: %6u fired, %6u calls, %4u overruns, latency p50 %5u p99 %5u max %6u us\n",
+         tof_fired, tof.calls, s.overruns[SENSOR_EVENT_TOF_READY], percentile(tof.latency_us, 0.5),
+         percentile(tof.latency_us, 0.99), percentile(tof.latency_us, 1.0));
+  if (verbose) {
+    printf("        stats max latency IMU %u us, ToF %u us\n", s.max_latency_us[SENSOR_EVENT_IMU_READY],
+           s.max_latency_us[SENSOR_EVENT_TOF_READY]);
+  }
+  
+  // The stats agree with what the handlers saw
+  uint32_t tof_max = percentile(tof.latency_us, 1.0);
+  expect(s.max_latency_us[SENSOR_EVENT_TOF_READY] <= tof_max &&
+         s.max_latency_us[SENSOR_EVENT_TOF_READY] + 1000 >= tof_max, name, "ToF latency stat off");
+  
+  expect(imu.out_of_order == 0 && tof.out_of_order == 0, name, "capture times went backwards");
+  expect(s.posted[SENSOR_EVENT_IMU_READY] + s.overruns[SENSOR_EVENT_IMU_READY] == imu_fired, name,
+         "IMU posts unaccounted for");
+  expect(s.dispatched[SENSOR_EVENT_IMU_READY] == s.posted[SENSOR_EVENT_IMU_READY], name,
+         "IMU events left undispatched");
+  expect(tof.calls == tof_fired && s.overruns[SENSOR_EVENT_TOF_READY] == 0, name, "ToF ranges lost");
+  expect(percentile(tof.latency_us, 1.0) < TOF_BUDGET_US, name, "ToF latency over the timing budget");
+  if (busy_ms) {
+    expect(imu.calls < imu_fired, name, "slow handler did not coalesce");
+  } else {
+    expect(s.overruns[SENSOR_EVENT_IMU_READY] == 0, name, "IMU overruns with an idle task");
+  }
+}
+
+int main(int argc, char** argv) {
+  uint32_t seconds = 3;
+  uint32_t imu_hz = 1000;
+  uint32_t busy_ms = 30;
+  
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+      seconds = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--imu-hz") && i + 1 < argc) {
+      imu_hz = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--busy") && i + 1 < argc) {
+      busy_ms = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "-v")) {
+      verbose = true;
+    } else {
+      fprintf(stderr, "usage: %s [--seconds N] [--imu-hz N] [--busy MS] [-v]\n", argv[0]);
+      return 1;
+    }
+  }
+  
+  printf("%d-slot queues, ToF timing budget %d ms\n\n", SENSOR_EVENT_QUEUE_SIZE, TOF_BUDGET_US / 1000);
+  scenario_queue();
+  scenario_live("live", seconds, imu_hz, 0);
+  scenario_live("slow", seconds, imu_hz, busy_ms);
+  
+  printf("%s\n", failures ? "FAIL" : "ok");
+  return failures ? 1 : 0;
+}
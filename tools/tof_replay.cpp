@@ -0,0 +1,280 @@
+// ===================================================================
+// ToF Alert Replay Benchmark (host)
+// ===================================================================
+// Replays range traces through the firmware's tracker (src/tof_tracker)
+// and through the old single-sample threshold rule, and reports false
+// alerts, warning lead time and per-sample cost for both.
+//
+// Trace CSV, one range per line:  t_ms,distance_mm,label
+//   distance_mm  -1 for no target
+//   label        0 = nothing to warn about (any alert is false)
+//                1 = approaching a hazard
+//                2 = impact (end of an approach; lead time is measured
+//                    from the first alert of the preceding approach)
+//
+//   g++ -O2 -std=c++17 -Isrc tools/tof_replay.cpp src/tof_tracker.cpp -o tof_replay
+//   ./tof_replay trace1.csv trace2.csv ...
+//   ./tof_replay --synthetic [--write DIR]
+// ===================================================================
+
+#include "tof_tracker.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#define PROXIMITY_MM        800    // Config default obstacle_threshold_mm
+#define MAX_INTERVAL_MS     1000   // OBSTACLE_ALERT_COOLDOWN_MS
+#define RANGE_PERIOD_MS     33
+
+struct Sample {
+  uint32_t t_ms;
+  int16_t distance_mm;
+  uint8_t label;
+};
+
+struct Trace {
+  std::string name;
+  std::vector<Sample> samples;
+};
+
+struct Result {
+  uint32_t alerts = 0;
+  uint32_t false_alerts = 0;
+  uint32_t hazards = 0;
+  uint32_t warned = 0;
+  double lead_total_ms = 0;
+  double lead_min_ms = 1e9;
+  double quiet_ms = 0;          // Time spent in label-0 samples
+  double replay_ns = 0;
+  size_t samples = 0;
+};
+
+// ===================================================================
+// Trace Loading and Synthesis
+// ===================================================================
+
+static bool load_trace(const char* path, Trace& trace) {
+  FILE* f = fopen(path, "r");
+  if (!f) return false;
+  trace.name = path;
+  char line[128];
+  while (fgets(line, sizeof(line), f)) {
+    unsigned long t;
+    int d, label = 0;
+    if (sscanf(line, "%lu,%d,%d", &t, &d, &label) >= 2) {
+      trace.samples.push_back({(uint32_t)t, (int16_t)d, (uint8_t)label});
+    }
+  }
+  fclose(f);
+  return true;
+}
+
+// Range noise, dropouts and spurious returns roughly as seen on the VL53L1X
+struct Sensor {
+  std::mt19937 rng;
+  std::normal_distribution<float> noise{0.0f, 15.0f};
+  std::uniform_real_distribution<float> u{0.0f, 1.0f};
+  
+  explicit Sensor(uint32_t seed) : rng(seed) {}
+  
+  int16_t measure(float true_mm) {
+    float p = u(rng);
+    if (p < 0.02f) return -1;                                   // Dropout
+    if (p < 0.05f) return (int16_t)(200 + u(rng) * 3500);       // Spurious
+    return (int16_t)std::lround(true_mm + noise(rng));
+  }
+};
+
+// Walk at speed_mm_s from start_mm until the target is at impact_mm
+static Trace synth_approach(const char* name, float start_mm, float speed_mm_s,
+                           float impact_mm, uint32_t seed) {
+  Trace trace{name, {}};
+  Sensor sensor(seed);
+  uint32_t t = 0;
+  
+  // Two seconds standing still first
+  for (; t < 2000; t += RANGE_PERIOD_MS) trace.samples.push_back({t, sensor.measure(start_mm), 0});
+  
+  float d = start_mm;
+  while (d > impact_mm) {
+    float ttc_ms = (d - impact_mm) / speed_mm_s * 1000.0f;
+    trace.samples.push_back({t, sensor.measure(d), (uint8_t)(ttc_ms <= 3000 ? 1 : 0)});
+    t += RANGE_PERIOD_MS;
+    d -= speed_mm_s * RANGE_PERIOD_MS / 1000.0f;
+  }
+  trace.samples.push_back({t, sensor.measure(impact_mm), 2});
+  return trace;
+}
+
+static Trace synth_static(const char* name, float distance_mm, uint32_t duration_ms, uint32_t seed) {
+  Trace trace{name, {}};
+  Sensor sensor(seed);
+  for (uint32_t t = 0; t < duration_ms; t += RANGE_PERIOD_MS) {
+    trace.samples.push_back({t, sensor.measure(distance_mm), 0});
+  }
+  return trace;
+}
+
+// Walking past a wall at a steady lateral distance with a slow sway
+static Trace synth_parallel(const char* name, uint32_t duration_ms, uint32_t seed) {
+  Trace trace{name, {}};
+  Sensor sensor(seed);
+  for (uint32_t t = 0; t < duration_ms; t += RANGE_PERIOD_MS) {
+    float d = 1200.0f + 150.0f * std::sin(t * 0.002f);
+    trace.samples.push_back({t, sensor.measure(d), 0});
+  }
+  return trace;
+}
+
+static std::vector<Trace> synthetic_traces() {
+  std::vector<Trace> traces;
+  for (uint32_t seed = 1; seed <= 20; seed++) {
+    traces.push_back(synth_approach("approach_walk", 3500, 1200, 300, seed));
+    traces.push_back(synth_approach("approach_fast", 4000, 2000, 300, seed + 100));
+    traces.push_back(synth_approach("approach_slow", 2500, 500, 300, seed + 200));
+    traces.push_back(synth_static("static_1500", 1500, 60000, seed + 300));
+    traces.push_back(synth_parallel("parallel_wall", 60000, seed + 400));
+  }
+  return traces;
+}
+
+static void write_trace(const Trace& trace, const char* dir, int index) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%02d_%s.csv", dir, index, trace.name.c_str());
+  FILE* f = fopen(path, "w");
+  if (!f) return;
+  for (const Sample& s : trace.samples) fprintf(f, "%u,%d,%u\n", s.t_ms, s.distance_mm, s.label);
+  fclose(f);
+}
+
+// ===================================================================
+// Replay
+// ===================================================================
+
+static void score_alert(Result& r, const Sample& s, bool& in_warning, uint32_t& first_alert_ms) {
+  r.alerts++;
+  if (s.label == 0) {
+    r.false_alerts++;
+  } else if (!in_warning) {
+    in_warning = true;
+    first_alert_ms = s.t_ms;
+  }
+}
+
+static void score_sample(Result& r, const Sample& s, const Sample* prev,
+                         bool& in_warning, uint32_t& first_alert_ms) {
+  if (s.label == 0) {
+    if (prev) r.quiet_ms += s.t_ms - prev->t_ms;
+    in_warning = false;
+  }
+  if (s.label == 2) {
+    r.hazards++;
+    if (in_warning) {
+      double lead = (double)(s.t_ms - first_alert_ms);
+      r.warned++;
+      r.lead_total_ms += lead;
+      if (lead < r.lead_min_ms) r.lead_min_ms = lead;
+    }
+    in_warning = false;
+  }
+}
+
+static void replay_tracker(const Trace& trace, Result& r) {
+  TofTracker trk;
+  TofAlertPacer pacer;
+  tof_tracker_init(trk);
+  tof_pacer_init(pacer);
+  bool in_warning = false;
+  uint32_t first_alert_ms = 0;
+  
+  auto t0 = std::chrono::steady_clock::now();
+  std::vector<uint8_t> fired(trace.samples.size());
+  for (size_t i = 0; i < trace.samples.size(); i++) {
+    const Sample& s = trace.samples[i];
+    TofThreat threat = tof_tracker_update(trk, s.distance_mm, s.distance_mm > 0, s.t_ms, PROXIMITY_MM);
+    fired[i] = tof_pacer_should_alert(pacer, threat, s.t_ms, MAX_INTERVAL_MS);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  r.replay_ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+  r.samples += trace.samples.size();
+  
+  for (size_t i = 0; i < trace.samples.size(); i++) {
+    const Sample& s = trace.samples[i];
+    if (fired[i]) score_alert(r, s, in_warning, first_alert_ms);
+    score_sample(r, s, i ? &trace.samples[i - 1] : nullptr, in_warning, first_alert_ms);
+  }
+}
+
+// The rule this replaced: any raw range under the threshold, fixed cooldown
+static void replay_threshold(const Trace& trace, Result& r) {
+  uint32_t last_alert = 0;
+  bool alerted = false;
+  bool in_warning = false;
+  uint32_t first_alert_ms = 0;
+  
+  for (size_t i = 0; i < trace.samples.size(); i++) {
+    const Sample& s = trace.samples[i];
+    if (s.distance_mm > 0 && s.distance_mm < PROXIMITY_MM &&
+        (!alerted || s.t_ms - last_alert >= MAX_INTERVAL_MS)) {
+      alerted = true;
+      last_alert = s.t_ms;
+      score_alert(r, s, in_warning, first_alert_ms);
+    }
+    score_sample(r, s, i ? &trace.samples[i - 1] : nullptr, in_warning, first_alert_ms);
+  }
+}
+
+static void report(const char* name, const Result& r) {
+  double quiet_min = r.quiet_ms / 60000.0;
+  printf("%-10s alerts %5u  false %4u (%.2f/min)  warned %u/%u hazards",
+         name, r.alerts, r.false_alerts, quiet_min > 0 ? r.false_alerts / quiet_min : 0.0,
+         r.warned, r.hazards);
+  if (r.warned) {
+    printf("  lead mean %.0f ms min %.0f ms", r.lead_total_ms / r.warned, r.lead_min_ms);
+  }
+  if (r.samples) printf("  %.0f ns/sample", r.replay_ns / r.samples);
+  printf("\n");
+}
+
+int main(int argc, char** argv) {
+  std::vector<Trace> traces;
+  const char* write_dir = nullptr;
+  
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--synthetic") == 0) {
+      std::vector<Trace> synth = synthetic_traces();
+      traces.insert(traces.end(), synth.begin(), synth.end());
+    } else if (strcmp(argv[i], "--write") == 0 && i + 1 < argc) {
+      write_dir = argv[++i];
+    } else {
+      Trace trace;
+      if (!load_trace(argv[i], trace)) {
+        perror(argv[i]);
+        return 1;
+      }
+      traces.push_back(trace);
+    }
+  }
+  
+  if (traces.empty()) {
+    fprintf(stderr, "usage: %s [--synthetic] [--write DIR] [trace.csv ...]\n", argv[0]);
+    return 1;
+  }
+  
+  Result tracker, threshold;
+  for (size_t i = 0; i < traces.size(); i++) {
+    if (write_dir) write_trace(traces[i], write_dir, (int)i);
+    replay_tracker(traces[i], tracker);
+    replay_threshold(traces[i], threshold);
+  }
+  
+  printf("%zu traces\n", traces.size());
+  report("tracker", tracker);
+  report("threshold", threshold);
+  return 0;
+}
@@ -0,0 +1,309 @@
+// ===================================================================
+// ToF Zone Scan Replay (host)
+// ===================================================================
+// Feeds synthetic per-zone ranges through the firmware's zone scheduler
+// and obstacle map (src/tof_zones) on a virtual millisecond clock. The
+// sensor model ranges the zone it was last programmed for; each range
+// takes its timing budget plus an overhead (fixed part plus jitter),
+// and a budget change costs a stop/start. The reading reaches the map
+// a few milliseconds after it was captured, as through tof_ring.
+//   sweep      zones ranged left, centre, right in turn; each range is
+//              filed under the zone it measured; every zone refreshed
+//              within a sweep; sweep stats match what was ranged
+//   focus      an obstacle moving across the zones gets the longest
+//              budget wherever it is
+//   overhead   whatever the per-range overhead (2-11 ms), the measured
+//              rebalance keeps every sweep within 100 ms (>= 10 Hz)
+//   stall      ranges stop for 600 ms: each zone reads stale exactly
+//              300 ms after its last range, and all are fresh again
+//              within two sweeps of the restart
+//
+//   g++ -O2 -std=c++17 -Isrc tools/tof_zones_replay.cpp src/tof_zones.cpp -o tof_zones_replay
+//   ./tof_zones_replay [--seconds N] [--seed N] [-v]
+// ===================================================================
+
+#include "tof_zones.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+
+#define WARMUP_MS        1000   // Overhead estimate settling
+#define RESTART_MS       3      // stopRanging/startRanging on a budget change
+#define READ_DELAY_MAX   3      // Capture to map, through the worker and ring
+
+static bool verbose = false;
+static int failures = 0;
+
+static void expect(bool ok, const char* scenario, const char* what) {
+  if (ok) return;
+  printf("  FAIL %s: %s\n", scenario, what);
+  failures++;
+}
+
+// Ground truth: distance in each zone at t, -1 for nothing in range
+typedef int16_t (*SceneFn)(uint8_t zone, uint32_t t_ms);
+
+struct RunConfig {
+  const char* name;
+  SceneFn scene;
+  uint32_t duration_ms;
+  uint16_t overhead_ms;       // Fixed part of each range beyond its budget
+  uint16_t jitter_ms;         // Plus 0..jitter
+  uint32_t stall_from_ms;     // No ranges in [from, to); 0 = none
+  uint32_t stall_to_ms;
+  uint32_t seed;
+};
+
+struct Delivery {
+  uint32_t at_ms;             // Reaches the map
+  uint8_t zone;
+  int16_t distance_mm;
+  bool valid;
+  uint32_t timestamp_ms;
+};
+
+struct RunResult {
+  TofZoneScheduler sched;
+  uint32_t ranges;
+  uint32_t sweeps;            // Counted by the sim, last-zone to last-zone
+  uint32_t max_sweep_ms;      // After warmup
+  uint32_t slow_sweeps;       // After warmup
+  uint32_t max_age_ms;        // Oldest zone entry seen, outside the stall
+  uint32_t misfiled;          // Range filed under a zone it did not measure
+  uint32_t out_of_order;      // Zone sequence not left, centre, right
+  uint32_t stale_wrong;       // Map said fresh when stale, or the reverse
+  uint32_t focus_checks;
+  uint32_t focus_wrong;       // Nearest zone not given the longest budget
+  uint32_t focus_raised;      // Nearest zone above the shortest budget
+  uint32_t fresh_after_stall_ms;
+};
+
+static RunResult run(const RunConfig& cfg) {
+  std::mt19937 rng(cfg.seed);
+  std::uniform_int_distribution<int> jitter(0, cfg.jitter_ms);
+  std::uniform_int_distribution<int> noise(-15, 15);
+  std::uniform_int_distribution<int> delay(1, READ_DELAY_MAX);
+  std::uniform_int_distribution<int> dropout(0, 49);
+  
+  RunResult r;
+  memset(&r, 0, sizeof(r));
+  
+  TofZoneScheduler& sched = r.sched;
+  TofObstacleMap map;
+  tof_map_init(map);
+  
+  TofZoneStep step = tof_zone_scheduler_init(sched);
+  uint8_t ranging_zone = step.zone;
+  uint16_t ranging_budget = step.budget_ms;
+  uint32_t next_done = ranging_budget + cfg.overhead_ms + jitter(rng);
+  
+  std::deque<Delivery> pipe;
+  uint32_t last_ts[TOF_ZONE_COUNT] = {0};
+  bool seen[TOF_ZONE_COUNT] = {false};
+  uint32_t last_sweep_end = 0;
+  uint8_t expect_zone = step.zone;
+  bool stalled_before = false;
+  
+  for (uint32_t t = 0; t < cfg.duration_ms; t++) {
+    bool stalled = cfg.stall_from_ms && t >= cfg.stall_from_ms && t < cfg.stall_to_ms;
+    if (stalled) {
+      next_done = cfg.stall_to_ms + ranging_budget + cfg.overhead_ms;
+    }
+    
+    // Sensor: a range completes for the zone it was programmed with
+    if (!stalled && t == next_done) {
+      int16_t truth = cfg.scene(ranging_zone, t);
+      bool valid = truth > 0 && dropout(rng) != 0;
+      int16_t mm = valid ? (int16_t)(truth + noise(rng)) : -1;
+      
+      if (ranging_zone != expect_zone) r.out_of_order++;
+      uint8_t filed = sched.current;
+      if (filed != ranging_zone) r.misfiled++;
+      step = tof_zone_scheduler_advance(sched, mm, t);
+      r.ranges++;
+      pipe.push_back({t + delay(rng), filed, mm, valid, t});
+      
+      if (filed == TOF_ZONE_COUNT - 1) {
+        if (last_sweep_end) {
+          uint32_t sweep = t - last_sweep_end;
+          r.sweeps++;
+          if (t > WARMUP_MS) {
+            if (sweep > r.max_sweep_ms) r.max_sweep_ms = sweep;
+            if (sweep > TOF_ZONE_SWEEP_TARGET_MS) r.slow_sweeps++;
+          }
+        }
+        last_sweep_end = t;
+        
+        // The zone that was nearest this sweep should now have the
+        // longest budget
+        int focus = -1;
+        for (int z = 0; z < TOF_ZONE_COUNT; z++) {
+          if (sched.last_mm[z] > 0 && (focus < 0 || sched.last_mm[z] < sched.last_mm[focus])) focus = z;
+        }
+        if (focus >= 0) {
+          r.focus_checks++;
+          if (sched.budget_ms[focus] > 20) r.focus_raised++;
+          for (int z = 0; z < TOF_ZONE_COUNT; z++) {
+            if (sched.budget_ms[z] > sched.budget_ms[focus]) {
+              r.focus_wrong++;
+              break;
+            }
+          }
+        }
+      }
+      
+      expect_zone = (ranging_zone + 1) % TOF_ZONE_COUNT;
+      ranging_zone = step.zone;
+      ranging_budget = step.budget_ms;
+      next_done = t + ranging_budget + cfg.overhead_ms + jitter(rng);
+      if (step.budget_changed) next_done += RESTART_MS;
+    }
+    
+    // Consumer: deliveries reach the map, then the map is read
+    while (!pipe.empty() && pipe.front().at_ms <= t) {
+      const Delivery& d = pipe.front();
+      tof_map_update(map, d.zone, d.distance_mm, d.valid, d.timestamp_ms);
+      last_ts[d.zone] = d.timestamp_ms;
+      seen[d.zone] = true;
+      pipe.pop_front();
+    }
+    
+    bool all_fresh = true;
+    for (int z = 0; z < TOF_ZONE_COUNT; z++) {
+      if (!seen[z]) {
+        all_fresh = false;
+        continue;
+      }
+      uint32_t age = t - last_ts[z];
+      int16_t d = tof_map_distance(map, z, t);
+      bool stale = age > TOF_ZONE_MAX_AGE_MS;
+      bool valid = map.zones[z].valid;
+      if (stale && d != -1) r.stale_wrong++;
+      if (!stale && valid && d != map.zones[z].distance_mm) r.stale_wrong++;
+      if (stale) all_fresh = false;
+      bool in_stall = cfg.stall_from_ms && t >= cfg.stall_from_ms;
+      if (!in_stall && age > r.max_age_ms) r.max_age_ms = age;
+    }
+    
+    if (stalled) stalled_before = true;
+    if (stalled_before && !stalled && all_fresh && !r.fresh_after_stall_ms) {
+      r.fresh_after_stall_ms = t - cfg.stall_to_ms;
+    }
+    if (stalled) {
+      int16_t nearest;
+      if (t - cfg.stall_from_ms > TOF_ZONE_MAX_AGE_MS + READ_DELAY_MAX && tof_map_nearest(map, t, nearest) >= 0) {
+        r.stale_wrong++;
+      }
+    }
+  }
+  return r;
+}
+
+static void report(const RunConfig& cfg, const RunResult& r) {
+  const TofZoneStats& s = r.sched.stats;
+  printf("%-12s overhead %2u+%u ms  ranges %5u  sweeps %4u  sweep max %3u ms  slow %2u  "
+         "budgets %u/%u/%u  est. overhead %2u ms  max age %3u ms\n",
+         cfg.name, cfg.overhead_ms, cfg.jitter_ms, r.ranges, s.sweeps, r.max_sweep_ms, r.slow_sweeps,
+         r.sched.budget_ms[0], r.sched.budget_ms[1], r.sched.budget_ms[2], r.sched.overhead_ms, r.max_age_ms);
+  if (verbose) {
+    printf("             stats: last %u ms, max %u ms (warmup included), slow %u; focus checks %u\n",
+           s.last_sweep_ms, s.max_sweep_ms, s.slow_sweeps, r.focus_checks);
+    printf("             focus raised in %u of %u sweeps, restart est. %u ms\n", r.focus_raised, r.focus_checks,
+           r.sched.restart_ms);
+  }
+}
+
+static void expect_common(const char* name, const RunResult& r) {
+  expect(r.misfiled == 0, name, "range filed under the wrong zone");
+  expect(r.out_of_order == 0, name, "zones not ranged in turn");
+  expect(r.stale_wrong == 0, name, "map staleness disagrees with entry age");
+  expect(r.sched.stats.ranges == r.ranges, name, "range count");
+  expect(r.sched.stats.sweeps == r.sweeps, name, "sweep count");
+}
+
+// ===================================================================
+// Scenes
+// ===================================================================
+
+static int16_t scene_static(uint8_t zone, uint32_t t_ms) {
+  (void)t_ms;
+  static const int16_t mm[TOF_ZONE_COUNT] = {700, -1, 1500};
+  return mm[zone];
+}
+
+// A post passing from right to left while the user walks, 3 s per zone;
+// a wall far off in every zone
+static int16_t scene_moving(uint8_t zone, uint32_t t_ms) {
+  uint8_t near_zone = TOF_ZONE_COUNT - 1 - (t_ms / 3000) % TOF_ZONE_COUNT;
+  if (zone == near_zone) return (int16_t)(1200 - (t_ms % 3000) / 5);
+  return 2500;
+}
+
+int main(int argc, char** argv) {
+  uint32_t seconds = 10;
+  uint32_t seed = 1;
+  
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+      seconds = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "-v")) {
+      verbose = true;
+    } else {
+      fprintf(stderr, "usage: %s [--seconds N] [--seed N] [-v]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (seconds < 4) seconds = 4;
+  uint32_t duration_ms = seconds * 1000;
+  
+  printf("sweep target %u ms, stale after %u ms, %u s per run\n\n", TOF_ZONE_SWEEP_TARGET_MS,
+         TOF_ZONE_MAX_AGE_MS, seconds);
+  
+  {
+    RunConfig cfg = {"sweep", scene_static, duration_ms, 6, 2, 0, 0, seed};
+    RunResult r = run(cfg);
+    report(cfg, r);
+    expect_common(cfg.name, r);
+    expect(r.slow_sweeps == 0, cfg.name, "sweep slower than 10 Hz");
+    // Every zone is refreshed once a sweep, so no entry outlives one
+    // sweep plus the longest range and the read delay
+    expect(r.max_age_ms <= TOF_ZONE_SWEEP_TARGET_MS + 50 + READ_DELAY_MAX, cfg.name, "zone not refreshed each sweep");
+  }
+  
+  {
+    RunConfig cfg = {"focus", scene_moving, duration_ms, 3, 1, 0, 0, seed};
+    RunResult r = run(cfg);
+    report(cfg, r);
+    expect_common(cfg.name, r);
+    expect(r.focus_checks > 0 && r.focus_wrong == 0, cfg.name, "nearest zone not given the longest budget");
+    expect(r.focus_raised > r.focus_checks / 2, cfg.name, "spare sweep time not given to the nearest zone");
+    expect(r.slow_sweeps == 0, cfg.name, "sweep slower than 10 Hz");
+  }
+  
+  for (uint16_t overhead = 2; overhead <= 11; overhead += 3) {
+    char name[16];
+    snprintf(name, sizeof(name), "overhead %u", overhead);
+    RunConfig cfg = {name, scene_moving, duration_ms, overhead, 2, 0, 0, seed + overhead};
+    RunResult r = run(cfg);
+    report(cfg, r);
+    expect_common(name, r);
+    expect(r.slow_sweeps == 0, name, "sweep slower than 10 Hz");
+  }
+  
+  {
+    RunConfig cfg = {"stall", scene_static, duration_ms, 6, 2, 2000, 2600, seed};
+    RunResult r = run(cfg);
+    report(cfg, r);
+    expect_common(cfg.name, r);
+    expect(r.fresh_after_stall_ms > 0 && r.fresh_after_stall_ms <= 2 * TOF_ZONE_SWEEP_TARGET_MS, cfg.name,
+           "zones not fresh within two sweeps of the restart");
+    if (verbose) printf("             fresh again %u ms after the stall\n", r.fresh_after_stall_ms);
+  }
+  
+  printf("%s\n", failures ? "FAIL" : "ok");
+  return failures ? 1 : 0;
+}
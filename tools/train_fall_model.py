@@ -0,0 +1,277 @@
+#!/usr/bin/env python3
+"""
+Smart Walking Stick Firmware - Fall Model Trainer
+Trains the int8 decision-tree ensemble used by src/fall_classifier.cpp
+and writes its constexpr tables to src/fall_model.h.
+
+Input is the feature dump of tools/fall_eval (one inference window per
+line): label,f0,...,f9 with label 1 for a fall. Features are quantised
+to int8 between their 1st and 99th percentile, then gradient-boosted
+trees (log loss, Newton leaves) of a fixed depth are grown on the int8
+values. Every tree is complete, so the firmware walks the same number
+of nodes for every window. The decision threshold maximises F-beta
+(beta 2 by default: a missed fall costs more than a false alarm) on the
+quantised integer scores, exactly as the firmware computes them.
+
+Pure Python, no numpy needed; a few thousand windows train in seconds.
+
+Usage:
+  ./fall_eval --synthetic --features train.csv
+  python3 tools/train_fall_model.py train.csv -o src/fall_model.h
+  (rebuild fall_eval)
+  ./fall_eval --synthetic --seed 2
+"""
+
+import argparse
+import csv
+import math
+import sys
+
+FEATURES = [
+    "long_max_g", "long_min_g", "long_std_g", "long_jerk_max_g_s", "long_jerk_mean_g_s",
+    "long_tilt_deg", "short_mean_g", "short_std_g", "short_jerk_mean_g_s", "short_max_g",
+]
+ALWAYS_LEFT = (0, 127)  # Unsplit node: q <= 127 always holds
+
+
+def load_rows(paths):
+    labels, rows = [], []
+    for path in paths:
+        with open(path, newline="") as f:
+            for row in csv.reader(f):
+                if not row or row[0].startswith("#"):
+                    continue
+                if len(row) != len(FEATURES) + 1:
+                    raise ValueError(f"{path}: expected {len(FEATURES) + 1} columns, got {len(row)}")
+                labels.append(int(row[0]))
+                rows.append([float(v) for v in row[1:]])
+    return labels, rows
+
+
+# ===================================================================
+# Quantisation
+# ===================================================================
+
+def percentile(values, p):
+    s = sorted(values)
+    k = (len(s) - 1) * p
+    i = int(k)
+    j = min(i + 1, len(s) - 1)
+    return s[i] + (s[j] - s[i]) * (k - i)
+
+
+def quant_params(rows):
+    lo, inv = [], []
+    for f in range(len(FEATURES)):
+        column = [r[f] for r in rows]
+        a, b = percentile(column, 0.01), percentile(column, 0.99)
+        lo.append(a)
+        inv.append(255.0 / (b - a) if b > a else 1.0)
+    return lo, inv
+
+
+def lround(v):
+    # C lroundf: halves away from zero
+    return int(math.floor(abs(v) + 0.5)) * (1 if v >= 0 else -1)
+
+
+def quantise(row, lo, inv):
+    return [max(-128, min(127, lround((x - l) * s) - 128)) for x, l, s in zip(row, lo, inv)]
+
+
+# ===================================================================
+# Boosting
+# ===================================================================
+
+def best_split(idx, q, grad, hess, l2, min_hess):
+    g_total = sum(grad[i] for i in idx)
+    h_total = sum(hess[i] for i in idx)
+    parent = g_total * g_total / (h_total + l2)
+    best = (0.0, None)
+    for f in range(len(FEATURES)):
+        g_hist = [0.0] * 256
+        h_hist = [0.0] * 256
+        for i in idx:
+            b = q[i][f] + 128
+            g_hist[b] += grad[i]
+            h_hist[b] += hess[i]
+        g_left = h_left = 0.0
+        for b in range(255):
+            g_left += g_hist[b]
+            h_left += h_hist[b]
+            h_right = h_total - h_left
+            if h_left < min_hess or h_right < min_hess:
+                continue
+            g_right = g_total - g_left
+            gain = (g_left * g_left / (h_left + l2) + g_right * g_right / (h_right + l2) - parent)
+            if gain > best[0]:
+                best = (gain, (f, b - 128))
+    return best[1]
+
+
+def grow_tree(q, grad, hess, depth, l2, min_hess):
+    nodes = []
+    level = [list(range(len(q)))]
+    for _ in range(depth):
+        next_level = []
+        for idx in level:
+            split = best_split(idx, q, grad, hess, l2, min_hess) if idx else None
+            f, t = split if split else ALWAYS_LEFT
+            nodes.append((f, t))
+            next_level.append([i for i in idx if q[i][f] <= t])
+            next_level.append([i for i in idx if q[i][f] > t])
+        level = next_level
+    leaves = []
+    for idx in level:
+        g = sum(grad[i] for i in idx)
+        h = sum(hess[i] for i in idx)
+        leaves.append(-g / (h + l2) if idx else 0.0)
+    return nodes, leaves
+
+
+def tree_leaf(nodes, depth, x):
+    n = 0
+    for _ in range(depth):
+        f, t = nodes[n]
+        n = 2 * n + 1 + (x[f] > t)
+    return n - len(nodes)
+
+
+def train(labels, q, args):
+    pos = sum(labels)
+    weight = [args.pos_weight if y else 1.0 for y in labels]
+    base = math.log((pos * args.pos_weight) / max(1, len(labels) - pos))
+    margin = [base] * len(labels)
+    trees = []
+    for t in range(args.trees):
+        grad, hess = [], []
+        for y, m, w in zip(labels, margin, weight):
+            p = 1.0 / (1.0 + math.exp(-m))
+            grad.append(w * (p - y))
+            hess.append(w * max(p * (1.0 - p), 1e-6))
+        nodes, leaves = grow_tree(q, grad, hess, args.depth, args.l2, args.min_hess)
+        leaves = [v * args.rate for v in leaves]
+        trees.append((nodes, leaves))
+        for i, x in enumerate(q):
+            margin[i] += leaves[tree_leaf(nodes, args.depth, x)]
+    return base, trees
+
+
+# ===================================================================
+# Integer Model
+# ===================================================================
+
+def to_int8(base, trees):
+    peak = max(abs(v) for _, leaves in trees for v in leaves) or 1.0
+    scale = 127.0 / peak
+    int_trees = [(nodes, [lround(v * scale) for v in leaves]) for nodes, leaves in trees]
+    return lround(base * scale), int_trees, scale
+
+
+def int_score(bias, int_trees, depth, x):
+    return bias + sum(leaves[tree_leaf(nodes, depth, x)] for nodes, leaves in int_trees)
+
+
+def pick_threshold(labels, scores, beta):
+    pos = sum(labels)
+    best = (-1.0, 0, 0, 0)
+    for thr in sorted(set(scores)):
+        tp = sum(1 for y, s in zip(labels, scores) if y and s > thr)
+        fp = sum(1 for y, s in zip(labels, scores) if not y and s > thr)
+        if tp == 0:
+            continue
+        p, r = tp / (tp + fp), tp / pos
+        f = (1 + beta * beta) * p * r / (beta * beta * p + r)
+        if f > best[0]:
+            best = (f, thr, p, r)
+    return best
+
+
+def write_header(path, args, lo, inv, bias, int_trees, threshold, stats):
+    out = []
+    out.append("#ifndef FALL_MODEL_H")
+    out.append("#define FALL_MODEL_H")
+    out.append("")
+    out.append("#include <stdint.h>")
+    out.append("")
+    out.append("// ===================================================================")
+    out.append("// Fall Model (generated by tools/train_fall_model.py - do not edit)")
+    out.append("// ===================================================================")
+    out.append(f"// {args.trees} trees of depth {args.depth} on {len(FEATURES)} int8 features, "
+               f"trained on {stats['windows']} windows")
+    out.append(f"// ({stats['falls']} falls). Training windows at the chosen threshold: "
+               f"precision {stats['precision']:.3f},")
+    out.append(f"// recall {stats['recall']:.3f}. Leaves are logits x {stats['scale']:.2f}.")
+    out.append("// ===================================================================")
+    out.append("")
+    out.append(f"#define FALL_MODEL_FEATURES {len(FEATURES)}")
+    out.append(f"#define FALL_MODEL_TREES    {args.trees}")
+    out.append(f"#define FALL_MODEL_DEPTH    {args.depth}")
+    out.append("")
+    out.append("// q = clamp(round((x - lo) * inv_scale) - 128, -128, 127)")
+    out.append("static constexpr float fall_model_feature_lo[FALL_MODEL_FEATURES] = {")
+    for f, v in enumerate(lo):
+        out.append(f"  {v:.6g}f,{' ' * max(1, 14 - len(f'{v:.6g}'))}// {FEATURES[f]}")
+    out.append("};")
+    out.append("static constexpr float fall_model_feature_inv_scale[FALL_MODEL_FEATURES] = {")
+    out.append("  " + ", ".join(f"{v:.6g}f" for v in inv))
+    out.append("};")
+    out.append("")
+    nodes = (1 << args.depth) - 1
+    leaves = 1 << args.depth
+    out.append("// Node n: go to 2n+2 if q[feature] > threshold, else 2n+1")
+    out.append(f"static constexpr uint8_t fall_model_node_feature[FALL_MODEL_TREES][{nodes}] = {{")
+    for tree_nodes, _ in int_trees:
+        out.append("  {" + ", ".join(str(f) for f, _ in tree_nodes) + "},")
+    out.append("};")
+    out.append(f"static constexpr int8_t fall_model_node_threshold[FALL_MODEL_TREES][{nodes}] = {{")
+    for tree_nodes, _ in int_trees:
+        out.append("  {" + ", ".join(str(t) for _, t in tree_nodes) + "},")
+    out.append("};")
+    out.append(f"static constexpr int8_t fall_model_leaf[FALL_MODEL_TREES][{leaves}] = {{")
+    for _, tree_leaves in int_trees:
+        out.append("  {" + ", ".join(str(v) for v in tree_leaves) + "},")
+    out.append("};")
+    out.append("")
+    out.append(f"static constexpr int32_t fall_model_bias = {bias};")
+    out.append(f"static constexpr int32_t fall_model_threshold = {threshold};   // score > threshold: fall")
+    out.append("")
+    out.append("#endif // FALL_MODEL_H")
+    with open(path, "w") as f:
+        f.write("\n".join(out) + "\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("features", nargs="+", help="feature CSV(s) from fall_eval --features")
+    parser.add_argument("-o", "--output", default="src/fall_model.h")
+    parser.add_argument("--trees", type=int, default=16)
+    parser.add_argument("--depth", type=int, default=3)
+    parser.add_argument("--rate", type=float, default=0.3, help="learning rate")
+    parser.add_argument("--l2", type=float, default=1.0, help="leaf L2 regularisation")
+    parser.add_argument("--min-hess", type=float, default=2.0, help="smallest child hessian sum")
+    parser.add_argument("--pos-weight", type=float, default=2.0, help="weight of fall windows")
+    parser.add_argument("--beta", type=float, default=2.0, help="F-beta for the threshold")
+    args = parser.parse_args()
+
+    labels, rows = load_rows(args.features)
+    if not rows or not 0 < sum(labels) < len(labels):
+        sys.exit("need both fall and non-fall windows")
+
+    lo, inv = quant_params(rows)
+    q = [quantise(r, lo, inv) for r in rows]
+    base, trees = train(labels, q, args)
+    bias, int_trees, scale = to_int8(base, trees)
+
+    scores = [int_score(bias, int_trees, args.depth, x) for x in q]
+    f, threshold, precision, recall = pick_threshold(labels, scores, args.beta)
+    stats = {"windows": len(rows), "falls": sum(labels), "precision": precision,
+             "recall": recall, "scale": scale}
+    write_header(args.output, args, lo, inv, bias, int_trees, threshold, stats)
+    print(f"{len(rows)} windows ({sum(labels)} falls): threshold {threshold}, "
+          f"precision {precision:.3f}, recall {recall:.3f}, F{args.beta:g} {f:.3f}")
+    print(f"wrote {args.output}")
+
+
+if __name__ == "__main__":
+    main()
@@ -14,12 +14,63 @@ REQUIRED_FILES = [
     "src/config.h",
     "src/ble.h",
     "src/ble.cpp",
+    "src/ahrs.h",
+    "src/ahrs.cpp",
+    "src/battery_model.h",
+    "src/battery_model.cpp",
+    "src/black_box.h",
+    "src/black_box.cpp",
+    "src/boot.h",
+    "src/boot.cpp",
+    "src/calibration_engine.h",
+    "src/calibration_engine.cpp",
     "src/sensors.h",
     "src/sensors.cpp",
     "src/fall_detection.h",
     "src/fall_detection.cpp",
+    "src/fall_classifier.h",
+    "src/fall_classifier.cpp",
+    "src/fall_model.h",
+    "src/fall_kernels.h",
+    "src/fall_kernels.cpp",
+    "src/gait.h",
+    "src/gait.cpp",
     "src/haptics.h",
     "src/haptics.cpp",
+    "src/landmark_db.h",
+    "src/landmark_db.cpp",
+    "src/i2c_bus.h",
+    "src/i2c_bus.cpp",
+    "src/imu_features.h",
+    "src/imu_features.cpp",
+    "src/imu_fifo.h",
+    "src/imu_fifo.cpp",
+    "src/rfid_detect.h",
+    "src/rfid_detect.cpp",
+    "src/ring_buffer.h",
+    "src/sensor_events.h",
+    "src/sensor_events.cpp",
+    "src/telemetry_frame.h",
+    "src/telemetry_frame.cpp",
+    "src/telemetry_batch.h",
+    "src/telemetry_batch.cpp",
+    "src/conn_policy.h",
+    "src/conn_policy.cpp",
+    "src/alert_queue.h",
+    "src/alert_queue.cpp",
+    "src/journal.h",
+    "src/journal.cpp",
+    "src/log.h",
+    "src/log.cpp",
+    "src/tof_tracker.h",
+    "src/tof_tracker.cpp",
+    "src/tof_zones.h",
+    "src/tof_zones.cpp",
+    "src/sensing_task.h",
+    "src/sensing_task.cpp",
+    "tools/build_landmarks.py",
+    "tools/train_fall_model.py",
+    "partitions.csv",
     "platformio.ini",
     "README.md"
 ]
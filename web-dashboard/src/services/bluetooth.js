@@ -3,6 +3,218 @@ const SENSOR_DATA_CHAR_UUID = '12345678-1234-1234-1234-1234567890ad';
 const ALERTS_CHAR_UUID = '12345678-1234-1234-1234-1234567890ae';
 const CONFIG_CHAR_UUID = '12345678-1234-1234-1234-1234567890af';
 const CALIBRATION_CHAR_UUID = '12345678-1234-1234-1234-1234567890b0';
+const JOURNAL_CHAR_UUID = '12345678-1234-1234-1234-1234567890b3';
+
+// Slots in the stick's alert queue (src/alert_queue.h)
+const ALERT_QUEUE_SIZE = 16;
+
+// Telemetry journal records (src/journal.h): u8 type, u8 payload length,
+// u16 CRC-16/CCITT of the three, then the payload (u32 t_ms first).
+// Journal notifications are a u32 log offset and the log bytes from it.
+const JOURNAL_RECORD_HEADER = 4;
+const JOURNAL_SYNC_HEADER = 4;
+const JOURNAL_REC_BOOT = 1;
+const JOURNAL_REC_SAMPLE = 2;
+const JOURNAL_REC_GAIT = 3;
+const JOURNAL_REC_ALERT = 4;
+const JOURNAL_SYNC_IDLE_MS = 10000;
+
+// Binary sensor frames (src/telemetry_frame.h): little-endian, a 10-byte
+// header (magic, version, type, flags, u16 seq, u32 t_us) on each frame
+const TELEMETRY_FRAME_MAGIC = 0xb5;
+const TELEMETRY_FRAME_VERSION = 1;
+const TELEMETRY_HEADER_BYTES = 10;
+const TELEMETRY_FRAME_SAMPLE = 1;
+const TELEMETRY_FRAME_GAIT = 2;
+const TELEMETRY_FRAME_IMU = 3;
+const TELEMETRY_FRAME_IMU_DELTA = 4;
+const TELEMETRY_SAMPLE_BYTES = 40;
+const TELEMETRY_GAIT_BYTES = 34;
+const TELEMETRY_IMU_HEADER_BYTES = 12;
+const TELEMETRY_IMU_SAMPLE_BYTES = 12;
+
+// Raw MPU6050 counts in IMU frames
+const ACCEL_LSB_PER_G = 4096;
+const GYRO_LSB_PER_DPS = 65.5;
+
+const FLAG_IMU = 0x01;
+const FLAG_TOF = 0x02;
+const FLAG_ZONES = 0x04;
+const FLAG_BATTERY = 0x08;
+const FLAG_CHARGING = 0x10;
+const FLAG_FLAT = 0x20;
+const FLAG_WALKING = 0x01;
+
+const round = (v, digits) => Math.round(v * 10 ** digits) / 10 ** digits;
+
+// Raw counts of an IMU frame (type 3) or delta frame (type 4: keyframe,
+// then six zigzag varints per sample). Returns the frame's size, or 0
+// if it runs past the notification.
+function decodeImuFrame(view, offset, out) {
+  const count = view.getUint8(offset + 10);
+  const delta = view.getUint8(offset + 2) === TELEMETRY_FRAME_IMU_DELTA;
+  let at = offset + TELEMETRY_IMU_HEADER_BYTES;
+  const v = [0, 0, 0, 0, 0, 0];
+  for (let k = 0; k < count; k++) {
+    if (!delta || k === 0) {
+      if (at + TELEMETRY_IMU_SAMPLE_BYTES > view.byteLength) return 0;
+      for (let i = 0; i < 6; i++) v[i] = view.getInt16(at + 2 * i, true);
+      at += TELEMETRY_IMU_SAMPLE_BYTES;
+    } else {
+      for (let i = 0; i < 6; i++) {
+        let z = 0;
+        let shift = 0;
+        let byte;
+        do {
+          if (at >= view.byteLength || shift > 14) return 0;
+          byte = view.getUint8(at++);
+          z |= (byte & 0x7f) << shift;
+          shift += 7;
+        } while (byte & 0x80);
+        v[i] = ((v[i] + ((z >>> 1) ^ -(z & 1))) << 16) >> 16;
+      }
+    }
+    out.push(v.slice());
+  }
+  return at - offset;
+}
+
+// Decodes one notification of binary frames into the same objects the
+// JSON path produces; a gait frame is attached to the sample before it.
+// Streamed IMU samples, if any, are appended to imu as { ts, ax, ay, az,
+// gx, gy, gz } in g and deg/s. state carries the sequence and
+// time-unwrapping across notifications.
+export function decodeTelemetryFrames(view, state, imu = []) {
+  const samples = [];
+  let offset = 0;
+  while (offset + TELEMETRY_HEADER_BYTES <= view.byteLength) {
+    if (view.getUint8(offset) !== TELEMETRY_FRAME_MAGIC ||
+        view.getUint8(offset + 1) !== TELEMETRY_FRAME_VERSION) {
+      break;
+    }
+    const type = view.getUint8(offset + 2);
+    const flags = view.getUint8(offset + 3);
+    const seq = view.getUint16(offset + 4, true);
+    const tUs = view.getUint32(offset + 6, true);
+    const isImu = type === TELEMETRY_FRAME_IMU || type === TELEMETRY_FRAME_IMU_DELTA;
+    const counts = [];
+    const size = type === TELEMETRY_FRAME_SAMPLE ? TELEMETRY_SAMPLE_BYTES :
+                 type === TELEMETRY_FRAME_GAIT ? TELEMETRY_GAIT_BYTES :
+                 isImu && offset + TELEMETRY_IMU_HEADER_BYTES <= view.byteLength ?
+                   decodeImuFrame(view, offset, counts) : 0;
+    if (!size || offset + size > view.byteLength) break;
+
+    if (state.seq !== null) state.lost += (seq - state.seq - 1) & 0xffff;
+    state.seq = seq;
+    // micros() wraps every ~71 minutes
+    if (state.lastUs !== null && state.lastUs - tUs > 2 ** 31) state.epochUs += 2 ** 32;
+    state.lastUs = tUs;
+    const ts = Math.round((state.epochUs + tUs) / 1000);
+
+    const i16 = (at) => view.getInt16(offset + at, true);
+    const u16 = (at) => view.getUint16(offset + at, true);
+    const u32 = (at) => view.getUint32(offset + at, true);
+
+    if (type === TELEMETRY_FRAME_SAMPLE) {
+      const data = { ts, seq };
+      if (flags & FLAG_IMU) {
+        data.imu = {
+          ax: i16(10) / 1000, ay: i16(12) / 1000, az: i16(14) / 1000,
+          gx: i16(16) / 10, gy: i16(18) / 10, gz: i16(20) / 10,
+          pitch: round(i16(22) / 100, 1), roll: round(i16(24) / 100, 1)
+        };
+      }
+      if (flags & FLAG_FLAT) data.flat = true;
+      if (flags & FLAG_TOF) data.dist_mm = i16(26);
+      if (flags & FLAG_ZONES) data.zones = [i16(28), i16(30), i16(32)];
+      if (flags & FLAG_BATTERY) {
+        data.battery = { v: round(u16(34) / 1000, 2), pct: view.getUint8(offset + 36) };
+        if (u16(38) !== 0xffff) data.battery.runtime_min = u16(38);
+        if (flags & FLAG_CHARGING) data.battery.chg = true;
+      }
+      samples.push(data);
+    } else if (isImu) {
+      const periodMs = view.getUint8(offset + 11);
+      counts.forEach((c, k) => {
+        imu.push({
+          ts: ts + k * periodMs,
+          ax: c[0] / ACCEL_LSB_PER_G, ay: c[1] / ACCEL_LSB_PER_G, az: c[2] / ACCEL_LSB_PER_G,
+          gx: c[3] / GYRO_LSB_PER_DPS, gy: c[4] / GYRO_LSB_PER_DPS, gz: c[5] / GYRO_LSB_PER_DPS
+        });
+      });
+    } else {
+      const gait = {
+        steps: u32(10), plants: u32(14), cad: u16(18), stride_ms: u16(20),
+        cv: u16(22) / 1000, bouts: u16(24), walk_s: u32(26)
+      };
+      if (flags & FLAG_WALKING) gait.walking = true;
+      if (samples.length) samples[samples.length - 1].gait = gait;
+      else samples.push({ ts, seq, gait });
+    }
+    offset += size;
+  }
+  return samples;
+}
+
+function journalCrc(bytes) {
+  let crc = 0xffff;
+  for (const b of bytes) {
+    crc ^= b << 8;
+    for (let k = 0; k < 8; k++) crc = crc & 0x8000 ? ((crc << 1) ^ 0x1021) & 0xffff : (crc << 1) & 0xffff;
+  }
+  return crc;
+}
+
+// One journal record as { type, t_ms, ... }: samples and gait in the
+// shape of the live SENSOR_DATA objects, alerts with their JSON parsed
+function decodeJournalRecord(type, payload) {
+  const view = new DataView(payload.buffer, payload.byteOffset, payload.byteLength);
+  const i16 = (at) => view.getInt16(at, true);
+  const u16 = (at) => view.getUint16(at, true);
+  const u32 = (at) => view.getUint32(at, true);
+  const t_ms = payload.length >= 4 ? u32(0) : 0;
+  if (type === JOURNAL_REC_BOOT && payload.length >= 5) {
+    return { type: 'boot', t_ms, reset_reason: payload[4] };
+  }
+  if (type === JOURNAL_REC_SAMPLE && payload.length >= 24) {
+    const flags = payload[23];
+    const data = { type: 'sample', t_ms, ts: t_ms };
+    if (flags & FLAG_IMU) {
+      data.imu = {
+        ax: i16(4) / 1000, ay: i16(6) / 1000, az: i16(8) / 1000,
+        gx: i16(10) / 10, gy: i16(12) / 10, gz: i16(14) / 10,
+        pitch: round(i16(16) / 100, 1), roll: round(i16(18) / 100, 1)
+      };
+    }
+    if (flags & FLAG_FLAT) data.flat = true;
+    if (flags & FLAG_TOF) data.dist_mm = i16(20);
+    if (flags & FLAG_BATTERY) {
+      data.battery = { pct: payload[22] };
+      if (flags & FLAG_CHARGING) data.battery.chg = true;
+    }
+    return data;
+  }
+  if (type === JOURNAL_REC_GAIT && payload.length >= 29) {
+    const gait = {
+      steps: u32(4), plants: u32(8), cad: u16(12), stride_ms: u16(14),
+      cv: u16(16) / 1000, bouts: u16(18), walk_s: u32(20)
+    };
+    if (payload[28]) gait.walking = true;
+    return { type: 'gait', t_ms, ts: t_ms, gait };
+  }
+  if (type === JOURNAL_REC_ALERT && payload.length >= 8) {
+    const text = new TextDecoder().decode(payload.subarray(8));
+    let alert = null;
+    try {
+      alert = JSON.parse(text);
+    } catch (e) {
+      // Cut at the record limit; keep the text
+      alert = { raw: text };
+    }
+    return { type: 'alert', t_ms, seq: u32(4), alert };
+  }
+  return { type: 'unknown', record_type: type, t_ms };
+}
 
 export class SmartStickBLE {
   constructor() {
@@ -13,16 +225,27 @@ export class SmartStickBLE {
     this.alertsChar = null;
     this.configChar = null;
     this.calibrationChar = null;
+    this.journalChar = null;
     this.onSensorDataCallback = null;
+    this.onImuStreamCallback = null;
     this.onAlertCallback = null;
     this.onCalibrationCallback = null;
     this.onDisconnect = null;
+    this.telemetryFormat = 'json';
+    this.telemetryState = null;
+    this.imuStreaming = false;
+    this.lastAlertSeq = 0;
   }
   
   onSensorData(callback) {
     this.onSensorDataCallback = callback;
   }
   
+  // Batches of raw 100 Hz IMU samples, once requestImuStream(true)
+  onImuStream(callback) {
+    this.onImuStreamCallback = callback;
+  }
+  
   onAlert(callback) {
     this.onAlertCallback = callback;
   }
@@ -55,6 +278,12 @@ export class SmartStickBLE {
       this.alertsChar = await this.service.getCharacteristic(ALERTS_CHAR_UUID);
       this.configChar = await this.service.getCharacteristic(CONFIG_CHAR_UUID);
       this.calibrationChar = await this.service.getCharacteristic(CALIBRATION_CHAR_UUID);
+      try {
+        this.journalChar = await this.service.getCharacteristic(JOURNAL_CHAR_UUID);
+      } catch (e) {
+        // Firmware without the journal
+        this.journalChar = null;
+      }
 
       await this.sensorDataChar.startNotifications();
       await this.configChar.startNotifications();
@@ -72,10 +301,32 @@ export class SmartStickBLE {
           console.error('Failed to parse calibration data:', e);
         }
       });
+      this.telemetryFormat = 'json';
+      this.imuStreaming = false;
+      this.telemetryState = { seq: null, lost: 0, lastUs: null, epochUs: 0 };
       this.sensorDataChar.addEventListener('characteristicvaluechanged', (event) => {
-        const value = new TextDecoder().decode(event.target.value);
+        const view = event.target.value;
+        if (view.byteLength && view.getUint8(0) === TELEMETRY_FRAME_MAGIC) {
+          const imu = [];
+          for (const data of decodeTelemetryFrames(view, this.telemetryState, imu)) {
+            if (this.onSensorDataCallback) {
+              this.onSensorDataCallback(data);
+            }
+          }
+          if (imu.length && this.onImuStreamCallback) {
+            this.onImuStreamCallback(imu);
+          }
+          return;
+        }
+        const value = new TextDecoder().decode(view);
         try {
           const data = JSON.parse(value);
+          if (data.format) {
+            // Reply to the format request
+            this.telemetryFormat = data.format;
+            this.imuStreaming = !!data.imu_stream;
+            return;
+          }
           if (this.onSensorDataCallback) {
             this.onSensorDataCallback(data);
           }
@@ -83,12 +334,25 @@ export class SmartStickBLE {
           console.error('Failed to parse sensor data:', e);
         }
       });
+      await this.requestBinaryTelemetry();
 
+      // Alerts carry a sequence number and are resent until acked, so
+      // ack every copy and pass each seq on once. Replays never reach
+      // further back than the stick's queue; a seq further back than
+      // that means it restarted from power-off.
       await this.alertsChar.startNotifications();
       this.alertsChar.addEventListener('characteristicvaluechanged', (event) => {
         const value = new TextDecoder().decode(event.target.value);
         try {
           const data = JSON.parse(value);
+          if (typeof data.seq === 'number') {
+            this.ackAlert(data.seq);
+            const back = this.lastAlertSeq - data.seq;
+            if (back >= 0 && back < ALERT_QUEUE_SIZE) {
+              return;
+            }
+            this.lastAlertSeq = data.seq;
+          }
           if (this.onAlertCallback) {
             this.onAlertCallback(data);
           }
@@ -104,6 +368,15 @@ export class SmartStickBLE {
     }
   }
 
+  async ackAlert(seq) {
+    try {
+      await this.alertsChar.writeValue(new TextEncoder().encode(JSON.stringify({ ack: seq })));
+    } catch (e) {
+      // The stick resends until an ack gets through
+      console.warn('Alert ack failed:', e);
+    }
+  }
+
   async disconnect() {
     if (this.device && this.device.gatt.connected) {
       await this.device.gatt.disconnect();
@@ -166,6 +439,131 @@ export class SmartStickBLE {
     });
   }
 
+  // Firmware without binary frames rejects the write; JSON carries on
+  async requestBinaryTelemetry() {
+    const cmd = JSON.stringify({ format: 'binary', version: TELEMETRY_FRAME_VERSION });
+    try {
+      await this.sensorDataChar.writeValue(new TextEncoder().encode(cmd));
+    } catch (e) {
+      console.warn('Binary telemetry not supported, using JSON:', e);
+    }
+  }
+
+  // Raw IMU samples ride in batched binary notifications, delta-coded
+  // unless codec is 'raw'; the reply sets imuStreaming (false without
+  // the sensor's 100 Hz FIFO)
+  async requestImuStream(enable, codec = 'delta') {
+    if (!this.sensorDataChar) {
+      throw new Error('Not connected to device');
+    }
+    const cmd = JSON.stringify({
+      format: 'binary', version: TELEMETRY_FRAME_VERSION, imu_stream: enable, imu_codec: codec
+    });
+    await this.sensorDataChar.writeValue(new TextEncoder().encode(cmd));
+  }
+
+  // {tail, head, records, ...}: what the journal holds, by log offset
+  async readJournalInfo() {
+    if (!this.journalChar) {
+      throw new Error('Journal not supported by this firmware');
+    }
+    const value = await this.journalChar.readValue();
+    return JSON.parse(new TextDecoder().decode(value));
+  }
+
+  // Downloads the journal from log offset `from` (0: all it still
+  // holds). Resolves with the decoded records and the offset to sync
+  // from next time: the head when complete, else the start of the
+  // first record not received whole (after a disconnect or a stalled
+  // link). `skipped` counts bytes the ring overwrote before they were
+  // fetched; records failing their CRC are counted, not returned.
+  async syncJournal(from = 0, onRecords = null) {
+    if (!this.journalChar) {
+      throw new Error('Journal not supported by this firmware');
+    }
+    const result = { records: [], offset: from, complete: false, skipped: 0, badCrc: 0 };
+    let pending = new Uint8Array(0);   // Bytes of a record not yet whole
+    let expected = from;               // Offset the next notification continues
+
+    return new Promise((resolve, reject) => {
+      let idle;
+      const finish = (complete) => {
+        clearTimeout(idle);
+        this.journalChar.removeEventListener('characteristicvaluechanged', onValue);
+        this.device.removeEventListener('gattserverdisconnected', onGone);
+        result.complete = complete;
+        resolve(result);
+      };
+      const onGone = () => finish(false);
+      const onValue = (event) => {
+        clearTimeout(idle);
+        idle = setTimeout(() => finish(false), JOURNAL_SYNC_IDLE_MS);
+        const view = event.target.value;
+        if (view.byteLength < JOURNAL_SYNC_HEADER) return;
+        const offset = view.getUint32(0, true);
+        if (view.byteLength === JOURNAL_SYNC_HEADER) {
+          if (offset !== expected) pending = new Uint8Array(0);
+          result.offset = offset;
+          finish(true);
+          return;
+        }
+
+        // A jump forward: the bytes in between were overwritten
+        if (offset !== expected) {
+          if (offset > expected) result.skipped += offset - expected;
+          pending = new Uint8Array(0);
+          result.offset = offset;
+        }
+        const bytes = new Uint8Array(view.buffer, view.byteOffset + JOURNAL_SYNC_HEADER,
+                                     view.byteLength - JOURNAL_SYNC_HEADER);
+        const joined = new Uint8Array(pending.length + bytes.length);
+        joined.set(pending);
+        joined.set(bytes, pending.length);
+        expected = offset + bytes.length;
+
+        const batch = [];
+        let at = 0;
+        while (at + JOURNAL_RECORD_HEADER <= joined.length) {
+          const len = joined[at + 1];
+          const size = JOURNAL_RECORD_HEADER + len;
+          if (at + size > joined.length) break;
+          const crc = joined[at + 2] | (joined[at + 3] << 8);
+          const head = [joined[at], len];
+          const payload = joined.subarray(at + JOURNAL_RECORD_HEADER, at + size);
+          if (journalCrc([...head, ...payload]) === crc) {
+            batch.push({ offset: result.offset + at, ...decodeJournalRecord(joined[at], payload) });
+          } else {
+            result.badCrc++;
+          }
+          at += size;
+        }
+        pending = joined.slice(at);
+        result.offset += at;
+        result.records.push(...batch);
+        if (batch.length && onRecords) onRecords(batch);
+      };
+
+      this.journalChar.addEventListener('characteristicvaluechanged', onValue);
+      this.device.addEventListener('gattserverdisconnected', onGone);
+      this.journalChar.startNotifications()
+        .then(() => this.journalChar.writeValue(new TextEncoder().encode(JSON.stringify({ cmd: 'sync', from }))))
+        .then(() => {
+          idle = setTimeout(() => finish(false), JOURNAL_SYNC_IDLE_MS);
+        })
+        .catch((err) => {
+          clearTimeout(idle);
+          this.journalChar.removeEventListener('characteristicvaluechanged', onValue);
+          this.device.removeEventListener('gattserverdisconnected', onGone);
+          reject(err);
+        });
+    });
+  }
+
+  // Frames missing from the sequence since connecting
+  telemetryLost() {
+    return this.telemetryState ? this.telemetryState.lost : 0;
+  }
+
   isConnected() {
     return this.device && this.device.gatt && this.device.gatt.connected;
   }